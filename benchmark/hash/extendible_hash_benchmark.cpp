@@ -0,0 +1,166 @@
+/**
+ * extendible_hash_benchmark.cpp
+ *
+ * Multi-threaded throughput of ExtendibleHash over the key patterns used by
+ * extendible_hash_test: sequential keys, uniformly random keys and strided
+ * keys that share their low bits.
+ */
+
+#include <random>
+
+#include "benchmark_util.h"
+#include "hash/extendible_hash.h"
+
+namespace scudb {
+
+static const int kBucketSize = 10;
+static const uint64_t kNumKeys = 1 << 17;
+static const uint64_t kOpsPerThread = 1 << 19;
+
+// key generators, mirroring the patterns of extendible_hash_test
+static std::vector<int> SequentialKeys(uint64_t n) {
+  std::vector<int> keys;
+  for (uint64_t i = 0; i < n; i++)
+    keys.push_back((int)i);
+  return keys;
+}
+
+static std::vector<int> RandomKeys(uint64_t n) {
+  std::default_random_engine engine(0);
+  std::uniform_int_distribution<int> distribution(0, 1 << 30);
+  std::vector<int> keys;
+  for (uint64_t i = 0; i < n; i++)
+    keys.push_back(distribution(engine));
+  return keys;
+}
+
+static std::vector<int> StridedKeys(uint64_t n) {
+  std::vector<int> keys;
+  for (uint64_t i = 0; i < n; i++)
+    keys.push_back((int)(i * 16));
+  return keys;
+}
+
+// every thread inserts its own slice of keys
+static void InsertBenchmark(const std::string &name,
+                            const std::vector<int> &keys,
+                            uint64_t num_threads) {
+  ExtendibleHash<int, int> table(kBucketSize);
+  double seconds = RunParallel(num_threads, [&](uint64_t tid) {
+    for (uint64_t i = tid; i < keys.size(); i += num_threads)
+      table.Insert(keys[i], keys[i]);
+  });
+  PrintResult(name + "/insert", num_threads, keys.size(), seconds);
+}
+
+// 90% lookups, 10% upserts over a prefilled table
+static void MixedBenchmark(const std::string &name,
+                           const std::vector<int> &keys,
+                           uint64_t num_threads) {
+  ExtendibleHash<int, int> table(kBucketSize);
+  for (auto key : keys)
+    table.Insert(key, key);
+  double seconds = RunParallel(num_threads, [&](uint64_t tid) {
+    std::default_random_engine engine(tid);
+    std::uniform_int_distribution<size_t> pick(0, keys.size() - 1);
+    int value;
+    for (uint64_t i = 0; i < kOpsPerThread; i++) {
+      int key = keys[pick(engine)];
+      if (i % 10 == 0)
+        table.Insert(key, key);
+      else
+        table.Find(key, value);
+    }
+  });
+  PrintResult(name + "/mixed", num_threads, kOpsPerThread * num_threads,
+              seconds);
+}
+
+// approximate heap footprint: directory slots plus fixed-capacity buckets
+static size_t Footprint(ExtendibleHash<int, int> &table) {
+  size_t slots = (size_t)1 << table.GetGlobalDepth();
+  return slots * sizeof(void *) +
+         table.GetNumBuckets() * kBucketSize * (sizeof(int) + sizeof(int));
+}
+
+static void PrintFootprint(const std::string &phase,
+                           ExtendibleHash<int, int> &table) {
+  std::printf("%-40s depth=%-3d buckets=%-8d footprint=%zu bytes\n",
+              phase.c_str(), table.GetGlobalDepth(), table.GetNumBuckets(),
+              Footprint(table));
+}
+
+// fill, drain to 1%, then insert/delete churn around the small live set
+static void ChurnBenchmark(const std::vector<int> &keys) {
+  ExtendibleHash<int, int> table(kBucketSize);
+  for (auto key : keys)
+    table.Insert(key, key);
+  PrintFootprint("churn/peak", table);
+
+  size_t live = keys.size() / 100;
+  for (size_t i = live; i < keys.size(); i++)
+    table.Remove(keys[i]);
+  PrintFootprint("churn/drained", table);
+
+  std::default_random_engine engine(0);
+  std::uniform_int_distribution<size_t> pick(live, keys.size() - 1);
+  Timer timer;
+  for (uint64_t i = 0; i < kOpsPerThread; i++) {
+    int key = keys[pick(engine)];
+    table.Insert(key, key);
+    table.Remove(key);
+  }
+  PrintResult("churn/insert+remove", 1, 2 * kOpsPerThread,
+              timer.ElapsedSeconds());
+  PrintFootprint("churn/steady", table);
+}
+
+// insert-only build: every split adds exactly one bucket
+template <typename Hash>
+static void SkewBenchmark(const std::string &name,
+                          const std::vector<int> &keys) {
+  ExtendibleHash<int, int, Hash> table(kBucketSize);
+  Timer timer;
+  for (auto key : keys)
+    table.Insert(key, key);
+  double seconds = timer.ElapsedSeconds();
+  int buckets = table.GetNumBuckets();
+  std::printf("%-40s depth=%-3d slots=%-8zu splits=%-8d occupancy=%5.1f%% "
+              "%8.3fs\n",
+              name.c_str(), table.GetGlobalDepth(),
+              (size_t)1 << table.GetGlobalDepth(), buckets - 1,
+              100.0 * keys.size() / ((double)buckets * kBucketSize), seconds);
+}
+
+static std::vector<int> PageStridedKeys(uint64_t n) {
+  std::vector<int> keys;
+  for (uint64_t i = 0; i < n; i++)
+    keys.push_back((int)(i << 12));
+  return keys;
+}
+
+} // namespace scudb
+
+int main() {
+  using namespace scudb;
+  std::vector<std::pair<std::string, std::vector<int>>> patterns = {
+      {"sequential", SequentialKeys(kNumKeys)},
+      {"random", RandomKeys(kNumKeys)},
+      {"strided", StridedKeys(kNumKeys)}};
+  for (auto &pattern : patterns) {
+    for (uint64_t threads : {1, 2, 4, 8}) {
+      InsertBenchmark(pattern.first, pattern.second, threads);
+      MixedBenchmark(pattern.first, pattern.second, threads);
+    }
+  }
+  ChurnBenchmark(RandomKeys(kNumKeys));
+
+  patterns.push_back({"page-strided", PageStridedKeys(kNumKeys >> 4)});
+  for (auto &pattern : patterns) {
+    SkewBenchmark<IdentityHash<int>>("skew/identity/" + pattern.first,
+                                     pattern.second);
+    SkewBenchmark<DefaultHash<int>>("skew/default/" + pattern.first,
+                                    pattern.second);
+  }
+  return 0;
+}
@@ -0,0 +1,57 @@
+/**
+ * benchmark_util.h
+ *
+ * Small helpers shared by the micro benchmarks under benchmark/
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace scudb {
+
+// wall clock stopwatch, started on construction
+class Timer {
+public:
+  Timer() : start_(std::chrono::steady_clock::now()) {}
+
+  inline void Reset() { start_ = std::chrono::steady_clock::now(); }
+
+  inline double ElapsedSeconds() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start_)
+        .count();
+  }
+
+private:
+  std::chrono::steady_clock::time_point start_;
+};
+
+// run fn(thread_itr) on num_threads threads and return elapsed seconds
+template <typename Function>
+double RunParallel(uint64_t num_threads, Function fn) {
+  std::vector<std::thread> thread_group;
+  Timer timer;
+  for (uint64_t thread_itr = 0; thread_itr < num_threads; ++thread_itr) {
+    thread_group.push_back(std::thread(fn, thread_itr));
+  }
+  for (auto &thread : thread_group) {
+    thread.join();
+  }
+  return timer.ElapsedSeconds();
+}
+
+// print one result row: <name> <threads> <ops> <seconds> <Mops/s>
+inline void PrintResult(const std::string &name, uint64_t num_threads,
+                        uint64_t ops, double seconds) {
+  std::printf("%-40s threads=%-3llu ops=%-10llu %8.3fs %10.3f Mops/s\n",
+              name.c_str(), (unsigned long long)num_threads,
+              (unsigned long long)ops, seconds, ops / seconds / 1e6);
+}
+
+} // namespace scudb
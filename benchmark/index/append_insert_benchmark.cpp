@@ -0,0 +1,98 @@
+/**
+ * append_insert_benchmark.cpp
+ *
+ * Inserts of auto-incrementing keys, the common case of a BIGINT primary
+ * key. Threads draw the next key from a shared counter, so the keys arrive in
+ * nearly ascending order and almost every insert goes to the end of the last
+ * leaf. Shuffled keys are the baseline. Every run reports the insert rate and
+ * the final leaf fill, the entries per leaf against what a leaf holds when it
+ * is packed by a bulk load.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <random>
+
+#include "benchmark_util.h"
+#include "index/b_plus_tree.h"
+#include "index/integer_key.h"
+#include "vtable/virtual_table.h"
+
+namespace scudb {
+
+typedef BPlusTree<IntegerKey<int64_t>, RID, IntegerComparator<int64_t>> Tree;
+
+static const int64_t kNumKeys = 1 << 18;
+static const size_t kPoolSize = 4096;
+
+// entries per leaf of a bulk loaded tree, filled to the last byte
+static double PackedLeafEntries(IntegerComparator<int64_t> &comparator) {
+  DiskManager disk_manager("benchmark.db");
+  BufferPoolManager bpm(kPoolSize, &disk_manager);
+  page_id_t header_page_id;
+  bpm.NewPage(header_page_id);
+  Tree tree("bench_pk", &bpm, comparator);
+  std::vector<std::pair<IntegerKey<int64_t>, RID>> items(kNumKeys);
+  for (int64_t i = 0; i < kNumKeys; i++) {
+    items[i].first.SetFromInteger(i);
+    items[i].second = RID(0, (uint32_t)i);
+  }
+  tree.BulkLoad(items, 1.0);
+  BPlusTreeShape shape = tree.GetShape();
+  bpm.UnpinPage(header_page_id, true);
+  remove("benchmark.db");
+  return (double)shape.entries / shape.leaf_pages;
+}
+
+static void InsertBenchmark(IntegerComparator<int64_t> &comparator,
+                            bool sequential, uint64_t num_threads,
+                            double packed) {
+  DiskManager disk_manager("benchmark.db");
+  BufferPoolManager bpm(kPoolSize, &disk_manager);
+  page_id_t header_page_id;
+  bpm.NewPage(header_page_id);
+  Tree tree("bench_pk", &bpm, comparator);
+
+  std::vector<int64_t> keys(kNumKeys);
+  for (int64_t i = 0; i < kNumKeys; i++)
+    keys[i] = i;
+  if (!sequential)
+    std::shuffle(keys.begin(), keys.end(), std::default_random_engine(0));
+  std::atomic<int64_t> next(0);
+  double seconds = RunParallel(num_threads, [&](uint64_t tid) {
+    Transaction transaction(tid);
+    IntegerKey<int64_t> index_key;
+    for (int64_t i = next++; i < kNumKeys; i = next++) {
+      index_key.SetFromInteger(keys[i]);
+      tree.Insert(index_key, RID(0, (uint32_t)keys[i]), &transaction);
+    }
+  });
+  std::string label =
+      std::string("appendinsert/") + (sequential ? "sequential" : "random");
+  PrintResult(label, num_threads, kNumKeys, seconds);
+
+  BPlusTreeShape shape = tree.GetShape();
+  double entries = (double)shape.entries / shape.leaf_pages;
+  std::printf("%-40s entries=%lld leaves=%d leaf_fill=%.1f%% height=%d\n",
+              label.c_str(), (long long)shape.entries, shape.leaf_pages,
+              100.0 * entries / packed, shape.height);
+
+  bpm.UnpinPage(header_page_id, true);
+  remove("benchmark.db");
+}
+
+} // namespace scudb
+
+int main() {
+  using namespace scudb;
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  IntegerComparator<int64_t> comparator(key_schema);
+  double packed = PackedLeafEntries(comparator);
+  for (bool sequential : {true, false}) {
+    for (uint64_t threads : {1, 2, 4})
+      InsertBenchmark(comparator, sequential, threads, packed);
+  }
+  delete key_schema;
+  remove("benchmark.log");
+  return 0;
+}
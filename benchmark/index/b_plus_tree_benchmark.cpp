@@ -0,0 +1,236 @@
+/**
+ * b_plus_tree_benchmark.cpp
+ *
+ * Multi-threaded throughput of BPlusTree: concurrent inserts of disjoint key
+ * slices and a 90% lookup / 10% insert-or-remove mix over a prefilled tree.
+ * Writers that fit into their leaf only write latch the leaf, so the mix
+ * shows how much of the descent runs under shared latches. The build
+ * benchmark compares one by one inserts of unsorted keys with sorting them
+ * and loading the tree bottom-up. The shape benchmark reports height, leaf
+ * occupancy and internal fan-out for integer and varchar keys.
+ */
+
+#include <algorithm>
+#include <random>
+
+#include "benchmark_util.h"
+#include "index/b_plus_tree.h"
+#include "index/integer_key.h"
+#include "vtable/virtual_table.h"
+
+namespace scudb {
+
+typedef BPlusTree<GenericKey<8>, RID, GenericComparator<8>> Tree;
+
+static const int64_t kNumKeys = 1 << 16;
+static const uint64_t kOpsPerThread = 1 << 17;
+static const size_t kPoolSize = 4096;
+
+static std::vector<int64_t> ShuffledKeys(int64_t n) {
+  std::vector<int64_t> keys;
+  for (int64_t i = 0; i < n; i++)
+    keys.push_back(i);
+  std::shuffle(keys.begin(), keys.end(), std::default_random_engine(0));
+  return keys;
+}
+
+static void Insert(Tree &tree, int64_t key, Transaction *transaction) {
+  GenericKey<8> index_key;
+  index_key.SetFromInteger(key);
+  tree.Insert(index_key, RID(0, (uint32_t)key), transaction);
+}
+
+// every thread inserts its own slice of keys into an empty tree
+static void InsertBenchmark(GenericComparator<8> &comparator,
+                            const std::vector<int64_t> &keys,
+                            uint64_t num_threads) {
+  DiskManager disk_manager("benchmark.db");
+  BufferPoolManager bpm(kPoolSize, &disk_manager);
+  page_id_t header_page_id;
+  bpm.NewPage(header_page_id);
+  Tree tree("bench_pk", &bpm, comparator);
+
+  double seconds = RunParallel(num_threads, [&](uint64_t tid) {
+    Transaction transaction(tid);
+    for (uint64_t i = tid; i < keys.size(); i += num_threads)
+      Insert(tree, keys[i], &transaction);
+  });
+  PrintResult("bplustree/insert", num_threads, keys.size(), seconds);
+
+  bpm.UnpinPage(header_page_id, true);
+  remove("benchmark.db");
+}
+
+// 90% lookups, 5% inserts and 5% removes over a tree holding half the keys
+static void MixedBenchmark(GenericComparator<8> &comparator,
+                           const std::vector<int64_t> &keys,
+                           uint64_t num_threads) {
+  DiskManager disk_manager("benchmark.db");
+  BufferPoolManager bpm(kPoolSize, &disk_manager);
+  page_id_t header_page_id;
+  bpm.NewPage(header_page_id);
+  Tree tree("bench_pk", &bpm, comparator);
+  for (uint64_t i = 0; i < keys.size(); i += 2)
+    Insert(tree, keys[i], nullptr);
+
+  double seconds = RunParallel(num_threads, [&](uint64_t tid) {
+    Transaction transaction(tid);
+    std::default_random_engine engine(tid);
+    std::uniform_int_distribution<size_t> pick(0, keys.size() - 1);
+    GenericKey<8> index_key;
+    std::vector<RID> result;
+    for (uint64_t i = 0; i < kOpsPerThread; i++) {
+      int64_t key = keys[pick(engine)];
+      index_key.SetFromInteger(key);
+      if (i % 20 == 0) {
+        tree.Insert(index_key, RID(0, (uint32_t)key), &transaction);
+      } else if (i % 20 == 10) {
+        tree.Remove(index_key, &transaction);
+      } else {
+        result.clear();
+        tree.GetValue(index_key, result, &transaction);
+      }
+    }
+  });
+  PrintResult("bplustree/mixed", num_threads, kOpsPerThread * num_threads,
+              seconds);
+
+  bpm.UnpinPage(header_page_id, true);
+  remove("benchmark.db");
+}
+
+// build a tree over unsorted keys with a pool much smaller than the tree
+static void BuildBenchmark(GenericComparator<8> &comparator,
+                           const std::vector<int64_t> &keys, bool bulk_load) {
+  DiskManager disk_manager("benchmark.db");
+  BufferPoolManager bpm(64, &disk_manager);
+  page_id_t header_page_id;
+  bpm.NewPage(header_page_id);
+  Tree tree("bench_pk", &bpm, comparator);
+
+  Timer timer;
+  if (bulk_load) {
+    std::vector<std::pair<GenericKey<8>, RID>> items;
+    for (auto key : keys) {
+      GenericKey<8> index_key;
+      index_key.SetFromInteger(key);
+      items.emplace_back(index_key, RID(0, (uint32_t)key));
+    }
+    std::sort(items.begin(), items.end(),
+              [&](const std::pair<GenericKey<8>, RID> &a,
+                  const std::pair<GenericKey<8>, RID> &b) {
+                return comparator(a.first, b.first) < 0;
+              });
+    tree.BulkLoad(items, 0.9);
+  } else {
+    for (auto key : keys)
+      Insert(tree, key, nullptr);
+  }
+  PrintResult(bulk_load ? "bplustree/build/bulkload" : "bplustree/build/insert",
+              1, keys.size(), timer.ElapsedSeconds());
+
+  bpm.UnpinPage(header_page_id, true);
+  remove("benchmark.db");
+}
+
+// build a tree over key_schema from tuples in the given (shuffled) order and
+// report its shape
+template <typename KeyType, typename KeyComparator>
+static void ShapeBenchmark(const std::string &name, Schema *key_schema,
+                           const std::vector<Tuple> &tuples, bool bulk_load) {
+  typedef std::pair<KeyType, RID> Item;
+  DiskManager disk_manager("benchmark.db");
+  BufferPoolManager bpm(kPoolSize, &disk_manager);
+  page_id_t header_page_id;
+  bpm.NewPage(header_page_id);
+  KeyComparator comparator(key_schema);
+  BPlusTree<KeyType, RID, KeyComparator> tree("bench_pk", &bpm, comparator);
+
+  std::vector<Item> items;
+  for (size_t i = 0; i < tuples.size(); i++) {
+    KeyType index_key;
+    index_key.SetFromKey(tuples[i], key_schema);
+    items.emplace_back(index_key, RID(0, (uint32_t)i));
+  }
+  if (bulk_load) {
+    std::sort(items.begin(), items.end(), [&](const Item &a, const Item &b) {
+      return comparator(a.first, b.first) < 0;
+    });
+    tree.BulkLoad(items, 0.9);
+  } else {
+    for (auto &item : items)
+      tree.Insert(item.first, item.second);
+  }
+
+  BPlusTreeShape shape = tree.GetShape();
+  std::printf("%-40s height=%d leaves=%-6d internals=%-4d leaf_fill=%-6.1f "
+              "fanout=%.1f\n",
+              (name + (bulk_load ? "/bulkload" : "/insert")).c_str(),
+              shape.height, shape.leaf_pages, shape.internal_pages,
+              (double)shape.entries / shape.leaf_pages,
+              shape.internal_pages
+                  ? (double)shape.children / shape.internal_pages
+                  : 0.0);
+
+  bpm.UnpinPage(header_page_id, true);
+  remove("benchmark.db");
+}
+
+static std::vector<Tuple> MakeTuples(Schema *schema,
+                                     const std::vector<int64_t> &keys,
+                                     const char *format) {
+  std::vector<Tuple> tuples;
+  for (auto key : keys) {
+    std::vector<Value> values;
+    if (format == nullptr) {
+      values.push_back(Value(TypeId::BIGINT, key));
+    } else {
+      char buffer[64];
+      snprintf(buffer, sizeof(buffer), format, (long long)key);
+      values.push_back(Value(TypeId::VARCHAR, std::string(buffer)));
+    }
+    tuples.emplace_back(values, schema);
+  }
+  return tuples;
+}
+
+static void ShapeBenchmarks(const std::vector<int64_t> &keys) {
+  Schema *bigint_schema = ParseCreateStatement("a bigint");
+  Schema *varchar_schema = ParseCreateStatement("a varchar(64)");
+  std::vector<Tuple> bigints = MakeTuples(bigint_schema, keys, nullptr);
+  std::vector<Tuple> emails =
+      MakeTuples(varchar_schema, keys, "user%08lld@example.com");
+  std::vector<Tuple> paths = MakeTuples(
+      varchar_schema, keys, "customer/region-eu/account-%010lld/primary");
+  for (bool bulk_load : {false, true}) {
+    ShapeBenchmark<IntegerKey<int64_t>, IntegerComparator<int64_t>>(
+        "bplustree/shape/integer", bigint_schema, bigints, bulk_load);
+    ShapeBenchmark<GenericKey<8>, GenericComparator<8>>(
+        "bplustree/shape/bigint", bigint_schema, bigints, bulk_load);
+    ShapeBenchmark<GenericKey<32>, GenericComparator<32>>(
+        "bplustree/shape/varchar32", varchar_schema, emails, bulk_load);
+    ShapeBenchmark<GenericKey<64>, GenericComparator<64>>(
+        "bplustree/shape/varchar64", varchar_schema, paths, bulk_load);
+  }
+  delete bigint_schema;
+  delete varchar_schema;
+}
+
+} // namespace scudb
+
+int main() {
+  using namespace scudb;
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+  std::vector<int64_t> keys = ShuffledKeys(kNumKeys);
+  for (uint64_t threads : {1, 2, 4, 8}) {
+    InsertBenchmark(comparator, keys, threads);
+    MixedBenchmark(comparator, keys, threads);
+  }
+  BuildBenchmark(comparator, keys, false);
+  BuildBenchmark(comparator, keys, true);
+  ShapeBenchmarks(keys);
+  delete key_schema;
+  remove("benchmark.log");
+  return 0;
+}
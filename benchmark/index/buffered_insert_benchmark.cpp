@@ -0,0 +1,85 @@
+/**
+ * buffered_insert_benchmark.cpp
+ *
+ * Inserts of random keys into a B+ tree many times larger than the buffer
+ * pool, so nearly every insert reads its leaf from disk and writes back a
+ * dirty page to make room. The buffered rows turn on the write_buffer tree
+ * option: inserts wait in the buffer and reach the leaves in key order
+ * batches, one descent per leaf. Every run reports the insert rate, including
+ * the final flush, and the rate of point lookups of random keys afterwards.
+ */
+
+#include <algorithm>
+#include <random>
+
+#include "benchmark_util.h"
+#include "index/b_plus_tree.h"
+#include "index/integer_key.h"
+#include "vtable/virtual_table.h"
+
+namespace scudb {
+
+typedef BPlusTree<IntegerKey<int64_t>, RID, IntegerComparator<int64_t>> Tree;
+
+static const int64_t kNumKeys = 1 << 18;
+static const uint64_t kNumLookups = 1 << 16;
+
+static void BufferedInsertBenchmark(size_t pool_size, bool buffered) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  IntegerComparator<int64_t> comparator(key_schema);
+  std::string label = std::string(buffered ? "buffered" : "unbuffered") +
+                      "/pool=" + std::to_string(pool_size);
+  {
+    DiskManager disk_manager("benchmark.db");
+    BufferPoolManager bpm(pool_size, &disk_manager);
+    page_id_t header_page_id;
+    bpm.NewPage(header_page_id);
+    BPlusTreeOptions options;
+    options.write_buffer = buffered;
+    Tree tree("bench_pk", &bpm, comparator, INVALID_PAGE_ID, options);
+
+    std::vector<int64_t> keys;
+    for (int64_t i = 0; i < kNumKeys; i++)
+      keys.push_back(i);
+    std::shuffle(keys.begin(), keys.end(), std::default_random_engine(0));
+    Transaction transaction(0);
+    IntegerKey<int64_t> index_key;
+    Timer timer;
+    for (auto key : keys) {
+      index_key.SetFromInteger(key);
+      tree.Insert(index_key, RID(0, (uint32_t)key), &transaction);
+    }
+    // the shape walk applies what is still buffered
+    BPlusTreeShape shape = tree.GetShape();
+    PrintResult(label + "/insert", 1, kNumKeys, timer.ElapsedSeconds());
+    if (shape.entries != kNumKeys)
+      std::printf("%-40s unexpected entry count %lld\n", label.c_str(),
+                  (long long)shape.entries);
+
+    std::default_random_engine engine(1);
+    std::uniform_int_distribution<int64_t> pick(0, kNumKeys - 1);
+    std::vector<RID> result;
+    timer.Reset();
+    for (uint64_t i = 0; i < kNumLookups; i++) {
+      index_key.SetFromInteger(pick(engine));
+      result.clear();
+      tree.GetValue(index_key, result);
+    }
+    PrintResult(label + "/lookup", 1, kNumLookups, timer.ElapsedSeconds());
+    bpm.UnpinPage(header_page_id, true);
+  }
+  delete key_schema;
+  remove("benchmark.db");
+  remove("benchmark.log");
+}
+
+} // namespace scudb
+
+int main() {
+  using namespace scudb;
+  for (size_t pool_size : {64, 1024}) {
+    for (bool buffered : {false, true})
+      BufferedInsertBenchmark(pool_size, buffered);
+  }
+  return 0;
+}
@@ -0,0 +1,102 @@
+/**
+ * deferred_merge_benchmark.cpp
+ *
+ * Insert/delete churn on a B+ tree whose leaves are about half full, where a
+ * remove is likely to make its leaf underflow and the next insert into the
+ * merged leaf to split it again. Each round removes a random batch of keys
+ * and inserts them again. The delete phase then removes three keys of four.
+ * The deferred rows turn on the deferred_merge tree option, which leaves
+ * underfull leaves to the compaction thread of the tree; the final compaction
+ * of what is left over is timed separately.
+ */
+
+#include <algorithm>
+#include <random>
+
+#include "benchmark_util.h"
+#include "index/b_plus_tree.h"
+#include "index/integer_key.h"
+#include "vtable/virtual_table.h"
+
+namespace scudb {
+
+typedef BPlusTree<IntegerKey<int64_t>, RID, IntegerComparator<int64_t>> Tree;
+
+static const int64_t kNumKeys = 1 << 16;
+static const int kNumRounds = 16;
+static const size_t kBatchSize = 4096;
+static const size_t kPoolSize = 4096;
+
+static void DeferredMergeBenchmark(bool deferred) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  IntegerComparator<int64_t> comparator(key_schema);
+  std::string label = deferred ? "deferred" : "immediate";
+  DiskManager disk_manager("benchmark.db");
+  BufferPoolManager bpm(kPoolSize, &disk_manager);
+  page_id_t header_page_id;
+  bpm.NewPage(header_page_id);
+  {
+    BPlusTreeOptions options;
+    options.deferred_merge = deferred;
+    Tree tree("bench_pk", &bpm, comparator, INVALID_PAGE_ID, options);
+    IntegerKey<int64_t> index_key;
+    // descending inserts split every leaf in half and leave it so
+    std::vector<int64_t> keys;
+    for (int64_t key = kNumKeys - 1; key >= 0; key--) {
+      index_key.SetFromInteger(key);
+      tree.Insert(index_key, RID(0, (uint32_t)key));
+      keys.push_back(key);
+    }
+
+    std::default_random_engine engine(0);
+    Timer timer;
+    for (int round = 0; round < kNumRounds; round++) {
+      std::shuffle(keys.begin(), keys.end(), engine);
+      for (size_t i = 0; i < kBatchSize; i++) {
+        index_key.SetFromInteger(keys[i]);
+        tree.Remove(index_key);
+      }
+      for (size_t i = 0; i < kBatchSize; i++) {
+        index_key.SetFromInteger(keys[i]);
+        tree.Insert(index_key, RID(0, (uint32_t)keys[i]));
+      }
+    }
+    PrintResult(label + "/churn", 1, 2 * kNumRounds * kBatchSize,
+                timer.ElapsedSeconds());
+
+    std::shuffle(keys.begin(), keys.end(), engine);
+    timer.Reset();
+    for (size_t i = 0; i < keys.size(); i++) {
+      if (i % 4 != 0) {
+        index_key.SetFromInteger(keys[i]);
+        tree.Remove(index_key);
+      }
+    }
+    PrintResult(label + "/delete", 1, keys.size() - keys.size() / 4,
+                timer.ElapsedSeconds());
+    timer.Reset();
+    size_t freed = tree.Compact();
+    std::printf("%-40s %.3fs, %zu pages freed\n", (label + "/compact").c_str(),
+                timer.ElapsedSeconds(), freed);
+
+    int64_t entries = 0;
+    for (auto iterator = tree.Begin(); !iterator.isEnd(); ++iterator)
+      entries++;
+    if (entries != kNumKeys / 4)
+      std::printf("%-40s unexpected entry count %lld\n", label.c_str(),
+                  (long long)entries);
+  }
+  bpm.UnpinPage(header_page_id, true);
+  delete key_schema;
+  remove("benchmark.db");
+  remove("benchmark.log");
+}
+
+} // namespace scudb
+
+int main() {
+  using namespace scudb;
+  DeferredMergeBenchmark(false);
+  DeferredMergeBenchmark(true);
+  return 0;
+}
@@ -0,0 +1,130 @@
+/**
+ * in_memory_index_benchmark.cpp
+ *
+ * The in-memory adaptive radix tree index against the B+ tree index for a
+ * table that fits in memory: the buffer pool holds every page of the tree.
+ * Both are driven through the Index interface the way VtabFilter drives
+ * them, with point lookups and short range scans over random keys. The B+
+ * tree is measured with the generic key and, for the BIGINT column, with the
+ * native integer key ConstructIndex picks.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+
+#include "benchmark_util.h"
+#include "index/art_index.h"
+#include "index/b_plus_tree_index.h"
+#include "vtable/virtual_table.h"
+
+namespace scudb {
+
+static const int64_t kNumKeys = 1 << 15;
+static const uint64_t kNumLookups = 1 << 18;
+static const uint64_t kNumScans = 1 << 15;
+static const int64_t kScanLength = 16;
+static const size_t kPoolSize = 8192;
+
+template <typename IndexClass>
+static Index *MakeIndex(IndexMetadata *metadata, BufferPoolManager *bpm) {
+  return new IndexClass(metadata, bpm);
+}
+
+template <>
+Index *MakeIndex<ArtIndex>(IndexMetadata *metadata, BufferPoolManager *bpm) {
+  return new ArtIndex(metadata);
+}
+
+// key tuple of the i-th key, zero padded so varchars sort like the numbers
+static Tuple MakeKey(int64_t i, Schema *schema) {
+  if (schema->GetType(0) == TypeId::VARCHAR) {
+    char key[17];
+    std::snprintf(key, sizeof(key), "key%013lld", (long long)i);
+    return Tuple({Value(TypeId::VARCHAR, std::string(key))}, schema);
+  }
+  return Tuple({Value(TypeId::BIGINT, i)}, schema);
+}
+
+template <typename IndexClass>
+static void InMemoryIndexBenchmark(const std::string &name,
+                                   const std::string &column) {
+  DiskManager disk_manager("benchmark.db");
+  BufferPoolManager bpm(kPoolSize, &disk_manager);
+  // create header_page
+  page_id_t header_page_id;
+  bpm.NewPage(header_page_id);
+
+  Schema *schema = ParseCreateStatement(column);
+  Index *index =
+      MakeIndex<IndexClass>(new IndexMetadata("bench_pk", "bench", schema, {0}),
+                            &bpm);
+  Schema *key_schema = index->GetKeySchema();
+
+  std::vector<int64_t> keys;
+  for (int64_t i = 0; i < kNumKeys; i++)
+    keys.push_back(i);
+  std::shuffle(keys.begin(), keys.end(), std::default_random_engine(0));
+  Timer timer;
+  for (auto key : keys)
+    index->InsertEntry(MakeKey(key, key_schema), RID(0, (uint32_t)key));
+  PrintResult(name + "/insert", 1, kNumKeys, timer.ElapsedSeconds());
+
+  std::default_random_engine engine(1);
+  std::uniform_int_distribution<int64_t> pick(0, kNumKeys - 1);
+  std::vector<Tuple> probes;
+  for (uint64_t i = 0; i < kNumLookups; i++)
+    probes.push_back(MakeKey(pick(engine), key_schema));
+  std::vector<RID> result;
+  timer.Reset();
+  for (auto &probe : probes) {
+    result.clear();
+    index->ScanKey(probe, result);
+  }
+  PrintResult(name + "/point", 1, kNumLookups, timer.ElapsedSeconds());
+
+  std::uniform_int_distribution<int64_t> pick_low(0, kNumKeys - kScanLength);
+  std::vector<std::pair<Tuple, Tuple>> ranges;
+  for (uint64_t i = 0; i < kNumScans; i++) {
+    int64_t low = pick_low(engine);
+    ranges.emplace_back(MakeKey(low, key_schema),
+                        MakeKey(low + kScanLength - 1, key_schema));
+  }
+  uint64_t rows = 0;
+  timer.Reset();
+  for (auto &range : ranges) {
+    result.clear();
+    index->ScanRange(&range.first, &range.second, false, result);
+    rows += result.size();
+  }
+  PrintResult(name + "/range/length=" + std::to_string(kScanLength), 1,
+              kNumScans, timer.ElapsedSeconds());
+  if (rows != kNumScans * kScanLength)
+    std::printf("%-40s unexpected row count %llu\n", name.c_str(),
+                (unsigned long long)rows);
+
+  delete index;
+  delete schema;
+  bpm.UnpinPage(header_page_id, true);
+}
+
+} // namespace scudb
+
+int main() {
+  using namespace scudb;
+  typedef GenericKey<8> Key;
+  typedef GenericComparator<8> Comparator;
+  InMemoryIndexBenchmark<BPlusTreeIndex<Key, RID, Comparator>>("bplustree",
+                                                               "a bigint");
+  InMemoryIndexBenchmark<BPlusTreeIndex<IntegerKey<int64_t>, RID,
+                                        IntegerComparator<int64_t>>>(
+      "bplustree/integer", "a bigint");
+  InMemoryIndexBenchmark<ArtIndex>("art", "a bigint");
+  InMemoryIndexBenchmark<BPlusTreeIndex<GenericKey<32>, RID,
+                                        GenericComparator<32>>>(
+      "bplustree/varchar", "a varchar(16)");
+  InMemoryIndexBenchmark<ArtIndex>("art/varchar", "a varchar(16)");
+  remove("benchmark.db");
+  remove("benchmark.log");
+  return 0;
+}
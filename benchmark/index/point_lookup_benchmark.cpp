@@ -0,0 +1,183 @@
+/**
+ * point_lookup_benchmark.cpp
+ *
+ * Point lookups through the Index interface, the path VtabFilter takes for an
+ * equality predicate, for the extendible hash index and the B+ tree index.
+ * The B+ tree is measured with the generic key and with the native integer
+ * key ConstructIndex picks for a single BIGINT column. Every index is
+ * measured with a buffer pool that holds all of its pages and with one that
+ * forces evictions. The key search rows isolate the comparator: a binary
+ * search over one leaf worth of keys, as done on every level of a lookup.
+ * The batch rows hand the same probes to ScanKeys, the way an IN list or a
+ * join would, in batches of a few and of many keys per call. The probes are
+ * a small hot set, the adaptive rows repeat the B+ tree lookups with the
+ * adaptive hash index serving them. The bloom rows give the B+ tree index a
+ * Bloom filter, which answers the probes that miss, and report its false
+ * positive rate and the mean lookup latency.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+
+#include "benchmark_util.h"
+#include "index/b_plus_tree_index.h"
+#include "index/extendible_hash_table_index.h"
+#include "vtable/virtual_table.h"
+
+namespace scudb {
+
+static const int64_t kNumKeys = 1 << 14;
+static const uint64_t kNumLookups = 1 << 18;
+
+template <typename IndexClass>
+static void PrintLookupStats(const std::string &label, IndexClass &index) {}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+static void
+PrintLookupStats(const std::string &label,
+                 BPlusTreeIndex<KeyType, ValueType, KeyComparator> &index) {
+  // only lookups through a Bloom filter are counted
+  if (!index.GetMetadata()->HasBloomFilter())
+    return;
+  IndexLookupStats stats = index.GetLookupStats();
+  std::printf("%-40s misses=%llu false_positive_rate=%.4f latency=%.3fus\n",
+              label.c_str(), (unsigned long long)stats.misses,
+              stats.FalsePositiveRate(), stats.MeanLatencyMicros());
+}
+
+template <typename IndexClass>
+static void PointLookupBenchmark(const std::string &name, size_t pool_size,
+                                 bool bloom = false,
+                                 const BPlusTreeOptions &options =
+                                     BPlusTreeOptions()) {
+  DiskManager disk_manager("benchmark.db");
+  BufferPoolManager bpm(pool_size, &disk_manager);
+  // create header_page
+  page_id_t header_page_id;
+  bpm.NewPage(header_page_id);
+
+  Schema *schema = ParseCreateStatement("a bigint");
+  IndexClass index(new IndexMetadata("bench_pk", "bench", schema, {0},
+                                     IndexType::BPlusTreeIndex, true, {},
+                                     bloom, options),
+                   &bpm);
+
+  std::vector<Tuple> keys;
+  for (int64_t i = 0; i < kNumKeys; i++)
+    keys.emplace_back(std::vector<Value>{Value(TypeId::BIGINT, i)}, schema);
+  std::vector<int64_t> order(kNumKeys);
+  for (int64_t i = 0; i < kNumKeys; i++)
+    order[i] = i;
+  std::shuffle(order.begin(), order.end(), std::default_random_engine(0));
+
+  std::string label = name + "/pool=" + std::to_string(pool_size);
+  Timer timer;
+  for (auto i : order)
+    index.InsertEntry(keys[i], RID(0, (uint32_t)i));
+  PrintResult(label + "/insert", 1, kNumKeys, timer.ElapsedSeconds());
+
+  // half of the probes miss: keys past the end of the inserted range
+  std::default_random_engine engine(1);
+  std::uniform_int_distribution<int64_t> pick(0, 2 * kNumKeys - 1);
+  std::vector<Tuple> probes;
+  for (int i = 0; i < 1024; i++)
+    probes.emplace_back(std::vector<Value>{Value(TypeId::BIGINT, pick(engine))},
+                        schema);
+  std::vector<RID> result;
+  uint64_t hits = 0;
+  timer.Reset();
+  for (uint64_t i = 0; i < kNumLookups; i++) {
+    result.clear();
+    index.ScanKey(probes[i % probes.size()], result);
+    hits += result.size();
+  }
+  double seconds = timer.ElapsedSeconds();
+  PrintResult(label + "/lookup", 1, kNumLookups, seconds);
+  std::printf("%-40s hits=%llu\n", (label + "/lookup").c_str(),
+              (unsigned long long)hits);
+  PrintLookupStats(label + "/lookup", index);
+
+  for (size_t batch_size : {16, 256}) {
+    std::vector<std::vector<Tuple>> batches;
+    for (size_t i = 0; i < probes.size(); i += batch_size)
+      batches.emplace_back(probes.begin() + i,
+                           probes.begin() + i + batch_size);
+    std::string batch_label = label + "/batch=" + std::to_string(batch_size);
+    uint64_t batch_hits = 0;
+    timer.Reset();
+    for (uint64_t i = 0; i < kNumLookups / batch_size; i++) {
+      result.clear();
+      index.ScanKeys(batches[i % batches.size()], result);
+      batch_hits += result.size();
+    }
+    PrintResult(batch_label, 1, kNumLookups, timer.ElapsedSeconds());
+    std::printf("%-40s hits=%llu\n", batch_label.c_str(),
+                (unsigned long long)batch_hits);
+  }
+
+  bpm.UnpinPage(header_page_id, true);
+  delete schema;
+  remove("benchmark.db");
+  remove("benchmark.log");
+}
+
+// lower_bound over a sorted array of keys the size of a leaf
+template <typename KeyType, typename KeyComparator>
+static void KeySearchBenchmark(const std::string &name) {
+  Schema *schema = ParseCreateStatement("a bigint");
+  KeyComparator comparator(schema);
+  std::vector<KeyType> keys(32);
+  for (size_t i = 0; i < keys.size(); i++)
+    keys[i].SetFromInteger(2 * i);
+  std::vector<KeyType> probes(1024);
+  std::default_random_engine engine(1);
+  std::uniform_int_distribution<int64_t> pick(0, 2 * keys.size() - 1);
+  for (auto &probe : probes)
+    probe.SetFromInteger(pick(engine));
+
+  uint64_t sum = 0;
+  Timer timer;
+  for (uint64_t i = 0; i < kNumLookups; i++) {
+    sum += std::lower_bound(keys.begin(), keys.end(), probes[i % probes.size()],
+                            [&](const KeyType &a, const KeyType &b) {
+                              return comparator(a, b) < 0;
+                            }) -
+           keys.begin();
+  }
+  PrintResult(name + "/keysearch", 1, kNumLookups, timer.ElapsedSeconds());
+  std::printf("%-40s sum=%llu\n", (name + "/keysearch").c_str(),
+              (unsigned long long)sum);
+  delete schema;
+}
+
+} // namespace scudb
+
+int main() {
+  using namespace scudb;
+  typedef GenericKey<8> Key;
+  typedef GenericComparator<8> Comparator;
+  for (size_t pool_size : {4096, 64}) {
+    PointLookupBenchmark<ExtendibleHashTableIndex<Key, RID, Comparator>>(
+        "hash", pool_size);
+    for (bool adaptive : {false, true}) {
+      BPlusTreeOptions options;
+      options.adaptive_hash = adaptive;
+      std::string name = adaptive ? "bplustree/adaptive" : "bplustree";
+      PointLookupBenchmark<BPlusTreeIndex<Key, RID, Comparator>>(
+          name, pool_size, false, options);
+      PointLookupBenchmark<BPlusTreeIndex<IntegerKey<int64_t>, RID,
+                                          IntegerComparator<int64_t>>>(
+          name + "/integer", pool_size, false, options);
+    }
+    PointLookupBenchmark<BPlusTreeIndex<Key, RID, Comparator>>(
+        "bplustree/bloom", pool_size, true);
+    PointLookupBenchmark<BPlusTreeIndex<IntegerKey<int64_t>, RID,
+                                        IntegerComparator<int64_t>>>(
+        "bplustree/bloom/integer", pool_size, true);
+  }
+  KeySearchBenchmark<Key, Comparator>("generic");
+  KeySearchBenchmark<IntegerKey<int64_t>, IntegerComparator<int64_t>>(
+      "integer");
+  return 0;
+}
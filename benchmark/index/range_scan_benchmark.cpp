@@ -0,0 +1,106 @@
+/**
+ * range_scan_benchmark.cpp
+ *
+ * Long range scans through BPlusTree::Begin(key, end_key) over a tree that is
+ * much larger than the buffer pool. Keys are inserted in random order, so
+ * neighbouring leaves are scattered over the file and the OS read-ahead does
+ * not help. Before every run the db file is dropped from the OS cache and
+ * the scans are repeated with leaf prefetching off and on.
+ */
+
+#include <algorithm>
+#include <fcntl.h>
+#include <random>
+#include <unistd.h>
+
+#include "benchmark_util.h"
+#include "index/b_plus_tree.h"
+#include "index/integer_key.h"
+#include "vtable/virtual_table.h"
+
+namespace scudb {
+
+typedef BPlusTree<IntegerKey<int64_t>, RID, IntegerComparator<int64_t>> Tree;
+
+static const int64_t kNumKeys = 1 << 20;
+// every run reads a sixteenth of the keys, so the file stays mostly uncached
+static const int64_t kRowsPerRun = kNumKeys / 16;
+static const size_t kPoolSize = 32;
+
+// write back and evict the db file from the OS cache
+static void DropFileCache(const char *file_name) {
+  int fd = open(file_name, O_RDONLY);
+  if (fd < 0)
+    return;
+  fdatasync(fd);
+  posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  close(fd);
+}
+
+static void ScanBenchmark(Tree &tree, int64_t length, bool prefetch) {
+  ENABLE_PREFETCH = prefetch;
+  DropFileCache("benchmark.db");
+
+  std::default_random_engine engine(0);
+  std::uniform_int_distribution<int64_t> pick(0, kNumKeys - length);
+  IntegerKey<int64_t> low_key, high_key;
+  int64_t num_scans = kRowsPerRun / length;
+  uint64_t rows = 0, sum = 0;
+  Timer timer;
+  for (int64_t i = 0; i < num_scans; i++) {
+    int64_t low = pick(engine);
+    low_key.SetFromInteger(low);
+    high_key.SetFromInteger(low + length - 1);
+    for (auto iterator = tree.Begin(low_key, high_key); !iterator.isEnd();
+         ++iterator) {
+      sum += (*iterator).second.GetSlotNum();
+      rows++;
+    }
+  }
+  double seconds = timer.ElapsedSeconds();
+  std::string label = "rangescan/length=" + std::to_string(length) +
+                      (prefetch ? "/prefetch" : "/no-prefetch");
+  PrintResult(label, 1, rows, seconds);
+  if (rows != (uint64_t)(num_scans * length))
+    std::printf("%-40s unexpected row count %llu (sum %llu)\n", label.c_str(),
+                (unsigned long long)rows, (unsigned long long)sum);
+}
+
+} // namespace scudb
+
+int main() {
+  using namespace scudb;
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  IntegerComparator<int64_t> comparator(key_schema);
+  {
+    DiskManager disk_manager("benchmark.db");
+    BufferPoolManager bpm(kPoolSize, &disk_manager);
+    page_id_t header_page_id;
+    bpm.NewPage(header_page_id);
+    Tree tree("bench_pk", &bpm, comparator);
+
+    std::vector<int64_t> keys;
+    for (int64_t i = 0; i < kNumKeys; i++)
+      keys.push_back(i);
+    std::shuffle(keys.begin(), keys.end(), std::default_random_engine(0));
+    Transaction transaction(0);
+    IntegerKey<int64_t> index_key;
+    for (auto key : keys) {
+      index_key.SetFromInteger(key);
+      tree.Insert(index_key, RID(0, (uint32_t)key), &transaction);
+    }
+    BPlusTreeShape shape = tree.GetShape();
+    std::printf("%-40s height=%d leaves=%d\n", "rangescan/tree", shape.height,
+                shape.leaf_pages);
+
+    for (int64_t length : {1 << 10, 1 << 13, 1 << 16}) {
+      for (bool prefetch : {false, true})
+        ScanBenchmark(tree, length, prefetch);
+    }
+    bpm.UnpinPage(header_page_id, true);
+  }
+  delete key_schema;
+  remove("benchmark.db");
+  remove("benchmark.log");
+  return 0;
+}
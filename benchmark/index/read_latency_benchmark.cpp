@@ -0,0 +1,137 @@
+/**
+ * read_latency_benchmark.cpp
+ *
+ * Tail latency of BPlusTree point lookups while writers insert and remove
+ * bursts of keys. Readers time every GetValue over a prefilled tree, first on
+ * a quiet tree and then while writer threads keep splitting leaves and
+ * internal pages under them and merging them away again. Readers only ever
+ * hold one latch, so a lookup that lands on a page a writer is splitting
+ * waits for that page alone, not for the writer's whole path.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <random>
+
+#include "benchmark_util.h"
+#include "index/b_plus_tree.h"
+#include "index/integer_key.h"
+#include "vtable/virtual_table.h"
+
+namespace scudb {
+
+typedef BPlusTree<GenericKey<8>, RID, GenericComparator<8>> Tree;
+
+static const int64_t kNumKeys = 1 << 16;
+static const uint64_t kLookupsPerThread = 1 << 18;
+static const size_t kBurstSize = 1 << 10;
+static const size_t kPoolSize = 4096;
+
+static double Percentile(std::vector<double> &latencies, double p) {
+  size_t index = (size_t)(p * (latencies.size() - 1));
+  return latencies[index];
+}
+
+// readers time lookups of the even keys while writers insert and remove the
+// odd keys in bursts of kBurstSize
+static void ReadLatencyBenchmark(GenericComparator<8> &comparator,
+                                 uint64_t num_readers, uint64_t num_writers) {
+  DiskManager disk_manager("benchmark.db");
+  BufferPoolManager bpm(kPoolSize, &disk_manager);
+  page_id_t header_page_id;
+  bpm.NewPage(header_page_id);
+  Tree tree("bench_pk", &bpm, comparator);
+
+  std::vector<int64_t> keys;
+  for (int64_t i = 0; i < kNumKeys; i++)
+    keys.push_back(i);
+  std::shuffle(keys.begin(), keys.end(), std::default_random_engine(0));
+  std::vector<int64_t> stable_keys, burst_keys;
+  for (auto key : keys)
+    (key % 2 == 0 ? stable_keys : burst_keys).push_back(key);
+  GenericKey<8> index_key;
+  for (auto key : stable_keys) {
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, RID(0, (uint32_t)key));
+  }
+
+  std::vector<std::vector<double>> latencies(num_readers);
+  std::atomic<uint64_t> readers_done(0);
+  std::atomic<uint64_t> misses(0);
+  std::atomic<uint64_t> writes(0);
+  double seconds = RunParallel(num_readers + num_writers, [&](uint64_t tid) {
+    GenericKey<8> key;
+    if (tid >= num_readers) {
+      // every writer inserts its slice of the odd keys burst by burst, then
+      // removes them again, until the readers are done
+      Transaction transaction(tid);
+      std::vector<int64_t> slice;
+      for (size_t i = tid - num_readers; i < burst_keys.size();
+           i += num_writers)
+        slice.push_back(burst_keys[i]);
+      bool insert = true;
+      while (readers_done.load() < num_readers) {
+        for (size_t begin = 0; begin < slice.size(); begin += kBurstSize) {
+          size_t end = std::min(begin + kBurstSize, slice.size());
+          for (size_t i = begin; i < end; i++) {
+            key.SetFromInteger(slice[i]);
+            if (insert)
+              tree.Insert(key, RID(0, (uint32_t)slice[i]), &transaction);
+            else
+              tree.Remove(key, &transaction);
+          }
+          writes += end - begin;
+          std::this_thread::yield();
+        }
+        insert = !insert;
+      }
+      return;
+    }
+    std::default_random_engine engine(tid);
+    std::uniform_int_distribution<size_t> pick(0, stable_keys.size() - 1);
+    std::vector<RID> result;
+    std::vector<double> &latency = latencies[tid];
+    latency.reserve(kLookupsPerThread);
+    for (uint64_t i = 0; i < kLookupsPerThread; i++) {
+      int64_t probe = stable_keys[pick(engine)];
+      key.SetFromInteger(probe);
+      result.clear();
+      Timer timer;
+      bool found = tree.GetValue(key, result);
+      latency.push_back(timer.ElapsedSeconds());
+      if (!found || result[0].GetSlotNum() != probe)
+        misses++;
+    }
+    readers_done++;
+  });
+
+  std::vector<double> all;
+  for (auto &latency : latencies)
+    all.insert(all.end(), latency.begin(), latency.end());
+  std::sort(all.begin(), all.end());
+  std::string label = "readlatency/writers=" + std::to_string(num_writers);
+  PrintResult(label, num_readers, all.size(), seconds);
+  std::printf("%-40s p50=%.2fus p99=%.2fus p999=%.2fus max=%.2fus "
+              "writes=%llu misses=%llu\n",
+              label.c_str(), Percentile(all, 0.5) * 1e6,
+              Percentile(all, 0.99) * 1e6, Percentile(all, 0.999) * 1e6,
+              all.back() * 1e6,
+              (unsigned long long)writes.load(),
+              (unsigned long long)misses.load());
+
+  bpm.UnpinPage(header_page_id, true);
+  remove("benchmark.db");
+}
+
+} // namespace scudb
+
+int main() {
+  using namespace scudb;
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+  for (uint64_t writers : {0, 1, 2})
+    ReadLatencyBenchmark(comparator, 2, writers);
+  delete key_schema;
+  remove("benchmark.log");
+  return 0;
+}
@@ -0,0 +1,97 @@
+/**
+ * swizzled_lookup_benchmark.cpp
+ *
+ * Point lookups of random keys in a B+ tree whose pages all fit in the buffer
+ * pool, so a lookup costs the descent alone: per level, the key search in the
+ * page and pinning the child. The swizzled rows turn on the swizzling tree
+ * option, which pins the children through the frame of their parent without
+ * the page table and the latch of the buffer pool manager. Both trees get the
+ * same keys and run the same probes, on 1 to 4 threads, after a warm up pass
+ * that swizzles the children a lookup reaches.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <random>
+
+#include "benchmark_util.h"
+#include "index/b_plus_tree.h"
+#include "index/integer_key.h"
+#include "vtable/virtual_table.h"
+
+namespace scudb {
+
+typedef BPlusTree<IntegerKey<int64_t>, RID, IntegerComparator<int64_t>> Tree;
+
+static const int64_t kNumKeys = 1 << 17;
+static const uint64_t kNumLookups = 1 << 20;
+static const size_t kPoolSize = 16384;
+
+static void SwizzledLookupBenchmark(bool swizzled) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  IntegerComparator<int64_t> comparator(key_schema);
+  std::string label = swizzled ? "swizzled" : "page table";
+  {
+    DiskManager disk_manager("benchmark.db");
+    BufferPoolManager bpm(kPoolSize, &disk_manager);
+    page_id_t header_page_id;
+    bpm.NewPage(header_page_id);
+    BPlusTreeOptions options;
+    options.swizzling = swizzled;
+    Tree tree("bench_pk", &bpm, comparator, INVALID_PAGE_ID, options);
+
+    std::vector<int64_t> keys;
+    for (int64_t i = 0; i < kNumKeys; i++)
+      keys.push_back(i);
+    std::shuffle(keys.begin(), keys.end(), std::default_random_engine(0));
+    IntegerKey<int64_t> index_key;
+    for (auto key : keys) {
+      index_key.SetFromInteger(key);
+      tree.Insert(index_key, RID(0, (uint32_t)key));
+    }
+    BPlusTreeShape shape = tree.GetShape();
+    std::printf("%-40s height %d, %d leaves\n", label.c_str(), shape.height,
+                shape.leaf_pages);
+
+    std::default_random_engine engine(1);
+    std::uniform_int_distribution<int64_t> pick(0, kNumKeys - 1);
+    std::vector<IntegerKey<int64_t>> probes(kNumLookups);
+    for (auto &probe : probes)
+      probe.SetFromInteger(pick(engine));
+    std::vector<RID> result;
+    for (auto key : keys) {
+      index_key.SetFromInteger(key);
+      result.clear();
+      tree.GetValue(index_key, result);
+    }
+    for (uint64_t threads : {1, 2, 4}) {
+      std::atomic<uint64_t> found(0);
+      double seconds = RunParallel(threads, [&](uint64_t tid) {
+        std::vector<RID> rids;
+        uint64_t hits = 0;
+        for (uint64_t i = tid; i < kNumLookups; i += threads) {
+          rids.clear();
+          hits += tree.GetValue(probes[i], rids);
+        }
+        found += hits;
+      });
+      PrintResult(label + "/lookup", threads, kNumLookups, seconds);
+      if (found != kNumLookups)
+        std::printf("%-40s unexpected hit count %llu\n", label.c_str(),
+                    (unsigned long long)found);
+    }
+    bpm.UnpinPage(header_page_id, true);
+  }
+  delete key_schema;
+  remove("benchmark.db");
+  remove("benchmark.log");
+}
+
+} // namespace scudb
+
+int main() {
+  using namespace scudb;
+  for (bool swizzled : {false, true})
+    SwizzledLookupBenchmark(swizzled);
+  return 0;
+}
@@ -0,0 +1,143 @@
+/**
+ * varchar_index_benchmark.cpp
+ *
+ * Inserts and point lookups through B+ tree indexes over varchar and
+ * composite keys. Every workload runs on the index ConstructIndex builds for
+ * the declared column lengths and on the index the previous sizing rule
+ * picked (16 bytes per varchar column). A key longer than its GenericKey is
+ * truncated, keys that only differ past it collide and their inserts are
+ * lost, which shows up as missed lookups.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <random>
+
+#include "benchmark_util.h"
+#include "index/b_plus_tree_index.h"
+#include "vtable/virtual_table.h"
+
+namespace scudb {
+
+static const int64_t kNumKeys = 1 << 14;
+static const uint64_t kNumLookups = 1 << 18;
+static const size_t kPoolSize = 4096;
+
+typedef std::function<std::vector<Value>(int64_t)> KeyGenerator;
+
+// the generic key width picked by the previous sizing rule
+static Index *ConstructLegacyIndex(IndexMetadata *metadata,
+                                   BufferPoolManager *buffer_pool_manager) {
+  Schema *key_schema = metadata->GetKeySchema();
+  int key_size =
+      key_schema->GetLength() + 16 * key_schema->GetUnlinedColumnCount();
+  if (key_size <= 16)
+    return new BPlusTreeIndex<GenericKey<16>, RID, GenericComparator<16>>(
+        metadata, buffer_pool_manager);
+  if (key_size <= 32)
+    return new BPlusTreeIndex<GenericKey<32>, RID, GenericComparator<32>>(
+        metadata, buffer_pool_manager);
+  return new BPlusTreeIndex<GenericKey<64>, RID, GenericComparator<64>>(
+      metadata, buffer_pool_manager);
+}
+
+static void VarcharIndexBenchmark(const std::string &name,
+                                  const std::string &sql, KeyGenerator keys,
+                                  bool legacy) {
+  DiskManager disk_manager("benchmark.db");
+  BufferPoolManager bpm(kPoolSize, &disk_manager);
+  // create header_page
+  page_id_t header_page_id;
+  bpm.NewPage(header_page_id);
+
+  Schema *schema = ParseCreateStatement(sql);
+  std::vector<int> key_attrs;
+  for (int i = 0; i < schema->GetColumnCount(); i++)
+    key_attrs.push_back(i);
+  auto metadata = new IndexMetadata("bench_pk", "bench", schema, key_attrs);
+  Index *index = legacy ? ConstructLegacyIndex(metadata, &bpm)
+                        : ConstructIndex(metadata, &bpm);
+
+  std::vector<Tuple> tuples;
+  for (int64_t i = 0; i < kNumKeys; i++)
+    tuples.emplace_back(keys(i), schema);
+  std::vector<int64_t> order(kNumKeys);
+  for (int64_t i = 0; i < kNumKeys; i++)
+    order[i] = i;
+  std::shuffle(order.begin(), order.end(), std::default_random_engine(0));
+
+  std::string label = name + (legacy ? "/legacy" : "/sized");
+  Timer timer;
+  for (auto i : order)
+    index->InsertEntry(tuples[i], RID(0, (uint32_t)i));
+  PrintResult(label + "/insert", 1, kNumKeys, timer.ElapsedSeconds());
+
+  // every probe is a key that was inserted
+  std::default_random_engine engine(1);
+  std::uniform_int_distribution<int64_t> pick(0, kNumKeys - 1);
+  std::vector<int64_t> probes;
+  for (int i = 0; i < 1024; i++)
+    probes.push_back(pick(engine));
+  std::vector<RID> result;
+  uint64_t misses = 0;
+  timer.Reset();
+  for (uint64_t i = 0; i < kNumLookups; i++) {
+    int64_t probe = probes[i % probes.size()];
+    result.clear();
+    index->ScanKey(tuples[probe], result);
+    misses += result.size() != 1 || result[0].GetSlotNum() != probe;
+  }
+  double seconds = timer.ElapsedSeconds();
+  PrintResult(label + "/lookup", 1, kNumLookups, seconds);
+  std::printf("%-40s key_bytes=%zu misses=%llu\n", (label + "/lookup").c_str(),
+              KeyEncoder::MaxLength(schema), (unsigned long long)misses);
+
+  bpm.UnpinPage(header_page_id, true);
+  delete index;
+  delete schema;
+  remove("benchmark.db");
+  remove("benchmark.log");
+}
+
+static std::string Format(const char *format, long long a, long long b = 0) {
+  char buffer[128];
+  snprintf(buffer, sizeof(buffer), format, a, b);
+  return buffer;
+}
+
+} // namespace scudb
+
+int main() {
+  using namespace scudb;
+  std::vector<std::pair<std::string, std::pair<std::string, KeyGenerator>>>
+      workloads = {
+          {"email",
+           {"email varchar(24)",
+            [](int64_t i) {
+              return std::vector<Value>{Value(
+                  TypeId::VARCHAR, Format("user%08lld@example.com", i))};
+            }}},
+          {"path",
+           {"path varchar(64)",
+            [](int64_t i) {
+              return std::vector<Value>{
+                  Value(TypeId::VARCHAR,
+                        Format("customer/region-eu/account-%010lld/primary",
+                               i))};
+            }}},
+          {"composite",
+           {"region varchar(8), name varchar(24), id bigint",
+            [](int64_t i) {
+              return std::vector<Value>{
+                  Value(TypeId::VARCHAR, Format("eu-%lld", i % 4)),
+                  Value(TypeId::VARCHAR, Format("user%06lld", i / 4)),
+                  Value(TypeId::BIGINT, i)};
+            }}}};
+  for (auto &workload : workloads) {
+    for (bool legacy : {true, false})
+      VarcharIndexBenchmark(workload.first, workload.second.first,
+                            workload.second.second, legacy);
+  }
+  return 0;
+}
@@ -39,7 +39,13 @@ BufferPoolManager::~BufferPoolManager() {
 Page *BufferPoolManager::FetchPage(page_id_t page_id) {   ////pageӴȡڴ
  	assert(page_id != INVALID_PAGE_ID);      //شִֹ
 	std::lock_guard<std::mutex> lock(latch_);     //ڹ캯ԶĻ岢н
+	return FetchPageLatched(page_id);
+}
 
+/*
+ * FetchPage with latch_ held
+ */
+Page *BufferPoolManager::FetchPageLatched(page_id_t page_id) {
 	Page *res = nullptr;
 	if (page_table_->Find(page_id, res))   //ҳpages_д, ֱpin
 	{
@@ -58,14 +64,14 @@ Page *BufferPoolManager::FetchPage(page_id_t page_id) {   ////
 		}
 		else                       //LRUûҾҳҳжǷҳɱ, replacerҳ, ´
 		{
-			if (!replacer_->Victim(res))  //˵ʱκһҳ еҳ״̬Ϊpin 
+			if (!ClaimVictim(res))  //˵ʱκһҳ еҳ״̬Ϊpin 
 			{                             
 				return nullptr;      //ReplacerԪٷʵĶɾ
 			}                        //ҳŴ洢вTrueΪ򷵻False
 		}
 	}
 
-	assert(res->pin_count_ == 0);              //ûбpinҳҳɱ, 
+	assert(res->pin_count_ == -1);             //ûбpinҳҳɱ, 
 	if (res->is_dirty_)                                             //ҳд(dirty),
 	{                                                               
 		disk_manager_->WritePage(res->page_id_, res->GetData());   //disk_manager_->WritePage()Ƚҳдش
@@ -79,12 +85,54 @@ Page *BufferPoolManager::FetchPage(page_id_t page_id) {   ////
 	// initial meta data
 	res->page_id_ = page_id;
 	res->is_dirty_ = false;
-	res->pin_count_ = 1;
+	res->is_deleted_ = false;
 	disk_manager_->ReadPage(page_id, res->GetData()); //disk_manager_->ReadPage()иҳдҳ
+	// FetchChildPage may pin the frame once it is pinned here
+	res->pin_count_ = 1;
 
 	return res;
 }
 
+/*
+ * Fetch the child at index of the B+ tree internal page in frame parent,
+ * which the caller has pinned, page_id is the page id stored at index.
+ * The parent frame keeps the frames of its first SWIZZLED_CHILDREN children
+ * it fetched (pointer swizzling, the page data keeps the page ids): while
+ * such a frame still holds the child it is pinned by its pin count alone,
+ * without latch_ or a page table lookup. A frame being reused has a pin
+ * count of -1 and can not be pinned, one reused before the pin holds another
+ * page or none. Then the reference is unswizzled and the child fetched
+ * through the page table again. References are not dropped when a frame is
+ * reused, a stale one fails the page id check.
+ * A frame pinned here from 0 stays in the replacer, ClaimVictim skips it.
+ */
+Page *BufferPoolManager::FetchChildPage(Page *parent, int index,
+                                        page_id_t page_id) {
+	assert(page_id != INVALID_PAGE_ID && index >= 0);
+	if (index >= SWIZZLED_CHILDREN)
+		return FetchPage(page_id);
+
+	Page *res = parent->swizzled_[index];
+	if (res != nullptr && res->page_id_ == page_id)
+	{
+		int pin_count = res->pin_count_;
+		while (pin_count >= 0 &&
+		       !res->pin_count_.compare_exchange_weak(pin_count, pin_count + 1))
+		{
+		}
+		if (pin_count >= 0)
+		{
+			if (res->page_id_ == page_id)
+				return res;
+			UnpinFrame(res, false);
+		}
+	}
+	res = FetchPage(page_id);
+	if (res != nullptr)
+		parent->swizzled_[index] = res;
+	return res;
+}
+
 /*
  * Implementation of unpin page
  * if pin_count>0, decrement it and if it becomes zero, put it back to
@@ -105,6 +153,12 @@ bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {  //ȡ
 		{
 			if (--res->pin_count_ == 0)    //ݼΪ㣬ҳ·ŵLRUûȥҳɱ 
 			{
+				// deleted while pinned, free it now
+				if (res->is_deleted_)
+				{
+					FreeFrame(res);
+					return true;
+				}
 				replacer_->Insert(res);
 			}
 		}
@@ -121,6 +175,35 @@ bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {  //ȡ
 	}
 }
 
+/*
+ * UnpinPage of a page the caller has pinned, by its frame, without a page
+ * table lookup. A pin that is not the last one is released without latch_
+ */
+bool BufferPoolManager::UnpinFrame(Page *page, bool is_dirty) {
+	int pin_count = page->pin_count_;
+	if (is_dirty && pin_count > 0)
+		page->is_dirty_ = true;
+	while (pin_count > 1)
+	{
+		if (page->pin_count_.compare_exchange_weak(pin_count, pin_count - 1))
+			return true;
+	}
+	std::lock_guard<std::mutex> lock(latch_);
+
+	if (page->pin_count_ <= 0)
+		return false;
+	if (--page->pin_count_ == 0)
+	{
+		if (page->is_deleted_)
+		{
+			FreeFrame(page);
+			return true;
+		}
+		replacer_->Insert(page);
+	}
+	return true;
+}
+
 /*
  * Used to flush a particular page of the buffer pool to disk. Should call the
  * write_page method of the disk manager
@@ -148,7 +231,8 @@ bool BufferPoolManager::FlushPage(page_id_t page_id) { //
  * table, buffer pool manager should be reponsible for removing this entry out
  * of page table, reseting page metadata and adding back to free list. Second,
  * call disk manager's DeallocatePage() method to delete from disk file. If
- * the page is found within page table, but pin_count != 0, return false
+ * the page is found within page table, but pin_count != 0, the page is freed
+ * once its last pin is released and false is returned
  */
 bool BufferPoolManager::DeletePage(page_id_t page_id) { //ɾҳ 
   	std::lock_guard<std::mutex> lock(latch_);
@@ -156,18 +240,62 @@ bool BufferPoolManager::DeletePage(page_id_t page_id) { //ɾ
 	Page *res = nullptr;
 	if(page_table_->Find(page_id, res))
 	{
-		page_table_->Remove(page_id);     //ҳhashɾ
-		res->page_id_ = INVALID_PAGE_ID;
-		res->is_dirty_ = false;
+		if (res->pin_count_ > 0)     // still in use by another thread
+		{
+			res->is_deleted_ = true;
+			return false;
+		}
+		return FreeFrame(res);
+	}
+	return false; 
+}
 
-		replacer_->Erase(res);      ////ҳûɾ 
-		disk_manager_->DeallocatePage(page_id); //ô̹ DeallocatePageӴĵɾ 
+/*
+ * Remove the unpinned frame page from the page table and put it back to the
+ * free list, its page is deallocated. latch_ is held. A dirty page is written
+ * back first: page ids are not reused, and a page id that is still around
+ * should lead to the deleted page (e.g. a B+ tree page marked invalid), not
+ * to an older image of it.
+ * @return: false if FetchChildPage pinned the frame meanwhile, it is freed
+ * once that pin is released
+ */
+bool BufferPoolManager::FreeFrame(Page *page) {
+	int unpinned = 0;
+	if (!page->pin_count_.compare_exchange_strong(unpinned, -1))
+	{
+		page->is_deleted_ = true;
+		return false;
+	}
+	page_id_t page_id = page->page_id_;
+	if (page->is_dirty_)
+		disk_manager_->WritePage(page_id, page->GetData());
+	page_table_->Remove(page_id);     //ҳhashɾ
+	page->page_id_ = INVALID_PAGE_ID;
+	page->is_dirty_ = false;
+	page->is_deleted_ = false;
 
-		free_list_->push_back(res);    //adding back to free list. Second ӻؿ 
+	replacer_->Erase(page);      ////ҳûɾ 
+	disk_manager_->DeallocatePage(page_id); //ô̹ DeallocatePageӴĵɾ 
 
-		return true;
+	free_list_->push_back(page);    //adding back to free list. Second ӻؿ 
+	return true;
+}
+
+/*
+ * Pop the least recently used unpinned frame from the replacer and claim it
+ * for another page by setting its pin count from 0 to -1, latch_ is held. A
+ * frame FetchChildPage pinned since it was unpinned is dropped from the
+ * replacer instead, its last unpin puts it back.
+ * @return: false if all frames are pinned
+ */
+bool BufferPoolManager::ClaimVictim(Page *&page) {
+	while (replacer_->Victim(page))
+	{
+		int unpinned = 0;
+		if (page->pin_count_.compare_exchange_strong(unpinned, -1))
+			return true;
 	}
-	return false; 
+	return false;
 }
 
 /**
@@ -189,7 +317,7 @@ Page *BufferPoolManager::NewPage(page_id_t &page_id) {    //
 	}                             //LRUûҾҳҳ
 	else
 	{
-		if(!replacer_->Victim(res))       //˵ʱκһҳ
+		if(!ClaimVictim(res))       //˵ʱκһҳ
 		{
 			return nullptr;
 		}
@@ -206,11 +334,26 @@ Page *BufferPoolManager::NewPage(page_id_t &page_id) {    //
 
 	page_table_->Insert(page_id, res);   //ҳ 
 
+	res->is_deleted_ = false;
 	res->page_id_ = page_id;  //page_idΪҳ
 	res->is_dirty_ = false;  //ҳ־Ϊfalse
-	res->pin_count_ = 1;    //̼߳Ϊ1
 	res->ResetMemory();   //ոҳ
+	res->pin_count_ = 1;    //̼߳Ϊ1
 
 	return res;
 }
+
+/*
+ * Hint that page_id is about to be fetched: if it is not buffered, ask the
+ * disk manager to start reading it so the FetchPage that follows does not
+ * wait on the disk. Does not pin or buffer anything
+ */
+void BufferPoolManager::PrefetchPage(page_id_t page_id) {
+	if (!ENABLE_PREFETCH || page_id == INVALID_PAGE_ID)
+		return;
+	Page *res = nullptr;
+	if (page_table_->Find(page_id, res))   // page table is latched by itself
+		return;
+	disk_manager_->PrefetchPage(page_id);
+}
 } // namespace scudb
@@ -2,6 +2,7 @@
 
 namespace scudb {
   std::atomic<bool> ENABLE_LOGGING(false);  // for virtual table
+  std::atomic<bool> ENABLE_PREFETCH(false);
   std::chrono::duration<long long int> LOG_TIMEOUT =
    std::chrono::seconds(1);
 }
@@ -3,6 +3,7 @@
  *
  */
 #include "concurrency/transaction_manager.h"
+#include "index/index.h"
 #include "table/table_heap.h"
 
 #include <cassert>
@@ -32,6 +33,7 @@ void TransactionManager::Commit(Transaction *txn) {
     write_set->pop_back();
   }
   write_set->clear();
+  txn->GetIndexWriteSet()->clear();
 
   if (ENABLE_LOGGING) {
     // TODO: write log and update transaction's prev_lsn here
@@ -50,25 +52,9 @@ void TransactionManager::Commit(Transaction *txn) {
 }
 
 void TransactionManager::Abort(Transaction *txn) {
-  txn->SetState(TransactionState::ABORTED);
   // rollback before releasing lock
-  auto write_set = txn->GetWriteSet();
-  while (!write_set->empty()) {
-    auto &item = write_set->back();
-    auto table = item.table_;
-    if (item.wtype_ == WType::DELETE) {
-      LOG_DEBUG("rollback delete");
-      table->RollbackDelete(item.rid_, txn);
-    } else if (item.wtype_ == WType::INSERT) {
-      LOG_DEBUG("rollback insert");
-      table->ApplyDelete(item.rid_, txn);
-    } else if (item.wtype_ == WType::UPDATE) {
-      LOG_DEBUG("rollback update");
-      table->UpdateTuple(item.tuple_, item.rid_, txn);
-    }
-    write_set->pop_back();
-  }
-  write_set->clear();
+  RollbackTo(txn, 0, 0);
+  txn->SetState(TransactionState::ABORTED);
 
   if (ENABLE_LOGGING) {
     // TODO: write log and update transaction's prev_lsn here
@@ -85,4 +71,38 @@ void TransactionManager::Abort(Transaction *txn) {
     lock_manager_->Unlock(txn, locked_rid);
   }
 }
+
+void TransactionManager::RollbackTo(Transaction *txn, size_t write_count,
+                                    size_t index_write_count) {
+  // the undo writes are not recorded again while the transaction is aborted
+  TransactionState state = txn->GetState();
+  txn->SetState(TransactionState::ABORTED);
+  // index entries first, they only hold copies of the tuples
+  auto index_write_set = txn->GetIndexWriteSet();
+  while (index_write_set->size() > index_write_count) {
+    auto &item = index_write_set->back();
+    if (item.wtype_ == WType::INSERT)
+      item.index_->DeleteEntry(item.entry_, item.rid_, txn);
+    else if (item.wtype_ == WType::DELETE)
+      item.index_->InsertEntry(item.entry_, item.rid_, txn);
+    index_write_set->pop_back();
+  }
+  auto write_set = txn->GetWriteSet();
+  while (write_set->size() > write_count) {
+    auto &item = write_set->back();
+    auto table = item.table_;
+    if (item.wtype_ == WType::DELETE) {
+      LOG_DEBUG("rollback delete");
+      table->RollbackDelete(item.rid_, txn);
+    } else if (item.wtype_ == WType::INSERT) {
+      LOG_DEBUG("rollback insert");
+      table->ApplyDelete(item.rid_, txn);
+    } else if (item.wtype_ == WType::UPDATE) {
+      LOG_DEBUG("rollback update");
+      table->UpdateTuple(item.tuple_, item.rid_, txn);
+    }
+    write_set->pop_back();
+  }
+  txn->SetState(state);
+}
 } // namespace scudb
@@ -3,9 +3,11 @@
  */
 #include <assert.h>
 #include <cstring>
+#include <fcntl.h>
 #include <iostream>
 #include <sys/stat.h>
 #include <thread>
+#include <unistd.h>
 
 #include "common/logger.h"
 #include "disk/disk_manager.h"
@@ -19,8 +21,8 @@ static char *buffer_used = nullptr;
  * @input db_file: database file name
  */
 DiskManager::DiskManager(const std::string &db_file)
-    : file_name_(db_file), next_page_id_(0), num_flushes_(0), flush_log_(false),
-      flush_log_f_(nullptr) {
+    : file_name_(db_file), db_fd_(-1), next_page_id_(0), num_flushes_(0),
+      flush_log_(false), flush_log_f_(nullptr) {
   std::string::size_type n = file_name_.find(".");
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
@@ -42,21 +44,16 @@ DiskManager::DiskManager(const std::string &db_file)
                                 std::ios::out);
   }
 
-  db_io_.open(db_file,
-              std::ios::binary | std::ios::in | std::ios::out | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-    db_io_.close();
-    // reopen with original mode
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
+  // create the file if it does not exist
+  db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT, 0644);
+  if (db_fd_ < 0) {
+    LOG_DEBUG("can't open db file");
   }
 }
 
 DiskManager::~DiskManager() {
-  db_io_.close();
+  if (db_fd_ >= 0)
+    close(db_fd_);
   log_io_.close();
 }
 
@@ -64,17 +61,11 @@ DiskManager::~DiskManager() {
  * Write the contents of the specified page into disk file
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  size_t offset = page_id * PAGE_SIZE;
-  // set write cursor to offset
-  db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
-  // check for I/O error
-  if (db_io_.bad()) {
+  off_t offset = (off_t)page_id * PAGE_SIZE;
+  // unbuffered, the page is in the OS cache when pwrite returns
+  if (pwrite(db_fd_, page_data, PAGE_SIZE, offset) != PAGE_SIZE) {
     LOG_DEBUG("I/O error while writing");
-    return;
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
 }
 
 /**
@@ -87,11 +78,10 @@ void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
     LOG_DEBUG("I/O error while reading");
     // std::cerr << "I/O error while reading" << std::endl;
   } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
+    ssize_t read_count = pread(db_fd_, page_data, PAGE_SIZE, offset);
+    if (read_count < 0)
+      read_count = 0;
     // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
     if (read_count < PAGE_SIZE) {
       LOG_DEBUG("Read less than a page");
       // std::cerr << "Read less than a page" << std::endl;
@@ -100,6 +90,17 @@ void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
   }
 }
 
+/**
+ * Ask the OS to read the specified page in the background, a later ReadPage
+ * of it is served from the OS cache. Only a hint, errors are ignored
+ */
+void DiskManager::PrefetchPage(page_id_t page_id) {
+  if (db_fd_ < 0)
+    return;
+  posix_fadvise(db_fd_, (off_t)page_id * PAGE_SIZE, PAGE_SIZE,
+                POSIX_FADV_WILLNEED);
+}
+
 /**
  * Write the contents of the log into disk file
  * Only return when sync is done, and only perform sequence write
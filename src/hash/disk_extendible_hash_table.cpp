@@ -0,0 +1,607 @@
+/**
+ * disk_extendible_hash_table.cpp
+ */
+#include <string>
+
+#include "common/exception.h"
+#include "hash/disk_extendible_hash_table.h"
+#include "page/header_page.h"
+
+namespace scudb {
+
+HASH_TABLE_TEMPLATE_ARGUMENTS
+HASH_TABLE_TYPE::DiskExtendibleHashTable(
+    const std::string &name, BufferPoolManager *buffer_pool_manager,
+    const KeyComparator &comparator, page_id_t header_page_id)
+    : index_name_(name), header_page_id_(header_page_id),
+      buffer_pool_manager_(buffer_pool_manager), comparator_(comparator) {}
+
+/*
+ * Helper function to decide whether current hash table is empty
+ */
+HASH_TABLE_TEMPLATE_ARGUMENTS
+bool HASH_TABLE_TYPE::IsEmpty() const {
+  return header_page_id_ == INVALID_PAGE_ID;
+}
+
+HASH_TABLE_TEMPLATE_ARGUMENTS
+page_id_t HASH_TABLE_TYPE::GetHeaderPageId() const { return header_page_id_; }
+
+/*
+ * Equal keys are serialized to equal bytes, so hashing the raw key data is
+ * consistent with the comparator
+ */
+HASH_TABLE_TEMPLATE_ARGUMENTS
+uint32_t HASH_TABLE_TYPE::Hash(const KeyType &key) const {
+  return (uint32_t)HashBytes(key.data, sizeof(key.data));
+}
+
+HASH_TABLE_TEMPLATE_ARGUMENTS
+Page *HASH_TABLE_TYPE::FetchPage(page_id_t page_id) {
+  Page *page = buffer_pool_manager_->FetchPage(page_id);
+  if (page == nullptr)
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  return page;
+}
+
+HASH_TABLE_TEMPLATE_ARGUMENTS
+Page *HASH_TABLE_TYPE::NewPage(page_id_t &page_id) {
+  Page *page = buffer_pool_manager_->NewPage(page_id);
+  if (page == nullptr)
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  return page;
+}
+
+HASH_TABLE_TEMPLATE_ARGUMENTS
+HASH_TABLE_BUCKET_TYPE *HASH_TABLE_TYPE::FetchBucket(page_id_t page_id) {
+  return reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(
+      FetchPage(page_id)->GetData());
+}
+
+/*****************************************************************************
+ * OVERFLOW CHAINS
+ *****************************************************************************/
+/*
+ * The helpers below take the primary page of a bucket, which the caller keeps
+ * pinned (and latched unless it holds the exclusive table latch), and pin at
+ * most two overflow pages at a time besides it. No overflow page is empty,
+ * the primary page may be.
+ */
+HASH_TABLE_TEMPLATE_ARGUMENTS
+bool HASH_TABLE_TYPE::ChainLookup(HASH_TABLE_BUCKET_TYPE *bucket,
+                                  const KeyType &key, ValueType &value) {
+  bool found = bucket->Lookup(key, value, comparator_);
+  page_id_t page_id = bucket->GetNextPageId();
+  while (!found && page_id != INVALID_PAGE_ID) {
+    auto overflow = FetchBucket(page_id);
+    found = overflow->Lookup(key, value, comparator_);
+    page_id_t next_page_id = overflow->GetNextPageId();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+  return found;
+}
+
+/*
+ * Append item to the first page of the chain with room, without duplicate
+ * check. If every page is full, link a new overflow page at the end if
+ * allocate is set.
+ * @return: false if the item was not appended
+ */
+HASH_TABLE_TEMPLATE_ARGUMENTS
+bool HASH_TABLE_TYPE::ChainAppend(HASH_TABLE_BUCKET_TYPE *bucket,
+                                  const std::pair<KeyType, ValueType> &item,
+                                  bool allocate) {
+  HASH_TABLE_BUCKET_TYPE *page = bucket;
+  bool appended = page->Append(item);
+  while (!appended && page->GetNextPageId() != INVALID_PAGE_ID) {
+    auto next = FetchBucket(page->GetNextPageId());
+    if (page != bucket)
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    page = next;
+    appended = page->Append(item);
+  }
+  if (!appended && allocate) {
+    page_id_t overflow_page_id;
+    auto overflow = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(
+        NewPage(overflow_page_id)->GetData());
+    overflow->Init(overflow_page_id);
+    overflow->Append(item);
+    page->SetNextPageId(overflow_page_id);
+    buffer_pool_manager_->UnpinPage(overflow_page_id, true);
+    appended = true;
+  }
+  if (page != bucket)
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), appended);
+  return appended;
+}
+
+/*
+ * Remove key from the chain, an overflow page left empty is unlinked and
+ * freed
+ * @return: false if the key does not exist
+ */
+HASH_TABLE_TEMPLATE_ARGUMENTS
+bool HASH_TABLE_TYPE::ChainRemove(HASH_TABLE_BUCKET_TYPE *bucket,
+                                  const KeyType &key) {
+  if (bucket->Remove(key, comparator_))
+    return true;
+  HASH_TABLE_BUCKET_TYPE *prev = bucket;
+  bool removed = false;
+  while (!removed && prev->GetNextPageId() != INVALID_PAGE_ID) {
+    page_id_t page_id = prev->GetNextPageId();
+    auto page = FetchBucket(page_id);
+    removed = page->Remove(key, comparator_);
+    bool freed = removed && page->IsEmpty();
+    if (freed)
+      prev->SetNextPageId(page->GetNextPageId());
+    if (prev != bucket)
+      buffer_pool_manager_->UnpinPage(prev->GetPageId(), freed);
+    if (removed) {
+      buffer_pool_manager_->UnpinPage(page_id, true);
+      if (freed)
+        buffer_pool_manager_->DeletePage(page_id);
+    } else {
+      prev = page;
+    }
+  }
+  if (!removed && prev != bucket)
+    buffer_pool_manager_->UnpinPage(prev->GetPageId(), false);
+  return removed;
+}
+
+HASH_TABLE_TEMPLATE_ARGUMENTS
+bool HASH_TABLE_TYPE::IsChainEmpty(HASH_TABLE_BUCKET_TYPE *bucket) const {
+  return bucket->IsEmpty() && bucket->GetNextPageId() == INVALID_PAGE_ID;
+}
+
+/*
+ * Move every pair of the chain into items, free the overflow pages and leave
+ * the primary page empty
+ */
+HASH_TABLE_TEMPLATE_ARGUMENTS
+void HASH_TABLE_TYPE::TakeChain(
+    HASH_TABLE_BUCKET_TYPE *bucket,
+    std::vector<std::pair<KeyType, ValueType>> &items) {
+  page_id_t page_id = bucket->GetNextPageId();
+  for (int i = 0; i < bucket->GetSize(); i++)
+    items.push_back(bucket->GetItem(i));
+  bucket->Init(bucket->GetPageId());
+  while (page_id != INVALID_PAGE_ID) {
+    auto overflow = FetchBucket(page_id);
+    for (int i = 0; i < overflow->GetSize(); i++)
+      items.push_back(overflow->GetItem(i));
+    page_id_t next_page_id = overflow->GetNextPageId();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    buffer_pool_manager_->DeletePage(page_id);
+    page_id = next_page_id;
+  }
+}
+
+/*
+ * Walk header and directory page down to the bucket page of hash. Header and
+ * directory pages are only modified under the exclusive table latch, so the
+ * caller's table latch (either mode) is enough to read them.
+ */
+HASH_TABLE_TEMPLATE_ARGUMENTS
+page_id_t HASH_TABLE_TYPE::FindBucketPageId(uint32_t hash) {
+  if (IsEmpty())
+    return INVALID_PAGE_ID;
+  auto header = reinterpret_cast<HashTableHeaderPage *>(
+      FetchPage(header_page_id_)->GetData());
+  page_id_t directory_page_id =
+      header->GetDirectoryPageId(header->HashToDirectoryIndex(hash));
+  buffer_pool_manager_->UnpinPage(header_page_id_, false);
+  if (directory_page_id == INVALID_PAGE_ID)
+    return INVALID_PAGE_ID;
+
+  auto directory = reinterpret_cast<HashTableDirectoryPage *>(
+      FetchPage(directory_page_id)->GetData());
+  page_id_t bucket_page_id =
+      directory->GetBucketPageId(directory->HashToBucketIndex(hash));
+  buffer_pool_manager_->UnpinPage(directory_page_id, false);
+  return bucket_page_id;
+}
+
+/*****************************************************************************
+ * SEARCH
+ *****************************************************************************/
+/*
+ * Return the only value that associated with input key
+ * This method is used for point query
+ * @return : true means key exists
+ */
+HASH_TABLE_TEMPLATE_ARGUMENTS
+bool HASH_TABLE_TYPE::GetValue(const KeyType &key,
+                               std::vector<ValueType> &result,
+                               Transaction *transaction) {
+  uint32_t hash = Hash(key);
+  bool found = false;
+  ValueType value;
+
+  table_latch_.RLock();
+  page_id_t bucket_page_id = FindBucketPageId(hash);
+  if (bucket_page_id != INVALID_PAGE_ID) {
+    Page *page = FetchPage(bucket_page_id);
+    page->RLatch();
+    auto bucket = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(page->GetData());
+    found = ChainLookup(bucket, key, value);
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+  }
+  table_latch_.RUnlock();
+
+  if (found)
+    result.push_back(value);
+  return found;
+}
+
+/*****************************************************************************
+ * INSERTION
+ *****************************************************************************/
+/*
+ * Insert constant key & value pair into the hash table
+ * First try under the shared table latch, which succeeds whenever the bucket
+ * exists and one of its pages has room; otherwise retry under the exclusive
+ * latch, creating missing pages, splitting the bucket or linking an overflow
+ * page to it as needed.
+ * @return: since we only support unique key, if user try to insert duplicate
+ * keys return false, otherwise return true.
+ */
+HASH_TABLE_TEMPLATE_ARGUMENTS
+bool HASH_TABLE_TYPE::Insert(const KeyType &key, const ValueType &value,
+                             Transaction *transaction) {
+  uint32_t hash = Hash(key);
+  bool done = false, inserted = false;
+
+  table_latch_.RLock();
+  page_id_t bucket_page_id = FindBucketPageId(hash);
+  if (bucket_page_id != INVALID_PAGE_ID) {
+    Page *page = FetchPage(bucket_page_id);
+    page->WLatch();
+    auto bucket = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(page->GetData());
+    ValueType existing;
+    if (ChainLookup(bucket, key, existing)) {
+      done = true;
+    } else if (ChainAppend(bucket, std::make_pair(key, value), false)) {
+      done = inserted = true;
+    }
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(bucket_page_id, inserted);
+  }
+  table_latch_.RUnlock();
+  if (done)
+    return inserted;
+
+  table_latch_.WLock();
+  inserted = SplitInsert(key, value, hash);
+  table_latch_.WUnlock();
+  return inserted;
+}
+
+/*
+ * Allocate the header page of an empty table and record it in the header
+ * page of the database
+ */
+HASH_TABLE_TEMPLATE_ARGUMENTS
+void HASH_TABLE_TYPE::StartNewTable() {
+  page_id_t header_page_id;
+  auto header = reinterpret_cast<HashTableHeaderPage *>(
+      NewPage(header_page_id)->GetData());
+  header->Init(header_page_id);
+  buffer_pool_manager_->UnpinPage(header_page_id, true);
+
+  header_page_id_ = header_page_id;
+  UpdateRootPageId(true);
+}
+
+/*
+ * Allocate a directory page of global depth 0 with a single empty bucket
+ * @return: page id of the new directory page
+ */
+HASH_TABLE_TEMPLATE_ARGUMENTS
+page_id_t HASH_TABLE_TYPE::StartNewDirectory() {
+  page_id_t directory_page_id, bucket_page_id;
+  auto directory = reinterpret_cast<HashTableDirectoryPage *>(
+      NewPage(directory_page_id)->GetData());
+  directory->Init(directory_page_id);
+  auto bucket = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(
+      NewPage(bucket_page_id)->GetData());
+  bucket->Init(bucket_page_id);
+  directory->SetBucketPageId(0, bucket_page_id);
+  buffer_pool_manager_->UnpinPage(bucket_page_id, true);
+  buffer_pool_manager_->UnpinPage(directory_page_id, true);
+  return directory_page_id;
+}
+
+/*
+ * Insert under the exclusive table latch. A full bucket is split on the next
+ * hash bit, doubling its directory first if the bucket's local depth equals
+ * the global depth, until the bucket of key has room. A full bucket at
+ * HTABLE_DIRECTORY_MAX_DEPTH gets an overflow page instead.
+ * @return: false on duplicate key.
+ */
+HASH_TABLE_TEMPLATE_ARGUMENTS
+bool HASH_TABLE_TYPE::SplitInsert(const KeyType &key, const ValueType &value,
+                                  uint32_t hash) {
+  if (IsEmpty())
+    StartNewTable();
+
+  auto header = reinterpret_cast<HashTableHeaderPage *>(
+      FetchPage(header_page_id_)->GetData());
+  uint32_t directory_idx = header->HashToDirectoryIndex(hash);
+  page_id_t directory_page_id = header->GetDirectoryPageId(directory_idx);
+  bool header_dirty = false;
+  if (directory_page_id == INVALID_PAGE_ID) {
+    directory_page_id = StartNewDirectory();
+    header->SetDirectoryPageId(directory_idx, directory_page_id);
+    header_dirty = true;
+  }
+  buffer_pool_manager_->UnpinPage(header_page_id_, header_dirty);
+
+  auto directory = reinterpret_cast<HashTableDirectoryPage *>(
+      FetchPage(directory_page_id)->GetData());
+  bool directory_dirty = false, inserted = false;
+  while (true) {
+    uint32_t bucket_idx = directory->HashToBucketIndex(hash);
+    page_id_t bucket_page_id = directory->GetBucketPageId(bucket_idx);
+    auto bucket = FetchBucket(bucket_page_id);
+    ValueType existing;
+    if (ChainLookup(bucket, key, existing)) {
+      buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+      break;
+    }
+    uint32_t local_depth = directory->GetLocalDepth(bucket_idx);
+    bool can_split = local_depth < directory->GetMaxDepth();
+    if (ChainAppend(bucket, std::make_pair(key, value), !can_split)) {
+      buffer_pool_manager_->UnpinPage(bucket_page_id, true);
+      inserted = true;
+      break;
+    }
+
+    if (local_depth == directory->GetGlobalDepth())
+      directory->IncrGlobalDepth();
+
+    // move every pair whose hash has bit local_depth set into the split image,
+    // a bucket merged back from overflow pages may fill more than one page
+    page_id_t image_page_id;
+    auto image = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(
+        NewPage(image_page_id)->GetData());
+    image->Init(image_page_id);
+    std::vector<std::pair<KeyType, ValueType>> items;
+    TakeChain(bucket, items);
+    for (auto &item : items) {
+      bool to_image = (Hash(item.first) >> local_depth) & 1;
+      ChainAppend(to_image ? image : bucket, item, true);
+    }
+    uint32_t mask = (1U << local_depth) - 1;
+    for (uint32_t i = 0; i < directory->Size(); i++) {
+      if ((i & mask) != (bucket_idx & mask))
+        continue;
+      directory->SetLocalDepth(i, local_depth + 1);
+      if ((i >> local_depth) & 1)
+        directory->SetBucketPageId(i, image_page_id);
+    }
+    directory_dirty = true;
+    buffer_pool_manager_->UnpinPage(image_page_id, true);
+    buffer_pool_manager_->UnpinPage(bucket_page_id, true);
+  }
+  buffer_pool_manager_->UnpinPage(directory_page_id, directory_dirty);
+  return inserted;
+}
+
+/*****************************************************************************
+ * REMOVE
+ *****************************************************************************/
+/*
+ * Delete key & value pair associated with input key
+ * The pair is removed under the shared table latch; a bucket left empty is
+ * merged afterwards under the exclusive latch.
+ * @return: false if the key does not exist
+ */
+HASH_TABLE_TEMPLATE_ARGUMENTS
+bool HASH_TABLE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
+  uint32_t hash = Hash(key);
+  bool removed = false, empty = false;
+
+  table_latch_.RLock();
+  page_id_t bucket_page_id = FindBucketPageId(hash);
+  if (bucket_page_id != INVALID_PAGE_ID) {
+    Page *page = FetchPage(bucket_page_id);
+    page->WLatch();
+    auto bucket = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(page->GetData());
+    removed = ChainRemove(bucket, key);
+    empty = IsChainEmpty(bucket);
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(bucket_page_id, removed);
+  }
+  table_latch_.RUnlock();
+
+  if (removed && empty) {
+    table_latch_.WLock();
+    MergeBucket(hash);
+    table_latch_.WUnlock();
+  }
+  return removed;
+}
+
+/*
+ * Merge the bucket of hash with its split image while one of them is empty
+ * (without overflow pages) and both have the same local depth, free the empty
+ * page and halve the directory while no bucket uses its highest bit. Another thread may have
+ * refilled the bucket before the exclusive latch was taken, in which case
+ * nothing is merged.
+ */
+HASH_TABLE_TEMPLATE_ARGUMENTS
+void HASH_TABLE_TYPE::MergeBucket(uint32_t hash) {
+  if (IsEmpty())
+    return;
+  auto header = reinterpret_cast<HashTableHeaderPage *>(
+      FetchPage(header_page_id_)->GetData());
+  page_id_t directory_page_id =
+      header->GetDirectoryPageId(header->HashToDirectoryIndex(hash));
+  buffer_pool_manager_->UnpinPage(header_page_id_, false);
+  if (directory_page_id == INVALID_PAGE_ID)
+    return;
+
+  auto directory = reinterpret_cast<HashTableDirectoryPage *>(
+      FetchPage(directory_page_id)->GetData());
+  bool directory_dirty = false;
+  while (true) {
+    uint32_t bucket_idx = directory->HashToBucketIndex(hash);
+    uint32_t local_depth = directory->GetLocalDepth(bucket_idx);
+    if (local_depth == 0)
+      break;
+    uint32_t image_idx = directory->GetSplitImageIndex(bucket_idx);
+    if (directory->GetLocalDepth(image_idx) != local_depth)
+      break;
+
+    page_id_t bucket_page_id = directory->GetBucketPageId(bucket_idx);
+    page_id_t image_page_id = directory->GetBucketPageId(image_idx);
+    bool bucket_empty = IsChainEmpty(FetchBucket(bucket_page_id));
+    buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+    bool image_empty = IsChainEmpty(FetchBucket(image_page_id));
+    buffer_pool_manager_->UnpinPage(image_page_id, false);
+    if (!bucket_empty && !image_empty)
+      break;
+
+    page_id_t survivor = bucket_empty ? image_page_id : bucket_page_id;
+    page_id_t victim = bucket_empty ? bucket_page_id : image_page_id;
+    for (uint32_t i = 0; i < directory->Size(); i++) {
+      page_id_t page_id = directory->GetBucketPageId(i);
+      if (page_id == survivor || page_id == victim) {
+        directory->SetBucketPageId(i, survivor);
+        directory->SetLocalDepth(i, local_depth - 1);
+      }
+    }
+    buffer_pool_manager_->DeletePage(victim);
+    while (directory->CanShrink())
+      directory->DecrGlobalDepth();
+    directory_dirty = true;
+  }
+  buffer_pool_manager_->UnpinPage(directory_page_id, directory_dirty);
+}
+
+/*****************************************************************************
+ * UTILITIES AND DEBUG
+ *****************************************************************************/
+/*
+ * Update/Insert header page id in header page(where page_id = 0, header_page
+ * is defined under include/page/header_page.h)
+ * Call this method everytime the header page id is changed.
+ * @parameter: insert_record default value is false. When set to true,
+ * insert a record <index_name, header_page_id> into header page instead of
+ * updating it.
+ */
+HASH_TABLE_TEMPLATE_ARGUMENTS
+void HASH_TABLE_TYPE::UpdateRootPageId(int insert_record) {
+  HeaderPage *header_page = static_cast<HeaderPage *>(
+      buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
+  if (insert_record)
+    // create a new record<index_name + header_page_id> in header_page
+    header_page->InsertRecord(index_name_, header_page_id_);
+  else
+    // update header_page_id in header_page
+    header_page->UpdateRecord(index_name_, header_page_id_);
+  buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
+}
+
+/*
+ * This method is used for test only
+ * @return: global depth of the directory that key maps to, 0 if it does not
+ * exist yet
+ */
+HASH_TABLE_TEMPLATE_ARGUMENTS
+uint32_t HASH_TABLE_TYPE::GetGlobalDepth(const KeyType &key) {
+  uint32_t hash = Hash(key), global_depth = 0;
+  table_latch_.RLock();
+  if (!IsEmpty()) {
+    auto header = reinterpret_cast<HashTableHeaderPage *>(
+        FetchPage(header_page_id_)->GetData());
+    page_id_t directory_page_id =
+        header->GetDirectoryPageId(header->HashToDirectoryIndex(hash));
+    buffer_pool_manager_->UnpinPage(header_page_id_, false);
+    if (directory_page_id != INVALID_PAGE_ID) {
+      auto directory = reinterpret_cast<HashTableDirectoryPage *>(
+          FetchPage(directory_page_id)->GetData());
+      global_depth = directory->GetGlobalDepth();
+      buffer_pool_manager_->UnpinPage(directory_page_id, false);
+    }
+  }
+  table_latch_.RUnlock();
+  return global_depth;
+}
+
+/*
+ * This method is used for test only
+ * Check every directory: local depths never exceed the global depth, each
+ * bucket page is referenced by exactly 2^(global - local) slots sharing the
+ * same local depth, and every pair is stored in the bucket its hash maps to.
+ * No overflow page is empty.
+ */
+HASH_TABLE_TEMPLATE_ARGUMENTS
+bool HASH_TABLE_TYPE::VerifyIntegrity() {
+  bool valid = true;
+  table_latch_.RLock();
+  if (!IsEmpty()) {
+    auto header = reinterpret_cast<HashTableHeaderPage *>(
+        FetchPage(header_page_id_)->GetData());
+    for (uint32_t d = 0; d < header->MaxSize() && valid; d++) {
+      page_id_t directory_page_id = header->GetDirectoryPageId(d);
+      if (directory_page_id == INVALID_PAGE_ID)
+        continue;
+      auto directory = reinterpret_cast<HashTableDirectoryPage *>(
+          FetchPage(directory_page_id)->GetData());
+      uint32_t global_depth = directory->GetGlobalDepth();
+      for (uint32_t i = 0; i < directory->Size() && valid; i++) {
+        uint32_t local_depth = directory->GetLocalDepth(i);
+        page_id_t bucket_page_id = directory->GetBucketPageId(i);
+        if (local_depth > global_depth) {
+          valid = false;
+          break;
+        }
+        uint32_t references = 0;
+        for (uint32_t j = 0; j < directory->Size(); j++) {
+          if (directory->GetBucketPageId(j) != bucket_page_id)
+            continue;
+          references++;
+          valid = valid && directory->GetLocalDepth(j) == local_depth;
+        }
+        valid = valid && references == (1U << (global_depth - local_depth));
+
+        uint32_t mask = (1U << local_depth) - 1;
+        for (page_id_t page_id = bucket_page_id; page_id != INVALID_PAGE_ID;) {
+          auto bucket = FetchBucket(page_id);
+          valid = valid && (page_id == bucket_page_id || !bucket->IsEmpty());
+          for (int k = 0; k < bucket->GetSize(); k++) {
+            uint32_t hash = Hash(bucket->GetItem(k).first);
+            valid = valid && header->HashToDirectoryIndex(hash) == d &&
+                    (hash & mask) == (i & mask);
+          }
+          page_id_t next_page_id = bucket->GetNextPageId();
+          buffer_pool_manager_->UnpinPage(page_id, false);
+          page_id = next_page_id;
+        }
+      }
+      buffer_pool_manager_->UnpinPage(directory_page_id, false);
+    }
+    buffer_pool_manager_->UnpinPage(header_page_id_, false);
+  }
+  table_latch_.RUnlock();
+  return valid;
+}
+
+template class DiskExtendibleHashTable<GenericKey<4>, RID,
+                                       GenericComparator<4>>;
+template class DiskExtendibleHashTable<GenericKey<8>, RID,
+                                       GenericComparator<8>>;
+template class DiskExtendibleHashTable<GenericKey<16>, RID,
+                                       GenericComparator<16>>;
+template class DiskExtendibleHashTable<GenericKey<32>, RID,
+                                       GenericComparator<32>>;
+template class DiskExtendibleHashTable<GenericKey<64>, RID,
+                                       GenericComparator<64>>;
+template class DiskExtendibleHashTable<GenericKey<128>, RID,
+                                       GenericComparator<128>>;
+
+} // namespace scudb
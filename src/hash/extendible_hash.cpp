@@ -1,142 +1,405 @@
+#include <cstring>
 #include <list>
+#include <type_traits>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 #include "hash/extendible_hash.h"
 #include "page/page.h"
 
 namespace scudb {
 
+/*
+ * Key probes over a bucket's key array: return the index of key within
+ * keys[0, size) or -1. Integral and pointer keys of 4 or 8 bytes are
+ * compared several at a time with SIMD, everything else falls back to a
+ * linear scan with operator==.
+ */
+template <typename K, size_t Width = sizeof(K),
+          bool Vectorize = std::is_integral<K>::value ||
+                           std::is_pointer<K>::value>
+struct KeyProbe {
+  static int Find(const K *keys, size_t size, const K &key) {
+    for (size_t i = 0; i < size; i++) {
+      if (keys[i] == key)
+        return (int)i;
+    }
+    return -1;
+  }
+};
+
+template <typename K> struct KeyProbe<K, 4, true> {
+  static int Find(const K *keys, size_t size, const K &key) {
+    int32_t needle;
+    memcpy(&needle, &key, 4);
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256i pattern = _mm256_set1_epi32(needle);
+    for (; i + 8 <= size; i += 8) {
+      __m256i block =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i *>(keys + i));
+      int mask = _mm256_movemask_ps(
+          _mm256_castsi256_ps(_mm256_cmpeq_epi32(block, pattern)));
+      if (mask != 0)
+        return (int)i + __builtin_ctz(mask);
+    }
+#elif defined(__SSE2__)
+    const __m128i pattern = _mm_set1_epi32(needle);
+    for (; i + 4 <= size; i += 4) {
+      __m128i block =
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(keys + i));
+      int mask =
+          _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(block, pattern)));
+      if (mask != 0)
+        return (int)i + __builtin_ctz(mask);
+    }
+#endif
+    for (; i < size; i++) {
+      if (keys[i] == key)
+        return (int)i;
+    }
+    return -1;
+  }
+};
+
+template <typename K> struct KeyProbe<K, 8, true> {
+  static int Find(const K *keys, size_t size, const K &key) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    int64_t needle;
+    memcpy(&needle, &key, 8);
+    const __m256i pattern = _mm256_set1_epi64x(needle);
+    for (; i + 4 <= size; i += 4) {
+      __m256i block =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i *>(keys + i));
+      int mask = _mm256_movemask_pd(
+          _mm256_castsi256_pd(_mm256_cmpeq_epi64(block, pattern)));
+      if (mask != 0)
+        return (int)i + __builtin_ctz(mask);
+    }
+#endif
+    for (; i < size; i++) {
+      if (keys[i] == key)
+        return (int)i;
+    }
+    return -1;
+  }
+};
+
 /*
  * constructor
  * array_size: fixed array size for each bucket
  */
-template <typename K, typename V>
-ExtendibleHash<K, V>::ExtendibleHash(size_t size)
-        :globalDepth(0), bucketMaxSize(size), numBucket(1) {
-  bucketTable.push_back(std::make_shared<Bucket>(0));
+template <typename K, typename V, typename Hash>
+ExtendibleHash<K, V, Hash>::ExtendibleHash(size_t size)
+        :globalDepth(0), bucketMaxSize(size), numBucket(1),
+         bucketTable(new Slot[1]) {
+  bucketTable[0].store(new Bucket(0, bucketMaxSize));
+}
+
+/*
+ * destructor
+ * a bucket with local depth d is referenced by every 2^d-th slot, free it
+ * from the first slot that references it
+ */
+template <typename K, typename V, typename Hash>
+ExtendibleHash<K, V, Hash>::~ExtendibleHash() {
+  size_t length = (size_t)1 << globalDepth;
+  vector<Bucket *> buckets;
+  for (size_t i = 0; i < length; i++) {
+    Bucket *bucket = bucketTable[i].load();
+    if (i < ((size_t)1 << bucket->localDepth)) {
+      buckets.push_back(bucket);
+    }
+  }
+  for (Bucket *bucket : buckets) {
+    delete bucket;
+  }
 }
 
 /*
  * helper function to calculate the hashing address of input key
  */
-template <typename K, typename V>
-size_t ExtendibleHash<K, V>::HashKey(const K &key) {
-  return std::hash<K>{}(key);
+template <typename K, typename V, typename Hash>
+size_t ExtendibleHash<K, V, Hash>::HashKey(const K &key) {
+  return hashFunction(key);
 }
 
 /*
  * helper function to return global depth of hash table
  * NOTE: you must implement this function in order to pass test
  */
-template <typename K, typename V>
-int ExtendibleHash<K, V>::GetGlobalDepth() const {
-  return globalDepth;
+template <typename K, typename V, typename Hash>
+int ExtendibleHash<K, V, Hash>::GetGlobalDepth() const {
+  tableLatch.RLock();
+  int depth = globalDepth;
+  tableLatch.RUnlock();
+  return depth;
 }
 
 /*
  * helper function to return local depth of one specific bucket
  * NOTE: you must implement this function in order to pass test
  */
-template <typename K, typename V>
-int ExtendibleHash<K, V>::GetLocalDepth(int bucket_id) const {
-  if (!bucketTable[bucket_id] || bucketTable[bucket_id]->items.empty()) return -1;
-  return bucketTable[bucket_id]->localDepth;
-}              //ϣڲҲΪշؾֲ 
+template <typename K, typename V, typename Hash>
+int ExtendibleHash<K, V, Hash>::GetLocalDepth(int bucket_id) const {
+  int depth = -1;
+  tableLatch.RLock();
+  if (bucket_id >= 0 && bucket_id < (1 << globalDepth)) {
+    Bucket *bucket = bucketTable[bucket_id].load();
+    bucket->latch.RLock();
+    if (bucket->size > 0) {
+      depth = bucket->localDepth;
+    }
+    bucket->latch.RUnlock();
+  }
+  tableLatch.RUnlock();
+  return depth;
+}
 
 /*
  * helper function to return current number of bucket in hash table
  */
-template <typename K, typename V>
-int ExtendibleHash<K, V>::GetNumBuckets() const {
-  return numBucket;
+template <typename K, typename V, typename Hash>
+int ExtendibleHash<K, V, Hash>::GetNumBuckets() const {
+  return numBucket.load();
 }
 
 /*
  * lookup function to find value associate with input key
  */
-template <typename K, typename V>
-bool ExtendibleHash<K, V>::Find(const K &key, V &value) {
-  std::lock_guard<std::mutex> guard(mutex1);     //ʱʱ
+template <typename K, typename V, typename Hash>
+bool ExtendibleHash<K, V, Hash>::Find(const K &key, V &value) {
+  tableLatch.RLock();
+  Bucket *bucket = latchBucket(key, false);
 
-  auto index = getBucketIndex(key);     //ҵӦbucketλ
-  std::shared_ptr<Bucket> bucket = bucketTable[index];
-  if (bucket != nullptr && bucket->items.find(key) != bucket->items.end()) {//map.find(k) ѰֵΪkԪأ
-    value = bucket->items[key];                                              // ظԪصĵ, , map.end() 
-    return true;
+  int slot = findSlot(bucket, key);
+  if (slot != -1) {
+    value = bucket->values[slot];
   }
-  return false;
+  bucket->latch.RUnlock();
+  tableLatch.RUnlock();
+  return slot != -1;
 }
 
 /*
  * delete <key,value> entry in hash table
- * Shrink & Combination is not required for this project
+ * If the bucket becomes empty, it is merged with its split image and the
+ * directory is shrunk when possible
  */
-template <typename K, typename V>
-bool ExtendibleHash<K, V>::Remove(const K &key) {
-  std::lock_guard<std::mutex> guard(mutex1);
-
-  auto index = getBucketIndex(key);
-  std::shared_ptr<Bucket> bucket = bucketTable[index];
+template <typename K, typename V, typename Hash>
+bool ExtendibleHash<K, V, Hash>::Remove(const K &key) {
+  tableLatch.RLock();
+  Bucket *bucket = latchBucket(key, true);
 
-  if (bucket == nullptr || bucket->items.find(key) == bucket->items.end()) {
-    return false;      //ͰΪջδҵжӦĹؼֵĽڵ㣬false 
+  int slot = findSlot(bucket, key);
+  if (slot != -1) {
+    // fill the hole with the last pair to keep the arrays dense
+    size_t last = --bucket->size;
+    bucket->keys[slot] = bucket->keys[last];
+    bucket->values[slot] = std::move(bucket->values[last]);
+    bucket->values[last] = V();
   }
-  bucket->items.erase(key);  //map.erase() ƳͲƥԪأȻ󷵻ƳԪصĸ
-  return true;
+  bool merge = bucket->size == 0 && bucket->localDepth > 0;
+  bucket->latch.WUnlock();
+  tableLatch.RUnlock();
+  if (merge) {
+    mergeBucket(key);
+  }
+  return slot != -1;
 }
 
-template <typename K, typename V>
-int ExtendibleHash<K, V>::getBucketIndex(const K &key) {
-  return HashKey(key) & ((1 << globalDepth) - 1);   //1globalDepthλ൱2^GlobalDepth żһλȫ1
-}                                                   // ͹ؼhashcodeͿԵõؼֶӦbucketλ 
+template <typename K, typename V, typename Hash>
+int ExtendibleHash<K, V, Hash>::findSlot(const Bucket *bucket, const K &key) const {
+  return KeyProbe<K>::Find(bucket->keys.get(), bucket->size, key);
+}
+
+template <typename K, typename V, typename Hash>
+int ExtendibleHash<K, V, Hash>::getBucketIndex(const K &key) {
+  return HashKey(key) & ((1 << globalDepth) - 1);
+}
 
 /*
- * insert <key,value> entry in hash table
- * Split & Redistribute bucket when there is overflow and if necessary increase
- * global depth
+ * Latch (shared or exclusive) the bucket that key currently maps to.
+ * The slot is re-read after the bucket latch is granted: if a split
+ * redirected it in the meantime, the latch is dropped and the lookup retried.
+ * Caller must hold tableLatch in shared mode.
  */
-template <typename K, typename V>
-void ExtendibleHash<K, V>::Insert(const K &key, const V &value) {
-  std::lock_guard<std::mutex> guard(mutex1);
-
-  auto index = getBucketIndex(key);
-  std::shared_ptr<Bucket> targetBucket = bucketTable[index];
-
-  while (targetBucket->items.size() == bucketMaxSize) { //Ͱ, Ҫ   
-    if (targetBucket->localDepth == globalDepth) {   //L==GʱֻһָָǰͰչ
-      size_t length = bucketTable.size();            //λȺȫλȾ+1鵱ǰͰԪ  vectorһ ָ븴 
-      for (size_t i = 0; i < length; i++) {            
-        bucketTable.push_back(bucketTable[i]);         
-      }
-      globalDepth++;
-    }                 
-    int mask = 1 << targetBucket->localDepth;  //L<GʱֹһָָǰͰʲҪ
-    numBucket++;                               //ֻѳһͰλ+1Ȼ鵱ǰͰԪؼɡ
-    auto zeroBucket = std::make_shared<Bucket>(targetBucket->localDepth + 1);   //ƣֻ0 1 
-    auto oneBucket = std::make_shared<Bucket>(targetBucket->localDepth + 1);
-    for (auto item : targetBucket->items) {    //ͰԪ 
-      size_t hashkey = HashKey(item.first);    //ȡϣֵ 
-      if (hashkey & mask) {           // λ1 onebucket ֮ 
-        oneBucket->items.insert(item);
-      } else { 
-        zeroBucket->items.insert(item);
-      }
+template <typename K, typename V, typename Hash>
+typename ExtendibleHash<K, V, Hash>::Bucket *
+ExtendibleHash<K, V, Hash>::latchBucket(const K &key, bool exclusive) {
+  Slot &slot = bucketTable[getBucketIndex(key)];
+  for (;;) {
+    Bucket *bucket = slot.load();
+    if (exclusive) {
+      bucket->latch.WLock();
+    } else {
+      bucket->latch.RLock();
+    }
+    if (slot.load() == bucket) {
+      return bucket;
     }
+    if (exclusive) {
+      bucket->latch.WUnlock();
+    } else {
+      bucket->latch.RUnlock();
+    }
+  }
+}
 
-    for (size_t i = 0; i < bucketTable.size(); i++) {
-      if (bucketTable[i] == targetBucket) {              //ָ 
-        if (i & mask) {
-          bucketTable[i] = oneBucket;
-        } else {
-          bucketTable[i] = zeroBucket;
-        }
+/*
+ * Split bucket in place: pairs whose next hash bit is set move to a new
+ * image bucket and the remaining pairs are compacted to the front of the
+ * arrays, then the directory slots selecting that bit are redirected.
+ * Caller holds tableLatch in shared mode and the bucket latch exclusively, and
+ * guarantees bucket->localDepth < globalDepth, so no slot outside this
+ * bucket's range is touched.
+ */
+template <typename K, typename V, typename Hash>
+void ExtendibleHash<K, V, Hash>::splitBucket(Bucket *bucket) {
+  size_t mask = (size_t)1 << bucket->localDepth;
+  Bucket *image = new Bucket(bucket->localDepth + 1, bucketMaxSize);
+  size_t base = 0;
+  size_t keep = 0;
+  for (size_t i = 0; i < bucket->size; i++) {
+    size_t hashkey = HashKey(bucket->keys[i]);
+    base = hashkey & (mask - 1);
+    if (hashkey & mask) {
+      image->keys[image->size] = bucket->keys[i];
+      image->values[image->size++] = std::move(bucket->values[i]);
+    } else {
+      if (keep != i) {
+        bucket->keys[keep] = bucket->keys[i];
+        bucket->values[keep] = std::move(bucket->values[i]);
       }
+      keep++;
     }
+  }
+  for (size_t i = keep; i < bucket->size; i++) {
+    bucket->values[i] = V();
+  }
+  bucket->size = keep;
+  bucket->localDepth++;
+  numBucket++;
+
+  size_t length = (size_t)1 << globalDepth;
+  for (size_t i = base | mask; i < length; i += mask << 1) {
+    bucketTable[i].store(image);
+  }
+}
 
-    index = getBucketIndex(key);
-    targetBucket = bucketTable[index];
-  } //end while
+/*
+ * Double the directory, every new slot points to the same bucket as its
+ * lower half counterpart. Skipped if another thread already grew the
+ * directory past depth while this one waited for the exclusive latch.
+ */
+template <typename K, typename V, typename Hash>
+void ExtendibleHash<K, V, Hash>::growDirectory(int depth) {
+  tableLatch.WLock();
+  if (globalDepth == depth) {
+    size_t length = (size_t)1 << globalDepth;
+    Slot *table = new Slot[length << 1];
+    for (size_t i = 0; i < length; i++) {
+      Bucket *bucket = bucketTable[i].load();
+      table[i].store(bucket);
+      table[i + length].store(bucket);
+    }
+    bucketTable.reset(table);
+    globalDepth++;
+  }
+  tableLatch.WUnlock();
+}
 
-  targetBucket->items[key] = value;    //δ 
+/*
+ * Merge the bucket key maps to with its split image while one of the two is
+ * empty and both have the same local depth; the non-empty one survives with
+ * its local depth decreased. Then halve the directory as long as every slot
+ * in the upper half points to the same bucket as its lower half counterpart.
+ * State is re-checked here because other threads may have refilled the
+ * bucket between Remove dropping its latches and this call.
+ */
+template <typename K, typename V, typename Hash>
+void ExtendibleHash<K, V, Hash>::mergeBucket(const K &key) {
+  tableLatch.WLock();
+  size_t index = getBucketIndex(key);
+  Bucket *bucket = bucketTable[index].load();
+  while (bucket->localDepth > 0) {
+    size_t mask = (size_t)1 << (bucket->localDepth - 1);
+    Bucket *image = bucketTable[index ^ mask].load();
+    if (image->localDepth != bucket->localDepth ||
+        (bucket->size != 0 && image->size != 0)) {
+      break;
+    }
+    Bucket *survivor = bucket->size != 0 ? bucket : image;
+    Bucket *victim = survivor == bucket ? image : bucket;
+    // the victim is referenced by every (mask << 1)-th slot from its base
+    size_t base = (survivor == bucket ? index ^ mask : index) &
+                  ((mask << 1) - 1);
+    size_t length = (size_t)1 << globalDepth;
+    for (size_t i = base; i < length; i += mask << 1) {
+      bucketTable[i].store(survivor);
+    }
+    survivor->localDepth--;
+    delete victim;
+    numBucket--;
+    bucket = survivor;
+  }
+
+  while (globalDepth > 0) {
+    size_t half = (size_t)1 << (globalDepth - 1);
+    bool shrinkable = true;
+    for (size_t i = 0; i < half && shrinkable; i++) {
+      shrinkable = bucketTable[i].load() == bucketTable[i + half].load();
+    }
+    if (!shrinkable) {
+      break;
+    }
+    Slot *table = new Slot[half];
+    for (size_t i = 0; i < half; i++) {
+      table[i].store(bucketTable[i].load());
+    }
+    bucketTable.reset(table);
+    globalDepth--;
+  }
+  tableLatch.WUnlock();
+}
+
+/*
+ * insert <key,value> entry in hash table
+ * Split & Redistribute bucket when there is overflow and if necessary increase
+ * global depth
+ */
+template <typename K, typename V, typename Hash>
+void ExtendibleHash<K, V, Hash>::Insert(const K &key, const V &value) {
+  for (;;) {
+    tableLatch.RLock();
+    Bucket *bucket = latchBucket(key, true);
+
+    int slot = findSlot(bucket, key);
+    if (slot != -1) {
+      bucket->values[slot] = value;
+    } else if (bucket->size < bucketMaxSize) {
+      bucket->keys[bucket->size] = key;
+      bucket->values[bucket->size++] = value;
+    } else if (bucket->localDepth < globalDepth) {
+      // overflow, split and retry
+      splitBucket(bucket);
+      bucket->latch.WUnlock();
+      tableLatch.RUnlock();
+      continue;
+    } else {
+      // overflow and bucket is referenced by a single slot, grow directory
+      int depth = globalDepth;
+      bucket->latch.WUnlock();
+      tableLatch.RUnlock();
+      growDirectory(depth);
+      continue;
+    }
+    bucket->latch.WUnlock();
+    tableLatch.RUnlock();
+    return;
+  }
 }
 
 template class ExtendibleHash<page_id_t, Page *>;
@@ -145,4 +408,6 @@ template class ExtendibleHash<Page *, std::list<Page *>::iterator>;
 template class ExtendibleHash<int, std::string>;
 template class ExtendibleHash<int, std::list<int>::iterator>;
 template class ExtendibleHash<int, int>;
+template class ExtendibleHash<int, std::string, IdentityHash<int>>;
+template class ExtendibleHash<int, int, IdentityHash<int>>;
 } // namespace scudb
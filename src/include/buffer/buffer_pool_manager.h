@@ -26,15 +26,27 @@ public:
 
   Page *FetchPage(page_id_t page_id);   
 
+  Page *FetchChildPage(Page *parent, int index, page_id_t page_id);
+
   bool UnpinPage(page_id_t page_id, bool is_dirty);
 
+  bool UnpinFrame(Page *page, bool is_dirty);
+
   bool FlushPage(page_id_t page_id);
 
   Page *NewPage(page_id_t &page_id);
 
   bool DeletePage(page_id_t page_id);
 
+  void PrefetchPage(page_id_t page_id);
+
 private:
+  Page *FetchPageLatched(page_id_t page_id);
+
+  bool FreeFrame(Page *page);
+
+  bool ClaimVictim(Page *&page);
+
   size_t pool_size_; // number of pages in buffer pool
   Page *pages_;      // array of pages
   DiskManager *disk_manager_;        //̹ 
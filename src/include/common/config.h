@@ -16,6 +16,26 @@ extern std::chrono::duration<long long int> LOG_TIMEOUT;
 
 extern std::atomic<bool> ENABLE_LOGGING;
 
+// index scans ask the OS to read the next leaf ahead, off by default
+extern std::atomic<bool> ENABLE_PREFETCH;
+
+// optional features of a B+ tree, chosen per tree (see index/b_plus_tree.h)
+// and per index in the vtable CREATE statement. All off by default
+struct BPlusTreeOptions {
+  // point lookups of hot keys go straight to their leaf
+  bool adaptive_hash = false;
+  // inserts and removes are buffered and reach the leaves in batches
+  bool write_buffer = false;
+  // removes leave underfull leaves to a background compaction
+  bool deferred_merge = false;
+  // descents follow the child frames the parent frame keeps
+  bool swizzling = false;
+
+  bool Any() const {
+    return adaptive_hash || write_buffer || deferred_merge || swizzling;
+  }
+};
+
 #define INVALID_PAGE_ID -1 // representing an invalid page id
 #define INVALID_TXN_ID -1  // representing an invalid txn id
 #define INVALID_LSN -1     // representing an invalid lsn
@@ -25,6 +45,17 @@ extern std::atomic<bool> ENABLE_LOGGING;
   ((BUFFER_POOL_SIZE + 1) * PAGE_SIZE) // size of a log buffer in byte
 #define BUCKET_SIZE 50                 // size of extendible hash bucket
 #define BUFFER_POOL_SIZE 10            // size of buffer pool
+#define BULK_LOAD_FILL_FACTOR 0.9      // node fill of B+ tree index builds
+#define APPEND_SPLIT_SHARE 0.9         // left share of B+ tree right edge splits
+#define ADAPTIVE_HASH_SIZE 1024        // hot keys cached per B+ tree
+#define BLOOM_FILTER_MIN_KEYS 1024     // keys an index Bloom filter starts with
+#define WRITE_BUFFER_SIZE 4096         // pending writes of a buffered B+ tree
+#define COMPACTION_UNDERFULL_LEAVES 64 // underfull leaves that wake compaction
+#define MERGE_FILL_FACTOR 0.25         // leaf fill deferred merges start below
+#define STATISTICS_SAMPLE_LEAVES 32    // leaves B+ tree statistics sample
+#define STATISTICS_MIN_CHANGES 64      // writes B+ tree statistics outlast
+#define STATISTICS_STALE_SHARE 0.1     // and share of the entries they outlast
+#define SWIZZLED_CHILDREN 64           // child frames an internal frame keeps
 
 typedef int32_t page_id_t; // page id type
 typedef int32_t txn_id_t;  // transaction id type
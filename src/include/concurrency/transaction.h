@@ -31,6 +31,7 @@ enum class TransactionState { GROWING, SHRINKING, COMMITTED, ABORTED };
 enum class WType { INSERT = 0, DELETE, UPDATE };
 
 class TableHeap;
+class Index;
 
 // write set record
 class WriteRecord {
@@ -46,6 +47,21 @@ public:
   TableHeap *table_;
 };
 
+// index write set record, undone on abort like the write set of the heap
+class IndexWriteRecord {
+public:
+  IndexWriteRecord(RID rid, WType wtype, const Tuple &entry, Index *index)
+      : rid_(rid), wtype_(wtype), entry_(entry), index_(index) {}
+
+  RID rid_;
+  // INSERT or DELETE of the entry
+  WType wtype_;
+  // index entry of the tuple, see Index::GetEntrySchema
+  Tuple entry_;
+  // which index
+  Index *index_;
+};
+
 class Transaction {
 public:
   Transaction(Transaction const &) = delete;
@@ -56,6 +72,7 @@ public:
         exclusive_lock_set_{new std::unordered_set<RID>} {
     // initialize sets
     write_set_.reset(new std::deque<WriteRecord>);
+    index_write_set_.reset(new std::deque<IndexWriteRecord>);
     page_set_.reset(new std::deque<Page *>);
     deleted_page_set_.reset(new std::unordered_set<page_id_t>);
   }
@@ -73,6 +90,10 @@ public:
     return write_set_;
   }
 
+  inline std::shared_ptr<std::deque<IndexWriteRecord>> GetIndexWriteSet() {
+    return index_write_set_;
+  }
+
   inline std::shared_ptr<std::deque<Page *>> GetPageSet() { return page_set_; }
 
   inline void AddIntoPageSet(Page *page) { page_set_->push_back(page); }
@@ -109,6 +130,8 @@ private:
   txn_id_t txn_id_;
   // Below are used by transaction, undo set
   std::shared_ptr<std::deque<WriteRecord>> write_set_;
+  // undo set of the index entries
+  std::shared_ptr<std::deque<IndexWriteRecord>> index_write_set_;
   // prev lsn
   lsn_t prev_lsn_;
 
@@ -21,6 +21,11 @@ public:
   Transaction *Begin();
   void Commit(Transaction *txn);
   void Abort(Transaction *txn);
+  // undo the writes past the first write_count records of the write set and
+  // the first index_write_count of the index write set, the transaction goes
+  // on. Statement savepoints of the vtable use it
+  void RollbackTo(Transaction *txn, size_t write_count,
+                  size_t index_write_count);
 
 private:
   std::atomic<txn_id_t> next_txn_id_;
@@ -24,6 +24,8 @@ public:
 
   void WritePage(page_id_t page_id, const char *page_data);
   void ReadPage(page_id_t page_id, char *page_data);
+  // start reading the page into the OS cache without waiting for it
+  void PrefetchPage(page_id_t page_id);
 
   void WriteLog(char *log_data, int size);
   bool ReadLog(char *log_data, int size, int offset);
@@ -41,9 +43,10 @@ private:
   // stream to write log file
   std::fstream log_io_;
   std::string log_name_;
-  // stream to write db file
-  std::fstream db_io_;
   std::string file_name_;
+  // descriptor of the db file, pages are read and written with pread and
+  // pwrite, and read-ahead hints are given on it
+  int db_fd_;
   std::atomic<page_id_t> next_page_id_;
   int num_flushes_;
   bool flush_log_;
@@ -0,0 +1,103 @@
+/**
+ * disk_extendible_hash_table.h
+ *
+ * Implementation of a disk-resident extendible hash table whose pages live in
+ * the buffer pool.
+ * (1) We only support unique key
+ * (2) Three levels of pages: one header page, directory pages selected by the
+ * high bits of the hash and bucket pages selected by the low bits
+ * (3) Buckets split on overflow and merge with their split image once empty,
+ * directories grow and shrink accordingly
+ * (4) A full bucket that can not split any more, its directory being at
+ * HTABLE_DIRECTORY_MAX_DEPTH, links overflow pages from its primary page
+ *
+ * Concurrency: the table is guarded by a reader-writer latch. Lookups, and
+ * inserts/removes that neither split nor merge a bucket, hold it in shared
+ * mode and only latch the bucket page they touch. Anything that allocates,
+ * splits or frees a page retries with the table latch held exclusively, so
+ * header and directory pages are only written by a single thread. Overflow
+ * pages are only reached through the primary page of their bucket, so they
+ * are read, written and freed under its latch.
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/rwmutex.h"
+#include "concurrency/transaction.h"
+#include "hash/hash_function.h"
+#include "page/hash_table_bucket_page.h"
+#include "page/hash_table_directory_page.h"
+#include "page/hash_table_header_page.h"
+
+namespace scudb {
+
+#define HASH_TABLE_TYPE                                                        \
+  DiskExtendibleHashTable<KeyType, ValueType, KeyComparator>
+
+HASH_TABLE_TEMPLATE_ARGUMENTS
+class DiskExtendibleHashTable {
+public:
+  explicit DiskExtendibleHashTable(const std::string &name,
+                                   BufferPoolManager *buffer_pool_manager,
+                                   const KeyComparator &comparator,
+                                   page_id_t header_page_id = INVALID_PAGE_ID);
+
+  // Returns true if no page has been allocated yet.
+  bool IsEmpty() const;
+
+  // Insert a key-value pair, false on duplicate key.
+  bool Insert(const KeyType &key, const ValueType &value,
+              Transaction *transaction = nullptr);
+
+  // Remove a key and its value, false if the key does not exist.
+  bool Remove(const KeyType &key, Transaction *transaction = nullptr);
+
+  // return the value associated with a given key
+  bool GetValue(const KeyType &key, std::vector<ValueType> &result,
+                Transaction *transaction = nullptr);
+
+  page_id_t GetHeaderPageId() const;
+
+  // expose for test purpose
+  uint32_t GetGlobalDepth(const KeyType &key);
+  bool VerifyIntegrity();
+
+private:
+  uint32_t Hash(const KeyType &key) const;
+
+  Page *FetchPage(page_id_t page_id);
+  Page *NewPage(page_id_t &page_id);
+  HASH_TABLE_BUCKET_TYPE *FetchBucket(page_id_t page_id);
+
+  // the pages of the bucket, from its primary page on (see Insert)
+  bool ChainLookup(HASH_TABLE_BUCKET_TYPE *bucket, const KeyType &key,
+                   ValueType &value);
+  bool ChainAppend(HASH_TABLE_BUCKET_TYPE *bucket,
+                   const std::pair<KeyType, ValueType> &item, bool allocate);
+  bool ChainRemove(HASH_TABLE_BUCKET_TYPE *bucket, const KeyType &key);
+  bool IsChainEmpty(HASH_TABLE_BUCKET_TYPE *bucket) const;
+  void TakeChain(HASH_TABLE_BUCKET_TYPE *bucket,
+                 std::vector<std::pair<KeyType, ValueType>> &items);
+
+  // bucket page that hash maps to, INVALID_PAGE_ID if there is none yet
+  page_id_t FindBucketPageId(uint32_t hash);
+
+  void StartNewTable();
+  page_id_t StartNewDirectory();
+  bool SplitInsert(const KeyType &key, const ValueType &value, uint32_t hash);
+  void MergeBucket(uint32_t hash);
+
+  void UpdateRootPageId(int insert_record = false);
+
+  // member variable
+  std::string index_name_;
+  page_id_t header_page_id_;
+  BufferPoolManager *buffer_pool_manager_;
+  KeyComparator comparator_;
+  RWMutex table_latch_;
+};
+
+} // namespace scudb
@@ -5,34 +5,63 @@
  * Functionality: The buffer pool manager must maintain a page table to be able
  * to quickly map a PageId to its corresponding memory location; or alternately
  * report that the PageId does not match any currently-buffered page.
+ *
+ * Concurrency: the directory is protected by a reader-writer latch and every
+ * bucket carries its own latch. Find/Insert/Remove hold the directory latch in
+ * shared mode and only latch the bucket they touch, so operations on different
+ * buckets run in parallel. A bucket whose local depth is below the global depth
+ * is split in place while holding its own latch; only a split that has to
+ * double the directory takes the directory latch in exclusive mode.
+ *
+ * Shrinking: a Remove that empties a bucket merges it with its split image
+ * (when both have the same local depth) and halves the directory while no
+ * bucket uses the highest directory bit. Merging frees buckets, so it runs
+ * with the directory latch held exclusively, which guarantees no other thread
+ * is holding a pointer to a bucket.
  */
 
 #pragma once
 
+#include <atomic>
 #include <cstdlib>
 #include <vector>
 #include <string>
-#include <map>
 #include <memory>
 #include <mutex>
 
+#include "common/rwmutex.h"
+#include "hash/hash_function.h"
 #include "hash/hash_table.h"
-using std::map;
 using std::vector;
 using std::mutex;
 
 namespace scudb {
 
-template <typename K, typename V>
+/*
+ * Hash is the hash policy (see hash/hash_function.h), the directory is
+ * indexed by the low bits of Hash()(key).
+ */
+template <typename K, typename V, typename Hash = DefaultHash<K>>
 class ExtendibleHash : public HashTable<K, V> {
+  // fixed-capacity bucket, keys are kept apart from values so that a probe
+  // scans one contiguous array (vectorized for integral and pointer keys)
   struct Bucket {
-    Bucket(int depth) : localDepth(depth) {};
-    int localDepth;      //ֲ ÿͰһλȣʾǰͰԪصĵͼλһġ
-    map<K, V> items;     //keyֱӽзʵݽṹͨѹؼӳ䵽һλʼ¼
-  };                  //ͰǴ¼ĵط
+    Bucket(int depth, size_t capacity)
+        : localDepth(depth), size(0), keys(new K[capacity]),
+          values(new V[capacity]) {};
+    int localDepth;      // number of low hash bits shared by all items
+    size_t size;         // number of key/value pairs in use
+    std::unique_ptr<K[]> keys;   // keys[0, size)
+    std::unique_ptr<V[]> values; // values[i] belongs to keys[i]
+    RWMutex latch;       // protects localDepth, size, keys and values
+  };
+  // directory slot, may be redirected by a concurrent in-place split
+  typedef std::atomic<Bucket *> Slot;
+
 public:
   // constructor
   ExtendibleHash(size_t size);
+  ~ExtendibleHash();
   // helper function to generate hash addressing
   size_t HashKey(const K &key);
   // helper function to get global & local depth
@@ -43,16 +72,26 @@ public:
   bool Find(const K &key, V &value) override;
   bool Remove(const K &key) override;
   void Insert(const K &key, const V &value) override;
-  
 
 private:
   // add your own member variables here
-  int getBucketIndex(const K &key);     //һؼ֣ǹؼֶӦbucketλ
-  int globalDepth;         //ȫȱʾȡϣֵĵͼλΪ, ҹϣʼյ2^Global Depth
-  size_t bucketMaxSize;    //ÿbucketװļֵԵֵΪbucketMaxSize   size_t ͱʾCκζܴﵽ󳤶ȣ޷͡
-  int numBucket;            //ϣĳ
-  vector<std::shared_ptr<Bucket>> bucketTable;   //ϣ  
-  mutex mutex1;      //mutex 
+  int getBucketIndex(const K &key);
+  // latch the bucket that currently owns key, directory latch must be held
+  Bucket *latchBucket(const K &key, bool exclusive);
+  // index of key within bucket, -1 if absent
+  int findSlot(const Bucket *bucket, const K &key) const;
+  // split a full bucket whose local depth is below the global depth
+  void splitBucket(Bucket *bucket);
+  // double the directory unless another thread already grew it past depth
+  void growDirectory(int depth);
+  // merge empty buckets on the path of key and halve the directory if possible
+  void mergeBucket(const K &key);
 
+  int globalDepth;         // number of low hash bits used to index directory
+  size_t bucketMaxSize;    // max number of key/value pairs in one bucket
+  std::atomic<int> numBucket; // number of distinct buckets in directory
+  std::unique_ptr<Slot[]> bucketTable; // directory, 2^globalDepth slots
+  mutable RWMutex tableLatch;          // protects globalDepth and bucketTable
+  Hash hashFunction;                   // hash policy
 };
 } // namespace scudb
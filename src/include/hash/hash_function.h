@@ -0,0 +1,90 @@
+/**
+ * hash_function.h
+ *
+ * Hash policies for ExtendibleHash.
+ *
+ * ExtendibleHash selects a directory slot with the low GlobalDepth bits of the
+ * hash, so a policy has to spread the entropy of the whole key into its low
+ * bits. std::hash is the identity for integers on libstdc++, which makes keys
+ * that share their low bits (strided page ids, aligned pointers) collide
+ * until the directory grows past the stride.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <type_traits>
+
+namespace scudb {
+
+// 64-bit finalizer of MurmurHash3: every input bit affects every output bit
+inline uint64_t MixHash64(uint64_t x) {
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+// hash of a byte string (varchar keys, serialized index keys), consumes
+// 8 bytes per step and finishes with the 64-bit finalizer
+inline uint64_t HashBytes(const char *data, size_t length,
+                          uint64_t seed = 0x9e3779b97f4a7c15ULL) {
+  uint64_t hash = seed ^ (length * 0xc6a4a7935bd1e995ULL);
+  size_t i = 0;
+  for (; i + 8 <= length; i += 8) {
+    uint64_t word;
+    memcpy(&word, data + i, 8);
+    hash = (hash ^ MixHash64(word)) * 0x9e3779b97f4a7c15ULL;
+  }
+  if (i < length) {
+    uint64_t word = 0;
+    memcpy(&word, data + i, length - i);
+    hash = (hash ^ MixHash64(word)) * 0x9e3779b97f4a7c15ULL;
+  }
+  return MixHash64(hash);
+}
+
+/**
+ * Default hash policy: mixes integral and pointer keys, hashes the bytes of
+ * strings and falls back to mixing std::hash for any other key type.
+ */
+template <typename K, typename Enable = void> struct DefaultHash {
+  inline size_t operator()(const K &key) const {
+    return MixHash64(std::hash<K>{}(key));
+  }
+};
+
+template <typename K>
+struct DefaultHash<K, typename std::enable_if<std::is_integral<K>::value ||
+                                              std::is_enum<K>::value>::type> {
+  inline size_t operator()(const K &key) const {
+    return MixHash64(static_cast<uint64_t>(key));
+  }
+};
+
+template <typename K> struct DefaultHash<K *> {
+  inline size_t operator()(K *const &key) const {
+    return MixHash64(reinterpret_cast<uintptr_t>(key));
+  }
+};
+
+template <> struct DefaultHash<std::string> {
+  inline size_t operator()(const std::string &key) const {
+    return HashBytes(key.data(), key.size());
+  }
+};
+
+/**
+ * Identity hash policy (std::hash), keeps the key bits as the directory
+ * index. Only useful when the exact bucket layout matters, e.g. in tests.
+ */
+template <typename K> struct IdentityHash {
+  inline size_t operator()(const K &key) const { return std::hash<K>{}(key); }
+};
+
+} // namespace scudb
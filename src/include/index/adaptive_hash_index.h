@@ -0,0 +1,100 @@
+/**
+ * adaptive_hash_index.h
+ *
+ * In-memory hash of hot B+ tree keys to the leaf page that holds them, so a
+ * point lookup of a hot key fetches its leaf without descending from the
+ * root (the adaptive hash index of InnoDB, kept for whole keys).
+ *
+ * Every slot belongs to one key and counts its searches: a search of the key
+ * counts up, a search of another key that hashes to the slot counts down, and
+ * the slot goes to the other key once the count is down to zero. A key is
+ * served from the hash once it was counted up kHotSearches times.
+ *
+ * A slot stores the leaf with its version (the LSN of the leaf page, see
+ * page/b_plus_tree_page.h) at the time of the search, the tree compares the
+ * version under the leaf latch and validates the slot again after reading
+ * the leaf. Slots of leaves merged away are left in place: such a leaf is
+ * marked invalid before its page is deleted, page ids are never reused and
+ * a deleted page is written back first, so the page read back for a stale
+ * slot is always the invalid image, and the next search of the key records
+ * its new leaf.
+ */
+#pragma once
+
+#include <mutex>
+#include <vector>
+
+#include "common/config.h"
+#include "hash/hash_function.h"
+
+namespace scudb {
+
+template <typename KeyType, typename KeyComparator> class AdaptiveHashIndex {
+public:
+  AdaptiveHashIndex(size_t size, const KeyComparator &comparator)
+      : slots_(size), comparator_(comparator) {}
+
+  // leaf page and its version cached for key, false if key is not hot
+  bool Lookup(const KeyType &key, page_id_t &page_id, lsn_t &version) {
+    size_t index = SlotIndex(key);
+    std::lock_guard<std::mutex> guard(latches_[index % kLatches]);
+    Slot &slot = slots_[index];
+    if (slot.hits < kHotSearches || comparator_(slot.key, key) != 0)
+      return false;
+    page_id = slot.page_id;
+    version = slot.version;
+    return true;
+  }
+
+  // true if key is still cached in page_id at version
+  bool Validate(const KeyType &key, page_id_t page_id, lsn_t version) {
+    size_t index = SlotIndex(key);
+    std::lock_guard<std::mutex> guard(latches_[index % kLatches]);
+    Slot &slot = slots_[index];
+    return slot.hits >= kHotSearches && slot.page_id == page_id &&
+           slot.version == version && comparator_(slot.key, key) == 0;
+  }
+
+  // count a search of key that descended to the leaf page_id at version, the
+  // leaf is still latched
+  void Record(const KeyType &key, page_id_t page_id, lsn_t version) {
+    size_t index = SlotIndex(key);
+    std::lock_guard<std::mutex> guard(latches_[index % kLatches]);
+    Slot &slot = slots_[index];
+    if (slot.page_id != INVALID_PAGE_ID && comparator_(slot.key, key) == 0) {
+      if (slot.hits < kHotSearches)
+        slot.hits++;
+    } else if (slot.hits > 0) {
+      slot.hits--;
+      return;
+    } else {
+      slot.key = key;
+      slot.hits = 1;
+    }
+    slot.page_id = page_id;
+    slot.version = version;
+  }
+
+private:
+  static const uint32_t kHotSearches = 2;
+  static const size_t kLatches = 16;
+
+  struct Slot {
+    KeyType key;
+    page_id_t page_id = INVALID_PAGE_ID;
+    lsn_t version = INVALID_LSN;
+    uint32_t hits = 0;
+  };
+
+  // keys that compare equal are equal bytewise (see index/generic_key.h)
+  size_t SlotIndex(const KeyType &key) const {
+    return HashBytes(reinterpret_cast<const char *>(&key), sizeof(KeyType)) %
+           slots_.size();
+  }
+
+  std::vector<Slot> slots_;
+  std::mutex latches_[kLatches];
+  KeyComparator comparator_;
+};
+
+} // namespace scudb
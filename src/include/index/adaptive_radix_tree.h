@@ -0,0 +1,63 @@
+/**
+ * adaptive_radix_tree.h
+ *
+ * In-memory adaptive radix tree (Leis et al., ICDE 2013) mapping byte string
+ * keys to rids. Inner nodes branch on one key byte and grow from 4 over 16
+ * and 48 to 256 children as keys are added, shrinking again as they are
+ * removed. A node stores the bytes all keys below it share (path
+ * compression), and a key is kept in a leaf as soon as no other key shares
+ * its next byte (lazy expansion), so lookups compare the whole key once, at
+ * the leaf.
+ *
+ * No key may be a prefix of another. The order preserving key encoding (see
+ * index/key_encoding.h) is prefix free, so is an encoding followed by a
+ * fixed length rid. Keys are ordered bytewise (memcmp).
+ *
+ * The tree is not latched, the owner serializes writers against readers.
+ */
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include "common/rid.h"
+
+namespace scudb {
+
+// leaf or inner node, defined in index/adaptive_radix_tree.cpp
+struct ArtNode;
+
+class AdaptiveRadixTree {
+public:
+  // called for every key of a scan, the scan stops once it returns false
+  using ScanCallback = std::function<bool(const std::string &, const RID &)>;
+
+  AdaptiveRadixTree() : root_(nullptr), size_(0) {}
+  ~AdaptiveRadixTree() { Clear(); }
+
+  AdaptiveRadixTree(const AdaptiveRadixTree &) = delete;
+  AdaptiveRadixTree &operator=(const AdaptiveRadixTree &) = delete;
+
+  // false if key is already in the tree, its value is kept
+  bool Insert(const std::string &key, const RID &value);
+
+  // false if key is not in the tree
+  bool Remove(const std::string &key);
+
+  bool GetValue(const std::string &key, RID &value) const;
+
+  // the keys with low <= key <= high in key order, or in reverse key order
+  // if descending. A nullptr bound leaves that end open
+  void Scan(const std::string *low, const std::string *high, bool descending,
+            const ScanCallback &callback) const;
+
+  inline size_t Size() const { return size_; }
+
+  void Clear();
+
+private:
+  ArtNode *root_;
+  size_t size_;
+};
+
+} // namespace scudb
@@ -0,0 +1,91 @@
+/**
+ * art_index.h
+ *
+ * Index kept in memory in an adaptive radix tree over the encoded entries
+ * (see index/key_encoding.h), for tables that fit in memory. Nothing of it
+ * is written to disk, VtabConnect builds it from the table heap.
+ *
+ * The tree keys are laid out like the keys of a B+ tree index (see
+ * index/generic_key.h): the key columns, the rid for non-unique indexes and
+ * indexes with included columns, then the included columns. They are never
+ * truncated, so the index is always covering.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "common/rwmutex.h"
+#include "index/adaptive_radix_tree.h"
+#include "index/index.h"
+
+namespace scudb {
+
+class ArtIndex : public Index {
+
+public:
+  explicit ArtIndex(IndexMetadata *metadata);
+
+  ~ArtIndex() {}
+
+  bool InsertEntry(const Tuple &key, RID rid,
+                   Transaction *transaction = nullptr) override;
+
+  void DeleteEntry(const Tuple &key, RID rid,
+                   Transaction *transaction = nullptr) override;
+
+  void ScanKey(const Tuple &key, std::vector<RID> &result,
+               Transaction *transaction = nullptr) override;
+
+  bool IsOrdered() const override { return true; }
+
+  void ScanRange(const Tuple *low, const Tuple *high, bool descending,
+                 std::vector<RID> &result,
+                 Transaction *transaction = nullptr) override;
+
+  bool IsCovering() const override { return true; }
+
+  void ScanKeyEntries(const Tuple &key, std::vector<RID> &result,
+                      std::vector<Tuple> &entries,
+                      Transaction *transaction = nullptr) override;
+
+  void ScanRangeEntries(const Tuple *low, const Tuple *high, bool descending,
+                        std::vector<RID> &result, std::vector<Tuple> &entries,
+                        Transaction *transaction = nullptr) override;
+
+  // number of entries
+  size_t Size();
+
+protected:
+  // true if tree keys carry the rid: non-unique indexes and indexes with
+  // included columns
+  bool HasRidInKey() const;
+
+  // the first key_columns columns of tuple, rid if not nullptr and the
+  // remaining columns of schema
+  std::string Encode(const Tuple &tuple, Schema *schema, int key_columns,
+                     const RID *rid) const;
+
+  // first and last tree key of the entries of key
+  std::string LowKey(const Tuple &key) const;
+  std::string HighKey(const Tuple &key) const;
+
+  // the entry stored in a tree key
+  Tuple GetEntry(const std::string &tree_key) const;
+
+  // ScanRange of a key or of a range, entries are only decoded if not
+  // nullptr. The latch is held
+  void Collect(const std::string *low, const std::string *high,
+               bool descending, std::vector<RID> &result,
+               std::vector<Tuple> *entries);
+
+  // longest tree key without varchars that escape 0x00 bytes
+  size_t max_key_length_;
+
+  AdaptiveRadixTree tree_;
+  // shared by lookups, exclusive for inserts and deletes
+  RWMutex latch_;
+};
+
+} // namespace scudb
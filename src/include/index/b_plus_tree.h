@@ -3,34 +3,70 @@
  *
  * Implementation of simple b+ tree data structure where internal pages direct
  * the search and leaf pages contain actual data.
- * (1) We only support unique key
+ * (1) Keys are unique, non-unique indexes append the rid to the key
  * (2) support insert & remove
  * (3) The structure should shrink and grow dynamically
  * (4) Implement index iterator for range scan
  */
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
 #include <queue>
+#include <random>
+#include <thread>
 #include <vector>
 
+#include "common/rwmutex.h"
 #include "concurrency/transaction.h"
+#include "index/adaptive_hash_index.h"
 #include "index/index_iterator.h"
+#include "index/write_buffer.h"
 #include "page/b_plus_tree_internal_page.h"
 #include "page/b_plus_tree_leaf_page.h"
+#include "page/header_page.h"
 
 namespace scudb {
 
 #define BPLUSTREE_TYPE BPlusTree<KeyType, ValueType, KeyComparator>
+
+// kind of operation a tree descent serves, decides which pages are safe.
+// LAZY_DELETE is a remove with deferred merges, MERGE the compaction of an
+// underfull leaf.
+enum class Operation { READ = 0, INSERT, DELETE, LAZY_DELETE, MERGE };
+
+// page counts of a B+ tree, fan-out is children / internal_pages and leaf
+// occupancy is entries / leaf_pages
+struct BPlusTreeShape {
+  int height = 0;          // number of levels, 0 for an empty tree
+  int leaf_pages = 0;
+  int internal_pages = 0;
+  int64_t entries = 0;     // key/value pairs over all leaves
+  int64_t children = 0;    // child pointers over all internal pages
+  int underfull_leaves = 0; // leaves but the root less than half full
+};
+
 // Main class providing the API for the Interactive B+ Tree.
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTree {
+  // reverse iterators descend again when they can not latch the previous leaf
+  friend class IndexIterator<KeyType, ValueType, KeyComparator>;
+
 public:
   explicit BPlusTree(const std::string &name,
                            BufferPoolManager *buffer_pool_manager,
                            const KeyComparator &comparator,
-                           page_id_t root_page_id = INVALID_PAGE_ID);
+                           page_id_t root_page_id = INVALID_PAGE_ID,
+                           const BPlusTreeOptions &options =
+                               BPlusTreeOptions());
+
+  // applies the buffered writes and stops the compaction thread
+  ~BPlusTree();
 
-  // Returns true if this B+ tree has no keys and values.
+  // Returns true if this B+ tree has no keys and values. Buffered writes are
+  // not counted.
   bool IsEmpty() const;
 
   // Insert a key-value pair into this B+ tree.
@@ -44,9 +80,51 @@ public:
   bool GetValue(const KeyType &key, std::vector<ValueType> &result,
                 Transaction *transaction = nullptr);
 
+  // look up a batch of keys in one left-to-right pass, appends the values
+  // found in key order and returns how many there were
+  size_t GetValues(const std::vector<KeyType> &keys,
+                   std::vector<ValueType> &result,
+                   Transaction *transaction = nullptr);
+
+  // batch of inclusive key ranges [first, second], appends the values of
+  // every range in order of their low keys and returns how many there were
+  size_t GetRanges(const std::vector<std::pair<KeyType, KeyType>> &ranges,
+                   std::vector<ValueType> &result,
+                   Transaction *transaction = nullptr);
+
+  // Build this B+ tree bottom-up from pairs in strictly ascending key order,
+  // every node is filled to fill_factor of its capacity in bytes. Only valid
+  // on an empty tree.
+  bool BulkLoad(const std::vector<MappingType> &items,
+                double fill_factor = 1.0);
+
+  // Merge or redistribute every leaf but the root that is less than
+  // MERGE_FILL_FACTOR full. Returns the number of pages freed.
+  size_t Compact(Transaction *transaction = nullptr);
+
+  // Estimated statistics for the planner. same_key tells whether two keys
+  // have the same key columns, without it every key is distinct.
+  // The size of the tree is estimated from random descents, each leaf reached
+  // standing for the product of the fan-outs on its path. The estimate is
+  // kept in the header page next to the root id and sampled again once the
+  // writes since outnumber STATISTICS_MIN_CHANGES plus a share of
+  // STATISTICS_STALE_SHARE of the entries.
+  IndexStatistics GetStatistics(
+      const std::function<bool(const KeyType &, const KeyType &)> &same_key =
+          nullptr);
+
   // index iterator
   INDEXITERATOR_TYPE Begin();
   INDEXITERATOR_TYPE Begin(const KeyType &key);
+  INDEXITERATOR_TYPE Begin(const KeyType &key, const KeyType &end_key);
+  // reverse index iterator, walks from large keys to small ones
+  INDEXITERATOR_TYPE RBegin();
+  INDEXITERATOR_TYPE RBegin(const KeyType &key);
+  INDEXITERATOR_TYPE RBegin(const KeyType &key, const KeyType &end_key);
+
+  // Count pages and entries level by level, pins one page at a time. Not
+  // latched, like ToString it is meant for a quiescent tree.
+  BPlusTreeShape GetShape();
 
   // Print this B+ tree to stdout using a simple command-line
   std::string ToString(bool verbose = false);
@@ -58,11 +136,143 @@ public:
   // read data from file and remove one by one
   void RemoveFromFile(const std::string &file_name,
                       Transaction *transaction = nullptr);
-  // expose for test purpose
+  // expose for test purpose, the returned leaf is pinned and read latched
   B_PLUS_TREE_LEAF_PAGE_TYPE *FindLeafPage(const KeyType &key,
                                            bool leftMost = false);
 
 private:
+  Page *FetchPage(page_id_t page_id);
+  // With the swizzling option the child is fetched through the frame of its
+  // parent, which keeps the frames of the children it reached: a child still
+  // buffered is pinned without a page table lookup or the latch of the buffer
+  // pool manager (see BufferPoolManager::FetchChildPage).
+  Page *FetchChildPage(Page *parent, int index, page_id_t page_id);
+  Page *NewPage(page_id_t &page_id);
+
+  // Insert, Remove and the lookup of GetValue on the tree itself
+  bool InsertIntoTree(const KeyType &key, const ValueType &value,
+                      Transaction *transaction);
+  void RemoveFromTree(const KeyType &key, Transaction *transaction);
+  bool LookupInTree(const KeyType &key, ValueType &value);
+
+  // With the deferred_merge option, a remove only merges or redistributes a
+  // leaf it empties, so a leaf drained and refilled around half full no
+  // longer merges and splits in turn, and most removes latch the leaf only.
+  // A deferred remove of key left its leaf less than MERGE_FILL_FACTOR full,
+  // wakes the compaction thread (starting it the first time) once
+  // COMPACTION_UNDERFULL_LEAVES keys are pending. The thread merges the
+  // leaves of these keys that are still as empty, like an immediate remove
+  // would have.
+  void AddUnderfullLeaf(const KeyType &key);
+  // merge or redistribute the leaves of keys that are still less than
+  // MERGE_FILL_FACTOR full, returns the number of pages freed
+  size_t MergeUnderfullLeaves(const std::vector<KeyType> &keys,
+                              Transaction *transaction);
+  // body of the compaction thread
+  void RunCompaction();
+
+  // sample STATISTICS_SAMPLE_LEAVES leaves, stats_mutex_ is held
+  IndexStatistics SampleStatistics(
+      const std::function<bool(const KeyType &, const KeyType &)> &same_key);
+  // descend to a random leaf, which is pinned and read latched. weight is the
+  // product of the fan-outs on the way, nullptr if the tree is empty or the
+  // descent ran into a merged page
+  Page *FindRandomLeafPage(double &weight, int &height);
+
+  // With the write_buffer option, Insert and Remove only add a message to
+  // write_buffer_ (see index/write_buffer.h), a single buffer for the whole
+  // tree. Once it holds WRITE_BUFFER_SIZE messages, the ones for the child
+  // of the root with the most messages are applied in key order with one
+  // descent per leaf they reach, so a leaf is read and written once for a
+  // run of messages. Point lookups check the buffer before the tree. Scans
+  // and batched lookups apply all messages first.
+  typedef std::pair<
+      KeyType, typename WriteBuffer<KeyType, ValueType, KeyComparator>::Message>
+      BufferedMessage;
+  // apply every buffered message
+  void FlushWriteBuffer(Transaction *transaction = nullptr);
+  // apply the messages for the child of the root with the most messages,
+  // buffer_latch_ is write held
+  void FlushBusiestChild(Transaction *transaction);
+  // apply messages taken from the buffer in key order
+  void ApplyMessages(const std::vector<BufferedMessage> &messages,
+                     Transaction *transaction);
+  // apply messages from begin on to the leaf of the first one, returns the
+  // end of the messages applied
+  size_t ApplyToLeaf(const std::vector<BufferedMessage> &messages,
+                     size_t begin);
+
+  // The tree is a B-link tree (Lehman and Yao). Every page is linked to its
+  // right neighbour on the same level and every page but the last one of a
+  // level has a high key, the separator between it and that neighbour.
+  // Readers descend holding one latch at a time: the child is pinned under
+  // the parent latch, which is released before the child is latched. A split
+  // in between moves the upper keys into a new right neighbour, so a reader
+  // whose key is not below the high key follows the right link. Pages merged
+  // away are marked invalid and send readers back to the root; keys never
+  // move into a left sibling, the one change moving right can not recover
+  // from.
+  //
+  // B-link descent to the leaf, which is write latched if exclusive_leaf,
+  // returns nullptr on an empty tree. With prefetch_end the sibling leaves
+  // between key and that key are prefetched from the leaf's parent
+  Page *FindLeafPageOptimistic(const KeyType &key, bool leftMost,
+                               bool exclusive_leaf,
+                               const KeyType *prefetch_end = nullptr,
+                               bool rightMost = false);
+
+  // Writers first descend optimistically and only write latch the leaf; if
+  // the leaf would split or underflow they restart here from the root,
+  // keeping latched every ancestor that the split or merge may reach and
+  // freeing merged pages once all latches are released
+  // (Transaction::deleted_page_set_).
+  //
+  // write latch crabbing down to the leaf, unsafe ancestors stay latched in
+  // the page set of transaction, returns nullptr on an empty tree
+  Page *FindLeafPagePessimistic(const KeyType &key, Operation op,
+                                Transaction *transaction);
+
+  // true if node has a high key and key is not below it, the key moved to
+  // the right neighbour of node
+  bool IsPastHighKey(BPlusTreePage *node, const KeyType &key);
+  // right neighbour of node on its level
+  page_id_t GetNextPageId(BPlusTreePage *node) const;
+
+  // true if op on node can not propagate to its parent
+  bool IsSafe(BPlusTreePage *node, Operation op) const;
+
+  // unlatch and unpin every page in the page set (and the root latch), then
+  // delete the pages in the deleted page set
+  void ReleasePageSet(Transaction *transaction, bool is_dirty);
+
+  // Ascending inserts go straight to the last leaf: while inserts keep
+  // landing at its end, its page id is kept in last_leaf_page_id_ and the
+  // next insert latches it without descending. A split there leaves the left
+  // page APPEND_SPLIT_SHARE full instead of half.
+  //
+  // insert past the last key of the cached last leaf, false if there is no
+  // such leaf or key does not go to its end, leaf_full if it has no room
+  bool AppendToLastLeaf(const KeyType &key, const ValueType &value,
+                        bool &leaf_full);
+  // cache leaf (write latched) for the next insert if key went to its end and
+  // it is the last leaf, forget the cached leaf otherwise
+  void UpdateLastLeaf(B_PLUS_TREE_LEAF_PAGE_TYPE *leaf, const KeyType &key);
+  // forget page_id as last leaf, it is merged away
+  void ForgetLastLeaf(page_id_t page_id);
+
+  // With the adaptive_hash option, GetValue keeps the leaves of hot keys in
+  // adaptive_hash_ and reads them without descending while the version of the
+  // leaf shows that no pair moved out of it since (see
+  // index/adaptive_hash_index.h).
+  //
+  // look key up in the leaf the adaptive hash index caches for it, false if
+  // key is not hot or the leaf changed, found and value are set otherwise
+  bool AdaptiveHashLookup(const KeyType &key, ValueType &value, bool &found);
+
+  bool OptimisticInsert(const KeyType &key, const ValueType &value,
+                        bool &inserted);
+  bool OptimisticRemove(const KeyType &key, bool deferred);
+
   void StartNewTree(const KeyType &key, const ValueType &value);
 
   bool InsertIntoLeaf(const KeyType &key, const ValueType &value,
@@ -79,11 +289,17 @@ private:
 
   template <typename N>
   bool Coalesce(
-      N *&neighbor_node, N *&node,
-      BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *&parent,
+      N *left, N *right,
+      BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *parent,
       int index, Transaction *transaction = nullptr);
 
-  template <typename N> void Redistribute(N *neighbor_node, N *node, int index);
+  template <typename N> void Redistribute(N *left, N *right, int index);
+
+  // index of the largest key <= key in the leaf of page, -1 if none
+  int ReverseKeyIndex(Page *page, const KeyType &key);
+
+  // point the prev link of the leaf after leaf back at leaf
+  void RelinkNextLeaf(B_PLUS_TREE_LEAF_PAGE_TYPE *leaf);
 
   bool AdjustRoot(BPlusTreePage *node);
 
@@ -94,6 +310,35 @@ private:
   page_id_t root_page_id_;
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
+  const BPlusTreeOptions options_;
+  // guards root_page_id_, a pessimistic writer keeps it while the root itself
+  // may change
+  RWMutex root_latch_;
+  // last leaf while inserts append to it, INVALID_PAGE_ID otherwise
+  std::atomic<page_id_t> last_leaf_page_id_;
+  // no slots without the adaptive_hash option
+  AdaptiveHashIndex<KeyType, KeyComparator> adaptive_hash_;
+  // pending writes, read latched by lookups and write latched by writes
+  WriteBuffer<KeyType, ValueType, KeyComparator> write_buffer_;
+  RWMutex buffer_latch_;
+  // number of messages in write_buffer_, checked without the latch
+  std::atomic<size_t> buffered_;
+  // keys of leaves deferred removes left underfull, not merged yet
+  std::vector<KeyType> underfull_keys_;
+  // compaction thread, compaction_mutex_ guards underfull_keys_ and starting
+  // and stopping it
+  std::thread compaction_thread_;
+  std::mutex compaction_mutex_;
+  std::condition_variable compaction_cv_;
+  bool stop_compaction_;
+  // statistics of GetStatistics, stats_mutex_ guards them
+  std::mutex stats_mutex_;
+  IndexStatistics stats_;
+  bool stats_loaded_; // stats_ looked up in the header page
+  bool stats_valid_;
+  std::default_random_engine stats_engine_;
+  // inserts and removes since the statistics were sampled
+  std::atomic<int64_t> modifications_;
 };
 
 } // namespace scudb
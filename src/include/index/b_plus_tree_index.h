@@ -1,20 +1,49 @@
 /**
  * b_plus_tree_index.h
+ *
+ * An index with a Bloom filter (IndexMetadata::HasBloomFilter) checks it
+ * before searching the tree for a key. The filter holds the key columns of
+ * every entry inserted since it was built. Deleted keys stay in it, so it is
+ * rebuilt from the tree by the next lookup once a quarter of its keys were
+ * deleted, or once it holds more keys than it was sized for.
  */
 
 #pragma once
 
+#include <atomic>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
+#include "common/rwmutex.h"
 #include "index/b_plus_tree.h"
+#include "index/bloom_filter.h"
 #include "index/index.h"
 
 namespace scudb {
 
 #define BPLUSTREE_INDEX_TYPE BPlusTreeIndex<KeyType, ValueType, KeyComparator>
 
+// point lookup counters of an index with a Bloom filter, see
+// BPlusTreeIndex::GetLookupStats
+struct IndexLookupStats {
+  uint64_t lookups = 0;      // ScanKey and ScanKeyEntries calls
+  uint64_t misses = 0;       // lookups that found no entry
+  uint64_t filtered = 0;     // misses the Bloom filter answered alone
+  uint64_t lookup_nanos = 0; // time spent in lookups
+
+  // share of the misses that passed the Bloom filter and searched the tree
+  double FalsePositiveRate() const {
+    return misses == 0 ? 0 : (double)(misses - filtered) / misses;
+  }
+
+  double MeanLatencyMicros() const {
+    return lookups == 0 ? 0 : lookup_nanos / 1e3 / lookups;
+  }
+};
+
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeIndex : public Index {
 
@@ -25,20 +54,110 @@ public:
 
   ~BPlusTreeIndex() {}
 
-  void InsertEntry(const Tuple &key, RID rid,
+  bool InsertEntry(const Tuple &key, RID rid,
                    Transaction *transaction = nullptr) override;
 
-  void DeleteEntry(const Tuple &key,
+  void DeleteEntry(const Tuple &key, RID rid,
                    Transaction *transaction = nullptr) override;
 
   void ScanKey(const Tuple &key, std::vector<RID> &result,
                Transaction *transaction = nullptr) override;
 
+  // one pass over the sorted keys, see BPlusTree::GetRanges
+  void ScanKeys(const std::vector<Tuple> &keys, std::vector<RID> &result,
+                Transaction *transaction = nullptr) override;
+
+  bool IsOrdered() const override { return true; }
+
+  void ScanRange(const Tuple *low, const Tuple *high, bool descending,
+                 std::vector<RID> &result,
+                 Transaction *transaction = nullptr) override;
+
+  // entries are decoded from the index keys, InsertEntry refuses entries
+  // whose index key would be truncated
+  bool IsCovering() const override { return true; }
+
+  void ScanKeyEntries(const Tuple &key, std::vector<RID> &result,
+                      std::vector<Tuple> &entries,
+                      Transaction *transaction = nullptr) override;
+
+  void ScanRangeEntries(const Tuple *low, const Tuple *high, bool descending,
+                        std::vector<RID> &result, std::vector<Tuple> &entries,
+                        Transaction *transaction = nullptr) override;
+
+  // sort the keys and bulk load them if the tree is empty
+  bool InsertEntries(const std::vector<std::pair<Tuple, RID>> &entries,
+                     Transaction *transaction = nullptr) override;
+
+  IndexLookupStats GetLookupStats() const;
+
+  // statistics of the tree, distinct keys count the key columns only
+  bool GetStatistics(IndexStatistics &stats) override;
+
 protected:
+  // true if index keys carry the rid: non-unique indexes and indexes with
+  // included columns
+  bool HasRidInKey() const;
+
+  // index key of a key tuple, followed by rid if HasRidInKey()
+  KeyType MakeIndexKey(const Tuple &key, const RID &rid) const;
+
+  // index key of an entry: key columns, rid if HasRidInKey() and included
+  // columns. False if it does not fit into KeyType and is truncated
+  bool MakeEntryKey(const Tuple &entry, const RID &rid,
+                    KeyType &index_key) const;
+
+  // key tuple of an entry
+  Tuple GetKey(const Tuple &entry) const;
+
+  // ScanKey and ScanRange, entries are only decoded if not nullptr
+  void CollectKey(const Tuple &key, std::vector<RID> &result,
+                  std::vector<Tuple> *entries, Transaction *transaction);
+  void CollectRange(const Tuple *low, const Tuple *high, bool descending,
+                    std::vector<RID> &result, std::vector<Tuple> *entries,
+                    Transaction *transaction);
+
+  // the entry stored in index_key
+  Tuple GetEntry(const KeyType &index_key) const;
+
+  // ScanKey and ScanKeyEntries, through the Bloom filter and counted if the
+  // index has one
+  void LookupKey(const Tuple &key, std::vector<RID> &result,
+                 std::vector<Tuple> *entries, Transaction *transaction);
+
+  // hash of the key columns of an index key, the same for all entries of a
+  // key
+  uint64_t KeyHash(const KeyType &index_key) const;
+  // false if no entry has key, true without a Bloom filter
+  bool MayContain(const Tuple &key);
+  void AddToBloomFilter(const KeyType &index_key);
+  // bloom_latch_ is held
+  bool IsBloomFilterStale() const;
+  void RebuildBloomFilter();
+
   // comparator for key
   KeyComparator comparator_;
   // container
   BPlusTree<KeyType, ValueType, KeyComparator> container_;
+
+  // nullptr until the first lookup builds it, a rebuild replaces it under
+  // the write latch
+  std::unique_ptr<BloomFilter> bloom_filter_;
+  RWMutex bloom_latch_;
+  // keys added to and entries deleted from the index since the last build
+  std::atomic<size_t> bloom_keys_;
+  std::atomic<size_t> bloom_deletes_;
+  // held by the rebuilding thread
+  std::mutex rebuild_latch_;
+  // hashes added while a rebuild scans the tree, set under the write latch
+  bool bloom_recording_;
+  std::vector<uint64_t> bloom_added_;
+  std::mutex added_latch_;
+
+  std::atomic<uint64_t> lookups_;
+  std::atomic<uint64_t> misses_;
+  std::atomic<uint64_t> filtered_;
+  std::atomic<uint64_t> lookup_nanos_;
 };
 
 } // namespace scudb
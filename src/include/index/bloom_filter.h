@@ -0,0 +1,64 @@
+/**
+ * bloom_filter.h
+ *
+ * Bloom filter over 64-bit key hashes. A key sets kHashes bits derived from
+ * the two halves of its hash (double hashing), so a key whose bits are not
+ * all set was never added. With kBitsPerKey bits per key about 1% of the
+ * keys never added pass the filter. Bits are set with an atomic or, keys may
+ * be added and probed concurrently. Keys can not be removed, the owner
+ * rebuilds the filter instead.
+ */
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace scudb {
+
+class BloomFilter {
+public:
+  // room for keys keys, at least one word of bits
+  explicit BloomFilter(size_t keys)
+      : capacity_(keys),
+        num_words_(std::max<size_t>(1, (keys * kBitsPerKey + 63) / 64)),
+        words_(new std::atomic<uint64_t>[num_words_]) {
+    for (size_t i = 0; i < num_words_; i++)
+      words_[i].store(0, std::memory_order_relaxed);
+  }
+
+  inline void Add(uint64_t hash) {
+    uint64_t step = (hash >> 32) | 1;
+    for (int i = 0; i < kHashes; i++, hash += step) {
+      size_t bit = hash % (num_words_ * 64);
+      words_[bit / 64].fetch_or(1ULL << (bit % 64), std::memory_order_relaxed);
+    }
+  }
+
+  // false if hash was never added
+  inline bool MayContain(uint64_t hash) const {
+    uint64_t step = (hash >> 32) | 1;
+    for (int i = 0; i < kHashes; i++, hash += step) {
+      size_t bit = hash % (num_words_ * 64);
+      if ((words_[bit / 64].load(std::memory_order_relaxed) &
+           (1ULL << (bit % 64))) == 0)
+        return false;
+    }
+    return true;
+  }
+
+  // number of keys the filter was sized for
+  inline size_t GetCapacity() const { return capacity_; }
+
+private:
+  static const size_t kBitsPerKey = 10;
+  // ln 2 * kBitsPerKey hashes per key let the fewest keys pass
+  static const int kHashes = 7;
+
+  size_t capacity_;
+  size_t num_words_;
+  std::unique_ptr<std::atomic<uint64_t>[]> words_;
+};
+
+} // namespace scudb
@@ -0,0 +1,44 @@
+/**
+ * extendible_hash_table_index.h
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "hash/disk_extendible_hash_table.h"
+#include "index/index.h"
+
+namespace scudb {
+
+#define HASH_TABLE_INDEX_TYPE                                                  \
+  ExtendibleHashTableIndex<KeyType, ValueType, KeyComparator>
+
+HASH_TABLE_TEMPLATE_ARGUMENTS
+class ExtendibleHashTableIndex : public Index {
+
+public:
+  ExtendibleHashTableIndex(IndexMetadata *metadata,
+                           BufferPoolManager *buffer_pool_manager,
+                           page_id_t header_page_id = INVALID_PAGE_ID);
+
+  ~ExtendibleHashTableIndex() {}
+
+  bool InsertEntry(const Tuple &key, RID rid,
+                   Transaction *transaction = nullptr) override;
+
+  void DeleteEntry(const Tuple &key, RID rid,
+                   Transaction *transaction = nullptr) override;
+
+  void ScanKey(const Tuple &key, std::vector<RID> &result,
+               Transaction *transaction = nullptr) override;
+
+protected:
+  // comparator for key
+  KeyComparator comparator_;
+  // container
+  DiskExtendibleHashTable<KeyType, ValueType, KeyComparator> container_;
+};
+
+} // namespace scudb
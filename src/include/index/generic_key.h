@@ -6,51 +6,86 @@
  * This key type uses an fixed length array to hold data for indexing
  * purposes, the actual size of which is specified and instantiated
  * with a template argument.
+ *
+ * The data holds the order preserving encoding of the key columns (see
+ * index/key_encoding.h), zero padded to KeySize, so keys are compared with a
+ * single memcmp. An encoding longer than KeySize is truncated, keys that only
+ * differ past KeySize bytes compare equal, so indexes refuse to store keys
+ * that SetFromKey reports as truncated. Truncated keys still serve as scan
+ * bounds.
+ *
+ * A non-unique index appends the rid of the tuple to the key columns, so the
+ * index keys of tuples with equal key columns are distinct and ordered by
+ * rid. Included columns follow the rid, an index with included columns
+ * always stores it.
  */
 #pragma once
 
+#include <algorithm>
 #include <cstring>
 
+#include "index/key_encoding.h"
 #include "table/tuple.h"
 #include "type/value.h"
 
 namespace scudb {
 template <size_t KeySize> class GenericKey {
 public:
-  inline void SetFromKey(const Tuple &tuple) {
-    // intialize to 0
-    memset(data, 0, KeySize);
-    memcpy(data, tuple.GetData(), tuple.GetLength());
+  // false if the key does not fit into KeySize bytes and is truncated
+  inline bool SetFromKey(const Tuple &tuple, Schema *key_schema) {
+    return EncodeColumns(tuple, key_schema).Length() <= KeySize;
   }
 
-  // NOTE: for test purpose only
-  inline void SetFromInteger(int64_t key) {
+  // key columns followed by rid, for non-unique indexes
+  inline bool SetFromKey(const Tuple &tuple, Schema *key_schema,
+                         const RID &rid) {
+    return SetFromEntry(tuple, key_schema, key_schema->GetColumnCount(), rid);
+  }
+
+  // the first key_columns columns of an entry, rid and the included columns.
+  // False if they do not fit into KeySize bytes: the rid may be cut off then,
+  // and entries of different tuples be taken for one
+  inline bool SetFromEntry(const Tuple &entry, Schema *entry_schema,
+                           int key_columns, const RID &rid) {
     memset(data, 0, KeySize);
-    memcpy(data, &key, sizeof(int64_t));
+    KeyEncoder encoder(data, KeySize);
+    for (int i = 0; i < key_columns; i++)
+      encoder.PutValue(entry.GetValue(entry_schema, i));
+    encoder.PutUnsigned((uint32_t)rid.GetPageId(), 4);
+    encoder.PutUnsigned((uint32_t)rid.GetSlotNum(), 4);
+    for (int i = key_columns; i < entry_schema->GetColumnCount(); i++)
+      encoder.PutValue(entry.GetValue(entry_schema, i));
+    return encoder.Length() <= KeySize;
   }
 
-  inline Value ToValue(Schema *schema, int column_id) const {
-    const char *data_ptr;
-    const TypeId column_type = schema->GetType(column_id);
-    const bool is_inlined = schema->IsInlined(column_id);
-    if (is_inlined) {
-      data_ptr = (data + schema->GetOffset(column_id));
-    } else {
-      int32_t offset = *reinterpret_cast<int32_t *>(
-          const_cast<char *>(data + schema->GetOffset(column_id)));
-      data_ptr = (data + offset);
+  // inverse of SetFromKey / SetFromEntry, the key must not be truncated
+  inline Tuple GetEntry(Schema *entry_schema, int key_columns,
+                        bool has_rid) const {
+    KeyDecoder decoder(data);
+    std::vector<Value> values;
+    for (int i = 0; i < entry_schema->GetColumnCount(); i++) {
+      if (i == key_columns && has_rid)
+        decoder.Skip(2 * sizeof(uint32_t));
+      values.push_back(decoder.GetValue(entry_schema->GetType(i)));
     }
-    return Value::DeserializeFrom(data_ptr, column_type);
+    return Tuple(values, entry_schema);
   }
 
   // NOTE: for test purpose only
-  // interpret the first 8 bytes as int64_t from data vector
+  // encode key like a BIGINT column (INTEGER for keys of less than 8 bytes)
+  inline void SetFromInteger(int64_t key) {
+    memset(data, 0, KeySize);
+    KeyEncoder(data, KeySize).PutSigned(key, IntegerWidth());
+  }
+
+  // NOTE: for test purpose only
+  // decode the integer written by SetFromInteger
   inline int64_t ToString() const {
-    return *reinterpret_cast<int64_t *>(const_cast<char *>(data));
+    return KeyEncoder::GetSigned(data, IntegerWidth());
   }
 
   // NOTE: for test purpose only
-  // interpret the first 8 bytes as int64_t from data vector
+  // decode the integer written by SetFromInteger
   friend std::ostream &operator<<(std::ostream &os, const GenericKey &key) {
     os << key.ToString();
     return os;
@@ -58,29 +93,30 @@ public:
 
   // actual location of data, extends past the end.
   char data[KeySize];
+
+private:
+  inline KeyEncoder EncodeColumns(const Tuple &tuple, Schema *key_schema) {
+    // intialize to 0
+    memset(data, 0, KeySize);
+    KeyEncoder encoder(data, KeySize);
+    for (int i = 0; i < key_schema->GetColumnCount(); i++)
+      encoder.PutValue(tuple.GetValue(key_schema, i));
+    return encoder;
+  }
+
+  static constexpr int IntegerWidth() { return KeySize < 8 ? 4 : 8; }
 };
 
 /**
  * Function object returns true if lhs < rhs, used for trees
+ * Compares the encoded keys bytewise, which is column by column order.
  */
 template <size_t KeySize> class GenericComparator {
 public:
   inline int operator()(const GenericKey<KeySize> &lhs,
                         const GenericKey<KeySize> &rhs) const {
-    int column_count = key_schema_->GetColumnCount();
-
-    for (int i = 0; i < column_count; i++) {
-      Value lhs_value = (lhs.ToValue(key_schema_, i));
-      Value rhs_value = (rhs.ToValue(key_schema_, i));
-
-      if (lhs_value.CompareLessThan(rhs_value) == CMP_TRUE)
-        return -1;
-
-      if (lhs_value.CompareGreaterThan(rhs_value) == CMP_TRUE)
-        return 1;
-    }
-    // equals
-    return 0;
+    int result = memcmp(lhs.data, rhs.data, KeySize);
+    return (result > 0) - (result < 0);
   }
 
   GenericComparator(const GenericComparator &other) {
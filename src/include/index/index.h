@@ -9,11 +9,17 @@
 #include <vector>
 
 #include "catalog/schema.h"
+#include "common/config.h"
+#include "common/exception.h"
+#include "page/header_page.h"
 #include "table/tuple.h"
 #include "type/value.h"
 
 namespace scudb {
 
+// define index type enum, chosen per index in the vtable CREATE statement
+enum class IndexType { BPlusTreeIndex = 0, HashTableIndex, ArtIndex };
+
 /**
  * class IndexMetadata - Holds metadata of an index object
  *
@@ -21,6 +27,15 @@ namespace scudb {
  * index, since the external callers does not know the actual structure of
  * the index key, so it is the index's responsibility to maintain such a
  * mapping relation and does the conversion between tuple key and index key
+ *
+ * An index may include columns besides its key. They are stored with every
+ * entry but take no part in lookups, so queries that only read key and
+ * included columns are served from the index alone. The entry of a tuple
+ * holds its key columns followed by its included columns.
+ *
+ * An index may also keep a Bloom filter over its keys, which answers most
+ * lookups of keys it does not hold without searching the index. A B+ tree
+ * index takes the options of its tree from the metadata too.
  */
 class Transaction;
 class IndexMetadata {
@@ -28,17 +43,48 @@ class IndexMetadata {
 
 public:
   IndexMetadata(std::string index_name, std::string table_name,
-                const Schema *tuple_schema, const std::vector<int> &key_attrs)
-      : name_(index_name), table_name_(table_name), key_attrs_(key_attrs) {
+                const Schema *tuple_schema, const std::vector<int> &key_attrs,
+                IndexType index_type = IndexType::BPlusTreeIndex,
+                bool is_unique = true,
+                const std::vector<int> &include_attrs = std::vector<int>(),
+                bool has_bloom_filter = false,
+                const BPlusTreeOptions &tree_options = BPlusTreeOptions())
+      : name_(index_name), table_name_(table_name), key_attrs_(key_attrs),
+        include_attrs_(include_attrs), index_type_(index_type),
+        is_unique_(is_unique), has_bloom_filter_(has_bloom_filter),
+        tree_options_(tree_options) {
     key_schema_ = Schema::CopySchema(tuple_schema, key_attrs_);
+    entry_attrs_ = key_attrs_;
+    entry_attrs_.insert(entry_attrs_.end(), include_attrs_.begin(),
+                        include_attrs_.end());
+    entry_schema_ = include_attrs_.empty()
+                        ? key_schema_
+                        : Schema::CopySchema(tuple_schema, entry_attrs_);
   }
 
-  ~IndexMetadata() { delete key_schema_; };
+  ~IndexMetadata() {
+    if (entry_schema_ != key_schema_)
+      delete entry_schema_;
+    delete key_schema_;
+  };
 
   inline const std::string &GetName() const { return name_; }
 
   inline const std::string &GetTableName() { return table_name_; }
 
+  inline IndexType GetIndexType() const { return index_type_; }
+
+  // false if several tuples may share a key
+  inline bool IsUnique() const { return is_unique_; }
+
+  // true if lookups check a Bloom filter over the keys first
+  inline bool HasBloomFilter() const { return has_bloom_filter_; }
+
+  // optional features of the tree of a B+ tree index
+  inline const BPlusTreeOptions &GetTreeOptions() const {
+    return tree_options_;
+  }
+
   // Returns a schema object pointer that represents the indexed key
   inline Schema *GetKeySchema() const { return key_schema_; }
 
@@ -51,13 +97,35 @@ public:
   //  columns
   inline const std::vector<int> &GetKeyAttrs() const { return key_attrs_; }
 
+  // table columns stored with every entry besides the key
+  inline const std::vector<int> &GetIncludeAttrs() const {
+    return include_attrs_;
+  }
+
+  // table columns of an entry, the key columns followed by the included ones
+  inline const std::vector<int> &GetEntryAttrs() const { return entry_attrs_; }
+
+  // schema of an entry, the key schema if no columns are included
+  inline Schema *GetEntrySchema() const { return entry_schema_; }
+
   // Get a string representation for debugging
   const std::string ToString() const {
     std::stringstream os;
 
     os << "IndexMetadata["
        << "Name = " << name_ << ", "
-       << "Type = B+Tree, "
+       << "Type = "
+       << (index_type_ == IndexType::HashTableIndex
+               ? "Hash"
+               : index_type_ == IndexType::ArtIndex ? "ART" : "B+Tree")
+       << ", "
+       << "Unique = " << is_unique_ << ", "
+       << "Included columns = " << include_attrs_.size() << ", "
+       << "Bloom filter = " << has_bloom_filter_ << ", "
+       << "Adaptive hash = " << tree_options_.adaptive_hash << ", "
+       << "Write buffer = " << tree_options_.write_buffer << ", "
+       << "Deferred merge = " << tree_options_.deferred_merge << ", "
+       << "Swizzling = " << tree_options_.swizzling << ", "
        << "Table name = " << table_name_ << "] :: ";
     os << key_schema_->ToString();
 
@@ -69,8 +137,20 @@ private:
   std::string table_name_;
   // The mapping relation between key schema and tuple schema
   const std::vector<int> key_attrs_;
+  // columns stored besides the key, and both together
+  const std::vector<int> include_attrs_;
+  std::vector<int> entry_attrs_;
+  // data structure backing the index
+  IndexType index_type_;
+  // a non-unique index keeps one entry per tuple
+  bool is_unique_;
+  // lookups check a Bloom filter first
+  bool has_bloom_filter_;
+  const BPlusTreeOptions tree_options_;
   // schema of the indexed key
   Schema *key_schema_;
+  // schema of an entry, shares key_schema_ without included columns
+  Schema *entry_schema_;
 };
 
 /////////////////////////////////////////////////////////////////////
@@ -110,6 +190,12 @@ public:
     return metadata_->GetKeyAttrs();
   }
 
+  Schema *GetEntrySchema() const { return metadata_->GetEntrySchema(); }
+
+  const std::vector<int> &GetEntryAttrs() const {
+    return metadata_->GetEntryAttrs();
+  }
+
   // Get a string representation for debugging
   const std::string ToString() const {
     std::stringstream os;
@@ -122,17 +208,75 @@ public:
   ///////////////////////////////////////////////////////////////////
   // Point Modification
   ///////////////////////////////////////////////////////////////////
-  // designed for secondary indexes.
-  virtual void InsertEntry(const Tuple &key, RID rid,
+  // designed for secondary indexes. key is the entry of the tuple, the key
+  // columns followed by the included ones (see GetEntrySchema). False if the
+  // index does not take the entry, e.g. a unique index holds its key already
+  virtual bool InsertEntry(const Tuple &key, RID rid,
                            Transaction *transaction = nullptr) = 0;
 
-  // delete the index entry linked to given tuple
-  virtual void DeleteEntry(const Tuple &key,
+  // delete the index entry linked to given tuple, rid tells the entries of
+  // a non-unique index apart
+  virtual void DeleteEntry(const Tuple &key, RID rid,
                            Transaction *transaction = nullptr) = 0;
 
   virtual void ScanKey(const Tuple &key, std::vector<RID> &result,
                        Transaction *transaction = nullptr) = 0;
 
+  // rids of a batch of keys in any order, e.g. an IN list or the probe side
+  // of a join. Indexes that can resolve sorted keys in one pass override this
+  virtual void ScanKeys(const std::vector<Tuple> &keys,
+                        std::vector<RID> &result,
+                        Transaction *transaction = nullptr) {
+    for (auto &key : keys)
+      ScanKey(key, result, transaction);
+  }
+
+  // true if the index keeps its keys in order and supports ScanRange
+  virtual bool IsOrdered() const { return false; }
+
+  // true if the index hands out the entries of the rids it finds, see
+  // ScanKeyEntries and ScanRangeEntries
+  virtual bool IsCovering() const { return false; }
+
+  // ScanKey, also appends the entry of every rid to entries
+  virtual void ScanKeyEntries(const Tuple &key, std::vector<RID> &result,
+                              std::vector<Tuple> &entries,
+                              Transaction *transaction = nullptr) {
+    throw Exception(EXCEPTION_TYPE_INDEX, "index does not store entries");
+  }
+
+  // ScanRange, also appends the entry of every rid to entries
+  virtual void ScanRangeEntries(const Tuple *low, const Tuple *high,
+                                bool descending, std::vector<RID> &result,
+                                std::vector<Tuple> &entries,
+                                Transaction *transaction = nullptr) {
+    throw Exception(EXCEPTION_TYPE_INDEX, "index does not store entries");
+  }
+
+  // rids of the entries with low <= key <= high in key order, or in reverse
+  // key order if descending. A nullptr bound leaves that end open
+  virtual void ScanRange(const Tuple *low, const Tuple *high, bool descending,
+                         std::vector<RID> &result,
+                         Transaction *transaction = nullptr) {
+    throw Exception(EXCEPTION_TYPE_INDEX, "index keys are not ordered");
+  }
+
+  // insert a batch of entries in any order, e.g. when the index is built
+  // over an existing table. Indexes that build faster from sorted input
+  // override this. False if the index refused any of the entries
+  virtual bool InsertEntries(const std::vector<std::pair<Tuple, RID>> &entries,
+                             Transaction *transaction = nullptr) {
+    bool inserted = true;
+    for (auto &entry : entries)
+      inserted = InsertEntry(entry.first, entry.second, transaction) &&
+                 inserted;
+    return inserted;
+  }
+
+  // statistics for planning scans (see VtabBestIndex), false if the index
+  // keeps none
+  virtual bool GetStatistics(IndexStatistics &stats) { return false; }
+
 private:
   //===--------------------------------------------------------------------===//
   //  Data members
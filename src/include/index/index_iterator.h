@@ -1,12 +1,30 @@
 /**
  * index_iterator.h
  * For range scan of b+ tree
+ *
+ * The iterator keeps the leaf page it points into pinned and read latched,
+ * and latches the next leaf before releasing the current one, so leaves are
+ * always latched left to right. A thread must not modify the tree while it
+ * holds an iterator that is not at its end.
+ *
+ * A range iterator stops after the last key not greater than its end key.
+ * Whenever the iterator enters a leaf and the range goes on past it, the next
+ * leaf is prefetched, so reading it overlaps with consuming the current one.
+ *
+ * A reverse iterator walks the prev links from large keys to small ones and
+ * stops before the first key less than its end key. Latching right to left
+ * would deadlock with forward iterators and splits, so it only tries to
+ * latch the previous leaf while holding the current one. If a writer holds
+ * the previous leaf, it lets go of the current leaf and descends from the
+ * root again to the leaf before the smallest key it has passed.
  */
 #pragma once
 #include "page/b_plus_tree_leaf_page.h"
 
 namespace scudb {
 
+INDEX_TEMPLATE_ARGUMENTS class BPlusTree;
+
 #define INDEXITERATOR_TYPE                                                     \
   IndexIterator<KeyType, ValueType, KeyComparator>
 
@@ -15,6 +33,20 @@ class IndexIterator {
 public:
   // you may define your own constructor based on your member variables
   IndexIterator();
+  // page must be pinned and read latched, the iterator takes over both
+  IndexIterator(BufferPoolManager *buffer_pool_manager, Page *page, int index);
+  // same, ends after the last key <= end_key
+  IndexIterator(BufferPoolManager *buffer_pool_manager, Page *page, int index,
+                const KeyType &end_key, const KeyComparator *comparator);
+  // reverse iterator of tree, starting at index of page which is the largest
+  // key <= start_key (if given), ends before the first key < end_key (if
+  // given)
+  IndexIterator(BPlusTree<KeyType, ValueType, KeyComparator> *tree,
+                Page *page, int index, const KeyType *start_key,
+                const KeyType *end_key);
+  IndexIterator(IndexIterator &&other);
+  IndexIterator(const IndexIterator &) = delete;
+  IndexIterator &operator=(const IndexIterator &) = delete;
   ~IndexIterator();
 
   bool isEnd();
@@ -25,6 +57,35 @@ public:
 
 private:
   // add your own private member variables here
+  // skip past the end of exhausted leaves
+  void SkipExhaustedLeaves();
+  // bound the current leaf by the end key and prefetch the next one
+  void EnterLeaf();
+  // latch the leaf before the current one, see above
+  void MoveToPrevLeaf();
+  // unlatch and unpin the current page
+  void Release();
+
+  BufferPoolManager *buffer_pool_manager_;
+  Page *page_;
+  B_PLUS_TREE_LEAF_PAGE_TYPE *leaf_;
+  int index_;
+  // reverse iterators walk from index_ down to end_index_
+  bool reverse_;
+  BPlusTree<KeyType, ValueType, KeyComparator> *tree_;
+  // all keys >= bound_key_ have been passed by a reverse iterator
+  bool has_bound_;
+  KeyType bound_key_;
+  // entries of the current leaf within the range, [0, end_index_) or
+  // [end_index_, size) for reverse iterators
+  int end_index_;
+  // the range ends within the current leaf
+  bool last_leaf_;
+  // inclusive end key, no end key if comparator_ is nullptr
+  KeyType end_key_;
+  const KeyComparator *comparator_;
+  // pair at index_, keys are decompressed out of the leaf
+  MappingType item_;
 };
 
 } // namespace scudb
@@ -0,0 +1,61 @@
+/**
+ * integer_key.h
+ *
+ * Key used for indexing a single integer column
+ *
+ * GenericComparator deserializes a Value per key column and compares through
+ * the virtual Type interface on every comparison. For a key schema made of
+ * one INTEGER or BIGINT column the key is kept as a native integer instead,
+ * and the comparator is a plain integer comparison that inlines into the
+ * binary search of the B+ tree pages.
+ */
+#pragma once
+
+#include <cstring>
+
+#include "table/tuple.h"
+
+namespace scudb {
+template <typename IntType> class IntegerKey {
+public:
+  // the key tuple holds the column inlined at offset 0
+  inline void SetFromKey(const Tuple &tuple, Schema *key_schema) {
+    memcpy(&value_, tuple.GetData(), sizeof(IntType));
+  }
+
+  // the key tuple back, integer keys store no rid and no included columns
+  inline Tuple GetEntry(Schema *entry_schema, int key_columns,
+                        bool has_rid) const {
+    std::vector<Value> values{Value(entry_schema->GetType(0), value_)};
+    return Tuple(values, entry_schema);
+  }
+
+  // NOTE: for test purpose only
+  inline void SetFromInteger(int64_t key) { value_ = (IntType)key; }
+
+  inline int64_t ToString() const { return value_; }
+
+  friend std::ostream &operator<<(std::ostream &os, const IntegerKey &key) {
+    os << key.ToString();
+    return os;
+  }
+
+  IntType value_;
+};
+
+/**
+ * Function object returns -1, 0 or 1 if lhs is less than, equal to or
+ * greater than rhs, used for trees
+ */
+template <typename IntType> class IntegerComparator {
+public:
+  inline int operator()(const IntegerKey<IntType> &lhs,
+                        const IntegerKey<IntType> &rhs) const {
+    return (lhs.value_ > rhs.value_) - (lhs.value_ < rhs.value_);
+  }
+
+  // constructor, the key schema is implied by IntType
+  IntegerComparator(Schema *key_schema) {}
+};
+
+} // namespace scudb
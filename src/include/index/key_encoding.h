@@ -0,0 +1,232 @@
+/**
+ * key_encoding.h
+ *
+ * Order preserving byte encoding of index keys
+ *
+ * Every column is encoded so that comparing two encoded keys with memcmp
+ * gives the same order as comparing their columns one by one as Values:
+ * - integers are stored big-endian with the sign bit flipped
+ * - doubles are stored big-endian with the sign bit flipped for positive
+ *   numbers and all bits flipped for negative numbers
+ * - varchars are stored as a 0x01 marker (0x00 for NULL), their bytes with
+ *   0x00 escaped as 0x00 0xff and a 0x00 0x00 terminator
+ * Each column encoding is prefix free, so a composite key compares column by
+ * column. The NULL sentinels of the fixed length types are their minimum
+ * values, so NULL sorts first for every type.
+ * KeyDecoder reads the columns back, e.g. for index-only scans, or finds
+ * where the first columns of an encoding end.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "catalog/schema.h"
+#include "type/value.h"
+
+namespace scudb {
+
+class KeyEncoder {
+public:
+  // bytes past capacity are counted by Length() but not written
+  KeyEncoder(char *out, size_t capacity)
+      : out_(out), capacity_(capacity), length_(0) {}
+
+  // number of bytes of the full encoding
+  inline size_t Length() const { return length_; }
+
+  inline void PutByte(uint8_t byte) {
+    if (length_ < capacity_)
+      out_[length_] = (char)byte;
+    length_++;
+  }
+
+  // the low bytes of value, most significant first
+  inline void PutUnsigned(uint64_t value, int bytes) {
+    for (int i = bytes - 1; i >= 0; i--)
+      PutByte((uint8_t)(value >> (8 * i)));
+  }
+
+  inline void PutSigned(int64_t value, int bytes) {
+    PutUnsigned((uint64_t)value ^ (1ULL << (8 * bytes - 1)), bytes);
+  }
+
+  inline void PutDouble(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    bits = (bits >> 63) ? ~bits : bits | (1ULL << 63);
+    PutUnsigned(bits, 8);
+  }
+
+  inline void PutString(const char *data, size_t length) {
+    PutByte(1);
+    for (size_t i = 0; i < length; i++) {
+      PutByte((uint8_t)data[i]);
+      if (data[i] == 0)
+        PutByte(0xff);
+    }
+    PutByte(0);
+    PutByte(0);
+  }
+
+  inline void PutValue(const Value &value) {
+    switch (value.GetTypeId()) {
+    case TypeId::BOOLEAN:
+    case TypeId::TINYINT:
+      PutSigned(value.GetAs<int8_t>(), 1);
+      break;
+    case TypeId::SMALLINT:
+      PutSigned(value.GetAs<int16_t>(), 2);
+      break;
+    case TypeId::INTEGER:
+      PutSigned(value.GetAs<int32_t>(), 4);
+      break;
+    case TypeId::BIGINT:
+      PutSigned(value.GetAs<int64_t>(), 8);
+      break;
+    case TypeId::TIMESTAMP:
+      PutUnsigned(value.GetAs<uint64_t>(), 8);
+      break;
+    case TypeId::DECIMAL:
+      PutDouble(value.GetAs<double>());
+      break;
+    case TypeId::VARCHAR:
+      if (value.IsNull())
+        PutByte(0);
+      else
+        PutString(value.GetData(), value.GetLength() - 1);
+      break;
+    default:
+      break;
+    }
+  }
+
+  // length of the encoding of a column of the given type, length is the
+  // declared length of a varchar (embedded 0x00 bytes not counted)
+  static inline size_t ColumnLength(TypeId type, int32_t length) {
+    switch (type) {
+    case TypeId::BOOLEAN:
+    case TypeId::TINYINT:
+      return 1;
+    case TypeId::SMALLINT:
+      return 2;
+    case TypeId::INTEGER:
+      return 4;
+    case TypeId::BIGINT:
+    case TypeId::TIMESTAMP:
+    case TypeId::DECIMAL:
+      return 8;
+    case TypeId::VARCHAR:
+      return 1 + length + 2;
+    default:
+      return 0;
+    }
+  }
+
+  // length of the longest key of key_schema
+  static inline size_t MaxLength(const Schema *key_schema) {
+    size_t length = 0;
+    for (int i = 0; i < key_schema->GetColumnCount(); i++)
+      length += ColumnLength(key_schema->GetType(i),
+                             key_schema->GetAppropriateLength(i));
+    return length;
+  }
+
+  // inverse of PutSigned
+  static inline int64_t GetSigned(const char *data, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; i++)
+      value = (value << 8) | (uint8_t)data[i];
+    value ^= 1ULL << (8 * bytes - 1);
+    // sign extend from the encoded width
+    int shift = 64 - 8 * bytes;
+    return (int64_t)(value << shift) >> shift;
+  }
+
+private:
+  char *out_;
+  size_t capacity_;
+  size_t length_;
+};
+
+class KeyDecoder {
+public:
+  // data holds a complete encoding, it is not checked against its end
+  KeyDecoder(const char *data) : data_(data) {}
+
+  // bytes taken by the first columns of schema in an encoding of length
+  // bytes, or length if they run past its end (a truncated key)
+  static inline size_t ColumnsLength(const char *data, size_t length,
+                                     const Schema *schema, int columns) {
+    size_t offset = 0;
+    for (int i = 0; i < columns && offset < length; i++) {
+      TypeId type = schema->GetType(i);
+      if (type != TypeId::VARCHAR) {
+        offset += KeyEncoder::ColumnLength(type, 0);
+      } else if (data[offset++] != 0) {
+        while (offset + 1 < length &&
+               (data[offset] != 0 || data[offset + 1] != 0))
+          offset += data[offset] == 0 ? 2 : 1;
+        offset += 2;
+      }
+    }
+    return std::min(offset, length);
+  }
+
+  inline void Skip(size_t bytes) { data_ += bytes; }
+
+  // inverse of KeyEncoder::PutValue
+  inline Value GetValue(TypeId type) {
+    switch (type) {
+    case TypeId::BOOLEAN:
+    case TypeId::TINYINT:
+      return Value(type, (int8_t)GetSigned(1));
+    case TypeId::SMALLINT:
+      return Value(type, (int16_t)GetSigned(2));
+    case TypeId::INTEGER:
+      return Value(type, (int32_t)GetSigned(4));
+    case TypeId::BIGINT:
+      return Value(type, (int64_t)GetSigned(8));
+    case TypeId::DECIMAL: {
+      uint64_t bits = GetUnsigned(8);
+      bits = (bits >> 63) ? bits & ~(1ULL << 63) : ~bits;
+      double value;
+      memcpy(&value, &bits, sizeof(value));
+      return Value(type, value);
+    }
+    case TypeId::VARCHAR: {
+      if (*data_++ == 0)
+        return Value(type, nullptr, 0, false);
+      std::string value;
+      // 0x00 0xff is an escaped 0x00, 0x00 0x00 the terminator
+      while (data_[0] != 0 || data_[1] != 0) {
+        value.push_back(data_[0]);
+        data_ += data_[0] == 0 ? 2 : 1;
+      }
+      data_ += 2;
+      return Value(type, value);
+    }
+    default:
+      return Value(type);
+    }
+  }
+
+private:
+  inline uint64_t GetUnsigned(int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; i++)
+      value = (value << 8) | (uint8_t)*data_++;
+    return value;
+  }
+
+  inline int64_t GetSigned(int bytes) {
+    int64_t value = KeyEncoder::GetSigned(data_, bytes);
+    data_ += bytes;
+    return value;
+  }
+
+  const char *data_;
+};
+
+} // namespace scudb
@@ -0,0 +1,100 @@
+/**
+ * write_buffer.h
+ *
+ * Pending inserts and removes of a write-buffered B+ tree, sorted by key so
+ * they are applied to the leaves in key order batches (the message buffer of
+ * a B-epsilon tree node). A key has at most one message, a later operation
+ * on the key merges into it:
+ * - INSERT inserts the pair unless the tree holds the key already, a second
+ *   insert of the key is a duplicate
+ * - UPSERT follows a remove of the key, it replaces the pair in the tree
+ * - REMOVE removes the key, it overrides an insert of the key
+ * The buffer is not latched, the tree guards it.
+ */
+#pragma once
+
+#include <iterator>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace scudb {
+
+enum class BufferedOperation { INSERT = 0, UPSERT, REMOVE };
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+class WriteBuffer {
+public:
+  struct Message {
+    BufferedOperation operation;
+    ValueType value;
+  };
+
+  explicit WriteBuffer(const KeyComparator &comparator)
+      : messages_(KeyLess{comparator}) {}
+
+  // false if the key has a pending insert, the insert is a duplicate
+  bool Insert(const KeyType &key, const ValueType &value) {
+    auto it = messages_.find(key);
+    if (it == messages_.end()) {
+      messages_.emplace(key, Message{BufferedOperation::INSERT, value});
+      return true;
+    }
+    if (it->second.operation != BufferedOperation::REMOVE)
+      return false;
+    it->second = Message{BufferedOperation::UPSERT, value};
+    return true;
+  }
+
+  void Remove(const KeyType &key) {
+    messages_[key] = Message{BufferedOperation::REMOVE, ValueType()};
+  }
+
+  // the message of key, nullptr if there is none
+  const Message *Find(const KeyType &key) const {
+    auto it = messages_.find(key);
+    return it == messages_.end() ? nullptr : &it->second;
+  }
+
+  inline size_t Size() const { return messages_.size(); }
+
+  // number of messages with low <= key < high, a nullptr bound is open
+  size_t Count(const KeyType *low, const KeyType *high) const {
+    return std::distance(Lower(low), Upper(high));
+  }
+
+  // remove the messages with low <= key < high and return them in key order
+  std::vector<std::pair<KeyType, Message>> Take(const KeyType *low,
+                                                const KeyType *high) {
+    auto begin = Lower(low), end = Upper(high);
+    std::vector<std::pair<KeyType, Message>> messages(begin, end);
+    messages_.erase(begin, end);
+    return messages;
+  }
+
+private:
+  struct KeyLess {
+    KeyComparator comparator;
+    bool operator()(const KeyType &lhs, const KeyType &rhs) const {
+      return comparator(lhs, rhs) < 0;
+    }
+  };
+  using MessageMap = std::map<KeyType, Message, KeyLess>;
+
+  typename MessageMap::iterator Lower(const KeyType *low) {
+    return low == nullptr ? messages_.begin() : messages_.lower_bound(*low);
+  }
+  typename MessageMap::iterator Upper(const KeyType *high) {
+    return high == nullptr ? messages_.end() : messages_.lower_bound(*high);
+  }
+  typename MessageMap::const_iterator Lower(const KeyType *low) const {
+    return low == nullptr ? messages_.begin() : messages_.lower_bound(*low);
+  }
+  typename MessageMap::const_iterator Upper(const KeyType *high) const {
+    return high == nullptr ? messages_.end() : messages_.lower_bound(*high);
+  }
+
+  MessageMap messages_;
+};
+
+} // namespace scudb
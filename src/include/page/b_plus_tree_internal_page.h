@@ -8,17 +8,34 @@
  * the first key always remains invalid. That is to say, any search/lookup
  * should ignore the first key.
  *
- * Internal page format (keys are stored in increasing order):
+ * Internal page format (keys are stored in increasing order, prefix
+ * compressed, see page/packed_entry_array.h, the invalid first key is not
+ * stored):
  *  --------------------------------------------------------------------------
- * | HEADER | KEY(1)+PAGE_ID(1) | KEY(2)+PAGE_ID(2) | ... | KEY(n)+PAGE_ID(n) |
+ * | HEADER | PACKED KEY(1)+PAGE_ID(1) ... KEY(n)+PAGE_ID(n) |
  *  --------------------------------------------------------------------------
+ *
+ *  Header format (size in byte, 24 bytes in total):
+ *  ---------------------------------------------------------------------
+ * | PageType (4) | LSN (4) | CurrentSize (4) | ParentPageId (4) |
+ *  ---------------------------------------------------------------------
+ *  -------------------------------
+ * | PageId (4) | NextPageId (4) |
+ *  -------------------------------
+ *
+ * An internal page underflows when its pairs take less than half of the page.
+ * Like leaves, internal pages are linked to their right neighbour on the
+ * same level and every page but the last one of a level has a high key (see
+ * b_plus_tree.h).
  */
 
 #pragma once
 
 #include <queue>
+#include <vector>
 
 #include "page/b_plus_tree_page.h"
+#include "page/packed_entry_array.h"
 
 namespace scudb {
 
@@ -31,42 +48,58 @@ public:
   // must call initialize method after "create" a new node
   void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID);
 
+  page_id_t GetNextPageId() const;
+  void SetNextPageId(page_id_t next_page_id);
+  bool HasHighKey() const;
+  KeyType GetHighKey() const;
+
   KeyType KeyAt(int index) const;
-  void SetKeyAt(int index, const KeyType &key);
+  bool SetKeyAt(int index, const KeyType &key);
   int ValueIndex(const ValueType &value) const;
   ValueType ValueAt(int index) const;
 
+  // space accounting
+  size_t GetCapacity() const;
+  bool IsInsertSafe() const;
+  bool IsRemoveSafe() const;
+  bool IsUnderflow() const;
+
+  int LookupIndex(const KeyType &key, const KeyComparator &comparator) const;
   ValueType Lookup(const KeyType &key, const KeyComparator &comparator) const;
   void PopulateNewRoot(const ValueType &old_value, const KeyType &new_key,
                        const ValueType &new_value);
-  int InsertNodeAfter(const ValueType &old_value, const KeyType &new_key,
-                      const ValueType &new_value);
+  bool Populate(const std::vector<MappingType> &items, size_t begin,
+                size_t end, const KeyType *high_key = nullptr);
+  bool InsertNodeAfter(const ValueType &old_value, const KeyType &new_key,
+                       const ValueType &new_value);
   void Remove(int index);
   ValueType RemoveAndReturnOnlyChild();
 
-  void MoveHalfTo(BPlusTreeInternalPage *recipient,
-                  BufferPoolManager *buffer_pool_manager);
-  void MoveAllTo(BPlusTreeInternalPage *recipient, int index_in_parent,
+  KeyType MoveHalfTo(BPlusTreeInternalPage *recipient,
+                     const ValueType &old_value, const KeyType &new_key,
+                     const ValueType &new_value,
+                     BufferPoolManager *buffer_pool_manager);
+  bool MoveAllTo(BPlusTreeInternalPage *recipient, int index_in_parent,
                  BufferPoolManager *buffer_pool_manager);
-  void MoveFirstToEndOf(BPlusTreeInternalPage *recipient,
-                        BufferPoolManager *buffer_pool_manager);
-  void MoveLastToFrontOf(BPlusTreeInternalPage *recipient,
-                         int parent_index,
-                         BufferPoolManager *buffer_pool_manager);
+  bool RedistributeWith(BPlusTreeInternalPage *right, int index_in_parent,
+                        BufferPoolManager *buffer_pool_manager,
+                        const KeyComparator & /* Unused */);
   // DEUBG and PRINT
   std::string ToString(bool verbose) const;
   void QueueUpChildren(std::queue<BPlusTreePage *> *queue,
                        BufferPoolManager *buffer_pool_manager);
 
 private:
-  void CopyHalfFrom(MappingType *items, int size,
-                    BufferPoolManager *buffer_pool_manager);
-  void CopyAllFrom(MappingType *items, int size,
-                   BufferPoolManager *buffer_pool_manager);
-  void CopyLastFrom(const MappingType &pair,
-                    BufferPoolManager *buffer_pool_manager);
-  void CopyFirstFrom(const MappingType &pair, int parent_index,
-                     BufferPoolManager *buffer_pool_manager);
-  MappingType array[0];
+  typedef PackedEntryArray<KeyType, ValueType> Entries;
+
+  BPlusTreeInternalPage *FetchParent(BufferPoolManager *buffer_pool_manager);
+  void AdoptChild(page_id_t child_page_id,
+                  BufferPoolManager *buffer_pool_manager);
+  // point the parent of the children in items[begin, end) at this page
+  void AdoptChildren(const std::vector<MappingType> &items, size_t begin,
+                     size_t end, BufferPoolManager *buffer_pool_manager);
+
+  page_id_t next_page_id_;
+  Entries entries_;
 };
 } // namespace scudb
@@ -5,24 +5,30 @@
  * see include/common/rid.h for detailed implementation) together within leaf
  * page. Only support unique key.
 
- * Leaf page format (keys are stored in order):
+ * Leaf page format (keys are stored in order, prefix compressed, see
+ * page/packed_entry_array.h):
  *  ----------------------------------------------------------------------
- * | HEADER | KEY(1) + RID(1) | KEY(2) + RID(2) | ... | KEY(n) + RID(n)
+ * | HEADER | PACKED KEY(1) + RID(1) ... KEY(n) + RID(n)
  *  ----------------------------------------------------------------------
  *
- *  Header format (size in byte, 24 bytes in total):
+ *  Header format (size in byte, 28 bytes in total):
  *  ---------------------------------------------------------------------
- * | PageType (4) | CurrentSize (4) | MaxSize (4) | ParentPageId (4) |
+ * | PageType (4) | LSN (4) | CurrentSize (4) | ParentPageId (4) |
  *  ---------------------------------------------------------------------
- *  ------------------------------
- * | PageId (4) | NextPageId (4)
- *  ------------------------------
+ *  ---------------------------------------------
+ * | PageId (4) | NextPageId (4) | PrevPageId (4)
+ *  ---------------------------------------------
+ *
+ * A leaf underflows when its pairs take less than half of the page. Every
+ * leaf but the last one has a high key, the separator between it and its
+ * next page (see b_plus_tree.h).
  */
 #pragma once
 #include <utility>
 #include <vector>
 
 #include "page/b_plus_tree_page.h"
+#include "page/packed_entry_array.h"
 
 namespace scudb {
 #define B_PLUS_TREE_LEAF_PAGE_TYPE                                             \
@@ -38,36 +44,48 @@ public:
   // helper methods
   page_id_t GetNextPageId() const;
   void SetNextPageId(page_id_t next_page_id);
+  page_id_t GetPrevPageId() const;
+  void SetPrevPageId(page_id_t prev_page_id);
   KeyType KeyAt(int index) const;
   int KeyIndex(const KeyType &key, const KeyComparator &comparator) const;
-  const MappingType &GetItem(int index);
+  MappingType GetItem(int index) const;
+  bool HasHighKey() const;
+  KeyType GetHighKey() const;
+
+  // space accounting
+  size_t GetCapacity() const;
+  size_t GetUsedBytes() const;
+  bool IsInsertSafe() const;
+  bool IsRemoveSafe() const;
+  bool IsUnderflow() const;
+  // pairs take less than fill_factor of the page
+  bool IsBelowFill(double fill_factor) const;
 
   // insert and delete methods
-  int Insert(const KeyType &key, const ValueType &value,
-             const KeyComparator &comparator);
+  bool Insert(const KeyType &key, const ValueType &value,
+              const KeyComparator &comparator);
   bool Lookup(const KeyType &key, ValueType &value,
               const KeyComparator &comparator) const;
   int RemoveAndDeleteRecord(const KeyType &key,
                             const KeyComparator &comparator);
+  bool Populate(const std::vector<MappingType> &items, size_t begin,
+                size_t end, const KeyType *high_key = nullptr);
   // Split and Merge utility methods
-  void MoveHalfTo(BPlusTreeLeafPage *recipient,
-                  BufferPoolManager *buffer_pool_manager /* Unused */);
-  void MoveAllTo(BPlusTreeLeafPage *recipient, int /* Unused */,
+  void MoveHalfTo(BPlusTreeLeafPage *recipient, const KeyType &key,
+                  const ValueType &value, const KeyComparator &comparator);
+  bool MoveAllTo(BPlusTreeLeafPage *recipient, int /* Unused */,
                  BufferPoolManager * /* Unused */);
-  void MoveFirstToEndOf(BPlusTreeLeafPage *recipient,
-                        BufferPoolManager *buffer_pool_manager);
-  void MoveLastToFrontOf(BPlusTreeLeafPage *recipient, int parentIndex,
-                         BufferPoolManager *buffer_pool_manager);
+  bool RedistributeWith(BPlusTreeLeafPage *right, int index_in_parent,
+                        BufferPoolManager *buffer_pool_manager,
+                        const KeyComparator &comparator);
   // Debug
   std::string ToString(bool verbose = false) const;
 
 private:
-  void CopyHalfFrom(MappingType *items, int size);
-  void CopyAllFrom(MappingType *items, int size);
-  void CopyLastFrom(const MappingType &item);
-  void CopyFirstFrom(const MappingType &item, int parentIndex,
-                     BufferPoolManager *buffer_pool_manager);
+  typedef PackedEntryArray<KeyType, ValueType> Entries;
+
   page_id_t next_page_id_;
-  MappingType array[0];
+  page_id_t prev_page_id_;
+  Entries entries_;
 };
 } // namespace scudb
@@ -8,10 +8,16 @@
  *
  * Header format (size in byte, 20 bytes in total):
  * ----------------------------------------------------------------------------
- * | PageType (4) | LSN (4) | CurrentSize (4) | MaxSize (4) |
- * ----------------------------------------------------------------------------
- * | ParentPageId (4) | PageId(4) |
+ * | PageType (4) | LSN (4) | CurrentSize (4) | ParentPageId (4) | PageId(4) |
  * ----------------------------------------------------------------------------
+ *
+ * Pairs are stored with variable length (see page/packed_entry_array.h), so
+ * whether a page is full or underflows depends on the bytes of its pairs and
+ * is decided by the leaf and internal pages.
+ *
+ * Index pages are not logged. A leaf counts the rewrites of its pairs by a
+ * split, merge or redistribution in its LSN instead, which versions the
+ * leaf pages cached by the adaptive hash index (index/adaptive_hash_index.h).
  */
 
 #pragma once
@@ -23,6 +29,7 @@
 
 #include "buffer/buffer_pool_manager.h"
 #include "index/generic_key.h"
+#include "index/integer_key.h"
 
 namespace scudb {
 
@@ -39,22 +46,21 @@ class BPlusTreePage {
 public:
   bool IsLeafPage() const;
   bool IsRootPage() const;
+  // false once the page was merged away or dropped as root
+  bool IsValidPage() const;
   void SetPageType(IndexPageType page_type);
 
   int GetSize() const;
   void SetSize(int size);
   void IncreaseSize(int amount);
 
-  int GetMaxSize() const;
-  void SetMaxSize(int max_size);
-  int GetMinSize() const;
-
   page_id_t GetParentPageId() const;
   void SetParentPageId(page_id_t parent_page_id);
 
   page_id_t GetPageId() const;
   void SetPageId(page_id_t page_id);
 
+  lsn_t GetLSN() const;
   void SetLSN(lsn_t lsn = INVALID_LSN);
 
 private:
@@ -62,7 +68,6 @@ private:
   IndexPageType page_type_;
   lsn_t lsn_;
   int size_;
-  int max_size_;
   page_id_t parent_page_id_;
   page_id_t page_id_;
 };
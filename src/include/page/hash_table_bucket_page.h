@@ -0,0 +1,74 @@
+/**
+ * hash_table_bucket_page.h
+ *
+ * Leaf level page of a disk-resident extendible hash table, stores unsorted
+ * key/value pairs that share the low local depth bits of their hash. Only
+ * unique keys are supported. A bucket whose pairs do not fit into one page
+ * links overflow pages of the same format from its primary page.
+ *
+ * Format (size in byte):
+ *  ---------------------------------------------------------------------
+ * | PageId (4) | LSN (4) | Size (4) | NextPageId (4) | PACKED PAIRS...
+ *  ---------------------------------------------------------------------
+ * The pairs are stored in insertion order as a PackedEntryArray (see
+ * page/packed_entry_array.h), every key takes only the bytes it uses, so a
+ * page holds as many pairs as their key bytes allow.
+ */
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+#include "common/rid.h"
+#include "index/generic_key.h"
+#include "page/packed_entry_array.h"
+
+namespace scudb {
+
+#define HASH_TABLE_TEMPLATE_ARGUMENTS                                          \
+  template <typename KeyType, typename ValueType, typename KeyComparator>
+
+#define HASH_TABLE_BUCKET_TYPE                                                 \
+  HashTableBucketPage<KeyType, ValueType, KeyComparator>
+
+HASH_TABLE_TEMPLATE_ARGUMENTS
+class HashTableBucketPage {
+public:
+  // must call initialize method after "create" a new bucket page
+  void Init(page_id_t page_id);
+
+  page_id_t GetPageId() const;
+  void SetLSN(lsn_t lsn = INVALID_LSN);
+  // next overflow page of the bucket, INVALID_PAGE_ID at the end
+  page_id_t GetNextPageId() const;
+  void SetNextPageId(page_id_t next_page_id);
+
+  // index of key in this bucket, -1 if absent
+  int KeyIndex(const KeyType &key, const KeyComparator &comparator) const;
+  bool Lookup(const KeyType &key, ValueType &value,
+              const KeyComparator &comparator) const;
+  // fails if key is already present or the pair does not fit
+  bool Insert(const KeyType &key, const ValueType &value,
+              const KeyComparator &comparator);
+  bool Remove(const KeyType &key, const KeyComparator &comparator);
+
+  std::pair<KeyType, ValueType> GetItem(int index) const;
+  // append without duplicate check, used when redistributing a split bucket.
+  // False if the pair does not fit, an empty page holds any pair
+  bool Append(const std::pair<KeyType, ValueType> &item);
+  void RemoveAt(int index);
+
+  int GetSize() const;
+  bool IsEmpty() const;
+
+private:
+  page_id_t page_id_;
+  lsn_t lsn_;
+  int size_;
+  page_id_t next_page_id_;
+  PackedEntryArray<KeyType, ValueType> entries_;
+};
+
+} // namespace scudb
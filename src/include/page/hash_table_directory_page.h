@@ -0,0 +1,68 @@
+/**
+ * hash_table_directory_page.h
+ *
+ * Second level page of a disk-resident extendible hash table. The low
+ * GlobalDepth bits of a key's hash select a bucket page; several slots share a
+ * bucket page when its local depth is below the global depth.
+ *
+ * Format (size in byte):
+ *  --------------------------------------------------------------------------
+ * | PageId (4) | LSN (4) | GlobalDepth (4) | LocalDepths (1 * 2^MaxDepth) |
+ *  --------------------------------------------------------------------------
+ * | BucketPageIds (4 * 2^MaxDepth) |
+ *  --------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "common/config.h"
+
+namespace scudb {
+
+#define HTABLE_DIRECTORY_MAX_DEPTH 6
+#define HTABLE_DIRECTORY_ARRAY_SIZE (1 << HTABLE_DIRECTORY_MAX_DEPTH)
+
+class HashTableDirectoryPage {
+public:
+  // must call initialize method after "create" a new directory page
+  void Init(page_id_t page_id);
+
+  page_id_t GetPageId() const;
+  void SetLSN(lsn_t lsn = INVALID_LSN);
+
+  // directory slot addressed by the low bits of hash
+  uint32_t HashToBucketIndex(uint32_t hash) const;
+
+  page_id_t GetBucketPageId(uint32_t bucket_idx) const;
+  void SetBucketPageId(uint32_t bucket_idx, page_id_t bucket_page_id);
+
+  // slot that shares all but the highest local depth bit with bucket_idx
+  uint32_t GetSplitImageIndex(uint32_t bucket_idx) const;
+
+  uint32_t GetGlobalDepth() const;
+  uint32_t GetMaxDepth() const;
+  // double the directory, the upper half mirrors the lower half
+  void IncrGlobalDepth();
+  void DecrGlobalDepth();
+  // true if every local depth is below the global depth
+  bool CanShrink() const;
+  // number of slots in use, 2^GlobalDepth
+  uint32_t Size() const;
+
+  uint32_t GetLocalDepth(uint32_t bucket_idx) const;
+  void SetLocalDepth(uint32_t bucket_idx, uint32_t local_depth);
+
+private:
+  page_id_t page_id_;
+  lsn_t lsn_;
+  uint32_t global_depth_;
+  uint8_t local_depths_[HTABLE_DIRECTORY_ARRAY_SIZE];
+  page_id_t bucket_page_ids_[HTABLE_DIRECTORY_ARRAY_SIZE];
+};
+
+static_assert(sizeof(HashTableDirectoryPage) <= PAGE_SIZE,
+              "hash table directory page does not fit in a page");
+
+} // namespace scudb
@@ -0,0 +1,51 @@
+/**
+ * hash_table_header_page.h
+ *
+ * First level page of a disk-resident extendible hash table. The highest
+ * HTABLE_HEADER_MAX_DEPTH bits of a key's hash select a directory page, so the
+ * table can address more buckets than fit in a single directory page.
+ *
+ * Format (size in byte):
+ *  ------------------------------------------------------------------
+ * | PageId (4) | LSN (4) | DirectoryPageIds (4 * 2^MaxDepth) |
+ *  ------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "common/config.h"
+
+namespace scudb {
+
+#define HTABLE_HEADER_MAX_DEPTH 6
+#define HTABLE_HEADER_ARRAY_SIZE (1 << HTABLE_HEADER_MAX_DEPTH)
+
+class HashTableHeaderPage {
+public:
+  // must call initialize method after "create" a new header page
+  void Init(page_id_t page_id);
+
+  page_id_t GetPageId() const;
+  void SetLSN(lsn_t lsn = INVALID_LSN);
+
+  // directory slot addressed by the high bits of hash
+  uint32_t HashToDirectoryIndex(uint32_t hash) const;
+
+  page_id_t GetDirectoryPageId(uint32_t directory_idx) const;
+  void SetDirectoryPageId(uint32_t directory_idx, page_id_t directory_page_id);
+
+  // number of directory slots
+  uint32_t MaxSize() const;
+
+private:
+  page_id_t page_id_;
+  lsn_t lsn_;
+  page_id_t directory_page_ids_[HTABLE_HEADER_ARRAY_SIZE];
+};
+
+static_assert(sizeof(HashTableHeaderPage) <= PAGE_SIZE,
+              "hash table header page does not fit in a page");
+
+} // namespace scudb
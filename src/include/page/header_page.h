@@ -9,6 +9,14 @@
  *  -----------------------------------------------------------------
  * | RecordCount (4) | Entry_1 name (32) | Entry_1 root_id (4) | ... |
  *  -----------------------------------------------------------------
+ *
+ * Statistics records of indexes grow from the end of the page towards the
+ * root records:
+ *  -------------------------------------------------------------------
+ * | ... | Stats_2 name (32) | Stats_2 (32) | Stats_1 ... | StatsCount (4) |
+ *  -------------------------------------------------------------------
+ * Statistics can be sampled again at any time, so root records take the
+ * space of the last statistics records when the page is full.
  */
 
 #pragma once
@@ -19,9 +27,21 @@
 
 namespace scudb {
 
+// statistics of an index for the query planner, see BPlusTree::GetStatistics
+struct IndexStatistics {
+  int32_t height = 0;        // levels of the tree
+  int32_t leaf_pages = 0;
+  int64_t entries = 0;
+  int64_t distinct_keys = 0; // distinct values of the key columns
+  double average_fill = 0;   // share of a leaf page its pairs take
+};
+
 class HeaderPage : public Page {
 public:
-  void Init() { SetRecordCount(0); }
+  void Init() {
+    SetRecordCount(0);
+    SetStatisticsCount(0);
+  }
   /**
    * Record related
    */
@@ -33,6 +53,13 @@ public:
   bool GetRootId(const std::string &name, page_id_t &root_id);
   int GetRecordCount();
 
+  /**
+   * Statistics related
+   */
+  // insert or update, false if the page has no room left
+  bool SetStatistics(const std::string &name, const IndexStatistics &stats);
+  bool GetStatistics(const std::string &name, IndexStatistics &stats);
+
 private:
   /**
    * helper functions
@@ -40,5 +67,12 @@ private:
   int FindRecord(const std::string &name);
 
   void SetRecordCount(int record_count);
+
+  int FindStatistics(const std::string &name);
+  // offset of the i-th statistics record
+  int StatisticsOffset(int index);
+  int GetStatisticsCount();
+  void SetStatisticsCount(int stats_count);
+  void DeleteStatistics(const std::string &name);
 };
 } // namespace scudb
@@ -0,0 +1,446 @@
+/**
+ * packed_entry_array.h
+ *
+ * Storage for the sorted key & value pairs of a B+ tree page. A key is stored
+ * without the byte prefix shared by all keys of the page and without its
+ * trailing zero bytes, so a page holds as many pairs as their key bytes allow
+ * instead of a fixed number of full width keys. The raw key bytes are
+ * restored exactly, any trivially copyable key type can be stored.
+ *
+ * Format (offsets relative to DATA, n pairs):
+ *  ---------------------------------------------------------------------------
+ * | Capacity (2) | PrefixSize (2) | SkipFirstKey (2) | HighKeySize (2) |
+ * | HasHighKey (2) | DATA...
+ *  ---------------------------------------------------------------------------
+ * DATA:
+ *  ---------------------------------------------------------------------------
+ * | PREFIX | OFFSET(0) ... OFFSET(n-1) | FREE | PAIR(n-1) | ... | PAIR(0) |
+ * | HIGH KEY |
+ *  ---------------------------------------------------------------------------
+ * PAIR(i) = VALUE + KEY SUFFIX spans [OFFSET(i), OFFSET(i-1)), the pairs are
+ * packed in key order from the high key at the end of DATA (OFFSET(-1) =
+ * Capacity - HighKeySize). If SkipFirstKey is set (internal pages) the suffix
+ * of PAIR(0) is empty and its key is not part of the prefix.
+ *
+ * The optional high key is the upper bound of the keys the page may hold (see
+ * b_plus_tree.h). It is stored without trailing zero bytes and counts as
+ * used bytes like the pairs.
+ *
+ * The prefix is the longest prefix shared by all keys that no key is shorter
+ * than without its trailing zero bytes, so that every key is stored as the
+ * prefix followed by its own suffix. It is recomputed whenever the array is
+ * rebuilt. Insert rebuilds the
+ * array when the new key does not share the prefix, Remove keeps the prefix,
+ * so removing a pair frees exactly the bytes of that pair.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace scudb {
+
+template <typename KeyType, typename ValueType> class PackedEntryArray {
+public:
+  typedef std::pair<KeyType, ValueType> Entry;
+
+  // fixed bytes of every pair: its offset and its value
+  static const size_t kPairOverhead = sizeof(uint16_t) + sizeof(ValueType);
+
+  // empty array of capacity bytes of DATA
+  void Init(size_t capacity, bool skip_first_key) {
+    capacity_ = (uint16_t)capacity;
+    prefix_size_ = 0;
+    skip_first_key_ = skip_first_key;
+    high_key_size_ = 0;
+    has_high_key_ = false;
+  }
+
+  size_t GetCapacity() const { return capacity_; }
+
+  // bytes of DATA in use by the prefix, the offsets, the pairs and the high
+  // key
+  size_t GetUsedBytes(int size) const {
+    if (size == 0)
+      return high_key_size_;
+    return prefix_size_ + size * sizeof(uint16_t) + capacity_ -
+           OffsetAt(size - 1);
+  }
+
+  // largest number of bytes a single pair may take with the current prefix
+  size_t GetMaxPairBytes() const {
+    return kPairOverhead + sizeof(KeyType) - prefix_size_;
+  }
+
+  // true if any key can be inserted without exceeding the capacity, even one
+  // that shares no byte with the prefix
+  bool HasRoomForAny(int size) const {
+    size_t keys = size - FirstKey(size);
+    return GetUsedBytes(size) - prefix_size_ + keys * prefix_size_ +
+               kPairOverhead + sizeof(KeyType) <=
+           capacity_;
+  }
+
+  KeyType KeyAt(int index) const {
+    KeyType key;
+    char *bytes = reinterpret_cast<char *>(&key);
+    size_t begin = OffsetAt(index) + sizeof(ValueType);
+    size_t suffix = EndOf(index) - begin;
+    memcpy(bytes, data_, prefix_size_);
+    memcpy(bytes + prefix_size_, data_ + begin, suffix);
+    memset(bytes + prefix_size_ + suffix, 0,
+           sizeof(KeyType) - prefix_size_ - suffix);
+    return key;
+  }
+
+  bool HasHighKey() const { return has_high_key_; }
+
+  KeyType HighKey() const {
+    assert(has_high_key_);
+    KeyType key;
+    char *bytes = reinterpret_cast<char *>(&key);
+    memcpy(bytes, data_ + capacity_ - high_key_size_, high_key_size_);
+    memset(bytes + high_key_size_, 0, sizeof(KeyType) - high_key_size_);
+    return key;
+  }
+
+  ValueType ValueAt(int index) const {
+    ValueType value;
+    memcpy(reinterpret_cast<char *>(&value), data_ + OffsetAt(index),
+           sizeof(ValueType));
+    return value;
+  }
+
+  void SetValueAt(int index, const ValueType &value) {
+    memcpy(data_ + OffsetAt(index), reinterpret_cast<const char *>(&value),
+           sizeof(ValueType));
+  }
+
+  /*
+   * Insert key & value at index. Takes the pair in place if the key shares
+   * the prefix and there is room, otherwise rebuilds the array.
+   * @return: false if the pair does not fit, the array is unchanged then
+   */
+  bool Insert(int size, int index, const KeyType &key,
+              const ValueType &value) {
+    const char *bytes = reinterpret_cast<const char *>(&key);
+    size_t length = SignificantBytes(key);
+    if (size > FirstKey(size) && length >= prefix_size_ &&
+        memcmp(bytes, data_, prefix_size_) == 0) {
+      size_t suffix = length - prefix_size_;
+      size_t pair = sizeof(ValueType) + suffix;
+      if (GetUsedBytes(size) + sizeof(uint16_t) + pair <= capacity_) {
+        size_t low = OffsetAt(size - 1), end = EndOf(index);
+        // pairs index..size-1 move down, offsets index..size-1 move right
+        memmove(data_ + low - pair, data_ + low, end - low);
+        char *offsets = data_ + prefix_size_;
+        memmove(offsets + (index + 1) * sizeof(uint16_t),
+                offsets + index * sizeof(uint16_t),
+                (size - index) * sizeof(uint16_t));
+        for (int i = index + 1; i <= size; i++)
+          SetOffsetAt(i, (uint16_t)(OffsetAt(i) - pair));
+        SetOffsetAt(index, (uint16_t)(end - pair));
+        memcpy(data_ + end - pair, reinterpret_cast<const char *>(&value),
+               sizeof(ValueType));
+        memcpy(data_ + end - suffix, bytes + prefix_size_, suffix);
+        return true;
+      }
+    }
+    std::vector<Entry> entries;
+    CopyTo(size, entries);
+    entries.insert(entries.begin() + index, std::make_pair(key, value));
+    return Assign(entries, 0, entries.size());
+  }
+
+  // remove the pair at index, the prefix is kept
+  void Remove(int size, int index) {
+    assert(index >= 0 && index < size);
+    size_t low = OffsetAt(size - 1), begin = OffsetAt(index);
+    size_t pair = EndOf(index) - begin;
+    // pairs index+1..size-1 move up, offsets index+1..size-1 move left
+    memmove(data_ + low + pair, data_ + low, begin - low);
+    char *offsets = data_ + prefix_size_;
+    memmove(offsets + index * sizeof(uint16_t),
+            offsets + (index + 1) * sizeof(uint16_t),
+            (size - index - 1) * sizeof(uint16_t));
+    for (int i = index; i < size - 1; i++)
+      SetOffsetAt(i, (uint16_t)(OffsetAt(i) + pair));
+  }
+
+  // append all pairs to entries
+  void CopyTo(int size, std::vector<Entry> &entries) const {
+    for (int i = 0; i < size; i++)
+      entries.emplace_back(KeyAt(i), ValueAt(i));
+  }
+
+  /*
+   * Rebuild the array from entries[begin, end), which must be sorted, the
+   * high key is kept
+   * @return: false if they do not fit, the array is unchanged then
+   */
+  bool Assign(const std::vector<Entry> &entries, size_t begin, size_t end) {
+    if (!has_high_key_)
+      return Assign(entries, begin, end, nullptr);
+    KeyType high_key = HighKey();
+    return Assign(entries, begin, end, &high_key);
+  }
+
+  /*
+   * Rebuild the array from entries[begin, end) with high_key as its high
+   * key, or none if nullptr
+   * @return: false if they do not fit, the array is unchanged then
+   */
+  bool Assign(const std::vector<Entry> &entries, size_t begin, size_t end,
+              const KeyType *high_key) {
+    size_t prefix;
+    size_t high = high_key == nullptr ? 0 : SignificantBytes(*high_key);
+    if (GetBytes(entries, begin, end, skip_first_key_, prefix) + high >
+        capacity_)
+      return false;
+    if (high_key != nullptr)
+      memmove(data_ + capacity_ - high, high_key, high);
+    high_key_size_ = (uint16_t)high;
+    has_high_key_ = high_key != nullptr;
+    size_t first = begin + (skip_first_key_ && begin < end ? 1 : 0);
+    prefix_size_ = (uint16_t)prefix;
+    if (first < end)
+      memcpy(data_, reinterpret_cast<const char *>(&entries[first].first),
+             prefix);
+    size_t offset = capacity_ - high;
+    for (size_t i = begin; i < end; i++) {
+      size_t suffix =
+          i < first ? 0 : SignificantBytes(entries[i].first) - prefix;
+      offset -= sizeof(ValueType) + suffix;
+      memcpy(data_ + offset,
+             reinterpret_cast<const char *>(&entries[i].second),
+             sizeof(ValueType));
+      memcpy(data_ + offset + sizeof(ValueType),
+             reinterpret_cast<const char *>(&entries[i].first) + prefix,
+             suffix);
+      SetOffsetAt(i - begin, (uint16_t)offset);
+    }
+    return true;
+  }
+
+  /*
+   * Bytes of DATA that entries[begin, end) take, prefix is set to the size
+   * of their shared prefix
+   */
+  static size_t GetBytes(const std::vector<Entry> &entries, size_t begin,
+                         size_t end, bool skip_first_key, size_t &prefix) {
+    prefix = 0;
+    size_t first = begin + (skip_first_key && begin < end ? 1 : 0);
+    size_t bytes = (end - begin) * kPairOverhead;
+    if (first == end)
+      return bytes;
+    const KeyType &reference = entries[first].first;
+    size_t common = sizeof(KeyType), sum = 0;
+    for (size_t i = first; i < end; i++) {
+      size_t length = SignificantBytes(entries[i].first);
+      common = std::min(common, CommonBytes(reference, entries[i].first));
+      common = std::min(common, length);
+      sum += length;
+    }
+    prefix = common;
+    return bytes + prefix + sum - (end - first) * prefix;
+  }
+
+  /*
+   * Find m in [low, high] so that entries[0, m) and entries[m, n) both fit
+   * into capacity bytes and the left one takes closest to left_share of
+   * their bytes. The key of entries[m] is not stored on the right if
+   * skip_first_key, it moves up into the parent. The left page takes a high
+   * key no longer than the key of entries[m], the right page one of
+   * right_high_key bytes.
+   * @return: m, or -1 if there is no such split
+   */
+  static int SplitPoint(const std::vector<Entry> &entries, size_t capacity,
+                        bool skip_first_key, int low, int high,
+                        size_t right_high_key = 0, double left_share = 0.5) {
+    int n = entries.size();
+    int skip = skip_first_key ? 1 : 0;
+    // right[m]: bytes of entries[m, n), the shared prefix of a set of keys is
+    // the shortest common prefix with any one of them, here the last one
+    std::vector<size_t> right(n + 1, 0);
+    {
+      const KeyType &reference = entries[n - 1].first;
+      size_t common = sizeof(KeyType), sum = 0;
+      for (int m = n - 1; m >= 0; m--) {
+        if (m + skip < n) {
+          size_t length = SignificantBytes(entries[m + skip].first);
+          common = std::min(common,
+                            CommonBytes(reference, entries[m + skip].first));
+          common = std::min(common, length);
+          sum += length;
+        }
+        size_t keys = std::max(n - m - skip, 0);
+        size_t prefix = keys ? common : 0;
+        right[m] = (n - m) * kPairOverhead + prefix + sum - keys * prefix;
+      }
+    }
+    int best = -1;
+    double best_difference = 0;
+    const KeyType &reference = entries[std::min(skip, n - 1)].first;
+    size_t common = sizeof(KeyType), sum = 0;
+    for (int m = 1; m <= high; m++) {
+      // left: entries[0, m)
+      if (m - 1 >= skip) {
+        size_t length = SignificantBytes(entries[m - 1].first);
+        common =
+            std::min(common, CommonBytes(reference, entries[m - 1].first));
+        common = std::min(common, length);
+        sum += length;
+      }
+      if (m < low)
+        continue;
+      size_t keys = std::max(m - skip, 0);
+      size_t prefix = keys ? common : 0;
+      size_t left = m * kPairOverhead + prefix + sum - keys * prefix +
+                    SignificantBytes(entries[m].first);
+      size_t right_bytes = right[m] + right_high_key;
+      if (left > capacity || right_bytes > capacity)
+        continue;
+      double difference = std::abs(left * (1 - left_share) -
+                                   right_bytes * left_share);
+      if (best < 0 || difference < best_difference) {
+        best = m;
+        best_difference = difference;
+      }
+    }
+    return best;
+  }
+
+  /*
+   * Cut sorted entries into runs of consecutive entries that take at most
+   * fill_factor of capacity bytes each together with their high key, the
+   * key of the entry after the run, and at least two entries each if
+   * skip_first_key (internal pages). A last run of less than half of
+   * capacity is balanced with the run before it.
+   * @return: end of every run
+   */
+  static std::vector<size_t> Partition(const std::vector<Entry> &entries,
+                                       size_t capacity, bool skip_first_key,
+                                       double fill_factor) {
+    size_t n = entries.size(), skip = skip_first_key ? 1 : 0;
+    size_t limit = capacity * std::min(fill_factor, 1.0);
+    std::vector<size_t> ends;
+    size_t begin = 0;
+    while (begin < n) {
+      size_t end = begin, common = sizeof(KeyType), sum = 0;
+      while (end < n) {
+        size_t next_common = common, next_sum = sum;
+        if (end >= begin + skip) {
+          size_t length = SignificantBytes(entries[end].first);
+          next_common = std::min(common, CommonBytes(entries[begin + skip].first,
+                                                     entries[end].first));
+          next_common = std::min(next_common, length);
+          next_sum += length;
+        }
+        size_t count = end + 1 - begin;
+        size_t keys = count > skip ? count - skip : 0;
+        size_t prefix = keys ? next_common : 0;
+        size_t bytes = count * kPairOverhead + prefix + next_sum - keys * prefix;
+        if (end + 1 < n)
+          bytes += SignificantBytes(entries[end + 1].first);
+        if (count > skip + 1 && bytes > limit)
+          break;
+        common = next_common;
+        sum = next_sum;
+        end++;
+      }
+      ends.push_back(end);
+      begin = end;
+    }
+
+    if (ends.size() > 1) {
+      // the last two runs start at tail
+      size_t tail = ends.size() > 2 ? ends[ends.size() - 3] : 0;
+      size_t prefix;
+      if (GetBytes(entries, ends[ends.size() - 2], n, skip_first_key, prefix) <
+          capacity / 2) {
+        std::vector<Entry> last(entries.begin() + tail, entries.end());
+        int split = SplitPoint(last, capacity, skip_first_key, skip + 1,
+                               (int)last.size() - skip - 1);
+        if (split > 0)
+          ends[ends.size() - 2] = tail + split;
+      }
+    }
+    return ends;
+  }
+
+  // number of leading bytes two keys share
+  static size_t CommonBytes(const KeyType &lhs, const KeyType &rhs) {
+    const char *a = reinterpret_cast<const char *>(&lhs);
+    const char *b = reinterpret_cast<const char *>(&rhs);
+    size_t i = 0;
+    while (i < sizeof(KeyType) && a[i] == b[i])
+      i++;
+    return i;
+  }
+
+  // length of key without trailing zero bytes
+  static size_t SignificantBytes(const KeyType &key) {
+    const char *bytes = reinterpret_cast<const char *>(&key);
+    size_t length = sizeof(KeyType);
+    while (length > 0 && bytes[length - 1] == 0)
+      length--;
+    return length;
+  }
+
+private:
+  int FirstKey(int size) const { return skip_first_key_ && size > 0; }
+
+  size_t OffsetAt(int index) const {
+    uint16_t offset;
+    memcpy(&offset, data_ + prefix_size_ + index * sizeof(uint16_t),
+           sizeof(uint16_t));
+    return offset;
+  }
+
+  void SetOffsetAt(int index, uint16_t offset) {
+    memcpy(data_ + prefix_size_ + index * sizeof(uint16_t), &offset,
+           sizeof(uint16_t));
+  }
+
+  // end of the pair at index
+  size_t EndOf(int index) const {
+    return index == 0 ? capacity_ - high_key_size_ : OffsetAt(index - 1);
+  }
+
+  uint16_t capacity_;
+  uint16_t prefix_size_;
+  uint16_t skip_first_key_;
+  uint16_t high_key_size_;
+  uint16_t has_high_key_;
+  char data_[0];
+};
+
+/*
+ * Shortest key t with lhs < t <= rhs, made of a prefix of rhs followed by
+ * zero bytes. Used as separator between two pages instead of rhs itself
+ * (suffix truncation). Every candidate is checked with the comparator, so
+ * the result is a valid separator for any key type.
+ */
+template <typename KeyType, typename KeyComparator>
+KeyType ShortestSeparator(const KeyType &lhs, const KeyType &rhs,
+                          const KeyComparator &comparator) {
+  KeyType separator;
+  char *bytes = reinterpret_cast<char *>(&separator);
+  memset(bytes, 0, sizeof(KeyType));
+  const char *source = reinterpret_cast<const char *>(&rhs);
+  size_t length =
+      PackedEntryArray<KeyType, char>::SignificantBytes(rhs);
+  for (size_t i = 0; i < length; i++) {
+    bytes[i] = source[i];
+    if (comparator(lhs, separator) < 0 && comparator(separator, rhs) <= 0)
+      return separator;
+  }
+  return rhs;
+}
+
+} // namespace scudb
@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstring>
 #include <iostream>
 
@@ -20,7 +21,11 @@ class Page {
   friend class BufferPoolManager;
 
 public:
-  Page() { ResetMemory(); }
+  Page() {
+    ResetMemory();
+    for (auto &child : swizzled_)
+      child = nullptr;
+  }
   ~Page(){};
   // get actual data page content
   inline char *GetData() { return data_; }
@@ -33,6 +38,7 @@ public:
   inline void WLatch() { rwlatch_.WLock(); }
   inline void RUnlatch() { rwlatch_.RUnlock(); }
   inline void RLatch() { rwlatch_.RLock(); }
+  inline bool TryRLatch() { return rwlatch_.TryRLock(); }
 
   inline lsn_t GetLSN() { return *reinterpret_cast<lsn_t *>(GetData() + 4); }
   inline void SetLSN(lsn_t lsn) { memcpy(GetData() + 4, &lsn, 4); }
@@ -42,9 +48,17 @@ private:
   inline void ResetMemory() { memset(data_, 0, PAGE_SIZE); }
   // members
   char data_[PAGE_SIZE]; // actual data
-  page_id_t page_id_ = INVALID_PAGE_ID;
-  int pin_count_ = 0;
-  bool is_dirty_ = false;
+  // page_id_, pin_count_ and is_dirty_ are read without the latch of the
+  // buffer pool manager by BufferPoolManager::FetchChildPage and UnpinFrame
+  std::atomic<page_id_t> page_id_{INVALID_PAGE_ID};
+  // -1 while the frame holds no page or is being reused for another one
+  std::atomic<int> pin_count_{-1};
+  std::atomic<bool> is_dirty_{false};
+  // deleted while pinned, the frame is freed once the last pin is released
+  bool is_deleted_ = false;
+  // frames of the first children of a B+ tree internal page by child index,
+  // see BufferPoolManager::FetchChildPage
+  std::atomic<Page *> swizzled_[SWIZZLED_CHILDREN];
   RWMutex rwlatch_;
 };
 
@@ -4,10 +4,14 @@
 
 #pragma once
 
+#include <algorithm>
+
 #include "buffer/lru_replacer.h"
 #include "catalog/schema.h"
 #include "concurrency/transaction_manager.h"
+#include "index/art_index.h"
 #include "index/b_plus_tree_index.h"
+#include "index/extendible_hash_table_index.h"
 #include "logging/log_manager.h"
 #include "sqlite/sqlite3ext.h"
 #include "table/table_heap.h"
@@ -59,6 +63,14 @@ int VtabCommit(sqlite3_vtab *pVTab);
 
 int VtabBegin(sqlite3_vtab *pVTab);
 
+int VtabRollback(sqlite3_vtab *pVTab);
+
+int VtabSavepoint(sqlite3_vtab *pVTab, int iSavepoint);
+
+int VtabRelease(sqlite3_vtab *pVTab, int iSavepoint);
+
+int VtabRollbackTo(sqlite3_vtab *pVTab, int iSavepoint);
+
 // storage engine
 class StorageEngine {
 public:
@@ -99,6 +111,12 @@ public:
 StorageEngine *storage_engine_;
 // global transaction, sqlite does not support concurrent transaction
 Transaction *global_transaction_ = nullptr;
+// global_transaction_ was begun by a cursor of a read statement, which
+// commits it once the cursor is closed
+bool global_read_transaction_ = false;
+// sizes of the write set and the index write set of global_transaction_ at
+// every open savepoint, SQLite opens one around a statement it may abort
+std::vector<std::pair<size_t, size_t>> global_savepoints_;
 
 class VirtualTable {
   friend class Cursor;
@@ -127,22 +145,43 @@ public:
     delete index_;
   }
 
+  // fill a new index with the tuples already in the table heap, false if
+  // the index refused any of them
+  inline bool BuildIndex(Transaction *txn) {
+    if (index_ == nullptr)
+      return true;
+    std::vector<std::pair<Tuple, RID>> entries;
+    for (auto iterator = table_heap_->begin(txn);
+         iterator != table_heap_->end(); ++iterator)
+      entries.emplace_back(MakeEntry(*iterator), iterator->GetRid());
+    return index_->InsertEntries(entries, txn);
+  }
+
+  // index entry of a tuple, its key columns followed by the included ones
+  inline Tuple MakeEntry(const Tuple &tuple) {
+    std::vector<Value> entry_values;
+    for (auto &i : index_->GetEntryAttrs())
+      entry_values.push_back(tuple.GetValue(schema_, i));
+    return Tuple(entry_values, index_->GetEntrySchema());
+  }
+
   // insert into table heap
   inline bool InsertTuple(const Tuple &tuple, RID &rid) {
     return table_heap_->InsertTuple(tuple, rid, GetTransaction());
   }
 
-  // insert into index
-  inline void InsertEntry(const Tuple &tuple, const RID &rid) {
+  // insert into index, false if the index refuses the entry. The entry is
+  // kept in the index write set to undo it on rollback
+  inline bool InsertEntry(const Tuple &tuple, const RID &rid) {
     if (index_ == nullptr)
-      return;
-    // construct indexed key tuple
-    std::vector<Value> key_values;
-
-    for (auto &i : index_->GetKeyAttrs())
-      key_values.push_back(tuple.GetValue(schema_, i));
-    Tuple key(key_values, index_->GetKeySchema());
-    index_->InsertEntry(key, rid, GetTransaction());
+      return true;
+    Tuple entry = MakeEntry(tuple);
+    Transaction *txn = GetTransaction();
+    if (!index_->InsertEntry(entry, rid, txn))
+      return false;
+    if (txn != nullptr)
+      txn->GetIndexWriteSet()->emplace_back(rid, WType::INSERT, entry, index_);
+    return true;
   }
 
   // delete from table heap
@@ -155,15 +194,18 @@ public:
   inline void DeleteEntry(const RID &rid) {
     if (index_ == nullptr)
       return;
+    Transaction *txn = GetTransaction();
     Tuple deleted_tuple(rid);
-    table_heap_->GetTuple(rid, deleted_tuple, GetTransaction());
-    // construct indexed key tuple
-    std::vector<Value> key_values;
-
-    for (auto &i : index_->GetKeyAttrs())
-      key_values.push_back(deleted_tuple.GetValue(schema_, i));
-    Tuple key(key_values, index_->GetKeySchema());
-    index_->DeleteEntry(key, GetTransaction());
+    table_heap_->GetTuple(rid, deleted_tuple, txn);
+    Tuple entry = MakeEntry(deleted_tuple);
+    index_->DeleteEntry(entry, rid, txn);
+    if (txn != nullptr)
+      txn->GetIndexWriteSet()->emplace_back(rid, WType::DELETE, entry, index_);
+  }
+
+  // read table heap tuple
+  inline bool GetTuple(const RID &rid, Tuple &tuple) {
+    return table_heap_->GetTuple(rid, tuple, GetTransaction());
   }
 
   // update table heap tuple
@@ -206,6 +248,12 @@ public:
 
   inline bool IsIndexScan() { return is_index_scan_; }
 
+  // index scans read the columns from the index entries instead of the
+  // tuples in the table heap, the planner checked that they are covered
+  inline void SetIndexOnly(bool is_index_only) {
+    is_index_only_ = is_index_only;
+  }
+
   inline VirtualTable *GetVirtualTable() { return virtual_table_; }
 
   inline Schema *GetKeySchema() {
@@ -221,7 +269,14 @@ public:
 
   // return tuple at which cursor is currently pointed
   inline Value GetCurrentValue(Schema *schema, int column) {
-    if (is_index_scan_) {
+    if (is_index_scan_ && is_index_only_) {
+      Index *index = virtual_table_->index_;
+      auto &entry_attrs = index->GetEntryAttrs();
+      int entry_column =
+          std::find(entry_attrs.begin(), entry_attrs.end(), column) -
+          entry_attrs.begin();
+      return entries_[offset_].GetValue(index->GetEntrySchema(), entry_column);
+    } else if (is_index_scan_) {
       RID rid = results[offset_];
       Tuple tuple(rid);
       virtual_table_->table_heap_->GetTuple(rid, tuple, GetTransaction());
@@ -249,18 +304,39 @@ public:
 
   // wrapper around poit scan methods
   inline void ScanKey(const Tuple &key) {
-    virtual_table_->index_->ScanKey(key, results);
+    results.clear();
+    entries_.clear();
+    offset_ = 0;
+    if (is_index_only_)
+      virtual_table_->index_->ScanKeyEntries(key, results, entries_);
+    else
+      virtual_table_->index_->ScanKey(key, results);
+  }
+
+  // wrapper around ordered range scan, nullptr bounds are open
+  inline void ScanRange(const Tuple *low, const Tuple *high, bool descending) {
+    results.clear();
+    entries_.clear();
+    offset_ = 0;
+    if (is_index_only_)
+      virtual_table_->index_->ScanRangeEntries(low, high, descending, results,
+                                               entries_);
+    else
+      virtual_table_->index_->ScanRange(low, high, descending, results);
   }
 
 private:
   sqlite3_vtab_cursor base_; /* Base class - must be first */
   // for index scan
   std::vector<RID> results;
+  // entry of every rid in results for index-only scans
+  std::vector<Tuple> entries_;
   int offset_ = 0;
   // for sequential scan
   TableIterator table_iterator_;
   // flag to indicate which scan method is currently used
   bool is_index_scan_ = false;
+  bool is_index_only_ = false;
   VirtualTable *virtual_table_;
 }; // namespace scudb
 
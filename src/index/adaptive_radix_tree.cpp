@@ -0,0 +1,535 @@
+/**
+ * adaptive_radix_tree.cpp
+ */
+
+#include <cassert>
+#include <cstring>
+
+#include "index/adaptive_radix_tree.h"
+
+namespace scudb {
+
+enum class ArtNodeType : uint8_t { Leaf, Node4, Node16, Node48, Node256 };
+
+struct ArtNode {
+  explicit ArtNode(ArtNodeType type) : type(type), count(0) {}
+  ArtNodeType type;
+  // number of children of an inner node
+  uint16_t count;
+  // bytes shared by all keys below an inner node, past the byte that led to
+  // the node
+  std::string prefix;
+};
+
+struct ArtLeaf : ArtNode {
+  ArtLeaf(const std::string &key, const RID &value)
+      : ArtNode(ArtNodeType::Leaf), key(key), value(value) {}
+  std::string key;
+  RID value;
+};
+
+// up to 4 and 16 children, keys sorted
+struct ArtNode4 : ArtNode {
+  ArtNode4() : ArtNode(ArtNodeType::Node4) {}
+  uint8_t keys[4];
+  ArtNode *children[4];
+};
+
+struct ArtNode16 : ArtNode {
+  ArtNode16() : ArtNode(ArtNodeType::Node16) {}
+  uint8_t keys[16];
+  ArtNode *children[16];
+};
+
+// up to 48 children in any slot, index holds slot + 1 of a byte, 0 if none
+struct ArtNode48 : ArtNode {
+  ArtNode48() : ArtNode(ArtNodeType::Node48) {
+    memset(index, 0, sizeof(index));
+    memset(children, 0, sizeof(children));
+  }
+  uint8_t index[256];
+  ArtNode *children[48];
+};
+
+struct ArtNode256 : ArtNode {
+  ArtNode256() : ArtNode(ArtNodeType::Node256) {
+    memset(children, 0, sizeof(children));
+  }
+  ArtNode *children[256];
+};
+
+namespace {
+
+/*****************************************************************************
+ * NODE HELPERS
+ *****************************************************************************/
+void DeleteNode(ArtNode *node) {
+  switch (node->type) {
+  case ArtNodeType::Leaf:
+    delete static_cast<ArtLeaf *>(node);
+    break;
+  case ArtNodeType::Node4:
+    delete static_cast<ArtNode4 *>(node);
+    break;
+  case ArtNodeType::Node16:
+    delete static_cast<ArtNode16 *>(node);
+    break;
+  case ArtNodeType::Node48:
+    delete static_cast<ArtNode48 *>(node);
+    break;
+  case ArtNodeType::Node256:
+    delete static_cast<ArtNode256 *>(node);
+    break;
+  }
+}
+
+// call visit(byte, child) for every child with first <= byte <= last in
+// byte order, or in reverse byte order if descending. False if a visit
+// returned false
+template <typename Visit>
+bool ForEachChild(const ArtNode *node, bool descending, uint8_t first,
+                  uint8_t last, Visit visit) {
+  switch (node->type) {
+  case ArtNodeType::Node4:
+  case ArtNodeType::Node16: {
+    const uint8_t *keys = node->type == ArtNodeType::Node4
+                              ? static_cast<const ArtNode4 *>(node)->keys
+                              : static_cast<const ArtNode16 *>(node)->keys;
+    ArtNode *const *children =
+        node->type == ArtNodeType::Node4
+            ? static_cast<const ArtNode4 *>(node)->children
+            : static_cast<const ArtNode16 *>(node)->children;
+    for (int i = 0; i < node->count; i++) {
+      int slot = descending ? node->count - 1 - i : i;
+      if (keys[slot] >= first && keys[slot] <= last &&
+          !visit(keys[slot], children[slot]))
+        return false;
+    }
+    return true;
+  }
+  case ArtNodeType::Node48: {
+    auto inner = static_cast<const ArtNode48 *>(node);
+    for (int i = first; i <= last; i++) {
+      int byte = descending ? first + last - i : i;
+      if (inner->index[byte] != 0 &&
+          !visit((uint8_t)byte, inner->children[inner->index[byte] - 1]))
+        return false;
+    }
+    return true;
+  }
+  case ArtNodeType::Node256: {
+    auto inner = static_cast<const ArtNode256 *>(node);
+    for (int i = first; i <= last; i++) {
+      int byte = descending ? first + last - i : i;
+      if (inner->children[byte] != nullptr &&
+          !visit((uint8_t)byte, inner->children[byte]))
+        return false;
+    }
+    return true;
+  }
+  default:
+    return true;
+  }
+}
+
+void DeleteTree(ArtNode *node) {
+  ForEachChild(node, false, 0, 255, [](uint8_t, ArtNode *child) {
+    DeleteTree(child);
+    return true;
+  });
+  DeleteNode(node);
+}
+
+// slot of the child for byte, nullptr if there is none
+ArtNode **FindChild(ArtNode *node, uint8_t byte) {
+  switch (node->type) {
+  case ArtNodeType::Node4: {
+    auto inner = static_cast<ArtNode4 *>(node);
+    for (int i = 0; i < inner->count; i++)
+      if (inner->keys[i] == byte)
+        return &inner->children[i];
+    return nullptr;
+  }
+  case ArtNodeType::Node16: {
+    auto inner = static_cast<ArtNode16 *>(node);
+    for (int i = 0; i < inner->count; i++)
+      if (inner->keys[i] == byte)
+        return &inner->children[i];
+    return nullptr;
+  }
+  case ArtNodeType::Node48: {
+    auto inner = static_cast<ArtNode48 *>(node);
+    return inner->index[byte] == 0 ? nullptr
+                                   : &inner->children[inner->index[byte] - 1];
+  }
+  case ArtNodeType::Node256: {
+    auto inner = static_cast<ArtNode256 *>(node);
+    return inner->children[byte] == nullptr ? nullptr : &inner->children[byte];
+  }
+  default:
+    return nullptr;
+  }
+}
+
+// insert into the sorted keys of a node with room for one more child
+template <typename SortedNode>
+void InsertSorted(SortedNode *node, uint8_t byte, ArtNode *child) {
+  int i = node->count;
+  for (; i > 0 && node->keys[i - 1] > byte; i--) {
+    node->keys[i] = node->keys[i - 1];
+    node->children[i] = node->children[i - 1];
+  }
+  node->keys[i] = byte;
+  node->children[i] = child;
+  node->count++;
+}
+
+template <typename SortedNode>
+void RemoveSorted(SortedNode *node, uint8_t byte) {
+  int i = 0;
+  while (node->keys[i] != byte)
+    i++;
+  for (; i + 1 < node->count; i++) {
+    node->keys[i] = node->keys[i + 1];
+    node->children[i] = node->children[i + 1];
+  }
+  node->count--;
+}
+
+// copy the sorted children of from into an empty Node4 or Node16
+template <typename To, typename From> To *CopySorted(From *from) {
+  To *to = new To();
+  to->prefix = std::move(from->prefix);
+  for (int i = 0; i < from->count; i++) {
+    to->keys[i] = from->keys[i];
+    to->children[i] = from->children[i];
+  }
+  to->count = from->count;
+  return to;
+}
+
+// add a child for byte, the node is replaced by a larger one if it is full
+void AddChild(ArtNode *&node, uint8_t byte, ArtNode *child) {
+  switch (node->type) {
+  case ArtNodeType::Node4: {
+    auto inner = static_cast<ArtNode4 *>(node);
+    if (inner->count < 4) {
+      InsertSorted(inner, byte, child);
+      return;
+    }
+    ArtNode16 *grown = CopySorted<ArtNode16>(inner);
+    delete inner;
+    InsertSorted(grown, byte, child);
+    node = grown;
+    return;
+  }
+  case ArtNodeType::Node16: {
+    auto inner = static_cast<ArtNode16 *>(node);
+    if (inner->count < 16) {
+      InsertSorted(inner, byte, child);
+      return;
+    }
+    ArtNode48 *grown = new ArtNode48();
+    grown->prefix = std::move(inner->prefix);
+    for (int i = 0; i < 16; i++) {
+      grown->index[inner->keys[i]] = (uint8_t)(i + 1);
+      grown->children[i] = inner->children[i];
+    }
+    grown->count = 16;
+    delete inner;
+    node = grown;
+    AddChild(node, byte, child);
+    return;
+  }
+  case ArtNodeType::Node48: {
+    auto inner = static_cast<ArtNode48 *>(node);
+    if (inner->count < 48) {
+      int slot = 0;
+      while (inner->children[slot] != nullptr)
+        slot++;
+      inner->children[slot] = child;
+      inner->index[byte] = (uint8_t)(slot + 1);
+      inner->count++;
+      return;
+    }
+    ArtNode256 *grown = new ArtNode256();
+    grown->prefix = std::move(inner->prefix);
+    for (int i = 0; i < 256; i++)
+      if (inner->index[i] != 0)
+        grown->children[i] = inner->children[inner->index[i] - 1];
+    grown->count = 48;
+    delete inner;
+    node = grown;
+    AddChild(node, byte, child);
+    return;
+  }
+  case ArtNodeType::Node256: {
+    auto inner = static_cast<ArtNode256 *>(node);
+    inner->children[byte] = child;
+    inner->count++;
+    return;
+  }
+  default:
+    assert(false);
+  }
+}
+
+// remove the child for byte, the node is replaced by a smaller one once it
+// is a few children below the size it grew at, and by its only child once
+// it has one
+void RemoveChild(ArtNode *&node, uint8_t byte) {
+  switch (node->type) {
+  case ArtNodeType::Node4: {
+    auto inner = static_cast<ArtNode4 *>(node);
+    RemoveSorted(inner, byte);
+    if (inner->count > 1)
+      return;
+    // merge the prefix and the byte into the only child, a leaf keeps its
+    // whole key anyway
+    ArtNode *child = inner->children[0];
+    if (child->type != ArtNodeType::Leaf)
+      child->prefix = inner->prefix + (char)inner->keys[0] + child->prefix;
+    delete inner;
+    node = child;
+    return;
+  }
+  case ArtNodeType::Node16: {
+    auto inner = static_cast<ArtNode16 *>(node);
+    RemoveSorted(inner, byte);
+    if (inner->count > 3)
+      return;
+    node = CopySorted<ArtNode4>(inner);
+    delete inner;
+    return;
+  }
+  case ArtNodeType::Node48: {
+    auto inner = static_cast<ArtNode48 *>(node);
+    inner->children[inner->index[byte] - 1] = nullptr;
+    inner->index[byte] = 0;
+    inner->count--;
+    if (inner->count > 12)
+      return;
+    ArtNode16 *shrunk = new ArtNode16();
+    shrunk->prefix = std::move(inner->prefix);
+    for (int i = 0; i < 256; i++)
+      if (inner->index[i] != 0)
+        InsertSorted(shrunk, (uint8_t)i, inner->children[inner->index[i] - 1]);
+    delete inner;
+    node = shrunk;
+    return;
+  }
+  case ArtNodeType::Node256: {
+    auto inner = static_cast<ArtNode256 *>(node);
+    inner->children[byte] = nullptr;
+    inner->count--;
+    if (inner->count > 40)
+      return;
+    ArtNode *shrunk = new ArtNode48();
+    shrunk->prefix = std::move(inner->prefix);
+    for (int i = 0; i < 256; i++)
+      if (inner->children[i] != nullptr)
+        AddChild(shrunk, (uint8_t)i, inner->children[i]);
+    delete inner;
+    node = shrunk;
+    return;
+  }
+  default:
+    assert(false);
+  }
+}
+
+// number of bytes of the prefix of node that key matches from depth
+size_t MatchPrefix(const ArtNode *node, const std::string &key, size_t depth) {
+  size_t matched = 0;
+  while (matched < node->prefix.size() && depth + matched < key.size() &&
+         node->prefix[matched] == key[depth + matched])
+    matched++;
+  return matched;
+}
+
+// order of the keys below a node whose path to depth matches bound, and
+// whose prefix follows, against bound: 0 if bound continues past the prefix
+// with the same bytes
+int ComparePrefix(const ArtNode *node, const std::string &bound,
+                  size_t depth) {
+  for (size_t i = 0; i < node->prefix.size(); i++) {
+    // the keys extend bound
+    if (depth + i >= bound.size())
+      return 1;
+    uint8_t byte = (uint8_t)node->prefix[i];
+    uint8_t bound_byte = (uint8_t)bound[depth + i];
+    if (byte != bound_byte)
+      return byte < bound_byte ? -1 : 1;
+  }
+  return depth + node->prefix.size() < bound.size() ? 0 : 1;
+}
+
+/*****************************************************************************
+ * RECURSIVE OPERATIONS
+ *****************************************************************************/
+bool InsertAt(ArtNode *&node, const std::string &key, const RID &value,
+              size_t depth) {
+  if (node == nullptr) {
+    node = new ArtLeaf(key, value);
+    return true;
+  }
+  if (node->type == ArtNodeType::Leaf) {
+    auto leaf = static_cast<ArtLeaf *>(node);
+    if (leaf->key == key)
+      return false;
+    // the keys part at some byte, neither is a prefix of the other
+    size_t end = depth;
+    while (end < key.size() && end < leaf->key.size() &&
+           leaf->key[end] == key[end])
+      end++;
+    assert(end < key.size() && end < leaf->key.size());
+    ArtNode *inner = new ArtNode4();
+    inner->prefix = key.substr(depth, end - depth);
+    AddChild(inner, (uint8_t)leaf->key[end], leaf);
+    AddChild(inner, (uint8_t)key[end], new ArtLeaf(key, value));
+    node = inner;
+    return true;
+  }
+  size_t matched = MatchPrefix(node, key, depth);
+  if (matched < node->prefix.size()) {
+    // key leaves the prefix, split it in front of the first other byte
+    assert(depth + matched < key.size());
+    ArtNode *inner = new ArtNode4();
+    inner->prefix = node->prefix.substr(0, matched);
+    uint8_t byte = (uint8_t)node->prefix[matched];
+    node->prefix.erase(0, matched + 1);
+    AddChild(inner, byte, node);
+    AddChild(inner, (uint8_t)key[depth + matched], new ArtLeaf(key, value));
+    node = inner;
+    return true;
+  }
+  depth += node->prefix.size();
+  assert(depth < key.size());
+  ArtNode **child = FindChild(node, (uint8_t)key[depth]);
+  if (child != nullptr)
+    return InsertAt(*child, key, value, depth + 1);
+  AddChild(node, (uint8_t)key[depth], new ArtLeaf(key, value));
+  return true;
+}
+
+bool RemoveAt(ArtNode *&node, const std::string &key, size_t depth) {
+  if (node->type == ArtNodeType::Leaf) {
+    // only the root is reached as a leaf
+    if (static_cast<ArtLeaf *>(node)->key != key)
+      return false;
+    DeleteNode(node);
+    node = nullptr;
+    return true;
+  }
+  if (MatchPrefix(node, key, depth) < node->prefix.size())
+    return false;
+  depth += node->prefix.size();
+  if (depth >= key.size())
+    return false;
+  ArtNode **child = FindChild(node, (uint8_t)key[depth]);
+  if (child == nullptr)
+    return false;
+  if ((*child)->type != ArtNodeType::Leaf)
+    return RemoveAt(*child, key, depth + 1);
+  if (static_cast<ArtLeaf *>(*child)->key != key)
+    return false;
+  DeleteNode(*child);
+  RemoveChild(node, (uint8_t)key[depth]);
+  return true;
+}
+
+// low and high are nullptr unless the path to node matches their first
+// depth bytes, otherwise every key below node is within that bound
+bool ScanAt(const ArtNode *node, size_t depth, const std::string *low,
+            const std::string *high, bool descending,
+            const AdaptiveRadixTree::ScanCallback &callback) {
+  if (node->type == ArtNodeType::Leaf) {
+    auto leaf = static_cast<const ArtLeaf *>(node);
+    if ((low != nullptr && leaf->key < *low) ||
+        (high != nullptr && leaf->key > *high))
+      return true;
+    return callback(leaf->key, leaf->value);
+  }
+  if (low != nullptr) {
+    int order = ComparePrefix(node, *low, depth);
+    if (order < 0)
+      return true;
+    if (order > 0)
+      low = nullptr;
+  }
+  if (high != nullptr) {
+    int order = ComparePrefix(node, *high, depth);
+    if (order > 0)
+      return true;
+    if (order < 0)
+      high = nullptr;
+  }
+  depth += node->prefix.size();
+  // only the children between the bytes of the bounds, a bound still holds
+  // below the child of its own byte
+  uint8_t first = low == nullptr ? 0 : (uint8_t)(*low)[depth];
+  uint8_t last = high == nullptr ? 255 : (uint8_t)(*high)[depth];
+  return ForEachChild(
+      node, descending, first, last, [&](uint8_t byte, ArtNode *child) {
+        return ScanAt(child, depth + 1,
+                      low != nullptr && byte == first ? low : nullptr,
+                      high != nullptr && byte == last ? high : nullptr,
+                      descending, callback);
+      });
+}
+
+} // namespace
+
+/*****************************************************************************
+ * TREE
+ *****************************************************************************/
+bool AdaptiveRadixTree::Insert(const std::string &key, const RID &value) {
+  if (!InsertAt(root_, key, value, 0))
+    return false;
+  size_++;
+  return true;
+}
+
+bool AdaptiveRadixTree::Remove(const std::string &key) {
+  if (root_ == nullptr || !RemoveAt(root_, key, 0))
+    return false;
+  size_--;
+  return true;
+}
+
+// the prefixes are skipped, not compared, the leaf compares the whole key
+bool AdaptiveRadixTree::GetValue(const std::string &key, RID &value) const {
+  ArtNode *node = root_;
+  size_t depth = 0;
+  while (node != nullptr) {
+    if (node->type == ArtNodeType::Leaf) {
+      auto leaf = static_cast<ArtLeaf *>(node);
+      if (leaf->key != key)
+        return false;
+      value = leaf->value;
+      return true;
+    }
+    depth += node->prefix.size();
+    if (depth >= key.size())
+      return false;
+    ArtNode **child = FindChild(node, (uint8_t)key[depth++]);
+    node = child == nullptr ? nullptr : *child;
+  }
+  return false;
+}
+
+void AdaptiveRadixTree::Scan(const std::string *low, const std::string *high,
+                             bool descending,
+                             const ScanCallback &callback) const {
+  if (root_ != nullptr)
+    ScanAt(root_, 0, low, high, descending, callback);
+}
+
+void AdaptiveRadixTree::Clear() {
+  if (root_ != nullptr)
+    DeleteTree(root_);
+  root_ = nullptr;
+  size_ = 0;
+}
+
+} // namespace scudb
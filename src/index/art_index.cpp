@@ -0,0 +1,169 @@
+/**
+ * art_index.cpp
+ */
+
+#include "index/art_index.h"
+#include "index/key_encoding.h"
+
+namespace scudb {
+
+ArtIndex::ArtIndex(IndexMetadata *metadata)
+    : Index(metadata),
+      max_key_length_(KeyEncoder::MaxLength(metadata->GetEntrySchema()) +
+                      sizeof(RID)) {}
+
+bool ArtIndex::HasRidInKey() const {
+  return !GetMetadata()->IsUnique() ||
+         !GetMetadata()->GetIncludeAttrs().empty();
+}
+
+std::string ArtIndex::Encode(const Tuple &tuple, Schema *schema,
+                             int key_columns, const RID *rid) const {
+  std::string tree_key(max_key_length_, '\0');
+  while (true) {
+    KeyEncoder encoder(&tree_key[0], tree_key.size());
+    for (int i = 0; i < key_columns; i++)
+      encoder.PutValue(tuple.GetValue(schema, i));
+    if (rid != nullptr) {
+      encoder.PutUnsigned((uint32_t)rid->GetPageId(), 4);
+      encoder.PutUnsigned((uint32_t)rid->GetSlotNum(), 4);
+    }
+    for (int i = key_columns; i < schema->GetColumnCount(); i++)
+      encoder.PutValue(tuple.GetValue(schema, i));
+    // escaped 0x00 bytes make a varchar longer than declared, encode again
+    // into a buffer that fits
+    if (encoder.Length() > tree_key.size()) {
+      tree_key.assign(encoder.Length(), '\0');
+      continue;
+    }
+    tree_key.resize(encoder.Length());
+    return tree_key;
+  }
+}
+
+// the rid follows the key columns and is never all ones (INVALID_PAGE_ID), so
+// every tree key of key lies between them
+std::string ArtIndex::LowKey(const Tuple &key) const {
+  return Encode(key, GetKeySchema(), GetIndexColumnCount(), nullptr);
+}
+
+std::string ArtIndex::HighKey(const Tuple &key) const {
+  std::string high = LowKey(key);
+  if (HasRidInKey())
+    high.append(sizeof(RID), '\xff');
+  return high;
+}
+
+Tuple ArtIndex::GetEntry(const std::string &tree_key) const {
+  Schema *entry_schema = GetEntrySchema();
+  KeyDecoder decoder(tree_key.data());
+  std::vector<Value> values;
+  for (int i = 0; i < entry_schema->GetColumnCount(); i++) {
+    if (i == GetIndexColumnCount() && HasRidInKey())
+      decoder.Skip(sizeof(RID));
+    values.push_back(decoder.GetValue(entry_schema->GetType(i)));
+  }
+  return Tuple(values, entry_schema);
+}
+
+/*****************************************************************************
+ * MODIFICATION
+ *****************************************************************************/
+bool ArtIndex::InsertEntry(const Tuple &key, RID rid,
+                           Transaction *transaction) {
+  std::string tree_key = Encode(key, GetEntrySchema(), GetIndexColumnCount(),
+                                HasRidInKey() ? &rid : nullptr);
+  latch_.WLock();
+  // a unique index with included columns keeps the first entry of a key,
+  // like a unique tree key does
+  bool duplicate = false;
+  if (GetMetadata()->IsUnique() && HasRidInKey()) {
+    std::string low = LowKey(key), high = HighKey(key);
+    tree_.Scan(&low, &high, false, [&](const std::string &, const RID &) {
+      duplicate = true;
+      return false;
+    });
+  }
+  bool inserted = !duplicate && tree_.Insert(tree_key, rid);
+  latch_.WUnlock();
+  return inserted;
+}
+
+void ArtIndex::DeleteEntry(const Tuple &key, RID rid,
+                           Transaction *transaction) {
+  std::string tree_key = Encode(key, GetEntrySchema(), GetIndexColumnCount(),
+                                HasRidInKey() ? &rid : nullptr);
+  latch_.WLock();
+  tree_.Remove(tree_key);
+  latch_.WUnlock();
+}
+
+size_t ArtIndex::Size() {
+  latch_.RLock();
+  size_t size = tree_.Size();
+  latch_.RUnlock();
+  return size;
+}
+
+/*****************************************************************************
+ * SEARCH
+ *****************************************************************************/
+void ArtIndex::Collect(const std::string *low, const std::string *high,
+                       bool descending, std::vector<RID> &result,
+                       std::vector<Tuple> *entries) {
+  tree_.Scan(low, high, descending,
+             [&](const std::string &tree_key, const RID &rid) {
+               result.push_back(rid);
+               if (entries != nullptr)
+                 entries->push_back(GetEntry(tree_key));
+               return true;
+             });
+}
+
+void ArtIndex::ScanKey(const Tuple &key, std::vector<RID> &result,
+                       Transaction *transaction) {
+  std::string low = LowKey(key);
+  latch_.RLock();
+  if (HasRidInKey()) {
+    std::string high = HighKey(key);
+    Collect(&low, &high, false, result, nullptr);
+  } else {
+    RID rid;
+    if (tree_.GetValue(low, rid))
+      result.push_back(rid);
+  }
+  latch_.RUnlock();
+}
+
+void ArtIndex::ScanKeyEntries(const Tuple &key, std::vector<RID> &result,
+                              std::vector<Tuple> &entries,
+                              Transaction *transaction) {
+  std::string low = LowKey(key), high = HighKey(key);
+  latch_.RLock();
+  Collect(&low, &high, false, result, &entries);
+  latch_.RUnlock();
+}
+
+void ArtIndex::ScanRange(const Tuple *low, const Tuple *high, bool descending,
+                         std::vector<RID> &result, Transaction *transaction) {
+  std::string low_key = low == nullptr ? "" : LowKey(*low);
+  std::string high_key = high == nullptr ? "" : HighKey(*high);
+  latch_.RLock();
+  Collect(low == nullptr ? nullptr : &low_key,
+          high == nullptr ? nullptr : &high_key, descending, result, nullptr);
+  latch_.RUnlock();
+}
+
+void ArtIndex::ScanRangeEntries(const Tuple *low, const Tuple *high,
+                                bool descending, std::vector<RID> &result,
+                                std::vector<Tuple> &entries,
+                                Transaction *transaction) {
+  std::string low_key = low == nullptr ? "" : LowKey(*low);
+  std::string high_key = high == nullptr ? "" : HighKey(*high);
+  latch_.RLock();
+  Collect(low == nullptr ? nullptr : &low_key,
+          high == nullptr ? nullptr : &high_key, descending, result, &entries);
+  latch_.RUnlock();
+}
+
+} // namespace scudb
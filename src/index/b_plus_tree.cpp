@@ -1,8 +1,14 @@
 /**
  * b_plus_tree.cpp
  */
+#include <algorithm>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <numeric>
+#include <sstream>
 #include <string>
+#include <thread>
 
 #include "common/exception.h"
 #include "common/logger.h"
@@ -16,15 +22,36 @@ INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_TYPE::BPlusTree(const std::string &name,
                                 BufferPoolManager *buffer_pool_manager,
                                 const KeyComparator &comparator,
-                                page_id_t root_page_id)
+                                page_id_t root_page_id,
+                                const BPlusTreeOptions &options)
     : index_name_(name), root_page_id_(root_page_id),
-      buffer_pool_manager_(buffer_pool_manager), comparator_(comparator) {}
+      buffer_pool_manager_(buffer_pool_manager), comparator_(comparator),
+      options_(options), last_leaf_page_id_(INVALID_PAGE_ID),
+      adaptive_hash_(options.adaptive_hash ? ADAPTIVE_HASH_SIZE : 0,
+                     comparator),
+      write_buffer_(comparator),
+      buffered_(0), stop_compaction_(false), stats_loaded_(false),
+      stats_valid_(false), modifications_(0) {}
+
+INDEX_TEMPLATE_ARGUMENTS
+BPLUSTREE_TYPE::~BPlusTree() {
+  FlushWriteBuffer();
+  {
+    std::lock_guard<std::mutex> lock(compaction_mutex_);
+    stop_compaction_ = true;
+  }
+  compaction_cv_.notify_one();
+  if (compaction_thread_.joinable())
+    compaction_thread_.join();
+}
 
 /*
  * Helper function to decide whether current b+tree is empty
  */
 INDEX_TEMPLATE_ARGUMENTS
-bool BPLUSTREE_TYPE::IsEmpty() const { return true; }
+bool BPLUSTREE_TYPE::IsEmpty() const {
+  return root_page_id_ == INVALID_PAGE_ID;
+}
 /*****************************************************************************
  * SEARCH
  *****************************************************************************/
@@ -37,23 +64,298 @@ INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::GetValue(const KeyType &key,
                               std::vector<ValueType> &result,
                               Transaction *transaction) {
-  return false;
+  ValueType value;
+  bool found;
+  if (buffered_ == 0) {
+    found = LookupInTree(key, value);
+  } else {
+    // a buffered message of key decides over the tree, the pair of a pending
+    // insert only counts if the tree does not hold the key
+    buffer_latch_.RLock();
+    auto message = write_buffer_.Find(key);
+    if (message == nullptr) {
+      found = LookupInTree(key, value);
+    } else if (message->operation == BufferedOperation::REMOVE) {
+      found = false;
+    } else {
+      found = true;
+      if (message->operation == BufferedOperation::UPSERT ||
+          !LookupInTree(key, value))
+        value = message->value;
+    }
+    buffer_latch_.RUnlock();
+  }
+
+  if (found)
+    result.push_back(value);
+  return found;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::LookupInTree(const KeyType &key, ValueType &value) {
+  bool found;
+  if (AdaptiveHashLookup(key, value, found))
+    return found;
+  Page *page = FindLeafPageOptimistic(key, false, false);
+  if (page == nullptr)
+    return false;
+  auto leaf = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+  found = leaf->Lookup(key, value, comparator_);
+  if (options_.adaptive_hash)
+    adaptive_hash_.Record(key, page->GetPageId(), leaf->GetLSN());
+  page->RUnlatch();
+  buffer_pool_manager_->UnpinFrame(page, false);
+  return found;
+}
+
+/*
+ * A hot key was found in its leaf by a search that left the leaf at the
+ * cached version. Pairs only move out of a leaf when it is rewritten, which
+ * changes its version, and keys inserted meanwhile go to the leaf that covers
+ * them, so the key is still in that leaf or nowhere in the tree.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::AdaptiveHashLookup(const KeyType &key, ValueType &value,
+                                        bool &found) {
+  page_id_t page_id;
+  lsn_t version;
+  if (!options_.adaptive_hash ||
+      !adaptive_hash_.Lookup(key, page_id, version))
+    return false;
+  Page *page = FetchPage(page_id);
+  page->RLatch();
+  auto leaf = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+  bool hit = leaf->IsLeafPage() && leaf->GetLSN() == version;
+  if (hit) {
+    found = leaf->Lookup(key, value, comparator_);
+    // the page may have been merged away and read back before it was latched
+    hit = adaptive_hash_.Validate(key, page_id, version);
+  }
+  page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(page_id, false);
+  return hit;
+}
+
+/*
+ * Batched point query, every key is the range [key, key] of GetRanges
+ */
+INDEX_TEMPLATE_ARGUMENTS
+size_t BPLUSTREE_TYPE::GetValues(const std::vector<KeyType> &keys,
+                                 std::vector<ValueType> &result,
+                                 Transaction *transaction) {
+  std::vector<std::pair<KeyType, KeyType>> ranges;
+  ranges.reserve(keys.size());
+  for (auto &key : keys)
+    ranges.emplace_back(key, key);
+  return GetRanges(ranges, result, transaction);
+}
+
+/*
+ * The ranges are sorted by low key and resolved in one pass that keeps the
+ * read latched path from the root to the current leaf. The next range
+ * restarts from the deepest page on the path whose high key is above its low
+ * key, so a run of keys in one leaf costs a single descent and keys in a
+ * neighbouring leaf only descend from their common ancestor. Latches are
+ * only taken top-down and the latched path can not change, so no page needs
+ * to be left to the right. A range that runs past the leaf releases the path
+ * and finishes with an iterator.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+size_t BPLUSTREE_TYPE::GetRanges(
+    const std::vector<std::pair<KeyType, KeyType>> &ranges,
+    std::vector<ValueType> &result, Transaction *transaction) {
+  FlushWriteBuffer(transaction);
+  std::vector<size_t> order(ranges.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return comparator_(ranges[a].first, ranges[b].first) < 0;
+  });
+
+  std::vector<Page *> path;
+  auto pop = [&]() {
+    path.back()->RUnlatch();
+    buffer_pool_manager_->UnpinPage(path.back()->GetPageId(), false);
+    path.pop_back();
+  };
+  size_t count = 0;
+  for (size_t i : order) {
+    const KeyType &low = ranges[i].first, &high = ranges[i].second;
+    if (comparator_(low, high) > 0)
+      continue;
+    while (!path.empty() &&
+           IsPastHighKey(
+               reinterpret_cast<BPlusTreePage *>(path.back()->GetData()), low))
+      pop();
+    if (path.empty()) {
+      root_latch_.RLock();
+      if (IsEmpty()) {
+        root_latch_.RUnlock();
+        break;
+      }
+      Page *root = FetchPage(root_page_id_);
+      root->RLatch();
+      root_latch_.RUnlock();
+      path.push_back(root);
+    }
+
+    auto node = reinterpret_cast<BPlusTreePage *>(path.back()->GetData());
+    while (!node->IsLeafPage()) {
+      auto internal = reinterpret_cast<
+          BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(node);
+      Page *child = FetchPage(internal->Lookup(low, comparator_));
+      child->RLatch();
+      path.push_back(child);
+      node = reinterpret_cast<BPlusTreePage *>(child->GetData());
+    }
+
+    auto leaf = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(node);
+    int index = leaf->KeyIndex(low, comparator_);
+    for (; index < leaf->GetSize() &&
+           comparator_(leaf->KeyAt(index), high) <= 0;
+         index++, count++)
+      result.push_back(leaf->GetItem(index).second);
+    if (index < leaf->GetSize() || !leaf->HasHighKey() ||
+        comparator_(high, leaf->GetHighKey()) < 0)
+      continue;
+    // the range continues in the leaves to the right
+    KeyType high_key = leaf->GetHighKey();
+    while (!path.empty())
+      pop();
+    for (auto iterator = Begin(high_key, high); !iterator.isEnd();
+         ++iterator, count++)
+      result.push_back((*iterator).second);
+  }
+  while (!path.empty())
+    pop();
+  return count;
 }
 
 /*****************************************************************************
  * INSERTION
  *****************************************************************************/
+/*
+ * With the write buffer on, the insert only adds a message and does not read
+ * the tree. It returns false for a key with a pending insert only, the insert
+ * of a key the tree holds already is dropped when its message is applied
+ * (InsertIntoTree keeps the first pair). Unique indexes check the key first
+ * (see BPlusTreeIndex::InsertEntry).
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value,
+                            Transaction *transaction) {
+  modifications_++;
+  if (!options_.write_buffer)
+    return InsertIntoTree(key, value, transaction);
+  buffer_latch_.WLock();
+  bool inserted = write_buffer_.Insert(key, value);
+  if (write_buffer_.Size() >= WRITE_BUFFER_SIZE)
+    FlushBusiestChild(transaction);
+  buffered_ = write_buffer_.Size();
+  buffer_latch_.WUnlock();
+  return inserted;
+}
+
 /*
  * Insert constant key & value pair into b+ tree
  * if current tree is empty, start new tree, update root page id and insert
  * entry, otherwise insert into leaf page.
+ * Keys past the end of the last leaf are appended there without a descent
+ * while inserts keep coming in ascending order. Otherwise the first attempt
+ * only write latches the leaf and succeeds whenever the leaf has room, and
+ * the insert restarts with write latches from the root if it has not.
  * @return: since we only support unique key, if user try to insert duplicate
  * keys return false, otherwise return true.
  */
 INDEX_TEMPLATE_ARGUMENTS
-bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value,
-                            Transaction *transaction) {
-  return false;
+bool BPLUSTREE_TYPE::InsertIntoTree(const KeyType &key, const ValueType &value,
+                                    Transaction *transaction) {
+  bool inserted, leaf_full = false;
+  if (AppendToLastLeaf(key, value, leaf_full))
+    return true;
+  if (!leaf_full && OptimisticInsert(key, value, inserted))
+    return inserted;
+
+  std::unique_ptr<Transaction> local_transaction;
+  if (transaction == nullptr) {
+    local_transaction.reset(new Transaction(INVALID_TXN_ID));
+    transaction = local_transaction.get();
+  }
+  return InsertIntoLeaf(key, value, transaction);
+}
+
+/*
+ * Append to the cached last leaf, holding its write latch only. The last leaf
+ * takes every key above its first one, so a key past its last key belongs
+ * there and is not a duplicate. The cached page id is checked again once the
+ * page is latched: a leaf merged away is forgotten before its page is
+ * deleted, so the page is only read while it still is the last leaf.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::AppendToLastLeaf(const KeyType &key,
+                                      const ValueType &value,
+                                      bool &leaf_full) {
+  page_id_t page_id = last_leaf_page_id_.load();
+  if (page_id == INVALID_PAGE_ID)
+    return false;
+  Page *page = FetchPage(page_id);
+  page->WLatch();
+  auto leaf = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+  bool inserted = false;
+  if (last_leaf_page_id_.load() == page_id &&
+      leaf->GetNextPageId() == INVALID_PAGE_ID && leaf->GetSize() > 0 &&
+      comparator_(key, leaf->KeyAt(leaf->GetSize() - 1)) > 0) {
+    inserted = leaf->Insert(key, value, comparator_);
+    leaf_full = !inserted;
+  }
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page_id, inserted);
+  return inserted;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::UpdateLastLeaf(B_PLUS_TREE_LEAF_PAGE_TYPE *leaf,
+                                    const KeyType &key) {
+  page_id_t page_id = INVALID_PAGE_ID;
+  if (leaf->GetNextPageId() == INVALID_PAGE_ID &&
+      comparator_(key, leaf->KeyAt(leaf->GetSize() - 1)) == 0)
+    page_id = leaf->GetPageId();
+  // random inserts only read the shared page id
+  if (last_leaf_page_id_.load() != page_id)
+    last_leaf_page_id_.store(page_id);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ForgetLastLeaf(page_id_t page_id) {
+  last_leaf_page_id_.compare_exchange_strong(page_id, INVALID_PAGE_ID);
+}
+
+/*
+ * Insert into a leaf that has room while holding the read latches of the
+ * ancestors and the write latch of the leaf only
+ * @return: true if the insert was handled (inserted is set), false if the leaf
+ * is full or the tree is empty
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::OptimisticInsert(const KeyType &key,
+                                      const ValueType &value, bool &inserted) {
+  Page *page = FindLeafPageOptimistic(key, false, true);
+  if (page == nullptr)
+    return false;
+  auto leaf = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+  bool done = true;
+  ValueType old_value;
+  inserted = false;
+  if (leaf->Lookup(key, old_value, comparator_)) {
+    // duplicate key
+  } else if (leaf->Insert(key, value, comparator_)) {
+    inserted = true;
+    UpdateLastLeaf(leaf, key);
+  } else {
+    done = false;
+  }
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), inserted);
+  return done;
 }
 /*
  * Insert constant key & value pair into an empty tree
@@ -62,31 +364,74 @@ bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value,
  * tree's root page id and insert entry directly into leaf page.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {}
+void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {
+  page_id_t page_id;
+  Page *page = NewPage(page_id);
+  auto root = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+  root->Init(page_id);
+  root->Insert(key, value, comparator_);
+  root_page_id_ = page_id;
+  UpdateRootPageId(true);
+  buffer_pool_manager_->UnpinPage(page_id, true);
+}
 
 /*
  * Insert constant key & value pair into leaf page
  * User needs to first find the right leaf page as insertion target, then look
  * through leaf page to see whether insert key exist or not. If exist, return
  * immdiately, otherwise insert entry. Remember to deal with split if necessary.
+ * The leaf is found with write latch crabbing, every ancestor a split may
+ * reach stays latched until the insert is done. Starts a new tree if the tree
+ * is empty.
  * @return: since we only support unique key, if user try to insert duplicate
  * keys return false, otherwise return true.
  */
 INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value,
                                     Transaction *transaction) {
-  return false;
+  Page *page = FindLeafPagePessimistic(key, Operation::INSERT, transaction);
+  bool inserted = true;
+  if (page == nullptr) {
+    // root latch is held, no other thread can start the tree meanwhile
+    StartNewTree(key, value);
+  } else {
+    auto leaf =
+        reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+    ValueType old_value;
+    if (leaf->Lookup(key, old_value, comparator_)) {
+      inserted = false;
+    } else if (leaf->Insert(key, value, comparator_)) {
+      UpdateLastLeaf(leaf, key);
+    } else {
+      B_PLUS_TREE_LEAF_PAGE_TYPE *new_leaf = Split(leaf);
+      leaf->MoveHalfTo(new_leaf, key, value, comparator_);
+      RelinkNextLeaf(new_leaf);
+      UpdateLastLeaf(new_leaf, key);
+      // the new high key of leaf, the shortest key between the two leaves
+      InsertIntoParent(leaf, leaf->GetHighKey(), new_leaf, transaction);
+      buffer_pool_manager_->UnpinPage(new_leaf->GetPageId(), true);
+    }
+  }
+  ReleasePageSet(transaction, inserted);
+  return inserted;
 }
 
 /*
- * Split input page and return newly created page.
+ * Create the right sibling of input page that a split moves half of its key &
+ * value pairs into, and return it.
  * Using template N to represent either internal page or leaf page.
  * User needs to first ask for new page from buffer pool manager(NOTICE: throw
- * an "out of memory" exception if returned value is nullptr), then move half
- * of key & value pairs from input page to newly created page
+ * an "out of memory" exception if returned value is nullptr). The caller
+ * moves the pairs, since the pair that did not fit is inserted meanwhile.
  */
 INDEX_TEMPLATE_ARGUMENTS
-template <typename N> N *BPLUSTREE_TYPE::Split(N *node) { return nullptr; }
+template <typename N> N *BPLUSTREE_TYPE::Split(N *node) {
+  page_id_t page_id;
+  Page *page = NewPage(page_id);
+  N *new_node = reinterpret_cast<N *>(page->GetData());
+  new_node->Init(page_id, node->GetParentPageId());
+  return new_node;
+}
 
 /*
  * Insert key & value pair into internal page after split
@@ -101,67 +446,363 @@ INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node,
                                       const KeyType &key,
                                       BPlusTreePage *new_node,
-                                      Transaction *transaction) {}
+                                      Transaction *transaction) {
+  if (old_node->IsRootPage()) {
+    // the root split, root latch is still held
+    page_id_t root_page_id;
+    Page *page = NewPage(root_page_id);
+    auto root = reinterpret_cast<
+        BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(
+        page->GetData());
+    root->Init(root_page_id);
+    root->PopulateNewRoot(old_node->GetPageId(), key, new_node->GetPageId());
+    old_node->SetParentPageId(root_page_id);
+    new_node->SetParentPageId(root_page_id);
+    root_page_id_ = root_page_id;
+    UpdateRootPageId();
+    buffer_pool_manager_->UnpinPage(root_page_id, true);
+    return;
+  }
+
+  // parent is write latched in the page set of transaction
+  page_id_t parent_page_id = old_node->GetParentPageId();
+  auto parent = reinterpret_cast<
+      BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(
+      FetchPage(parent_page_id)->GetData());
+  new_node->SetParentPageId(parent_page_id);
+  if (!parent->InsertNodeAfter(old_node->GetPageId(), key,
+                               new_node->GetPageId())) {
+    auto new_parent = Split(parent);
+    KeyType middle_key =
+        parent->MoveHalfTo(new_parent, old_node->GetPageId(), key,
+                           new_node->GetPageId(), buffer_pool_manager_);
+    InsertIntoParent(parent, middle_key, new_parent, transaction);
+    buffer_pool_manager_->UnpinPage(new_parent->GetPageId(), true);
+  }
+  buffer_pool_manager_->UnpinPage(parent_page_id, true);
+}
+
+/*****************************************************************************
+ * BULK LOADING
+ *****************************************************************************/
+/*
+ * Build the leaf level from the sorted items, then every internal level from
+ * the (separator, page id) pairs of the level below, until one node is left
+ * which becomes the root. The separator of a leaf is the shortest key between
+ * it and its left neighbour, and the high key of that neighbour. Each level
+ * is written sequentially with two pages pinned at a time besides the
+ * children being adopted.
+ * @return: false if the tree is not empty or the keys are not strictly
+ * ascending
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::BulkLoad(const std::vector<MappingType> &items,
+                              double fill_factor) {
+  for (size_t i = 1; i < items.size(); i++) {
+    if (comparator_(items[i - 1].first, items[i].first) >= 0)
+      return false;
+  }
+  FlushWriteBuffer();
+  root_latch_.WLock();
+  if (!IsEmpty() || items.empty()) {
+    root_latch_.WUnlock();
+    return items.empty();
+  }
+  modifications_ += items.size();
+
+  // separator and page id of every node of the level built last
+  std::vector<std::pair<KeyType, page_id_t>> level;
+  page_id_t page_id;
+  auto leaf = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(
+      NewPage(page_id)->GetData());
+  leaf->Init(page_id);
+  std::vector<size_t> ends = PackedEntryArray<KeyType, ValueType>::Partition(
+      items, leaf->GetCapacity(), false, fill_factor);
+  size_t begin = 0;
+  KeyType high_key;
+  for (size_t i = 0; i < ends.size(); i++) {
+    if (i > 0) {
+      auto new_leaf = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(
+          NewPage(page_id)->GetData());
+      new_leaf->Init(page_id);
+      new_leaf->SetPrevPageId(leaf->GetPageId());
+      leaf->SetNextPageId(page_id);
+      buffer_pool_manager_->UnpinPage(leaf->GetPageId(), true);
+      leaf = new_leaf;
+      level.emplace_back(high_key, page_id);
+    } else {
+      level.emplace_back(items[0].first, page_id);
+    }
+    bool last = i + 1 == ends.size();
+    if (!last)
+      high_key = ShortestSeparator(items[ends[i] - 1].first,
+                                   items[ends[i]].first, comparator_);
+    leaf->Populate(items, begin, ends[i], last ? nullptr : &high_key);
+    begin = ends[i];
+  }
+  buffer_pool_manager_->UnpinPage(leaf->GetPageId(), true);
+
+  while (level.size() > 1) {
+    std::vector<std::pair<KeyType, page_id_t>> parent_level;
+    auto internal = reinterpret_cast<
+        BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(
+        NewPage(page_id)->GetData());
+    internal->Init(page_id);
+    ends = PackedEntryArray<KeyType, page_id_t>::Partition(
+        level, internal->GetCapacity(), true, fill_factor);
+    begin = 0;
+    for (size_t i = 0; i < ends.size(); i++) {
+      if (i > 0) {
+        auto new_internal = reinterpret_cast<
+            BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(
+            NewPage(page_id)->GetData());
+        new_internal->Init(page_id);
+        internal->SetNextPageId(page_id);
+        buffer_pool_manager_->UnpinPage(internal->GetPageId(), true);
+        internal = new_internal;
+      }
+      // the first key of the node moves up as its separator and is the high
+      // key of the node before it
+      parent_level.emplace_back(level[begin].first, page_id);
+      bool last = i + 1 == ends.size();
+      internal->Populate(level, begin, ends[i],
+                         last ? nullptr : &level[ends[i]].first);
+      for (; begin < ends[i]; begin++) {
+        auto child = reinterpret_cast<BPlusTreePage *>(
+            FetchPage(level[begin].second)->GetData());
+        child->SetParentPageId(page_id);
+        buffer_pool_manager_->UnpinPage(level[begin].second, true);
+      }
+    }
+    buffer_pool_manager_->UnpinPage(internal->GetPageId(), true);
+    level.swap(parent_level);
+  }
+
+  root_page_id_ = level[0].second;
+  UpdateRootPageId(true);
+  root_latch_.WUnlock();
+  return true;
+}
 
 /*****************************************************************************
  * REMOVE
  *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
+  modifications_++;
+  if (!options_.write_buffer) {
+    RemoveFromTree(key, transaction);
+    return;
+  }
+  buffer_latch_.WLock();
+  write_buffer_.Remove(key);
+  if (write_buffer_.Size() >= WRITE_BUFFER_SIZE)
+    FlushBusiestChild(transaction);
+  buffered_ = write_buffer_.Size();
+  buffer_latch_.WUnlock();
+}
+
 /*
  * Delete key & value pair associated with input key
  * If current tree is empty, return immdiately.
  * If not, User needs to first find the right leaf page as deletion target, then
  * delete entry from leaf page. Remember to deal with redistribute or merge if
  * necessary.
+ * Like Insert, the first attempt only write latches the leaf and restarts
+ * with write latches from the root if the leaf would underflow. With merges
+ * deferred, only a leaf that would be emptied restarts, one left less than
+ * MERGE_FILL_FACTOR full waits for the compaction thread.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {}
+void BPLUSTREE_TYPE::RemoveFromTree(const KeyType &key,
+                                    Transaction *transaction) {
+  bool deferred = options_.deferred_merge;
+  if (OptimisticRemove(key, deferred))
+    return;
+
+  std::unique_ptr<Transaction> local_transaction;
+  if (transaction == nullptr) {
+    local_transaction.reset(new Transaction(INVALID_TXN_ID));
+    transaction = local_transaction.get();
+  }
+  Page *page = FindLeafPagePessimistic(
+      key, deferred ? Operation::LAZY_DELETE : Operation::DELETE, transaction);
+  bool underfull = false;
+  if (page != nullptr) {
+    auto leaf =
+        reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+    int size = leaf->GetSize();
+    bool was_underfull = leaf->IsBelowFill(MERGE_FILL_FACTOR);
+    if (leaf->RemoveAndDeleteRecord(key, comparator_) < size) {
+      // an insert may have refilled the leaf since the optimistic attempt,
+      // then its parent is not latched
+      if (deferred && !leaf->IsRootPage() && leaf->GetSize() > 0)
+        underfull = !was_underfull && leaf->IsBelowFill(MERGE_FILL_FACTOR);
+      else if (CoalesceOrRedistribute(leaf, transaction))
+        transaction->AddIntoDeletedPageSet(leaf->GetPageId());
+    }
+  }
+  ReleasePageSet(transaction, true);
+  if (underfull)
+    AddUnderfullLeaf(key);
+}
 
 /*
- * User needs to first find the sibling of input page. If sibling's size + input
- * page's size > page's max size, then redistribute. Otherwise, merge.
+ * Remove from a leaf that stays at least half full while holding the read
+ * latches of the ancestors and the write latch of the leaf only. The parent
+ * page id of the leaf is not stable without its parent latched, so a root
+ * leaf is treated like any other leaf here. With deferred merges the leaf
+ * only has to keep one pair.
+ * @return: true if the remove was handled, false if the leaf would underflow
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::OptimisticRemove(const KeyType &key, bool deferred) {
+  Page *page = FindLeafPageOptimistic(key, false, true);
+  if (page == nullptr)
+    return true;
+  auto leaf = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+  bool done = true, removed = false, underfull = false;
+  ValueType value;
+  if (!leaf->Lookup(key, value, comparator_)) {
+    // nothing to remove
+  } else if (deferred ? leaf->GetSize() > 1 : leaf->IsRemoveSafe()) {
+    bool was_underfull = leaf->IsBelowFill(MERGE_FILL_FACTOR);
+    leaf->RemoveAndDeleteRecord(key, comparator_);
+    removed = true;
+    underfull = !was_underfull && leaf->IsBelowFill(MERGE_FILL_FACTOR);
+  } else {
+    done = false;
+  }
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), removed);
+  if (underfull)
+    AddUnderfullLeaf(key);
+  return done;
+}
+
+/*
+ * User needs to first find the sibling of input page. If the pairs of both
+ * pages fit into one page, merge them. Otherwise, redistribute.
  * Using template N to represent either internal page or leaf page.
+ * Underflow only costs space, so a page without sibling or whose pairs can
+ * not be redistributed is left as it is.
  * @return: true means target leaf page should be deleted, false means no
  * deletion happens
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
 bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) {
+  if (node->IsRootPage())
+    return AdjustRoot(node);
+  if (!node->IsUnderflow())
+    return false;
+
+  // parent and node are write latched in the page set of transaction
+  page_id_t parent_page_id = node->GetParentPageId();
+  auto parent = reinterpret_cast<
+      BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(
+      FetchPage(parent_page_id)->GetData());
+  if (parent->GetSize() < 2) {
+    buffer_pool_manager_->UnpinPage(parent_page_id, false);
+    return false;
+  }
+  int index = parent->ValueIndex(node->GetPageId());
+  Page *sibling_page = FetchPage(parent->ValueAt(index == 0 ? 1 : index - 1));
+  if (index == 0) {
+    sibling_page->WLatch();
+  } else {
+    // latch siblings left to right like iterators do. While node is
+    // unlatched, iterators and the readers and optimistic writers that
+    // pinned it before the parent was latched may latch it. Such writers only
+    // make changes that need no split or merge, so node keeps its place in
+    // parent, and its pairs are only read once it is latched again. A thread
+    // that gets the latch of a merged page finds it invalid and starts over,
+    // the page is freed with its last pin (see BufferPoolManager::DeletePage)
+    Page *node_page = FetchPage(node->GetPageId());
+    node_page->WUnlatch();
+    sibling_page->WLatch();
+    node_page->WLatch();
+    buffer_pool_manager_->UnpinPage(node->GetPageId(), false);
+  }
+  transaction->AddIntoPageSet(sibling_page);
+
+  // the right page of the two is merged into the left one
+  N *sibling = reinterpret_cast<N *>(sibling_page->GetData());
+  N *left = index == 0 ? node : sibling;
+  N *right = index == 0 ? sibling : node;
+  int right_index = index == 0 ? 1 : index;
+  if (!Coalesce(left, right, parent, right_index, transaction))
+    Redistribute(left, right, right_index);
+  buffer_pool_manager_->UnpinPage(parent_page_id, true);
   return false;
 }
 
 /*
- * Move all the key & value pairs from one page to its sibling page, and notify
- * buffer pool manager to delete this page. Parent page must be adjusted to
- * take info of deletion into account. Remember to deal with coalesce or
- * redistribute recursively if necessary.
+ * Move all the key & value pairs from the right page into the left page, and
+ * notify buffer pool manager to delete the right page. Parent page must be
+ * adjusted to take info of deletion into account. Remember to deal with
+ * coalesce or redistribute recursively if necessary.
  * Using template N to represent either internal page or leaf page.
- * @param   neighbor_node      sibling page of input "node"
- * @param   node               input from method coalesceOrRedistribute()
- * @param   parent             parent page of input "node"
- * @return  true means parent node should be deleted, false means no deletion
- * happend
+ * @param   left               left page of the two siblings
+ * @param   right              right page of the two siblings
+ * @param   parent             parent page of both
+ * @param   index              index of right in parent
+ * @return  false if the pairs do not fit into one page, nothing is changed
+ * then
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
 bool BPLUSTREE_TYPE::Coalesce(
-    N *&neighbor_node, N *&node,
-    BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *&parent,
+    N *left, N *right,
+    BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *parent,
     int index, Transaction *transaction) {
-  return false;
+  if (!right->MoveAllTo(left, index, buffer_pool_manager_))
+    return false;
+  // readers that pinned right before it was unlinked start over
+  right->SetPageType(IndexPageType::INVALID_INDEX_PAGE);
+  if (left->IsLeafPage()) {
+    ForgetLastLeaf(right->GetPageId());
+    RelinkNextLeaf(reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(left));
+  }
+  transaction->AddIntoDeletedPageSet(right->GetPageId());
+  parent->Remove(index);
+  if (CoalesceOrRedistribute(parent, transaction))
+    transaction->AddIntoDeletedPageSet(parent->GetPageId());
+  return true;
 }
 
 /*
- * Redistribute key & value pairs from one page to its sibling page. If index ==
- * 0, move sibling page's first key & value pair into end of input "node",
- * otherwise move sibling page's last key & value pair into head of input
- * "node".
+ * Redistribute key & value pairs between two sibling pages so that both take
+ * about the same number of bytes, and update their separator in parent. The
+ * pages are left as they are if the new separator does not fit into parent.
  * Using template N to represent either internal page or leaf page.
- * @param   neighbor_node      sibling page of input "node"
- * @param   node               input from method coalesceOrRedistribute()
+ * @param   left               left page of the two siblings
+ * @param   right              right page of the two siblings
+ * @param   index              index of right in parent
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {}
+void BPLUSTREE_TYPE::Redistribute(N *left, N *right, int index) {
+  left->RedistributeWith(right, index, buffer_pool_manager_, comparator_);
+}
+
+/*
+ * After a split or merge changed the right neighbour of leaf, update the prev
+ * link of the new neighbour. leaf is write latched, its neighbour is latched
+ * after it, left to right like iterators do.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::RelinkNextLeaf(B_PLUS_TREE_LEAF_PAGE_TYPE *leaf) {
+  page_id_t next_page_id = leaf->GetNextPageId();
+  if (next_page_id == INVALID_PAGE_ID)
+    return;
+  Page *page = FetchPage(next_page_id);
+  page->WLatch();
+  reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData())
+      ->SetPrevPageId(leaf->GetPageId());
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(next_page_id, true);
+}
 /*
  * Update root page if necessary
  * NOTE: size of root page can be less than min size and this method is only
@@ -174,7 +815,400 @@ void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {}
  */
 INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) {
-  return false;
+  // root latch is held whenever the root may change
+  if (old_root_node->IsLeafPage()) {
+    if (old_root_node->GetSize() > 0)
+      return false;
+    root_page_id_ = INVALID_PAGE_ID;
+    UpdateRootPageId();
+    old_root_node->SetPageType(IndexPageType::INVALID_INDEX_PAGE);
+    ForgetLastLeaf(old_root_node->GetPageId());
+    return true;
+  }
+  if (old_root_node->GetSize() > 1)
+    return false;
+  auto old_root = reinterpret_cast<
+      BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(
+      old_root_node);
+  root_page_id_ = old_root->RemoveAndReturnOnlyChild();
+  UpdateRootPageId();
+  old_root->SetPageType(IndexPageType::INVALID_INDEX_PAGE);
+  auto root =
+      reinterpret_cast<BPlusTreePage *>(FetchPage(root_page_id_)->GetData());
+  root->SetParentPageId(INVALID_PAGE_ID);
+  buffer_pool_manager_->UnpinPage(root_page_id_, true);
+  return true;
+}
+
+/*****************************************************************************
+ * WRITE BUFFER
+ *****************************************************************************/
+/*
+ * Readers wait on buffer_latch_ while messages are applied, so they never see
+ * a message gone from the buffer but not in the tree yet. buffered_ drops
+ * once the messages are applied.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::FlushWriteBuffer(Transaction *transaction) {
+  if (buffered_ == 0)
+    return;
+  buffer_latch_.WLock();
+  ApplyMessages(write_buffer_.Take(nullptr, nullptr), transaction);
+  buffered_ = 0;
+  buffer_latch_.WUnlock();
+}
+
+/*
+ * Child i of the root covers the keys from KeyAt(i) up to KeyAt(i + 1), the
+ * messages of the child with the most of them go down in one batch. The
+ * separators are only read to pick the batch, the batch is applied by
+ * descents from the root whatever the root is by then (see ApplyMessages). A
+ * leaf root takes all messages.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::FlushBusiestChild(Transaction *transaction) {
+  KeyType low, high;
+  bool has_low = false, has_high = false;
+  root_latch_.RLock();
+  if (IsEmpty()) {
+    root_latch_.RUnlock();
+  } else {
+    Page *page = FetchPage(root_page_id_);
+    root_latch_.RUnlock();
+    page->RLatch();
+    auto node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    if (node->IsValidPage() && !node->IsLeafPage()) {
+      auto root = reinterpret_cast<
+          BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(node);
+      size_t most = 0;
+      for (int i = 0; i < root->GetSize(); i++) {
+        KeyType child_low, child_high;
+        if (i > 0)
+          child_low = root->KeyAt(i);
+        if (i + 1 < root->GetSize())
+          child_high = root->KeyAt(i + 1);
+        size_t count =
+            write_buffer_.Count(i > 0 ? &child_low : nullptr,
+                                i + 1 < root->GetSize() ? &child_high : nullptr);
+        if (count > most) {
+          most = count;
+          low = child_low;
+          high = child_high;
+          has_low = i > 0;
+          has_high = i + 1 < root->GetSize();
+        }
+      }
+    }
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  }
+  ApplyMessages(write_buffer_.Take(has_low ? &low : nullptr,
+                                   has_high ? &high : nullptr),
+                transaction);
+}
+
+/*
+ * One descent per leaf: the messages from the first one on are applied to its
+ * leaf (ApplyToLeaf) until one belongs to a leaf further right or would split
+ * or merge the leaf. That message goes down on its own like a write without
+ * buffer, then the next run starts.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ApplyMessages(const std::vector<BufferedMessage> &messages,
+                                   Transaction *transaction) {
+  size_t begin = 0;
+  while (begin < messages.size()) {
+    size_t end = ApplyToLeaf(messages, begin);
+    if (end > begin) {
+      begin = end;
+      continue;
+    }
+    auto &message = messages[begin++];
+    switch (message.second.operation) {
+    case BufferedOperation::UPSERT:
+      RemoveFromTree(message.first, transaction);
+      InsertIntoTree(message.first, message.second.value, transaction);
+      break;
+    case BufferedOperation::REMOVE:
+      RemoveFromTree(message.first, transaction);
+      break;
+    default:
+      InsertIntoTree(message.first, message.second.value, transaction);
+      break;
+    }
+  }
+}
+
+/*
+ * Apply messages from begin on to the leaf of messages[begin], holding its
+ * write latch only, like OptimisticInsert and OptimisticRemove do for a single
+ * key. An insert of a key the leaf holds is dropped, an upsert replaces its
+ * pair in place.
+ * @return: end of the messages applied, begin if the tree is empty or the
+ * first message does not fit the leaf
+ */
+INDEX_TEMPLATE_ARGUMENTS
+size_t BPLUSTREE_TYPE::ApplyToLeaf(const std::vector<BufferedMessage> &messages,
+                                   size_t begin) {
+  Page *page = FindLeafPageOptimistic(messages[begin].first, false, true);
+  if (page == nullptr)
+    return begin;
+  auto leaf = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+  bool deferred = options_.deferred_merge, dirty = false;
+  std::vector<KeyType> underfull_keys;
+  size_t end = begin;
+  for (; end < messages.size(); end++) {
+    const KeyType &key = messages[end].first;
+    BufferedOperation operation = messages[end].second.operation;
+    if (IsPastHighKey(leaf, key))
+      break;
+    ValueType value;
+    bool present = leaf->Lookup(key, value, comparator_);
+    if (operation == BufferedOperation::INSERT && present)
+      continue;
+    if (operation == BufferedOperation::REMOVE && !present)
+      continue;
+    if (operation == BufferedOperation::REMOVE) {
+      if (!(deferred ? leaf->GetSize() > 1 : leaf->IsRemoveSafe()))
+        break;
+      bool was_underfull = leaf->IsBelowFill(MERGE_FILL_FACTOR);
+      leaf->RemoveAndDeleteRecord(key, comparator_);
+      if (!was_underfull && leaf->IsBelowFill(MERGE_FILL_FACTOR))
+        underfull_keys.push_back(key);
+    } else if (present) {
+      // the pair of the same key takes the bytes the old one frees, put the
+      // old pair back and leave the message to the fallback if it does not
+      leaf->RemoveAndDeleteRecord(key, comparator_);
+      if (!leaf->Insert(key, messages[end].second.value, comparator_)) {
+        leaf->Insert(key, value, comparator_);
+        break;
+      }
+    } else if (leaf->Insert(key, messages[end].second.value, comparator_)) {
+      UpdateLastLeaf(leaf, key);
+    } else {
+      break;
+    }
+    dirty = true;
+  }
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), dirty);
+  for (auto &key : underfull_keys)
+    AddUnderfullLeaf(key);
+  return end;
+}
+
+/*****************************************************************************
+ * COMPACTION
+ *****************************************************************************/
+/*
+ * Collect the first keys of the leaves to merge, walking the leaves left to
+ * right with read latches like an iterator, then merge them.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+size_t BPLUSTREE_TYPE::Compact(Transaction *transaction) {
+  std::vector<KeyType> keys;
+  Page *page = FindLeafPageOptimistic(KeyType(), true, false);
+  while (page != nullptr) {
+    auto leaf =
+        reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+    if (!leaf->IsRootPage() && leaf->GetSize() > 0 &&
+        leaf->IsBelowFill(MERGE_FILL_FACTOR))
+      keys.push_back(leaf->KeyAt(0));
+    Page *next_page = nullptr;
+    if (leaf->GetNextPageId() != INVALID_PAGE_ID) {
+      next_page = FetchPage(leaf->GetNextPageId());
+      next_page->RLatch();
+    }
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    page = next_page;
+  }
+  return MergeUnderfullLeaves(keys, transaction);
+}
+
+/*
+ * Each leaf is looked up again with write latches from the root and merged
+ * or redistributed if it is still below the fill factor, keeping latched
+ * only the ancestors the merge reaches. A key moved or removed since still
+ * leads to the leaf it would be in.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+size_t BPLUSTREE_TYPE::MergeUnderfullLeaves(const std::vector<KeyType> &keys,
+                                            Transaction *transaction) {
+  std::unique_ptr<Transaction> local_transaction;
+  if (transaction == nullptr) {
+    local_transaction.reset(new Transaction(INVALID_TXN_ID));
+    transaction = local_transaction.get();
+  }
+  size_t freed = 0;
+  for (auto &key : keys) {
+    Page *page = FindLeafPagePessimistic(key, Operation::MERGE, transaction);
+    bool changed = false;
+    if (page != nullptr) {
+      auto leaf =
+          reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+      // a safe leaf was refilled, its parent is not latched
+      if (!IsSafe(leaf, Operation::MERGE)) {
+        changed = true;
+        if (CoalesceOrRedistribute(leaf, transaction))
+          transaction->AddIntoDeletedPageSet(leaf->GetPageId());
+      }
+    }
+    freed += transaction->GetDeletedPageSet()->size();
+    ReleasePageSet(transaction, changed);
+  }
+  return freed;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::AddUnderfullLeaf(const KeyType &key) {
+  std::lock_guard<std::mutex> lock(compaction_mutex_);
+  if (stop_compaction_)
+    return;
+  underfull_keys_.push_back(key);
+  if (underfull_keys_.size() < COMPACTION_UNDERFULL_LEAVES)
+    return;
+  if (!compaction_thread_.joinable())
+    compaction_thread_ = std::thread(&BPLUSTREE_TYPE::RunCompaction, this);
+  compaction_cv_.notify_one();
+}
+
+/*
+ * The thread takes the pending keys and merges their leaves without the
+ * mutex, keys added meanwhile wait for the next round.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::RunCompaction() {
+  std::unique_lock<std::mutex> lock(compaction_mutex_);
+  while (true) {
+    compaction_cv_.wait(lock, [this] {
+      return stop_compaction_ ||
+             underfull_keys_.size() >= COMPACTION_UNDERFULL_LEAVES;
+    });
+    if (stop_compaction_)
+      return;
+    std::vector<KeyType> keys;
+    keys.swap(underfull_keys_);
+    lock.unlock();
+    MergeUnderfullLeaves(keys, nullptr);
+    lock.lock();
+  }
+}
+
+/*****************************************************************************
+ * STATISTICS
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+IndexStatistics BPLUSTREE_TYPE::GetStatistics(
+    const std::function<bool(const KeyType &, const KeyType &)> &same_key) {
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  if (!stats_loaded_) {
+    HeaderPage *header_page =
+        static_cast<HeaderPage *>(FetchPage(HEADER_PAGE_ID));
+    stats_valid_ = header_page->GetStatistics(index_name_, stats_);
+    buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, false);
+    stats_loaded_ = true;
+  }
+  if (stats_valid_ &&
+      modifications_ <=
+          STATISTICS_MIN_CHANGES + stats_.entries * STATISTICS_STALE_SHARE)
+    return stats_;
+
+  modifications_ = 0;
+  stats_ = SampleStatistics(same_key);
+  stats_valid_ = true;
+  // the statistics still serve this tree if the page has no room for them
+  HeaderPage *header_page =
+      static_cast<HeaderPage *>(FetchPage(HEADER_PAGE_ID));
+  bool stored = header_page->SetStatistics(index_name_, stats_);
+  buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, stored);
+  return stats_;
+}
+
+/*
+ * Every leaf a descent reaches stands for as many leaves as the product of
+ * the fan-outs on its path, an unbiased estimate of the leaf count (Knuth).
+ * The entries of the leaf are scaled the same way. Every pair of adjacent
+ * entries with different keys adds a distinct key, the share of such pairs
+ * among the adjacent entries of the sampled leaves is taken for all pairs.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+IndexStatistics BPLUSTREE_TYPE::SampleStatistics(
+    const std::function<bool(const KeyType &, const KeyType &)> &same_key) {
+  IndexStatistics stats;
+  double leaves = 0, entries = 0, fill = 0;
+  int64_t sampled_pairs = 0, sampled_changes = 0;
+  int samples = 0;
+  for (int i = 0; i < STATISTICS_SAMPLE_LEAVES; i++) {
+    double weight;
+    int height;
+    Page *page = FindRandomLeafPage(weight, height);
+    if (page == nullptr)
+      continue;
+    auto leaf =
+        reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+    samples++;
+    stats.height = std::max(stats.height, height);
+    leaves += weight;
+    entries += weight * leaf->GetSize();
+    fill += (double)leaf->GetUsedBytes() / leaf->GetCapacity();
+    for (int j = 1; j < leaf->GetSize(); j++) {
+      sampled_pairs++;
+      if (!same_key || !same_key(leaf->KeyAt(j - 1), leaf->KeyAt(j)))
+        sampled_changes++;
+    }
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  }
+  if (samples == 0)
+    return stats;
+  stats.leaf_pages = (int32_t)(leaves / samples + 0.5);
+  stats.entries = (int64_t)(entries / samples + 0.5);
+  stats.average_fill = fill / samples;
+  stats.distinct_keys = stats.entries;
+  if (sampled_pairs > 0 && stats.entries > 0)
+    stats.distinct_keys =
+        1 + (int64_t)((stats.entries - 1.0) * sampled_changes / sampled_pairs +
+                      0.5);
+  return stats;
+}
+
+/*
+ * Like FindLeafPageOptimistic, the child is pinned under the latch of its
+ * parent and latched after the parent is released.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FindRandomLeafPage(double &weight, int &height) {
+  root_latch_.RLock();
+  if (IsEmpty()) {
+    root_latch_.RUnlock();
+    return nullptr;
+  }
+  Page *page = FetchPage(root_page_id_);
+  root_latch_.RUnlock();
+  page->RLatch();
+  auto node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  weight = 1;
+  height = 1;
+  while (node->IsValidPage() && !node->IsLeafPage()) {
+    auto internal = reinterpret_cast<
+        BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(node);
+    weight *= internal->GetSize();
+    Page *child_page =
+        FetchPage(internal->ValueAt(stats_engine_() % internal->GetSize()));
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    page = child_page;
+    page->RLatch();
+    node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    height++;
+  }
+  if (!node->IsValidPage()) {
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    return nullptr;
+  }
+  return page;
 }
 
 /*****************************************************************************
@@ -186,7 +1220,14 @@ bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) {
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin() { return INDEXITERATOR_TYPE(); }
+INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin() {
+  FlushWriteBuffer();
+  KeyType key;
+  Page *page = FindLeafPageOptimistic(key, true, false);
+  if (page == nullptr)
+    return INDEXITERATOR_TYPE();
+  return INDEXITERATOR_TYPE(buffer_pool_manager_, page, 0);
+}
 
 /*
  * Input parameter is low key, find the leaf page that contains the input key
@@ -195,7 +1236,92 @@ INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin() { return INDEXITERATOR_TYPE(); }
  */
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key) {
-  return INDEXITERATOR_TYPE();
+  FlushWriteBuffer();
+  Page *page = FindLeafPageOptimistic(key, false, false);
+  if (page == nullptr)
+    return INDEXITERATOR_TYPE();
+  auto leaf = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+  return INDEXITERATOR_TYPE(buffer_pool_manager_, page,
+                            leaf->KeyIndex(key, comparator_));
+}
+
+/*
+ * Input parameters are low key and inclusive end key, the iterator yields the
+ * pairs with key in [key, end_key] and prefetches the leaves the range spans
+ * @return : index iterator
+ */
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key,
+                                         const KeyType &end_key) {
+  FlushWriteBuffer();
+  Page *page = FindLeafPageOptimistic(key, false, false, &end_key);
+  if (page == nullptr)
+    return INDEXITERATOR_TYPE();
+  auto leaf = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+  return INDEXITERATOR_TYPE(buffer_pool_manager_, page,
+                            leaf->KeyIndex(key, comparator_), end_key,
+                            &comparator_);
+}
+
+/*
+ * Input parameter is void, find the rightmost leaf page first, then construct
+ * a reverse index iterator
+ * @return : reverse index iterator
+ */
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE BPLUSTREE_TYPE::RBegin() {
+  FlushWriteBuffer();
+  KeyType key;
+  Page *page = FindLeafPageOptimistic(key, false, false, nullptr, true);
+  if (page == nullptr)
+    return INDEXITERATOR_TYPE();
+  auto leaf = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+  return INDEXITERATOR_TYPE(this, page, leaf->GetSize() - 1, nullptr, nullptr);
+}
+
+/*
+ * Input parameter is high key, the reverse index iterator starts at the
+ * largest key not greater than it
+ * @return : reverse index iterator
+ */
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE BPLUSTREE_TYPE::RBegin(const KeyType &key) {
+  FlushWriteBuffer();
+  Page *page = FindLeafPageOptimistic(key, false, false);
+  if (page == nullptr)
+    return INDEXITERATOR_TYPE();
+  return INDEXITERATOR_TYPE(this, page, ReverseKeyIndex(page, key), &key,
+                            nullptr);
+}
+
+/*
+ * Input parameters are high key and inclusive low end key, the reverse index
+ * iterator yields the pairs with key in [end_key, key] from large to small
+ * @return : reverse index iterator
+ */
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE BPLUSTREE_TYPE::RBegin(const KeyType &key,
+                                          const KeyType &end_key) {
+  FlushWriteBuffer();
+  Page *page = FindLeafPageOptimistic(key, false, false, &end_key);
+  if (page == nullptr)
+    return INDEXITERATOR_TYPE();
+  return INDEXITERATOR_TYPE(this, page, ReverseKeyIndex(page, key), &key,
+                            &end_key);
+}
+
+/*
+ * Index of the largest key not greater than key in the leaf of page, -1 if
+ * there is none
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int BPLUSTREE_TYPE::ReverseKeyIndex(Page *page, const KeyType &key) {
+  auto leaf = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+  int index = leaf->KeyIndex(key, comparator_);
+  if (index < leaf->GetSize() &&
+      comparator_(leaf->KeyAt(index), key) == 0)
+    return index;
+  return index - 1;
 }
 
 /*****************************************************************************
@@ -204,11 +1330,264 @@ INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key) {
 /*
  * Find leaf page containing particular key, if leftMost flag == true, find
  * the left most leaf page
+ * The leaf is returned pinned and read latched, caller must release both.
  */
 INDEX_TEMPLATE_ARGUMENTS
 B_PLUS_TREE_LEAF_PAGE_TYPE *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key,
                                                          bool leftMost) {
-  return nullptr;
+  Page *page = FindLeafPageOptimistic(key, leftMost, false);
+  if (page == nullptr)
+    return nullptr;
+  return reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FetchPage(page_id_t page_id) {
+  Page *page = buffer_pool_manager_->FetchPage(page_id);
+  if (page == nullptr)
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  return page;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FetchChildPage(Page *parent, int index,
+                                     page_id_t page_id) {
+  Page *page =
+      options_.swizzling
+          ? buffer_pool_manager_->FetchChildPage(parent, index, page_id)
+          : buffer_pool_manager_->FetchPage(page_id);
+  if (page == nullptr)
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  return page;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::NewPage(page_id_t &page_id) {
+  Page *page = buffer_pool_manager_->NewPage(page_id);
+  if (page == nullptr)
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  return page;
+}
+
+/*
+ * B-link descent, holding one latch at a time. A page is pinned while its
+ * parent (or left neighbour) is latched, so it stays in the buffer pool, and
+ * only checked once it is latched itself:
+ * (1) an invalid page was merged away or dropped as root meanwhile, the
+ * descent starts over from the root
+ * (2) a key not below the high key moved right in a split, the descent
+ * follows the right link (rightMost always does)
+ * The type of a page only changes when it is merged away, which latches its
+ * parent, so it is read under the parent latch to decide whether the leaf
+ * gets a write latch. A child is fetched through the frame of its parent,
+ * with the swizzling option that skips the page table and the latch of the
+ * buffer pool manager while the child stays buffered (see
+ * BufferPoolManager::FetchChildPage).
+ * A range scan passes its end key as prefetch_end: the leaf's parent lists
+ * the leaves the range continues into, they are prefetched all at once
+ * instead of one by one as the iterator reaches them. An end key below key
+ * prefetches the leaves to the left for a reverse scan.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FindLeafPageOptimistic(const KeyType &key,
+                                             bool leftMost,
+                                             bool exclusive_leaf,
+                                             const KeyType *prefetch_end,
+                                             bool rightMost) {
+  auto latch = [](Page *page, bool exclusive) {
+    if (exclusive)
+      page->WLatch();
+    else
+      page->RLatch();
+  };
+  auto release = [this](Page *page, bool exclusive) {
+    if (exclusive)
+      page->WUnlatch();
+    else
+      page->RUnlatch();
+    buffer_pool_manager_->UnpinFrame(page, false);
+  };
+
+  Page *page = nullptr;
+  bool exclusive = false;
+  while (true) {
+    if (page == nullptr) {
+      // the root can not be dropped while root_latch_ is held
+      root_latch_.RLock();
+      if (IsEmpty()) {
+        root_latch_.RUnlock();
+        return nullptr;
+      }
+      page = FetchPage(root_page_id_);
+      exclusive = exclusive_leaf &&
+                  reinterpret_cast<BPlusTreePage *>(page->GetData())
+                      ->IsLeafPage();
+      root_latch_.RUnlock();
+      latch(page, exclusive);
+    }
+    auto node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    if (!node->IsValidPage()) {
+      release(page, exclusive);
+      page = nullptr;
+      std::this_thread::yield();
+      continue;
+    }
+    page_id_t next_page_id = GetNextPageId(node);
+    if (next_page_id != INVALID_PAGE_ID &&
+        (rightMost || (!leftMost && IsPastHighKey(node, key)))) {
+      // the right neighbour is on the same level, so of the same type
+      Page *next_page = FetchPage(next_page_id);
+      release(page, exclusive);
+      page = next_page;
+      latch(page, exclusive);
+      continue;
+    }
+    if (node->IsLeafPage())
+      return page;
+
+    auto internal = reinterpret_cast<
+        BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(node);
+    int child_index = leftMost    ? 0
+                      : rightMost ? internal->GetSize() - 1
+                                  : internal->LookupIndex(key, comparator_);
+    page_id_t child_page_id = internal->ValueAt(child_index);
+    Page *child_page = FetchChildPage(page, child_index, child_page_id);
+    auto child = reinterpret_cast<BPlusTreePage *>(child_page->GetData());
+    bool child_exclusive = exclusive_leaf && child->IsLeafPage();
+    if (prefetch_end != nullptr && child->IsLeafPage()) {
+      int index = child_index;
+      if (comparator_(*prefetch_end, key) >= 0) {
+        for (int i = index + 1; i < internal->GetSize() &&
+                                comparator_(internal->KeyAt(i),
+                                            *prefetch_end) <= 0;
+             i++)
+          buffer_pool_manager_->PrefetchPage(internal->ValueAt(i));
+      } else {
+        // child i holds the keys from KeyAt(i) up to KeyAt(i + 1)
+        for (int i = index - 1;
+             i >= 0 && comparator_(internal->KeyAt(i + 1), *prefetch_end) > 0;
+             i--)
+          buffer_pool_manager_->PrefetchPage(internal->ValueAt(i));
+      }
+    }
+    release(page, exclusive);
+    page = child_page;
+    exclusive = child_exclusive;
+    latch(page, exclusive);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::IsPastHighKey(BPlusTreePage *node, const KeyType &key) {
+  if (node->IsLeafPage()) {
+    auto leaf = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(node);
+    return leaf->HasHighKey() && comparator_(key, leaf->GetHighKey()) >= 0;
+  }
+  auto internal = reinterpret_cast<
+      BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(node);
+  return internal->HasHighKey() &&
+         comparator_(key, internal->GetHighKey()) >= 0;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t BPLUSTREE_TYPE::GetNextPageId(BPlusTreePage *node) const {
+  if (node->IsLeafPage())
+    return reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(node)
+        ->GetNextPageId();
+  return reinterpret_cast<
+             BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(node)
+      ->GetNextPageId();
+}
+
+/*
+ * Descend with write latch crabbing. Ancestors are released as soon as a page
+ * is safe for op, a nullptr entry in the page set stands for root_latch_.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FindLeafPagePessimistic(const KeyType &key,
+                                              Operation op,
+                                              Transaction *transaction) {
+  root_latch_.WLock();
+  transaction->AddIntoPageSet(nullptr);
+  if (IsEmpty())
+    return nullptr;
+
+  Page *page = FetchPage(root_page_id_);
+  page->WLatch();
+  auto node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  if (IsSafe(node, op))
+    ReleasePageSet(transaction, false);
+  transaction->AddIntoPageSet(page);
+
+  while (!node->IsLeafPage()) {
+    auto internal = reinterpret_cast<
+        BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(node);
+    int index = internal->LookupIndex(key, comparator_);
+    page = FetchChildPage(page, index, internal->ValueAt(index));
+    page->WLatch();
+    node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    if (IsSafe(node, op))
+      ReleasePageSet(transaction, false);
+    transaction->AddIntoPageSet(page);
+  }
+  return page;
+}
+
+/*
+ * A page is safe for insert if one more entry of any key does not split it,
+ * and safe for delete if one entry less does not make it underflow (for the
+ * root: does not leave it with a single child or no entry). With merges
+ * deferred a leaf only has to keep one entry, and a leaf is safe for merge if
+ * it is at least MERGE_FILL_FACTOR full.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::IsSafe(BPlusTreePage *node, Operation op) const {
+  if (op != Operation::READ && op != Operation::INSERT && node->IsRootPage())
+    return node->GetSize() > (node->IsLeafPage() ? 1 : 2);
+  if (node->IsLeafPage()) {
+    auto leaf = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(node);
+    switch (op) {
+    case Operation::INSERT:
+      return leaf->IsInsertSafe();
+    case Operation::DELETE:
+      return leaf->IsRemoveSafe();
+    case Operation::LAZY_DELETE:
+      return leaf->GetSize() > 1;
+    case Operation::MERGE:
+      return !leaf->IsBelowFill(MERGE_FILL_FACTOR);
+    default:
+      return true;
+    }
+  }
+  auto internal = reinterpret_cast<
+      BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(node);
+  switch (op) {
+  case Operation::INSERT:
+    return internal->IsInsertSafe();
+  case Operation::READ:
+    return true;
+  default:
+    return internal->IsRemoveSafe();
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ReleasePageSet(Transaction *transaction, bool is_dirty) {
+  auto page_set = transaction->GetPageSet();
+  while (!page_set->empty()) {
+    Page *page = page_set->front();
+    page_set->pop_front();
+    if (page == nullptr) {
+      root_latch_.WUnlock();
+    } else {
+      page->WUnlatch();
+      buffer_pool_manager_->UnpinFrame(page, is_dirty);
+    }
+  }
+  auto deleted_page_set = transaction->GetDeletedPageSet();
+  for (page_id_t page_id : *deleted_page_set)
+    buffer_pool_manager_->DeletePage(page_id);
+  deleted_page_set->clear();
 }
 
 /*
@@ -223,10 +1602,12 @@ INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
   HeaderPage *header_page = static_cast<HeaderPage *>(
       buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
-  if (insert_record)
-    // create a new record<index_name + root_page_id> in header_page
-    header_page->InsertRecord(index_name_, root_page_id_);
-  else
+  if (insert_record) {
+    // create a new record<index_name + root_page_id> in header_page, the
+    // record is kept when the tree becomes empty
+    if (!header_page->InsertRecord(index_name_, root_page_id_))
+      header_page->UpdateRecord(index_name_, root_page_id_);
+  } else
     // update root_page_id in header_page
     header_page->UpdateRecord(index_name_, root_page_id_);
   buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
@@ -237,7 +1618,70 @@ void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
  * print out whole b+tree sturcture, rank by rank
  */
 INDEX_TEMPLATE_ARGUMENTS
-std::string BPLUSTREE_TYPE::ToString(bool verbose) { return "Empty tree"; }
+BPlusTreeShape BPLUSTREE_TYPE::GetShape() {
+  FlushWriteBuffer();
+  BPlusTreeShape shape;
+  if (IsEmpty())
+    return shape;
+  std::queue<page_id_t> level;
+  level.push(root_page_id_);
+  while (!level.empty()) {
+    shape.height++;
+    std::queue<page_id_t> next_level;
+    while (!level.empty()) {
+      auto node =
+          reinterpret_cast<BPlusTreePage *>(FetchPage(level.front())->GetData());
+      level.pop();
+      if (node->IsLeafPage()) {
+        shape.leaf_pages++;
+        shape.entries += node->GetSize();
+        if (!node->IsRootPage() &&
+            reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(node)->IsUnderflow())
+          shape.underfull_leaves++;
+      } else {
+        auto internal = reinterpret_cast<
+            BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(node);
+        shape.internal_pages++;
+        shape.children += internal->GetSize();
+        for (int i = 0; i < internal->GetSize(); i++)
+          next_level.push(internal->ValueAt(i));
+      }
+      buffer_pool_manager_->UnpinPage(node->GetPageId(), false);
+    }
+    level = next_level;
+  }
+  return shape;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+std::string BPLUSTREE_TYPE::ToString(bool verbose) {
+  if (IsEmpty())
+    return "Empty tree";
+  std::ostringstream os;
+  std::queue<BPlusTreePage *> level;
+  level.push(
+      reinterpret_cast<BPlusTreePage *>(FetchPage(root_page_id_)->GetData()));
+  while (!level.empty()) {
+    std::queue<BPlusTreePage *> next_level;
+    while (!level.empty()) {
+      BPlusTreePage *node = level.front();
+      level.pop();
+      if (node->IsLeafPage()) {
+        os << reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(node)->ToString(
+            verbose);
+      } else {
+        auto internal = reinterpret_cast<
+            BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(node);
+        os << internal->ToString(verbose);
+        internal->QueueUpChildren(&next_level, buffer_pool_manager_);
+      }
+      os << (level.empty() ? "\n" : " | ");
+      buffer_pool_manager_->UnpinPage(node->GetPageId(), false);
+    }
+    level = next_level;
+  }
+  return os.str();
+}
 
 /*
  * This method is used for test only
@@ -279,5 +1723,8 @@ template class BPlusTree<GenericKey<8>, RID, GenericComparator<8>>;
 template class BPlusTree<GenericKey<16>, RID, GenericComparator<16>>;
 template class BPlusTree<GenericKey<32>, RID, GenericComparator<32>>;
 template class BPlusTree<GenericKey<64>, RID, GenericComparator<64>>;
+template class BPlusTree<GenericKey<128>, RID, GenericComparator<128>>;
+template class BPlusTree<IntegerKey<int32_t>, RID, IntegerComparator<int32_t>>;
+template class BPlusTree<IntegerKey<int64_t>, RID, IntegerComparator<int64_t>>;
 
 } // namespace scudb
@@ -2,9 +2,61 @@
  * b_plus_tree_index.cpp
  */
 
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+
+#include "hash/hash_function.h"
 #include "index/b_plus_tree_index.h"
 
 namespace scudb {
+
+/*
+ * Keys of a non-unique index carry the rid (see GenericKey), so the tree only
+ * holds distinct keys and the entries of one key are adjacent. Included
+ * columns follow the rid, so the index keys of one key stay adjacent too.
+ * Integer keys have no room for either, ConstructIndex only uses them for
+ * unique indexes without included columns.
+ */
+template <size_t KeySize>
+static inline bool SetIndexKey(GenericKey<KeySize> &index_key,
+                               const Tuple &entry, Schema *entry_schema,
+                               int key_columns, const RID *rid) {
+  if (rid == nullptr)
+    return index_key.SetFromKey(entry, entry_schema);
+  return index_key.SetFromEntry(entry, entry_schema, key_columns, *rid);
+}
+
+template <typename KeyType>
+static inline bool SetIndexKey(KeyType &index_key, const Tuple &entry,
+                               Schema *entry_schema, int key_columns,
+                               const RID *rid) {
+  assert(rid == nullptr);
+  index_key.SetFromKey(entry, entry_schema);
+  return true;
+}
+
+/*
+ * Bloom filter hash of the key columns of an index key. Generic keys are
+ * hashed up to the end of their key columns, the rid and included columns
+ * after them differ between entries of one key. A key truncated within its
+ * key columns is hashed whole, which are the same bytes for all its entries.
+ */
+template <size_t KeySize>
+static inline uint64_t HashKeyColumns(const GenericKey<KeySize> &index_key,
+                                      Schema *key_schema) {
+  return HashBytes(index_key.data,
+                   KeyDecoder::ColumnsLength(index_key.data, KeySize,
+                                             key_schema,
+                                             key_schema->GetColumnCount()));
+}
+
+template <typename KeyType>
+static inline uint64_t HashKeyColumns(const KeyType &index_key,
+                                      Schema *key_schema) {
+  return HashBytes(reinterpret_cast<const char *>(&index_key),
+                   sizeof(KeyType));
+}
 /*
  * Constructor
  */
@@ -14,41 +66,422 @@ BPLUSTREE_INDEX_TYPE::BPlusTreeIndex(IndexMetadata *metadata,
                                      page_id_t root_page_id)
     : Index(metadata), comparator_(metadata->GetKeySchema()),
       container_(metadata->GetName(), buffer_pool_manager, comparator_,
-                 root_page_id) {}
+                 root_page_id, metadata->GetTreeOptions()),
+      bloom_keys_(0), bloom_deletes_(0), bloom_recording_(false),
+      lookups_(0), misses_(0), filtered_(0), lookup_nanos_(0) {}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_INDEX_TYPE::HasRidInKey() const {
+  return !GetMetadata()->IsUnique() ||
+         !GetMetadata()->GetIncludeAttrs().empty();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+KeyType BPLUSTREE_INDEX_TYPE::MakeIndexKey(const Tuple &key,
+                                           const RID &rid) const {
+  KeyType index_key;
+  SetIndexKey(index_key, key, GetKeySchema(), GetIndexColumnCount(),
+              HasRidInKey() ? &rid : nullptr);
+  return index_key;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_INDEX_TYPE::MakeEntryKey(const Tuple &entry, const RID &rid,
+                                        KeyType &index_key) const {
+  return SetIndexKey(index_key, entry, GetEntrySchema(),
+                     GetIndexColumnCount(), HasRidInKey() ? &rid : nullptr);
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_INDEX_TYPE::InsertEntry(const Tuple &key, RID rid,
+Tuple BPLUSTREE_INDEX_TYPE::GetKey(const Tuple &entry) const {
+  if (GetEntrySchema() == GetKeySchema())
+    return entry;
+  std::vector<Value> values;
+  for (int i = 0; i < GetIndexColumnCount(); i++)
+    values.push_back(entry.GetValue(GetEntrySchema(), i));
+  return Tuple(values, GetKeySchema());
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+Tuple BPLUSTREE_INDEX_TYPE::GetEntry(const KeyType &index_key) const {
+  return index_key.GetEntry(GetEntrySchema(), GetIndexColumnCount(),
+                            HasRidInKey());
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_INDEX_TYPE::InsertEntry(const Tuple &key, RID rid,
                                        Transaction *transaction) {
+  if (GetMetadata()->IsUnique() &&
+      (HasRidInKey() || GetMetadata()->GetTreeOptions().write_buffer)) {
+    // the rid lets a second entry of the key in, and the write buffer takes
+    // a key without reading the tree (see BPlusTree::Insert). Keep the first
+    // one like the tree does with keys without rid
+    Tuple key_tuple = GetKey(key);
+    std::vector<RID> existing;
+    if (MayContain(key_tuple))
+      CollectKey(key_tuple, existing, nullptr, transaction);
+    if (!existing.empty())
+      return false;
+  }
   // construct insert index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  if (!MakeEntryKey(key, rid, index_key))
+    return false;
 
-  container_.Insert(index_key, rid, transaction);
+  if (!container_.Insert(index_key, rid, transaction))
+    return false;
+  AddToBloomFilter(index_key);
+  return true;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_INDEX_TYPE::DeleteEntry(const Tuple &key,
+void BPLUSTREE_INDEX_TYPE::DeleteEntry(const Tuple &key, RID rid,
                                        Transaction *transaction) {
-  // construct delete index key
+  // construct delete index key, an entry that does not fit was never stored
   KeyType index_key;
-  index_key.SetFromKey(key);
+  if (!MakeEntryKey(key, rid, index_key))
+    return;
 
   container_.Remove(index_key, transaction);
+  if (GetMetadata()->HasBloomFilter())
+    bloom_deletes_++;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::ScanKey(const Tuple &key, std::vector<RID> &result,
                                    Transaction *transaction) {
-  // construct scan index key
-  KeyType index_key;
-  index_key.SetFromKey(key);
+  LookupKey(key, result, nullptr, transaction);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::ScanKeyEntries(const Tuple &key,
+                                          std::vector<RID> &result,
+                                          std::vector<Tuple> &entries,
+                                          Transaction *transaction) {
+  LookupKey(key, result, &entries, transaction);
+}
+
+/*
+ * The counters measure the Bloom filter, an index without one skips them and
+ * their clock reads and shared atomics
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::LookupKey(const Tuple &key,
+                                     std::vector<RID> &result,
+                                     std::vector<Tuple> *entries,
+                                     Transaction *transaction) {
+  if (!GetMetadata()->HasBloomFilter()) {
+    CollectKey(key, result, entries, transaction);
+    return;
+  }
+  auto start = std::chrono::steady_clock::now();
+  size_t size = result.size();
+  bool filtered = !MayContain(key);
+  if (!filtered)
+    CollectKey(key, result, entries, transaction);
+  lookups_++;
+  if (result.size() == size) {
+    misses_++;
+    if (filtered)
+      filtered_++;
+  }
+  lookup_nanos_ += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+IndexLookupStats BPLUSTREE_INDEX_TYPE::GetLookupStats() const {
+  IndexLookupStats stats;
+  stats.lookups = lookups_.load();
+  stats.misses = misses_.load();
+  stats.filtered = filtered_.load();
+  stats.lookup_nanos = lookup_nanos_.load();
+  return stats;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_INDEX_TYPE::GetStatistics(IndexStatistics &stats) {
+  if (GetMetadata()->IsUnique()) {
+    stats = container_.GetStatistics();
+  } else {
+    // entries of a key differ in their rid only
+    stats = container_.GetStatistics(
+        [this](const KeyType &left, const KeyType &right) {
+          return KeyHash(left) == KeyHash(right);
+        });
+  }
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+uint64_t BPLUSTREE_INDEX_TYPE::KeyHash(const KeyType &index_key) const {
+  return HashKeyColumns(index_key, GetKeySchema());
+}
+
+/*
+ * A stale filter is rebuilt first. Keys are added to the filter after they
+ * went into the tree, so a rebuild in between finds them in the tree.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_INDEX_TYPE::MayContain(const Tuple &key) {
+  if (!GetMetadata()->HasBloomFilter())
+    return true;
+  bloom_latch_.RLock();
+  if (IsBloomFilterStale()) {
+    bloom_latch_.RUnlock();
+    RebuildBloomFilter();
+    bloom_latch_.RLock();
+  }
+  bool result = bloom_filter_ == nullptr ||
+                bloom_filter_->MayContain(KeyHash(MakeIndexKey(key, RID())));
+  bloom_latch_.RUnlock();
+  return result;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::AddToBloomFilter(const KeyType &index_key) {
+  if (!GetMetadata()->HasBloomFilter())
+    return;
+  uint64_t hash = KeyHash(index_key);
+  bloom_latch_.RLock();
+  if (bloom_filter_ != nullptr) {
+    bloom_filter_->Add(hash);
+    bloom_keys_++;
+  }
+  if (bloom_recording_) {
+    std::lock_guard<std::mutex> guard(added_latch_);
+    bloom_added_.push_back(hash);
+  }
+  bloom_latch_.RUnlock();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_INDEX_TYPE::IsBloomFilterStale() const {
+  return bloom_filter_ == nullptr ||
+         bloom_keys_.load() > bloom_filter_->GetCapacity() ||
+         4 * bloom_deletes_.load() > bloom_keys_.load();
+}
+
+/*
+ * Size the new filter for twice the keys in the tree, so it takes as many
+ * inserts again before it is rebuilt. The tree is scanned without the latch
+ * and one thread rebuilds at a time, lookups keep using the old filter
+ * meanwhile: it has no false negatives, only more false positives. A key
+ * added while the scan runs is recorded in bloom_added_, and the scan sees
+ * every key added before.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::RebuildBloomFilter() {
+  std::unique_lock<std::mutex> rebuild_guard(rebuild_latch_, std::try_to_lock);
+  if (!rebuild_guard.owns_lock())
+    return;
+  bloom_latch_.RLock();
+  bool stale = IsBloomFilterStale();
+  bloom_latch_.RUnlock();
+  if (!stale)
+    return;
+
+  bloom_latch_.WLock();
+  bloom_added_.clear();
+  bloom_recording_ = true;
+  size_t deletes = bloom_deletes_.load();
+  bloom_latch_.WUnlock();
+
+  std::vector<uint64_t> hashes;
+  for (auto iterator = container_.Begin(); !iterator.isEnd(); ++iterator)
+    hashes.push_back(KeyHash((*iterator).first));
+  std::unique_ptr<BloomFilter> filter(new BloomFilter(
+      std::max<size_t>(2 * hashes.size(), BLOOM_FILTER_MIN_KEYS)));
+  for (auto hash : hashes)
+    filter->Add(hash);
+
+  bloom_latch_.WLock();
+  for (auto hash : bloom_added_)
+    filter->Add(hash);
+  bloom_filter_ = std::move(filter);
+  bloom_keys_ = hashes.size() + bloom_added_.size();
+  bloom_deletes_ -= deletes;
+  bloom_added_.clear();
+  bloom_recording_ = false;
+  bloom_latch_.WUnlock();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::CollectKey(const Tuple &key,
+                                      std::vector<RID> &result,
+                                      std::vector<Tuple> *entries,
+                                      Transaction *transaction) {
+  if (!HasRidInKey()) {
+    // construct scan index key, the entry is the key itself
+    KeyType index_key = MakeIndexKey(key, RID());
+    if (container_.GetValue(index_key, result, transaction) &&
+        entries != nullptr)
+      entries->push_back(key);
+    return;
+  }
+  // every rid of the key, between the smallest and the largest rid encoding
+  KeyType low_key = MakeIndexKey(key, RID(0, 0));
+  KeyType high_key = MakeIndexKey(key, RID(-1, -1));
+  for (auto iterator = container_.Begin(low_key, high_key); !iterator.isEnd();
+       ++iterator) {
+    result.push_back((*iterator).second);
+    if (entries != nullptr)
+      entries->push_back(GetEntry((*iterator).first));
+  }
+}
+
+/*
+ * The rids come in key order rather than in the order of keys. A key of an
+ * index with rids in its keys is the range of all its rids, like in ScanKey.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::ScanKeys(const std::vector<Tuple> &keys,
+                                    std::vector<RID> &result,
+                                    Transaction *transaction) {
+  if (!HasRidInKey()) {
+    std::vector<KeyType> index_keys;
+    index_keys.reserve(keys.size());
+    for (auto &key : keys) {
+      if (MayContain(key))
+        index_keys.push_back(MakeIndexKey(key, RID()));
+    }
+    container_.GetValues(index_keys, result, transaction);
+    return;
+  }
+  std::vector<std::pair<KeyType, KeyType>> ranges;
+  ranges.reserve(keys.size());
+  for (auto &key : keys) {
+    if (MayContain(key))
+      ranges.emplace_back(MakeIndexKey(key, RID(0, 0)),
+                          MakeIndexKey(key, RID(-1, -1)));
+  }
+  container_.GetRanges(ranges, result, transaction);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::ScanRange(const Tuple *low, const Tuple *high,
+                                     bool descending, std::vector<RID> &result,
+                                     Transaction *transaction) {
+  CollectRange(low, high, descending, result, nullptr, transaction);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::ScanRangeEntries(const Tuple *low,
+                                            const Tuple *high, bool descending,
+                                            std::vector<RID> &result,
+                                            std::vector<Tuple> &entries,
+                                            Transaction *transaction) {
+  CollectRange(low, high, descending, result, &entries, transaction);
+}
+
+/*
+ * Walk the leaves from the low bound up, or with a reverse iterator from the
+ * high bound down. The bounds of an index with rids in its keys take in every
+ * rid.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::CollectRange(const Tuple *low, const Tuple *high,
+                                        bool descending,
+                                        std::vector<RID> &result,
+                                        std::vector<Tuple> *entries,
+                                        Transaction *transaction) {
+  KeyType low_key, high_key;
+  if (low != nullptr)
+    low_key = MakeIndexKey(*low, RID(0, 0));
+  if (high != nullptr)
+    high_key = MakeIndexKey(*high, RID(-1, -1));
+
+  if (!descending) {
+    auto iterator = low == nullptr    ? container_.Begin()
+                    : high == nullptr ? container_.Begin(low_key)
+                                      : container_.Begin(low_key, high_key);
+    for (; !iterator.isEnd(); ++iterator) {
+      if (low == nullptr && high != nullptr &&
+          comparator_((*iterator).first, high_key) > 0)
+        break;
+      result.push_back((*iterator).second);
+      if (entries != nullptr)
+        entries->push_back(GetEntry((*iterator).first));
+    }
+    return;
+  }
+  auto iterator = high == nullptr  ? container_.RBegin()
+                  : low == nullptr ? container_.RBegin(high_key)
+                                   : container_.RBegin(high_key, low_key);
+  for (; !iterator.isEnd(); ++iterator) {
+    if (high == nullptr && low != nullptr &&
+        comparator_((*iterator).first, low_key) < 0)
+      break;
+    result.push_back((*iterator).second);
+    if (entries != nullptr)
+      entries->push_back(GetEntry((*iterator).first));
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_INDEX_TYPE::InsertEntries(
+    const std::vector<std::pair<Tuple, RID>> &entries,
+    Transaction *transaction) {
+  // construct index keys in key order, the first of equal keys wins like
+  // with one by one inserts (keys of a non-unique index are all distinct).
+  // Unique keys with rid and included columns are told apart by their key
+  // columns alone, which also order them.
+  bool key_only = GetMetadata()->IsUnique() && HasRidInKey();
+  std::vector<std::pair<KeyType, MappingType>> keyed;
+  keyed.reserve(entries.size());
+  bool inserted = true;
+  for (auto &entry : entries) {
+    KeyType index_key;
+    if (!MakeEntryKey(entry.first, entry.second, index_key)) {
+      inserted = false;
+      continue;
+    }
+    keyed.emplace_back(
+        key_only ? MakeIndexKey(GetKey(entry.first), RID(0, 0)) : index_key,
+        std::make_pair(index_key, entry.second));
+  }
+  typedef std::pair<KeyType, MappingType> Keyed;
+  std::stable_sort(keyed.begin(), keyed.end(),
+                   [this](const Keyed &a, const Keyed &b) {
+                     return comparator_(a.first, b.first) < 0;
+                   });
+  auto last = std::unique(keyed.begin(), keyed.end(),
+                          [this](const Keyed &a, const Keyed &b) {
+                            return comparator_(a.first, b.first) == 0;
+                          });
+  // a unique index refuses the later entries of a key
+  if (last != keyed.end())
+    inserted = false;
+  keyed.erase(last, keyed.end());
+  std::vector<MappingType> items;
+  items.reserve(keyed.size());
+  for (auto &item : keyed)
+    items.push_back(item.second);
 
-  container_.GetValue(index_key, result, transaction);
+  if (!container_.BulkLoad(items, BULK_LOAD_FILL_FACTOR)) {
+    // the tree already holds keys, which entries may share the key columns
+    // of
+    if (key_only)
+      return Index::InsertEntries(entries, transaction);
+    for (auto &item : items)
+      inserted = container_.Insert(item.first, item.second, transaction) &&
+                 inserted;
+  }
+  for (auto &item : items)
+    AddToBloomFilter(item.first);
+  return inserted;
 }
 template class BPlusTreeIndex<GenericKey<4>, RID, GenericComparator<4>>;
 template class BPlusTreeIndex<GenericKey<8>, RID, GenericComparator<8>>;
 template class BPlusTreeIndex<GenericKey<16>, RID, GenericComparator<16>>;
 template class BPlusTreeIndex<GenericKey<32>, RID, GenericComparator<32>>;
 template class BPlusTreeIndex<GenericKey<64>, RID, GenericComparator<64>>;
+template class BPlusTreeIndex<GenericKey<128>, RID,
+                              GenericComparator<128>>;
+template class BPlusTreeIndex<IntegerKey<int32_t>, RID,
+                              IntegerComparator<int32_t>>;
+template class BPlusTreeIndex<IntegerKey<int64_t>, RID,
+                              IntegerComparator<int64_t>>;
 
 } // namespace scudb
@@ -0,0 +1,64 @@
+/**
+ * extendible_hash_table_index.cpp
+ */
+
+#include "index/extendible_hash_table_index.h"
+
+namespace scudb {
+/*
+ * Constructor
+ */
+HASH_TABLE_TEMPLATE_ARGUMENTS
+HASH_TABLE_INDEX_TYPE::ExtendibleHashTableIndex(
+    IndexMetadata *metadata, BufferPoolManager *buffer_pool_manager,
+    page_id_t header_page_id)
+    : Index(metadata), comparator_(metadata->GetKeySchema()),
+      container_(metadata->GetName(), buffer_pool_manager, comparator_,
+                 header_page_id) {}
+
+HASH_TABLE_TEMPLATE_ARGUMENTS
+bool HASH_TABLE_INDEX_TYPE::InsertEntry(const Tuple &key, RID rid,
+                                        Transaction *transaction) {
+  // construct insert index key, a truncated key is refused
+  KeyType index_key;
+  if (!index_key.SetFromKey(key, GetKeySchema()))
+    return false;
+
+  return container_.Insert(index_key, rid, transaction);
+}
+
+HASH_TABLE_TEMPLATE_ARGUMENTS
+void HASH_TABLE_INDEX_TYPE::DeleteEntry(const Tuple &key, RID rid,
+                                        Transaction *transaction) {
+  // construct delete index key, a truncated key was never stored
+  KeyType index_key;
+  if (!index_key.SetFromKey(key, GetKeySchema()))
+    return;
+
+  container_.Remove(index_key, transaction);
+}
+
+HASH_TABLE_TEMPLATE_ARGUMENTS
+void HASH_TABLE_INDEX_TYPE::ScanKey(const Tuple &key, std::vector<RID> &result,
+                                    Transaction *transaction) {
+  // construct scan index key, a truncated key was never stored
+  KeyType index_key;
+  if (!index_key.SetFromKey(key, GetKeySchema()))
+    return;
+
+  container_.GetValue(index_key, result, transaction);
+}
+template class ExtendibleHashTableIndex<GenericKey<4>, RID,
+                                        GenericComparator<4>>;
+template class ExtendibleHashTableIndex<GenericKey<8>, RID,
+                                        GenericComparator<8>>;
+template class ExtendibleHashTableIndex<GenericKey<16>, RID,
+                                        GenericComparator<16>>;
+template class ExtendibleHashTableIndex<GenericKey<32>, RID,
+                                        GenericComparator<32>>;
+template class ExtendibleHashTableIndex<GenericKey<64>, RID,
+                                        GenericComparator<64>>;
+template class ExtendibleHashTableIndex<GenericKey<128>, RID,
+                                        GenericComparator<128>>;
+
+} // namespace scudb
@@ -2,7 +2,10 @@
  * index_iterator.cpp
  */
 #include <cassert>
+#include <thread>
 
+#include "common/exception.h"
+#include "index/b_plus_tree.h"
 #include "index/index_iterator.h"
 
 namespace scudb {
@@ -12,15 +15,218 @@ namespace scudb {
  * set your own input parameters
  */
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::IndexIterator() {}
+INDEXITERATOR_TYPE::IndexIterator()
+    : buffer_pool_manager_(nullptr), page_(nullptr), leaf_(nullptr),
+      index_(0), reverse_(false), tree_(nullptr), has_bound_(false),
+      end_index_(0), last_leaf_(true), comparator_(nullptr) {}
 
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::~IndexIterator() {}
+INDEXITERATOR_TYPE::IndexIterator(BufferPoolManager *buffer_pool_manager,
+                                  Page *page, int index)
+    : buffer_pool_manager_(buffer_pool_manager), page_(page),
+      leaf_(reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData())),
+      index_(index), reverse_(false), tree_(nullptr), has_bound_(false),
+      comparator_(nullptr) {
+  EnterLeaf();
+  SkipExhaustedLeaves();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::IndexIterator(BufferPoolManager *buffer_pool_manager,
+                                  Page *page, int index,
+                                  const KeyType &end_key,
+                                  const KeyComparator *comparator)
+    : buffer_pool_manager_(buffer_pool_manager), page_(page),
+      leaf_(reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData())),
+      index_(index), reverse_(false), tree_(nullptr), has_bound_(false),
+      end_key_(end_key), comparator_(comparator) {
+  EnterLeaf();
+  SkipExhaustedLeaves();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::IndexIterator(
+    BPlusTree<KeyType, ValueType, KeyComparator> *tree, Page *page, int index,
+    const KeyType *start_key, const KeyType *end_key)
+    : buffer_pool_manager_(tree->buffer_pool_manager_), page_(page),
+      leaf_(reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData())),
+      index_(index), reverse_(true), tree_(tree),
+      has_bound_(start_key != nullptr),
+      comparator_(end_key != nullptr ? &tree->comparator_ : nullptr) {
+  if (start_key != nullptr)
+    bound_key_ = *start_key;
+  if (end_key != nullptr)
+    end_key_ = *end_key;
+  EnterLeaf();
+  SkipExhaustedLeaves();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::IndexIterator(IndexIterator &&other)
+    : buffer_pool_manager_(other.buffer_pool_manager_), page_(other.page_),
+      leaf_(other.leaf_), index_(other.index_), reverse_(other.reverse_),
+      tree_(other.tree_), has_bound_(other.has_bound_),
+      bound_key_(other.bound_key_), end_index_(other.end_index_),
+      last_leaf_(other.last_leaf_), end_key_(other.end_key_),
+      comparator_(other.comparator_) {
+  other.page_ = nullptr;
+  other.leaf_ = nullptr;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::~IndexIterator() { Release(); }
+
+INDEX_TEMPLATE_ARGUMENTS
+bool INDEXITERATOR_TYPE::isEnd() { return leaf_ == nullptr; }
+
+INDEX_TEMPLATE_ARGUMENTS
+const MappingType &INDEXITERATOR_TYPE::operator*() {
+  assert(!isEnd());
+  item_ = leaf_->GetItem(index_);
+  return item_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE &INDEXITERATOR_TYPE::operator++() {
+  assert(!isEnd());
+  index_ += reverse_ ? -1 : 1;
+  SkipExhaustedLeaves();
+  return *this;
+}
+
+/*
+ * Move to the first entry of the next non-empty leaf once the current leaf is
+ * exhausted, the iterator reaches its end after the last leaf or when the
+ * range ends
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::SkipExhaustedLeaves() {
+  if (reverse_) {
+    while (leaf_ != nullptr && index_ < end_index_) {
+      if (last_leaf_ || leaf_->GetPrevPageId() == INVALID_PAGE_ID) {
+        Release();
+        return;
+      }
+      MoveToPrevLeaf();
+    }
+    return;
+  }
+  while (leaf_ != nullptr && index_ >= end_index_) {
+    page_id_t next_page_id = leaf_->GetNextPageId();
+    if (last_leaf_ || next_page_id == INVALID_PAGE_ID) {
+      Release();
+      return;
+    }
+    Page *next_page = buffer_pool_manager_->FetchPage(next_page_id);
+    if (next_page == nullptr)
+      throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+    next_page->RLatch();
+    Release();
+    page_ = next_page;
+    leaf_ = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page_->GetData());
+    index_ = 0;
+    EnterLeaf();
+  }
+}
+
+/*
+ * Find how many entries of the current leaf are within the range, unless the
+ * range ends here the next leaf is about to be read, so start fetching it
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::EnterLeaf() {
+  if (reverse_) {
+    end_index_ = 0;
+    last_leaf_ = false;
+    if (comparator_ != nullptr) {
+      int index = leaf_->KeyIndex(end_key_, *comparator_);
+      // keys are unique, nothing before the end key can be in range
+      last_leaf_ = index > 0 || (index < leaf_->GetSize() &&
+                                 (*comparator_)(leaf_->KeyAt(index),
+                                                end_key_) == 0);
+      end_index_ = index;
+    }
+    if (!last_leaf_)
+      buffer_pool_manager_->PrefetchPage(leaf_->GetPrevPageId());
+    return;
+  }
+  end_index_ = leaf_->GetSize();
+  last_leaf_ = false;
+  if (comparator_ != nullptr) {
+    int index = leaf_->KeyIndex(end_key_, *comparator_);
+    if (index < end_index_) {
+      // keys are unique, nothing past the end key can be in range
+      if ((*comparator_)(leaf_->KeyAt(index), end_key_) == 0)
+        index++;
+      end_index_ = index;
+      last_leaf_ = true;
+    }
+  }
+  if (!last_leaf_)
+    buffer_pool_manager_->PrefetchPage(leaf_->GetNextPageId());
+}
+
+/*
+ * Move a reverse iterator to the last entry of the previous leaf. The current
+ * leaf pins the previous one through its prev link, but only a try latch is
+ * safe against the left to right latch order, see index_iterator.h
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::MoveToPrevLeaf() {
+  if (leaf_->GetSize() > 0 &&
+      (!has_bound_ ||
+       tree_->comparator_(leaf_->KeyAt(0), bound_key_) < 0)) {
+    bound_key_ = leaf_->KeyAt(0);
+    has_bound_ = true;
+  }
+  page_id_t prev_page_id = leaf_->GetPrevPageId();
+  Page *prev_page = buffer_pool_manager_->FetchPage(prev_page_id);
+  if (prev_page == nullptr)
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  if (prev_page->TryRLatch()) {
+    Release();
+    page_ = prev_page;
+    leaf_ = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page_->GetData());
+    index_ = leaf_->GetSize() - 1;
+    EnterLeaf();
+    return;
+  }
+  buffer_pool_manager_->UnpinPage(prev_page_id, false);
+  Release();
+
+  // a writer is changing the previous leaf, wait for it from the root
+  std::this_thread::yield();
+  Page *page = tree_->FindLeafPageOptimistic(bound_key_, false, false, nullptr,
+                                             !has_bound_);
+  if (page == nullptr)
+    return;
+  page_ = page;
+  leaf_ = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page_->GetData());
+  // the leaf of bound_key_ holds it or the keys after it
+  index_ = has_bound_ ? leaf_->KeyIndex(bound_key_, tree_->comparator_) - 1
+                      : leaf_->GetSize() - 1;
+  EnterLeaf();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::Release() {
+  if (page_ == nullptr)
+    return;
+  page_->RUnlatch();
+  buffer_pool_manager_->UnpinPage(page_->GetPageId(), false);
+  page_ = nullptr;
+  leaf_ = nullptr;
+}
 
 template class IndexIterator<GenericKey<4>, RID, GenericComparator<4>>;
 template class IndexIterator<GenericKey<8>, RID, GenericComparator<8>>;
 template class IndexIterator<GenericKey<16>, RID, GenericComparator<16>>;
 template class IndexIterator<GenericKey<32>, RID, GenericComparator<32>>;
 template class IndexIterator<GenericKey<64>, RID, GenericComparator<64>>;
+template class IndexIterator<GenericKey<128>, RID, GenericComparator<128>>;
+template class IndexIterator<IntegerKey<int32_t>, RID,
+                             IntegerComparator<int32_t>>;
+template class IndexIterator<IntegerKey<int64_t>, RID,
+                             IntegerComparator<int64_t>>;
 
 } // namespace scudb
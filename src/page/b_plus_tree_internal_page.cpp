@@ -1,6 +1,8 @@
 /**
  * b_plus_tree_internal_page.cpp
  */
+#include <algorithm>
+#include <cassert>
 #include <iostream>
 #include <sstream>
 
@@ -13,25 +15,67 @@ namespace scudb {
  *****************************************************************************/
 /*
  * Init method after creating a new internal page
- * Including set page type, set current size, set page id, set parent id and set
- * max page size
+ * Including set page type, set current size, set page id, set parent id, set
+ * next page id and set the capacity of the pairs
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(page_id_t page_id,
-                                          page_id_t parent_id) {}
+                                          page_id_t parent_id) {
+  SetPageType(IndexPageType::INTERNAL_PAGE);
+  SetSize(0);
+  SetPageId(page_id);
+  SetParentPageId(parent_id);
+  SetNextPageId(INVALID_PAGE_ID);
+  SetLSN();
+  entries_.Init(PAGE_SIZE - sizeof(BPlusTreeInternalPage), true);
+}
+
+/**
+ * Helper methods to set/get the page id of the right neighbour
+ */
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetNextPageId() const {
+  return next_page_id_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) {
+  next_page_id_ = next_page_id;
+}
+
+/*
+ * Helper methods to get the high key, every key below this page is below it
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::HasHighKey() const {
+  return entries_.HasHighKey();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+KeyType B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetHighKey() const {
+  return entries_.HighKey();
+}
 /*
  * Helper method to get/set the key associated with input "index"(a.k.a
  * array offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
 KeyType B_PLUS_TREE_INTERNAL_PAGE_TYPE::KeyAt(int index) const {
-  // replace with your own code
-  KeyType key;
-  return key;
+  assert(index >= 0 && index < GetSize());
+  return entries_.KeyAt(index);
 }
 
+/*
+ * @return  false if the key does not fit, the page is unchanged then
+ */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) {}
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) {
+  assert(index > 0 && index < GetSize());
+  std::vector<MappingType> items;
+  entries_.CopyTo(GetSize(), items);
+  items[index].first = key;
+  return entries_.Assign(items, 0, items.size());
+}
 
 /*
  * Helper method to find and return array index(or offset), so that its value
@@ -39,7 +83,11 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) {}
  */
 INDEX_TEMPLATE_ARGUMENTS
 int B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueIndex(const ValueType &value) const {
-  return 0;
+  for (int i = 0; i < GetSize(); i++) {
+    if (entries_.ValueAt(i) == value)
+      return i;
+  }
+  return -1;
 }
 
 /*
@@ -47,21 +95,76 @@ int B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueIndex(const ValueType &value) const {
  * offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
-ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const { return 0; }
+ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const {
+  assert(index >= 0 && index < GetSize());
+  return entries_.ValueAt(index);
+}
+
+/*****************************************************************************
+ * SPACE ACCOUNTING
+ *****************************************************************************/
+/*
+ * Bytes available for the pairs of an internal page
+ */
+INDEX_TEMPLATE_ARGUMENTS
+size_t B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetCapacity() const {
+  return entries_.GetCapacity();
+}
+
+/*
+ * True if a pair with any key can be inserted without splitting the page
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::IsInsertSafe() const {
+  return entries_.HasRoomForAny(GetSize());
+}
+
+/*
+ * True if removing any pair does not make the page underflow
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::IsRemoveSafe() const {
+  return entries_.GetUsedBytes(GetSize()) >=
+         entries_.GetCapacity() / 2 + entries_.GetMaxPairBytes();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::IsUnderflow() const {
+  return entries_.GetUsedBytes(GetSize()) < entries_.GetCapacity() / 2;
+}
 
 /*****************************************************************************
  * LOOKUP
  *****************************************************************************/
+/*
+ * Find and return the index of the child pointer(page_id) which points to the
+ * child page that contains input "key"
+ * Start the search from the second key(the first key should always be invalid)
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_INTERNAL_PAGE_TYPE::LookupIndex(
+    const KeyType &key, const KeyComparator &comparator) const {
+  // find the last index i >= 1 so that array[i].first <= key, or 0
+  int low = 1, high = GetSize();
+  while (low < high) {
+    int mid = low + (high - low) / 2;
+    if (comparator(entries_.KeyAt(mid), key) <= 0)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  return low - 1;
+}
+
 /*
  * Find and return the child pointer(page_id) which points to the child page
  * that contains input "key"
- * Start the search from the second key(the first key should always be invalid)
  */
 INDEX_TEMPLATE_ARGUMENTS
 ValueType
 B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key,
                                        const KeyComparator &comparator) const {
-  return INVALID_PAGE_ID;
+  return entries_.ValueAt(LookupIndex(key, comparator));
 }
 
 /*****************************************************************************
@@ -76,33 +179,85 @@ B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key,
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::PopulateNewRoot(
     const ValueType &old_value, const KeyType &new_key,
-    const ValueType &new_value) {}
+    const ValueType &new_value) {
+  std::vector<MappingType> items(2);
+  items[0].second = old_value;
+  items[1] = std::make_pair(new_key, new_value);
+  Populate(items, 0, items.size());
+}
+
+/*
+ * Replace the pairs of this page with items[begin, end), whose keys are
+ * sorted after the first one, and its high key with high_key (none if
+ * nullptr). The parent of the children is not changed
+ * @return  false if they do not fit, the page is unchanged then
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::Populate(
+    const std::vector<MappingType> &items, size_t begin, size_t end,
+    const KeyType *high_key) {
+  if (!entries_.Assign(items, begin, end, high_key))
+    return false;
+  SetSize(end - begin);
+  return true;
+}
+
 /*
  * Insert new_key & new_value pair right after the pair with its value ==
  * old_value
- * @return:  new size after insertion
+ * @return:  false if the pair does not fit, the page is unchanged then
  */
 INDEX_TEMPLATE_ARGUMENTS
-int B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertNodeAfter(
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertNodeAfter(
     const ValueType &old_value, const KeyType &new_key,
     const ValueType &new_value) {
-  return 0;
+  int index = ValueIndex(old_value) + 1;
+  assert(index > 0);
+  if (!entries_.Insert(GetSize(), index, new_key, new_value))
+    return false;
+  IncreaseSize(1);
+  return true;
 }
 
 /*****************************************************************************
  * SPLIT
  *****************************************************************************/
 /*
- * Remove half of key & value pairs from this page to "recipient" page
+ * Insert the new_key & new_value pair that did not fit right after old_value,
+ * then move the upper pairs to "recipient" page so that both pages take about
+ * the same number of bytes, or this page APPEND_SPLIT_SHARE of them if the
+ * pair went to the end of the last page of its level. recipient takes over the high key and becomes
+ * the right neighbour of this page
+ * @return:  the first key of recipient, which the caller pushes up into
+ * parent and which becomes the high key of this page
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveHalfTo(
-    BPlusTreeInternalPage *recipient,
-    BufferPoolManager *buffer_pool_manager) {}
-
-INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyHalfFrom(
-    MappingType *items, int size, BufferPoolManager *buffer_pool_manager) {}
+KeyType B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveHalfTo(
+    BPlusTreeInternalPage *recipient, const ValueType &old_value,
+    const KeyType &new_key, const ValueType &new_value,
+    BufferPoolManager *buffer_pool_manager) {
+  std::vector<MappingType> items;
+  entries_.CopyTo(GetSize(), items);
+  int index = ValueIndex(old_value) + 1;
+  items.insert(items.begin() + index, std::make_pair(new_key, new_value));
+  KeyType high_key;
+  if (HasHighKey())
+    high_key = GetHighKey();
+  // a split of the last child of the last page, see the leaf page
+  bool append = !HasHighKey() && index == GetSize();
+  int split = Entries::SplitPoint(
+      items, entries_.GetCapacity(), true, 2, items.size() - 2,
+      HasHighKey() ? Entries::SignificantBytes(high_key) : 0,
+      append ? APPEND_SPLIT_SHARE : 0.5);
+  assert(split > 0);
+  recipient->Populate(items, split, items.size(),
+                      HasHighKey() ? &high_key : nullptr);
+  Populate(items, 0, split, &items[split].first);
+  recipient->AdoptChildren(items, split, items.size(), buffer_pool_manager);
+  recipient->SetNextPageId(GetNextPageId());
+  SetNextPageId(recipient->GetPageId());
+  return items[split].first;
+}
 
 /*****************************************************************************
  * REMOVE
@@ -113,7 +268,11 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyHalfFrom(
  * NOTE: store key&value pair continuously after deletion
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Remove(int index) {}
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Remove(int index) {
+  assert(index >= 0 && index < GetSize());
+  entries_.Remove(GetSize(), index);
+  IncreaseSize(-1);
+}
 
 /*
  * Remove the only key & value pair in internal page and return the value
@@ -121,53 +280,121 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Remove(int index) {}
  */
 INDEX_TEMPLATE_ARGUMENTS
 ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::RemoveAndReturnOnlyChild() {
-  return INVALID_PAGE_ID;
+  assert(GetSize() == 1);
+  SetSize(0);
+  return entries_.ValueAt(0);
 }
 /*****************************************************************************
  * MERGE
  *****************************************************************************/
 /*
- * Remove all of key & value pairs from this page to "recipient" page, then
- * update relavent key & value pair in its parent page.
+ * Remove all of key & value pairs from this page to "recipient" page, the
+ * separator in parent comes down as the key of the first child of this page.
+ * recipient takes over the high key and the right neighbour of this page
+ * @return  false if the pairs of both pages do not fit into one, nothing is
+ * moved then
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveAllTo(
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveAllTo(
     BPlusTreeInternalPage *recipient, int index_in_parent,
-    BufferPoolManager *buffer_pool_manager) {}
+    BufferPoolManager *buffer_pool_manager) {
+  std::vector<MappingType> items;
+  recipient->entries_.CopyTo(recipient->GetSize(), items);
+  size_t begin = items.size();
+  entries_.CopyTo(GetSize(), items);
+  BPlusTreeInternalPage *parent = FetchParent(buffer_pool_manager);
+  items[begin].first = parent->KeyAt(index_in_parent);
+  buffer_pool_manager->UnpinPage(GetParentPageId(), false);
 
-INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyAllFrom(
-    MappingType *items, int size, BufferPoolManager *buffer_pool_manager) {}
+  KeyType high_key;
+  if (HasHighKey())
+    high_key = GetHighKey();
+  if (!recipient->Populate(items, 0, items.size(),
+                           HasHighKey() ? &high_key : nullptr))
+    return false;
+  recipient->AdoptChildren(items, begin, items.size(), buffer_pool_manager);
+  recipient->SetNextPageId(GetNextPageId());
+  SetSize(0);
+  return true;
+}
 
 /*****************************************************************************
  * REDISTRIBUTE
  *****************************************************************************/
 /*
- * Remove the first key & value pair from this page to tail of "recipient"
- * page, then update relavent key & value pair in its parent page.
+ * Move pairs from this page to its right sibling "right" so that both take
+ * about the same number of bytes, rotating through parent: the separator
+ * comes down as the key of the first child of right, the first key of the
+ * new right page goes up as the new separator and high key of this page.
+ * Like in leaves pairs never move left.
+ * @return  false if no pair moves or the new separator does not fit into
+ * the parent, nothing is changed then
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveFirstToEndOf(
-    BPlusTreeInternalPage *recipient,
-    BufferPoolManager *buffer_pool_manager) {}
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::RedistributeWith(
+    BPlusTreeInternalPage *right, int index_in_parent,
+    BufferPoolManager *buffer_pool_manager, const KeyComparator &) {
+  std::vector<MappingType> items;
+  entries_.CopyTo(GetSize(), items);
+  size_t middle = items.size();
+  right->entries_.CopyTo(right->GetSize(), items);
+  BPlusTreeInternalPage *parent = FetchParent(buffer_pool_manager);
+  items[middle].first = parent->KeyAt(index_in_parent);
+
+  KeyType high_key;
+  if (right->HasHighKey())
+    high_key = right->GetHighKey();
+  int split = Entries::SplitPoint(
+      items, entries_.GetCapacity(), true, 2, (int)items.size() - 2,
+      right->HasHighKey() ? Entries::SignificantBytes(high_key) : 0);
+  bool updated = split > 0 && split < GetSize() &&
+                 parent->SetKeyAt(index_in_parent, items[split].first);
+  buffer_pool_manager->UnpinPage(GetParentPageId(), updated);
+  if (!updated)
+    return false;
+  Populate(items, 0, split, &items[split].first);
+  right->Populate(items, split, items.size(),
+                  right->HasHighKey() ? &high_key : nullptr);
+  right->AdoptChildren(items, split, middle, buffer_pool_manager);
+  return true;
+}
 
+/*****************************************************************************
+ * HELPER METHODS
+ *****************************************************************************/
+/*
+ * Fetch the parent of this page, caller must unpin it
+ */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyLastFrom(
-    const MappingType &pair, BufferPoolManager *buffer_pool_manager) {}
+B_PLUS_TREE_INTERNAL_PAGE_TYPE *B_PLUS_TREE_INTERNAL_PAGE_TYPE::FetchParent(
+    BufferPoolManager *buffer_pool_manager) {
+  auto *page = buffer_pool_manager->FetchPage(GetParentPageId());
+  if (page == nullptr)
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  return reinterpret_cast<BPlusTreeInternalPage *>(page->GetData());
+}
 
 /*
- * Remove the last key & value pair from this page to head of "recipient"
- * page, then update relavent key & value pair in its parent page.
+ * Point the parent page id of child at this page
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveLastToFrontOf(
-    BPlusTreeInternalPage *recipient, int parent_index,
-    BufferPoolManager *buffer_pool_manager) {}
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::AdoptChild(
+    page_id_t child_page_id, BufferPoolManager *buffer_pool_manager) {
+  auto *page = buffer_pool_manager->FetchPage(child_page_id);
+  if (page == nullptr)
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  auto child = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  child->SetParentPageId(GetPageId());
+  buffer_pool_manager->UnpinPage(child_page_id, true);
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyFirstFrom(
-    const MappingType &pair, int parent_index,
-    BufferPoolManager *buffer_pool_manager) {}
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::AdoptChildren(
+    const std::vector<MappingType> &items, size_t begin, size_t end,
+    BufferPoolManager *buffer_pool_manager) {
+  for (size_t i = begin; i < end; i++)
+    AdoptChild(items[i].second, buffer_pool_manager);
+}
 
 /*****************************************************************************
  * DEBUG
@@ -177,7 +404,7 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::QueueUpChildren(
     std::queue<BPlusTreePage *> *queue,
     BufferPoolManager *buffer_pool_manager) {
   for (int i = 0; i < GetSize(); i++) {
-    auto *page = buffer_pool_manager->FetchPage(array[i].second);
+    auto *page = buffer_pool_manager->FetchPage(entries_.ValueAt(i));
     if (page == nullptr)
       throw Exception(EXCEPTION_TYPE_INDEX,
                       "all page are pinned while printing");
@@ -207,9 +434,9 @@ std::string B_PLUS_TREE_INTERNAL_PAGE_TYPE::ToString(bool verbose) const {
     } else {
       os << " ";
     }
-    os << std::dec << array[entry].first.ToString();
+    os << std::dec << entries_.KeyAt(entry).ToString();
     if (verbose) {
-      os << "(" << array[entry].second << ")";
+      os << "(" << entries_.ValueAt(entry) << ")";
     }
     ++entry;
   }
@@ -227,4 +454,10 @@ template class BPlusTreeInternalPage<GenericKey<32>, page_id_t,
                                            GenericComparator<32>>;
 template class BPlusTreeInternalPage<GenericKey<64>, page_id_t,
                                            GenericComparator<64>>;
+template class BPlusTreeInternalPage<GenericKey<128>, page_id_t,
+                                           GenericComparator<128>>;
+template class BPlusTreeInternalPage<IntegerKey<int32_t>, page_id_t,
+                                     IntegerComparator<int32_t>>;
+template class BPlusTreeInternalPage<IntegerKey<int64_t>, page_id_t,
+                                     IntegerComparator<int64_t>>;
 } // namespace scudb
@@ -2,10 +2,13 @@
  * b_plus_tree_leaf_page.cpp
  */
 
+#include <algorithm>
+#include <cassert>
 #include <sstream>
 
 #include "common/exception.h"
 #include "common/rid.h"
+#include "page/b_plus_tree_internal_page.h"
 #include "page/b_plus_tree_leaf_page.h"
 
 namespace scudb {
@@ -17,21 +20,45 @@ namespace scudb {
 /**
  * Init method after creating a new leaf page
  * Including set page type, set current size to zero, set page id/parent id, set
- * next page id and set max size
+ * next/prev page id and set the capacity of the pairs
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id) {
+  SetPageType(IndexPageType::LEAF_PAGE);
+  SetSize(0);
+  SetPageId(page_id);
+  SetParentPageId(parent_id);
+  SetNextPageId(INVALID_PAGE_ID);
+  SetPrevPageId(INVALID_PAGE_ID);
+  SetLSN();
+  entries_.Init(PAGE_SIZE - sizeof(BPlusTreeLeafPage), false);
+}
 
 /**
  * Helper methods to set/get next page id
  */
 INDEX_TEMPLATE_ARGUMENTS
 page_id_t B_PLUS_TREE_LEAF_PAGE_TYPE::GetNextPageId() const {
-  return INVALID_PAGE_ID;
+  return next_page_id_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) {
+  next_page_id_ = next_page_id;
+}
+
+/**
+ * Helper methods to set/get prev page id
+ */
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t B_PLUS_TREE_LEAF_PAGE_TYPE::GetPrevPageId() const {
+  return prev_page_id_;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SetPrevPageId(page_id_t prev_page_id) {
+  prev_page_id_ = prev_page_id;
+}
 
 /**
  * Helper method to find the first index i so that array[i].first >= key
@@ -40,7 +67,15 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) {}
 INDEX_TEMPLATE_ARGUMENTS
 int B_PLUS_TREE_LEAF_PAGE_TYPE::KeyIndex(
     const KeyType &key, const KeyComparator &comparator) const {
-  return 0;
+  int low = 0, high = GetSize();
+  while (low < high) {
+    int mid = low + (high - low) / 2;
+    if (comparator(entries_.KeyAt(mid), key) < 0)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  return low;
 }
 
 /*
@@ -49,9 +84,8 @@ int B_PLUS_TREE_LEAF_PAGE_TYPE::KeyIndex(
  */
 INDEX_TEMPLATE_ARGUMENTS
 KeyType B_PLUS_TREE_LEAF_PAGE_TYPE::KeyAt(int index) const {
-  // replace with your own code
-  KeyType key;
-  return key;
+  assert(index >= 0 && index < GetSize());
+  return entries_.KeyAt(index);
 }
 
 /*
@@ -59,9 +93,66 @@ KeyType B_PLUS_TREE_LEAF_PAGE_TYPE::KeyAt(int index) const {
  * "index"(a.k.a array offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
-const MappingType &B_PLUS_TREE_LEAF_PAGE_TYPE::GetItem(int index) {
-  // replace with your own code
-  return array[0];
+MappingType B_PLUS_TREE_LEAF_PAGE_TYPE::GetItem(int index) const {
+  assert(index >= 0 && index < GetSize());
+  return std::make_pair(entries_.KeyAt(index), entries_.ValueAt(index));
+}
+
+/*
+ * Helper methods to get the high key, every key of this page is below it
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::HasHighKey() const {
+  return entries_.HasHighKey();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+KeyType B_PLUS_TREE_LEAF_PAGE_TYPE::GetHighKey() const {
+  return entries_.HighKey();
+}
+
+/*****************************************************************************
+ * SPACE ACCOUNTING
+ *****************************************************************************/
+/*
+ * Bytes available for the pairs of a leaf page
+ */
+INDEX_TEMPLATE_ARGUMENTS
+size_t B_PLUS_TREE_LEAF_PAGE_TYPE::GetCapacity() const {
+  return entries_.GetCapacity();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+size_t B_PLUS_TREE_LEAF_PAGE_TYPE::GetUsedBytes() const {
+  return entries_.GetUsedBytes(GetSize());
+}
+
+/*
+ * True if a pair with any key can be inserted without splitting the page
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::IsInsertSafe() const {
+  return entries_.HasRoomForAny(GetSize());
+}
+
+/*
+ * True if removing any pair does not make the page underflow
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::IsRemoveSafe() const {
+  return entries_.GetUsedBytes(GetSize()) >=
+         entries_.GetCapacity() / 2 + entries_.GetMaxPairBytes();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::IsUnderflow() const {
+  return entries_.GetUsedBytes(GetSize()) < entries_.GetCapacity() / 2;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::IsBelowFill(double fill_factor) const {
+  return entries_.GetUsedBytes(GetSize()) <
+         entries_.GetCapacity() * fill_factor;
 }
 
 /*****************************************************************************
@@ -69,28 +160,75 @@ const MappingType &B_PLUS_TREE_LEAF_PAGE_TYPE::GetItem(int index) {
  *****************************************************************************/
 /*
  * Insert key & value pair into leaf page ordered by key
- * @return  page size after insertion
+ * @return  false if the pair does not fit, the page is unchanged then
  */
 INDEX_TEMPLATE_ARGUMENTS
-int B_PLUS_TREE_LEAF_PAGE_TYPE::Insert(const KeyType &key,
-                                       const ValueType &value,
-                                       const KeyComparator &comparator) {
-  return 0;
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::Insert(const KeyType &key,
+                                        const ValueType &value,
+                                        const KeyComparator &comparator) {
+  if (!entries_.Insert(GetSize(), KeyIndex(key, comparator), key, value))
+    return false;
+  IncreaseSize(1);
+  return true;
+}
+
+/*
+ * Replace the pairs of this page with items[begin, end), which are sorted,
+ * and its high key with high_key (none if nullptr). Pairs may have moved to
+ * another page, so the version of the page (its LSN) changes.
+ * @return  false if they do not fit, the page is unchanged then
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::Populate(const std::vector<MappingType> &items,
+                                          size_t begin, size_t end,
+                                          const KeyType *high_key) {
+  if (!entries_.Assign(items, begin, end, high_key))
+    return false;
+  SetSize(end - begin);
+  SetLSN(GetLSN() + 1);
+  return true;
 }
 
 /*****************************************************************************
  * SPLIT
  *****************************************************************************/
 /*
- * Remove half of key & value pairs from this page to "recipient" page
+ * Insert the key & value pair that did not fit, then move the upper pairs to
+ * "recipient" page so that both pages take about the same number of bytes, or
+ * this page APPEND_SPLIT_SHARE of them if the pair went to the end of the
+ * last leaf. recipient takes over the high key, this page gets the shortest key between
+ * the two pages, which is also their separator in the parent.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveHalfTo(
-    BPlusTreeLeafPage *recipient,
-    __attribute__((unused)) BufferPoolManager *buffer_pool_manager) {}
-
-INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyHalfFrom(MappingType *items, int size) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveHalfTo(BPlusTreeLeafPage *recipient,
+                                            const KeyType &key,
+                                            const ValueType &value,
+                                            const KeyComparator &comparator) {
+  std::vector<MappingType> items;
+  entries_.CopyTo(GetSize(), items);
+  int index = KeyIndex(key, comparator);
+  items.insert(items.begin() + index, std::make_pair(key, value));
+  KeyType high_key;
+  if (HasHighKey())
+    high_key = GetHighKey();
+  // ascending inserts never come back to a full left page
+  bool append = !HasHighKey() && index == GetSize();
+  int split = Entries::SplitPoint(
+      items, entries_.GetCapacity(), false, 1, items.size() - 1,
+      HasHighKey() ? Entries::SignificantBytes(high_key) : 0,
+      append ? APPEND_SPLIT_SHARE : 0.5);
+  assert(split > 0);
+  KeyType separator =
+      ShortestSeparator(items[split - 1].first, items[split].first, comparator);
+  recipient->Populate(items, split, items.size(),
+                      HasHighKey() ? &high_key : nullptr);
+  Populate(items, 0, split, &separator);
+  // recipient becomes the right neighbour of this page, the caller points
+  // the prev link of the old right neighbour at recipient
+  recipient->SetNextPageId(GetNextPageId());
+  recipient->SetPrevPageId(GetPageId());
+  SetNextPageId(recipient->GetPageId());
+}
 
 /*****************************************************************************
  * LOOKUP
@@ -103,7 +241,11 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyHalfFrom(MappingType *items, int size) {}
 INDEX_TEMPLATE_ARGUMENTS
 bool B_PLUS_TREE_LEAF_PAGE_TYPE::Lookup(const KeyType &key, ValueType &value,
                                         const KeyComparator &comparator) const {
-  return false;
+  int index = KeyIndex(key, comparator);
+  if (index == GetSize() || comparator(entries_.KeyAt(index), key) != 0)
+    return false;
+  value = entries_.ValueAt(index);
+  return true;
 }
 
 /*****************************************************************************
@@ -118,7 +260,12 @@ bool B_PLUS_TREE_LEAF_PAGE_TYPE::Lookup(const KeyType &key, ValueType &value,
 INDEX_TEMPLATE_ARGUMENTS
 int B_PLUS_TREE_LEAF_PAGE_TYPE::RemoveAndDeleteRecord(
     const KeyType &key, const KeyComparator &comparator) {
-  return 0;
+  int index = KeyIndex(key, comparator);
+  if (index == GetSize() || comparator(entries_.KeyAt(index), key) != 0)
+    return GetSize();
+  entries_.Remove(GetSize(), index);
+  IncreaseSize(-1);
+  return GetSize();
 }
 
 /*****************************************************************************
@@ -126,41 +273,72 @@ int B_PLUS_TREE_LEAF_PAGE_TYPE::RemoveAndDeleteRecord(
  *****************************************************************************/
 /*
  * Remove all of key & value pairs from this page to "recipient" page, then
- * update next page id
+ * update next page id and high key of recipient
+ * @return  false if the pairs of both pages do not fit into one, nothing is
+ * moved then
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveAllTo(BPlusTreeLeafPage *recipient,
-                                           int, BufferPoolManager *) {}
-INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyAllFrom(MappingType *items, int size) {}
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::MoveAllTo(BPlusTreeLeafPage *recipient,
+                                           int, BufferPoolManager *) {
+  std::vector<MappingType> items;
+  recipient->entries_.CopyTo(recipient->GetSize(), items);
+  entries_.CopyTo(GetSize(), items);
+  KeyType high_key;
+  if (HasHighKey())
+    high_key = GetHighKey();
+  if (!recipient->Populate(items, 0, items.size(),
+                           HasHighKey() ? &high_key : nullptr))
+    return false;
+  recipient->SetNextPageId(GetNextPageId());
+  SetSize(0);
+  return true;
+}
 
 /*****************************************************************************
  * REDISTRIBUTE
  *****************************************************************************/
 /*
- * Remove the first key & value pair from this page to "recipient" page, then
- * update relavent key & value pair in its parent page.
+ * Move pairs from this page to its right sibling "right" so that both take
+ * about the same number of bytes, then update the separator of right in its
+ * parent page and the high key of this page to the shortest key between the
+ * two pages. Pairs never move left: that would raise the lowest key of right
+ * under readers that only recover by moving right (see b_plus_tree.h).
+ * @return  false if no pair moves or the new separator does not fit into
+ * the parent, nothing is changed then
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveFirstToEndOf(
-    BPlusTreeLeafPage *recipient,
-    BufferPoolManager *buffer_pool_manager) {}
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::RedistributeWith(
+    BPlusTreeLeafPage *right, int index_in_parent,
+    BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator) {
+  std::vector<MappingType> items;
+  entries_.CopyTo(GetSize(), items);
+  right->entries_.CopyTo(right->GetSize(), items);
+  KeyType high_key;
+  if (right->HasHighKey())
+    high_key = right->GetHighKey();
+  int split = Entries::SplitPoint(
+      items, entries_.GetCapacity(), false, 1, items.size() - 1,
+      right->HasHighKey() ? Entries::SignificantBytes(high_key) : 0);
+  if (split < 0 || split >= GetSize())
+    return false;
 
-INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyLastFrom(const MappingType &item) {}
-/*
- * Remove the last key & value pair from this page to "recipient" page, then
- * update relavent key & value pair in its parent page.
- */
-INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveLastToFrontOf(
-    BPlusTreeLeafPage *recipient, int parentIndex,
-    BufferPoolManager *buffer_pool_manager) {}
-
-INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyFirstFrom(
-    const MappingType &item, int parentIndex,
-    BufferPoolManager *buffer_pool_manager) {}
+  auto *page = buffer_pool_manager->FetchPage(GetParentPageId());
+  if (page == nullptr)
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  auto parent = reinterpret_cast<
+      BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(
+      page->GetData());
+  KeyType separator =
+      ShortestSeparator(items[split - 1].first, items[split].first, comparator);
+  bool updated = parent->SetKeyAt(index_in_parent, separator);
+  buffer_pool_manager->UnpinPage(GetParentPageId(), updated);
+  if (!updated)
+    return false;
+  Populate(items, 0, split, &separator);
+  right->Populate(items, split, items.size(),
+                  right->HasHighKey() ? &high_key : nullptr);
+  return true;
+}
 
 /*****************************************************************************
  * DEBUG
@@ -185,9 +363,9 @@ std::string B_PLUS_TREE_LEAF_PAGE_TYPE::ToString(bool verbose) const {
     } else {
       stream << " ";
     }
-    stream << std::dec << array[entry].first;
+    stream << std::dec << entries_.KeyAt(entry);
     if (verbose) {
-      stream << "(" << array[entry].second << ")";
+      stream << "(" << entries_.ValueAt(entry) << ")";
     }
     ++entry;
   }
@@ -204,4 +382,10 @@ template class BPlusTreeLeafPage<GenericKey<32>, RID,
                                        GenericComparator<32>>;
 template class BPlusTreeLeafPage<GenericKey<64>, RID,
                                        GenericComparator<64>>;
+template class BPlusTreeLeafPage<GenericKey<128>, RID,
+                                       GenericComparator<128>>;
+template class BPlusTreeLeafPage<IntegerKey<int32_t>, RID,
+                                 IntegerComparator<int32_t>>;
+template class BPlusTreeLeafPage<IntegerKey<int64_t>, RID,
+                                 IntegerComparator<int64_t>>;
 } // namespace scudb
@@ -9,45 +9,45 @@ namespace scudb {
  * Helper methods to get/set page type
  * Page type enum class is defined in b_plus_tree_page.h
  */
-bool BPlusTreePage::IsLeafPage() const { return false; }
-bool BPlusTreePage::IsRootPage() const { return false; }
-void BPlusTreePage::SetPageType(IndexPageType page_type) {}
+bool BPlusTreePage::IsLeafPage() const {
+  return page_type_ == IndexPageType::LEAF_PAGE;
+}
+bool BPlusTreePage::IsRootPage() const {
+  return parent_page_id_ == INVALID_PAGE_ID;
+}
+bool BPlusTreePage::IsValidPage() const {
+  return page_type_ != IndexPageType::INVALID_INDEX_PAGE;
+}
+void BPlusTreePage::SetPageType(IndexPageType page_type) {
+  page_type_ = page_type;
+}
 
 /*
  * Helper methods to get/set size (number of key/value pairs stored in that
  * page)
  */
-int BPlusTreePage::GetSize() const { return 0; }
-void BPlusTreePage::SetSize(int size) {}
-void BPlusTreePage::IncreaseSize(int amount) {}
-
-/*
- * Helper methods to get/set max size (capacity) of the page
- */
-int BPlusTreePage::GetMaxSize() const { return 0; }
-void BPlusTreePage::SetMaxSize(int size) {}
-
-/*
- * Helper method to get min page size
- * Generally, min page size == max page size / 2
- */
-int BPlusTreePage::GetMinSize() const { return 0; }
+int BPlusTreePage::GetSize() const { return size_; }
+void BPlusTreePage::SetSize(int size) { size_ = size; }
+void BPlusTreePage::IncreaseSize(int amount) { size_ += amount; }
 
 /*
  * Helper methods to get/set parent page id
  */
-page_id_t BPlusTreePage::GetParentPageId() const { return 0; }
-void BPlusTreePage::SetParentPageId(page_id_t parent_page_id) {}
+page_id_t BPlusTreePage::GetParentPageId() const { return parent_page_id_; }
+void BPlusTreePage::SetParentPageId(page_id_t parent_page_id) {
+  parent_page_id_ = parent_page_id;
+}
 
 /*
  * Helper methods to get/set self page id
  */
-page_id_t BPlusTreePage::GetPageId() const { return 0; }
-void BPlusTreePage::SetPageId(page_id_t page_id) {}
+page_id_t BPlusTreePage::GetPageId() const { return page_id_; }
+void BPlusTreePage::SetPageId(page_id_t page_id) { page_id_ = page_id; }
 
 /*
- * Helper methods to set lsn
+ * Helper methods to get/set lsn
  */
+lsn_t BPlusTreePage::GetLSN() const { return lsn_; }
 void BPlusTreePage::SetLSN(lsn_t lsn) { lsn_ = lsn; }
 
 } // namespace scudb
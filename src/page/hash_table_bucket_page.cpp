@@ -0,0 +1,124 @@
+/**
+ * hash_table_bucket_page.cpp
+ */
+#include <cassert>
+
+#include "page/hash_table_bucket_page.h"
+
+namespace scudb {
+
+/*
+ * Init method after creating a new bucket page, the capacity is whatever is
+ * left of the page after the header
+ */
+HASH_TABLE_TEMPLATE_ARGUMENTS
+void HASH_TABLE_BUCKET_TYPE::Init(page_id_t page_id) {
+  page_id_ = page_id;
+  SetLSN();
+  size_ = 0;
+  next_page_id_ = INVALID_PAGE_ID;
+  entries_.Init(PAGE_SIZE - sizeof(HashTableBucketPage), false);
+}
+
+HASH_TABLE_TEMPLATE_ARGUMENTS
+page_id_t HASH_TABLE_BUCKET_TYPE::GetPageId() const { return page_id_; }
+
+HASH_TABLE_TEMPLATE_ARGUMENTS
+void HASH_TABLE_BUCKET_TYPE::SetLSN(lsn_t lsn) { lsn_ = lsn; }
+
+HASH_TABLE_TEMPLATE_ARGUMENTS
+page_id_t HASH_TABLE_BUCKET_TYPE::GetNextPageId() const {
+  return next_page_id_;
+}
+
+HASH_TABLE_TEMPLATE_ARGUMENTS
+void HASH_TABLE_BUCKET_TYPE::SetNextPageId(page_id_t next_page_id) {
+  next_page_id_ = next_page_id;
+}
+
+/*****************************************************************************
+ * LOOKUP
+ *****************************************************************************/
+HASH_TABLE_TEMPLATE_ARGUMENTS
+int HASH_TABLE_BUCKET_TYPE::KeyIndex(const KeyType &key,
+                                     const KeyComparator &comparator) const {
+  for (int i = 0; i < size_; i++) {
+    if (comparator(entries_.KeyAt(i), key) == 0)
+      return i;
+  }
+  return -1;
+}
+
+HASH_TABLE_TEMPLATE_ARGUMENTS
+bool HASH_TABLE_BUCKET_TYPE::Lookup(const KeyType &key, ValueType &value,
+                                    const KeyComparator &comparator) const {
+  int index = KeyIndex(key, comparator);
+  if (index == -1)
+    return false;
+  value = entries_.ValueAt(index);
+  return true;
+}
+
+/*****************************************************************************
+ * INSERTION
+ *****************************************************************************/
+HASH_TABLE_TEMPLATE_ARGUMENTS
+bool HASH_TABLE_BUCKET_TYPE::Insert(const KeyType &key, const ValueType &value,
+                                    const KeyComparator &comparator) {
+  if (KeyIndex(key, comparator) != -1)
+    return false;
+  return Append(std::make_pair(key, value));
+}
+
+HASH_TABLE_TEMPLATE_ARGUMENTS
+bool HASH_TABLE_BUCKET_TYPE::Append(
+    const std::pair<KeyType, ValueType> &item) {
+  if (!entries_.Insert(size_, size_, item.first, item.second)) {
+    assert(size_ > 0);
+    return false;
+  }
+  size_++;
+  return true;
+}
+
+/*****************************************************************************
+ * REMOVE
+ *****************************************************************************/
+HASH_TABLE_TEMPLATE_ARGUMENTS
+bool HASH_TABLE_BUCKET_TYPE::Remove(const KeyType &key,
+                                    const KeyComparator &comparator) {
+  int index = KeyIndex(key, comparator);
+  if (index == -1)
+    return false;
+  RemoveAt(index);
+  return true;
+}
+
+HASH_TABLE_TEMPLATE_ARGUMENTS
+void HASH_TABLE_BUCKET_TYPE::RemoveAt(int index) {
+  entries_.Remove(size_--, index);
+}
+
+/*****************************************************************************
+ * HELPER METHODS
+ *****************************************************************************/
+HASH_TABLE_TEMPLATE_ARGUMENTS
+std::pair<KeyType, ValueType>
+HASH_TABLE_BUCKET_TYPE::GetItem(int index) const {
+  return std::make_pair(entries_.KeyAt(index), entries_.ValueAt(index));
+}
+
+HASH_TABLE_TEMPLATE_ARGUMENTS
+int HASH_TABLE_BUCKET_TYPE::GetSize() const { return size_; }
+
+HASH_TABLE_TEMPLATE_ARGUMENTS
+bool HASH_TABLE_BUCKET_TYPE::IsEmpty() const { return size_ == 0; }
+
+template class HashTableBucketPage<GenericKey<4>, RID, GenericComparator<4>>;
+template class HashTableBucketPage<GenericKey<8>, RID, GenericComparator<8>>;
+template class HashTableBucketPage<GenericKey<16>, RID, GenericComparator<16>>;
+template class HashTableBucketPage<GenericKey<32>, RID, GenericComparator<32>>;
+template class HashTableBucketPage<GenericKey<64>, RID, GenericComparator<64>>;
+template class HashTableBucketPage<GenericKey<128>, RID,
+                                   GenericComparator<128>>;
+} // namespace scudb
@@ -0,0 +1,94 @@
+/**
+ * hash_table_directory_page.cpp
+ */
+#include "page/hash_table_directory_page.h"
+
+namespace scudb {
+
+/*
+ * Init method after creating a new directory page, a new directory has a
+ * single slot whose bucket page is allocated by the caller
+ */
+void HashTableDirectoryPage::Init(page_id_t page_id) {
+  page_id_ = page_id;
+  SetLSN();
+  global_depth_ = 0;
+  for (uint32_t i = 0; i < HTABLE_DIRECTORY_ARRAY_SIZE; i++) {
+    local_depths_[i] = 0;
+    bucket_page_ids_[i] = INVALID_PAGE_ID;
+  }
+}
+
+page_id_t HashTableDirectoryPage::GetPageId() const { return page_id_; }
+
+void HashTableDirectoryPage::SetLSN(lsn_t lsn) { lsn_ = lsn; }
+
+uint32_t HashTableDirectoryPage::HashToBucketIndex(uint32_t hash) const {
+  return hash & (Size() - 1);
+}
+
+page_id_t HashTableDirectoryPage::GetBucketPageId(uint32_t bucket_idx) const {
+  return bucket_page_ids_[bucket_idx];
+}
+
+void HashTableDirectoryPage::SetBucketPageId(uint32_t bucket_idx,
+                                             page_id_t bucket_page_id) {
+  bucket_page_ids_[bucket_idx] = bucket_page_id;
+}
+
+uint32_t
+HashTableDirectoryPage::GetSplitImageIndex(uint32_t bucket_idx) const {
+  uint32_t local_depth = local_depths_[bucket_idx];
+  if (local_depth == 0)
+    return bucket_idx;
+  return bucket_idx ^ (1U << (local_depth - 1));
+}
+
+uint32_t HashTableDirectoryPage::GetGlobalDepth() const {
+  return global_depth_;
+}
+
+uint32_t HashTableDirectoryPage::GetMaxDepth() const {
+  return HTABLE_DIRECTORY_MAX_DEPTH;
+}
+
+void HashTableDirectoryPage::IncrGlobalDepth() {
+  uint32_t size = Size();
+  for (uint32_t i = 0; i < size; i++) {
+    local_depths_[i + size] = local_depths_[i];
+    bucket_page_ids_[i + size] = bucket_page_ids_[i];
+  }
+  global_depth_++;
+}
+
+void HashTableDirectoryPage::DecrGlobalDepth() {
+  global_depth_--;
+  uint32_t size = Size();
+  for (uint32_t i = size; i < 2 * size; i++) {
+    local_depths_[i] = 0;
+    bucket_page_ids_[i] = INVALID_PAGE_ID;
+  }
+}
+
+bool HashTableDirectoryPage::CanShrink() const {
+  if (global_depth_ == 0)
+    return false;
+  for (uint32_t i = 0; i < Size(); i++) {
+    if (local_depths_[i] == global_depth_)
+      return false;
+  }
+  return true;
+}
+
+uint32_t HashTableDirectoryPage::Size() const { return 1U << global_depth_; }
+
+uint32_t HashTableDirectoryPage::GetLocalDepth(uint32_t bucket_idx) const {
+  return local_depths_[bucket_idx];
+}
+
+void HashTableDirectoryPage::SetLocalDepth(uint32_t bucket_idx,
+                                           uint32_t local_depth) {
+  local_depths_[bucket_idx] = (uint8_t)local_depth;
+}
+
+} // namespace scudb
@@ -0,0 +1,45 @@
+/**
+ * hash_table_header_page.cpp
+ */
+#include "page/hash_table_header_page.h"
+
+namespace scudb {
+
+/*
+ * Init method after creating a new header page, every directory slot starts
+ * out empty and is allocated on the first insert that hashes to it
+ */
+void HashTableHeaderPage::Init(page_id_t page_id) {
+  page_id_ = page_id;
+  SetLSN();
+  for (uint32_t i = 0; i < MaxSize(); i++)
+    directory_page_ids_[i] = INVALID_PAGE_ID;
+}
+
+page_id_t HashTableHeaderPage::GetPageId() const { return page_id_; }
+
+void HashTableHeaderPage::SetLSN(lsn_t lsn) { lsn_ = lsn; }
+
+/*
+ * The header consumes the high bits of the hash, directory pages consume the
+ * low bits, so the two levels never look at the same bits
+ */
+uint32_t HashTableHeaderPage::HashToDirectoryIndex(uint32_t hash) const {
+  return hash >> (32 - HTABLE_HEADER_MAX_DEPTH);
+}
+
+page_id_t
+HashTableHeaderPage::GetDirectoryPageId(uint32_t directory_idx) const {
+  return directory_page_ids_[directory_idx];
+}
+
+void HashTableHeaderPage::SetDirectoryPageId(uint32_t directory_idx,
+                                             page_id_t directory_page_id) {
+  directory_page_ids_[directory_idx] = directory_page_id;
+}
+
+uint32_t HashTableHeaderPage::MaxSize() const {
+  return HTABLE_HEADER_ARRAY_SIZE;
+}
+
+} // namespace scudb
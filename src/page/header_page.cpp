@@ -8,6 +8,8 @@
 
 namespace scudb {
 
+static const int kStatisticsRecordSize = 32 + sizeof(IndexStatistics);
+
 /**
  * Record related
  */
@@ -21,6 +23,13 @@ bool HeaderPage::InsertRecord(const std::string &name,
   // check for duplicate name
   if (FindRecord(name) != -1)
     return false;
+  // make room by dropping statistics
+  int stats_num = GetStatisticsCount();
+  while (stats_num > 0 && offset + 36 > StatisticsOffset(stats_num - 1))
+    stats_num--;
+  SetStatisticsCount(stats_num);
+  if (offset + 36 > StatisticsOffset(-1))
+    return false;
   // copy record content
   memcpy(GetData() + offset, name.c_str(), (name.length() + 1));
   memcpy((GetData() + offset + 32), &root_id, 4);
@@ -42,6 +51,7 @@ bool HeaderPage::DeleteRecord(const std::string &name) {
           (record_num - index - 1) * 36);
 
   SetRecordCount(record_num - 1);
+  DeleteStatistics(name);
   return true;
 }
 
@@ -93,4 +103,71 @@ int HeaderPage::FindRecord(const std::string &name) {
   }
   return -1;
 }
+
+/**
+ * Statistics related
+ */
+bool HeaderPage::SetStatistics(const std::string &name,
+                               const IndexStatistics &stats) {
+  assert(name.length() < 32);
+
+  int index = FindStatistics(name);
+  if (index == -1) {
+    index = GetStatisticsCount();
+    if (StatisticsOffset(index) < 4 + GetRecordCount() * 36)
+      return false;
+    memcpy(GetData() + StatisticsOffset(index), name.c_str(),
+           name.length() + 1);
+    SetStatisticsCount(index + 1);
+  }
+  memcpy(GetData() + StatisticsOffset(index) + 32, &stats, sizeof(stats));
+  return true;
+}
+
+bool HeaderPage::GetStatistics(const std::string &name,
+                               IndexStatistics &stats) {
+  assert(name.length() < 32);
+
+  int index = FindStatistics(name);
+  if (index == -1)
+    return false;
+  memcpy(&stats, GetData() + StatisticsOffset(index) + 32, sizeof(stats));
+  return true;
+}
+
+void HeaderPage::DeleteStatistics(const std::string &name) {
+  int index = FindStatistics(name);
+  if (index == -1)
+    return;
+  int stats_num = GetStatisticsCount();
+  // records after index lie below it in the page
+  memmove(GetData() + StatisticsOffset(stats_num - 2),
+          GetData() + StatisticsOffset(stats_num - 1),
+          (stats_num - index - 1) * kStatisticsRecordSize);
+  SetStatisticsCount(stats_num - 1);
+}
+
+int HeaderPage::FindStatistics(const std::string &name) {
+  int stats_num = GetStatisticsCount();
+
+  for (int i = 0; i < stats_num; i++) {
+    char *raw_name = GetData() + StatisticsOffset(i);
+    if (strcmp(raw_name, name.c_str()) == 0)
+      return i;
+  }
+  return -1;
+}
+
+// StatisticsOffset(-1) is the offset of the statistics count
+int HeaderPage::StatisticsOffset(int index) {
+  return PAGE_SIZE - 4 - (index + 1) * kStatisticsRecordSize;
+}
+
+int HeaderPage::GetStatisticsCount() {
+  return *reinterpret_cast<int *>(GetData() + StatisticsOffset(-1));
+}
+
+void HeaderPage::SetStatisticsCount(int stats_count) {
+  memcpy(GetData() + StatisticsOffset(-1), &stats_count, 4);
+}
 } // namespace scudb
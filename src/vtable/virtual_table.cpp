@@ -2,8 +2,11 @@
  * virtual_table.cpp
  */
 #include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <iostream>
+#include <limits>
+#include <memory>
 #include <sys/stat.h>
 #include <vector>
 
@@ -17,6 +20,16 @@ namespace scudb {
 
 SQLITE_EXTENSION_INIT1
 
+// idxNum of VtabBestIndex: kPointScan is a point query on every key column,
+// an ordered index scan sets kOrderedScan and the flags after it. Either one
+// sets kIndexOnly if the index entries hold every column the query reads
+static const int kPointScan = 1;
+static const int kOrderedScan = 2;
+static const int kDescendingScan = 4;
+static const int kLowBound = 8;
+static const int kHighBound = 16;
+static const int kIndexOnly = 32;
+
 /* API implementation */
 int VtabCreate(sqlite3 *db, void *pAux, int argc, const char *const *argv,
                sqlite3_vtab **ppVtab, char **pzErr) {
@@ -83,20 +96,42 @@ int VtabConnect(sqlite3 *db, void *pAux, int argc, const char *const *argv,
   header_page->GetRootId(std::string(argv[2]), table_root_id);
   // parse arg[4](string that defines table index)
   Index *index = nullptr;
+  bool index_exists = true;
   if (argc > 4) {
     std::string index_string(argv[4]);
     index_string = index_string.substr(1, (index_string.size() - 2));
     // create index object, allocate memory space
     IndexMetadata *index_metadata =
         ParseIndexStatement(index_string, std::string(argv[2]), schema);
-    // Retrieve index root page info from header page
-    page_id_t index_root_id;
-    header_page->GetRootId(index_metadata->GetName(), index_root_id);
+    // Retrieve index root page info from header page, an in-memory index
+    // is never stored and always built again
+    page_id_t index_root_id = INVALID_PAGE_ID;
+    index_exists =
+        index_metadata->GetIndexType() != IndexType::ArtIndex &&
+        header_page->GetRootId(index_metadata->GetName(), index_root_id);
     index = ConstructIndex(index_metadata, buffer_pool_manager, index_root_id);
   }
   VirtualTable *table =
       new VirtualTable(schema, buffer_pool_manager, lock_manager, log_manager,
                        index, table_root_id);
+  if (!index_exists) {
+    // index declared on a table that already holds tuples, or kept in
+    // memory only, build it from the table heap (sorted and bulk loaded for
+    // B+ tree indexes)
+    Transaction *txn = storage_engine_->transaction_manager_->Begin();
+    bool built = table->BuildIndex(txn);
+    storage_engine_->transaction_manager_->Commit(txn);
+    delete txn;
+    if (!built) {
+      // forget the partly built index, the next connect starts over
+      *pzErr = sqlite3_mprintf("can't build index %s, it refused a row",
+                               index->GetName().c_str());
+      header_page->DeleteRecord(index->GetName());
+      buffer_pool_manager->UnpinPage(HEADER_PAGE_ID, true);
+      delete table;
+      return SQLITE_ERROR;
+    }
+  }
 
   // register virtual table within sqlite system
   schema_string = "CREATE TABLE X(" + schema_string + ");";
@@ -108,20 +143,120 @@ int VtabConnect(sqlite3 *db, void *pAux, int argc, const char *const *argv,
 }
 
 /*
- * we only support
+ * Plan a scan of an ordered index for an ORDER BY over a prefix of the key
+ * columns (all ascending or all descending) or for range constraints on a
+ * single key column. SQLite still checks the constraints, the bounds only
+ * narrow the scan.
+ */
+static void PlanOrderedScan(const std::vector<int> &key_attrs,
+                            sqlite3_index_info *pIdxInfo) {
+  for (int i = 0; i < pIdxInfo->nConstraint; i++)
+    pIdxInfo->aConstraintUsage[i].argvIndex = 0;
+
+  bool ordered = pIdxInfo->nOrderBy > 0 &&
+                 pIdxInfo->nOrderBy <= (int)key_attrs.size();
+  for (int i = 0; ordered && i < pIdxInfo->nOrderBy; i++) {
+    ordered = pIdxInfo->aOrderBy[i].iColumn == key_attrs[i] &&
+              pIdxInfo->aOrderBy[i].desc == pIdxInfo->aOrderBy[0].desc;
+  }
+  int low = -1, high = -1;
+  for (int i = 0; key_attrs.size() == 1 && i < pIdxInfo->nConstraint; i++) {
+    if (pIdxInfo->aConstraint[i].usable == 0 ||
+        pIdxInfo->aConstraint[i].iColumn != key_attrs[0])
+      continue;
+    unsigned char op = pIdxInfo->aConstraint[i].op;
+    if (low < 0 && (op == SQLITE_INDEX_CONSTRAINT_GT ||
+                    op == SQLITE_INDEX_CONSTRAINT_GE))
+      low = i;
+    if (high < 0 && (op == SQLITE_INDEX_CONSTRAINT_LT ||
+                     op == SQLITE_INDEX_CONSTRAINT_LE))
+      high = i;
+  }
+  if (!ordered && low < 0 && high < 0)
+    return;
+
+  pIdxInfo->idxNum = kOrderedScan;
+  int argv_index = 1;
+  if (low >= 0) {
+    pIdxInfo->idxNum |= kLowBound;
+    pIdxInfo->aConstraintUsage[low].argvIndex = argv_index++;
+  }
+  if (high >= 0) {
+    pIdxInfo->idxNum |= kHighBound;
+    pIdxInfo->aConstraintUsage[high].argvIndex = argv_index++;
+  }
+  if (ordered) {
+    pIdxInfo->orderByConsumed = 1;
+    if (pIdxInfo->aOrderBy[0].desc)
+      pIdxInfo->idxNum |= kDescendingScan;
+  }
+}
+
+/*
+ * A range bound is only used if the key holds it exactly, e.g. an INTEGER key
+ * can not hold 2.5 or 2^40. Otherwise that end of the scan is left open.
+ */
+static bool IsExactBound(TypeId type, sqlite3_value *value) {
+  int64_t min, max;
+  switch (type) {
+  case TypeId::TINYINT:
+    min = std::numeric_limits<int8_t>::min();
+    max = std::numeric_limits<int8_t>::max();
+    break;
+  case TypeId::SMALLINT:
+    min = std::numeric_limits<int16_t>::min();
+    max = std::numeric_limits<int16_t>::max();
+    break;
+  case TypeId::INTEGER:
+    min = std::numeric_limits<int32_t>::min();
+    max = std::numeric_limits<int32_t>::max();
+    break;
+  case TypeId::BIGINT:
+    min = std::numeric_limits<int64_t>::min();
+    max = std::numeric_limits<int64_t>::max();
+    break;
+  case TypeId::DECIMAL:
+    return sqlite3_value_type(value) == SQLITE_FLOAT;
+  case TypeId::VARCHAR:
+    return sqlite3_value_type(value) == SQLITE_TEXT;
+  default:
+    return false;
+  }
+  // the smallest value of an integer type stands for NULL
+  sqlite3_int64 v = sqlite3_value_int64(value);
+  return sqlite3_value_type(value) == SQLITE_INTEGER && v > min && v <= max;
+}
+
+/*
+ * colUsed has a bit per column the statement reads, bit 63 stands for all
+ * columns from the 63rd on, which are never taken as covered.
+ */
+static bool IsCoveredScan(Index *index, sqlite3_index_info *pIdxInfo) {
+  if (!index->IsCovering())
+    return false;
+  sqlite3_uint64 covered = 0;
+  for (int column : index->GetEntryAttrs()) {
+    if (column < 63)
+      covered |= (sqlite3_uint64)1 << column;
+  }
+  return (pIdxInfo->colUsed & ~covered) == 0;
+}
+
+/*
+ * for point lookups we only support
  * (1) equlity check. e.g select * from foo where a = 1
  * (2) indexed column == predicated column
+ * other queries on an ordered index are left to PlanOrderedScan
  */
-int VtabBestIndex(sqlite3_vtab *tab, sqlite3_index_info *pIdxInfo) {
-  // LOG_DEBUG("VtabBestIndex");
-  VirtualTable *table = reinterpret_cast<VirtualTable *>(tab);
-  if (table->GetIndex() == nullptr)
-    return SQLITE_OK;
+static void PlanIndexScan(VirtualTable *table, sqlite3_index_info *pIdxInfo) {
   const std::vector<int> key_attrs = table->GetIndex()->GetKeyAttrs();
   // make sure indexed column == predicate column
   // e.g select * from foo where a = 1 and b =2; indexed column must be {a,b}
-  if (pIdxInfo->nConstraint != (int)(key_attrs.size()))
-    return SQLITE_OK;
+  if (pIdxInfo->nConstraint != (int)(key_attrs.size())) {
+    if (table->GetIndex()->IsOrdered())
+      PlanOrderedScan(key_attrs, pIdxInfo);
+    return;
+  }
 
   int counter = 0;
   bool is_index_scan = true;
@@ -143,8 +278,59 @@ int VtabBestIndex(sqlite3_vtab *tab, sqlite3_index_info *pIdxInfo) {
   }
 
   if (counter == (int)key_attrs.size() && is_index_scan) {
-    pIdxInfo->idxNum = 1;
+    pIdxInfo->idxNum = kPointScan;
+  } else if (table->GetIndex()->IsOrdered()) {
+    PlanOrderedScan(key_attrs, pIdxInfo);
   }
+}
+
+/*
+ * Cost of the planned scan in page and tuple reads from the statistics of
+ * the index, whose entries are the rows of the table. A scan of the table
+ * reads every row. An index scan descends the tree, reads the leaves of the
+ * matching entries and, unless it is index-only, fetches every match from
+ * the table heap. Each range bound is taken to keep a quarter of the rows.
+ */
+static void EstimateScanCost(Index *index, sqlite3_index_info *pIdxInfo) {
+  IndexStatistics stats;
+  if (!index->GetStatistics(stats))
+    return;
+  double rows = std::max<double>(stats.entries, 1);
+  int plan = pIdxInfo->idxNum;
+  if (plan == 0) {
+    pIdxInfo->estimatedRows = (sqlite3_int64)rows;
+    pIdxInfo->estimatedCost = rows;
+    return;
+  }
+  // no SQLITE_INDEX_SCAN_UNIQUE for unique keys: the one-pass DELETE and
+  // UPDATE it allows call VtabUpdate after the cursor and its transaction
+  // are closed
+  double matches = rows;
+  if (plan & kPointScan)
+    matches = rows / std::max<double>(stats.distinct_keys, 1);
+  if (plan & kLowBound)
+    matches /= 4;
+  if (plan & kHighBound)
+    matches /= 4;
+  matches = std::max(matches, 1.0);
+  double leaves = std::max(stats.leaf_pages, 1) * matches / rows;
+  pIdxInfo->estimatedRows = (sqlite3_int64)std::ceil(matches);
+  pIdxInfo->estimatedCost =
+      stats.height + std::ceil(leaves) + (plan & kIndexOnly ? 0 : matches);
+}
+
+int VtabBestIndex(sqlite3_vtab *tab, sqlite3_index_info *pIdxInfo) {
+  // LOG_DEBUG("VtabBestIndex");
+  VirtualTable *table = reinterpret_cast<VirtualTable *>(tab);
+  if (table->GetIndex() == nullptr)
+    return SQLITE_OK;
+  PlanIndexScan(table, pIdxInfo);
+  // index scans whose columns are all in the index skip the table heap
+  if (pIdxInfo->idxNum != 0 && IsCoveredScan(table->GetIndex(), pIdxInfo)) {
+    pIdxInfo->idxNum |= kIndexOnly;
+    pIdxInfo->idxStr = const_cast<char *>("index-only");
+  }
+  EstimateScanCost(table->GetIndex(), pIdxInfo);
   return SQLITE_OK;
 }
 
@@ -161,6 +347,7 @@ int VtabOpen(sqlite3_vtab *pVtab, sqlite3_vtab_cursor **ppCursor) {
   // if read operation, begin transaction here
   if (global_transaction_ == nullptr) {
     VtabBegin(pVtab);
+    global_read_transaction_ = true;
   }
   VirtualTable *virtual_table = reinterpret_cast<VirtualTable *>(pVtab);
   Cursor *cursor = new Cursor(virtual_table);
@@ -172,8 +359,10 @@ int VtabOpen(sqlite3_vtab *pVtab, sqlite3_vtab_cursor **ppCursor) {
 int VtabClose(sqlite3_vtab_cursor *cur) {
   // LOG_DEBUG("VtabClose");
   Cursor *cursor = reinterpret_cast<Cursor *>(cur);
-  // if read operation, commit transaction here
-  VtabCommit(nullptr);
+  // if read operation, commit transaction here. A write transaction ends in
+  // VtabCommit or VtabRollback once the statement is done
+  if (global_read_transaction_)
+    VtabCommit(nullptr);
   delete cursor;
   return SQLITE_OK;
 }
@@ -189,13 +378,27 @@ int VtabFilter(sqlite3_vtab_cursor *pVtabCursor, int idxNum, const char *idxStr,
   // LOG_DEBUG("VtabFilter");
   Cursor *cursor = reinterpret_cast<Cursor *>(pVtabCursor);
   Schema *key_schema;
+  cursor->SetIndexOnly(idxNum & kIndexOnly);
   // if indexed scan
-  if (idxNum == 1) {
+  if (idxNum & kPointScan) {
     cursor->SetScanFlag(true);
     // Construct the tuple for point query
     key_schema = cursor->GetKeySchema();
     Tuple scan_tuple = ConstructTuple(key_schema, argv);
     cursor->ScanKey(scan_tuple);
+  } else if (idxNum & kOrderedScan) {
+    cursor->SetScanFlag(true);
+    // bounds are on the single key column, low bound first
+    key_schema = cursor->GetKeySchema();
+    std::unique_ptr<Tuple> low, high;
+    int arg = 0;
+    if ((idxNum & kLowBound) && IsExactBound(key_schema->GetType(0), argv[arg]))
+      low.reset(new Tuple(ConstructTuple(key_schema, argv + arg)));
+    arg += (idxNum & kLowBound) ? 1 : 0;
+    if ((idxNum & kHighBound) &&
+        IsExactBound(key_schema->GetType(0), argv[arg]))
+      high.reset(new Tuple(ConstructTuple(key_schema, argv + arg)));
+    cursor->ScanRange(low.get(), high.get(), idxNum & kDescendingScan);
   }
   return SQLITE_OK;
 }
@@ -254,6 +457,14 @@ int VtabRowid(sqlite3_vtab_cursor *cur, sqlite3_int64 *pRowid) {
   return SQLITE_OK;
 }
 
+// the index refused the entry of the row, e.g. a unique index holding its
+// key already. The row is left as it was before the update
+static int RejectEntry(sqlite3_vtab *pVTab) {
+  sqlite3_free(pVTab->zErrMsg);
+  pVTab->zErrMsg = sqlite3_mprintf("index refused the key of the row");
+  return SQLITE_CONSTRAINT;
+}
+
 int VtabUpdate(sqlite3_vtab *pVTab, int argc, sqlite3_value **argv,
                sqlite_int64 *pRowid) {
   // LOG_DEBUG("VtabUpdate");
@@ -275,8 +486,11 @@ int VtabUpdate(sqlite3_vtab *pVTab, int argc, sqlite3_value **argv,
     // insert into table heap
     RID rid;
     table->InsertTuple(tuple, rid);
-    // insert into index
-    table->InsertEntry(tuple, rid);
+    // insert into index, take the tuple back if the index refuses it
+    if (!table->InsertEntry(tuple, rid)) {
+      table->DeleteTuple(rid);
+      return RejectEntry(pVTab);
+    }
   }
   // The row with rowid argv[0] is updated with new values in argv[2] and
   // following parameters.
@@ -284,25 +498,42 @@ int VtabUpdate(sqlite3_vtab *pVTab, int argc, sqlite3_value **argv,
     Schema *schema = table->GetSchema();
     Tuple tuple = ConstructTuple(schema, (argv + 2));
     RID rid(sqlite3_value_int64(argv[0]));
+    // keep the old tuple to restore it if the index refuses the new one
+    Tuple old_tuple(rid);
+    table->GetTuple(rid, old_tuple);
     // for update, index always delete and insert
     // because you have no clue key has been updated or not
     table->DeleteEntry(rid);
     // if true, then update succeed, rid keep the same
-    // else, delete & insert
-    if (table->UpdateTuple(tuple, rid) == false) {
+    if (table->UpdateTuple(tuple, rid)) {
+      if (!table->InsertEntry(tuple, rid)) {
+        table->UpdateTuple(old_tuple, rid);
+        table->InsertEntry(old_tuple, rid);
+        return RejectEntry(pVTab);
+      }
+    }
+    // else, insert & delete, rid should be different
+    else {
+      RID new_rid;
+      table->InsertTuple(tuple, new_rid);
+      if (!table->InsertEntry(tuple, new_rid)) {
+        table->DeleteTuple(new_rid);
+        table->InsertEntry(old_tuple, rid);
+        return RejectEntry(pVTab);
+      }
       table->DeleteTuple(rid);
-      // rid should be different
-      table->InsertTuple(tuple, rid);
     }
-    table->InsertEntry(tuple, rid);
   }
   return SQLITE_OK;
 }
 
 int VtabBegin(sqlite3_vtab *pVTab) {
   // LOG_DEBUG("VtabBegin");
-  // create new transaction(write operation will call this method)
-  global_transaction_ = storage_engine_->transaction_manager_->Begin();
+  // create new transaction(write operation will call this method), unless a
+  // cursor of the statement began one already
+  if (global_transaction_ == nullptr)
+    global_transaction_ = storage_engine_->transaction_manager_->Begin();
+  global_read_transaction_ = false;
   return SQLITE_OK;
 }
 
@@ -318,12 +549,61 @@ int VtabCommit(sqlite3_vtab *pVTab) {
   // when commit, delete transaction pointer and set to null
   delete transaction;
   global_transaction_ = nullptr;
+  global_savepoints_.clear();
+
+  return SQLITE_OK;
+}
+
+int VtabRollback(sqlite3_vtab *pVTab) {
+  // LOG_DEBUG("VtabRollback");
+  auto transaction = GetTransaction();
+  if (transaction == nullptr)
+    return SQLITE_OK;
+  // undo the index entries and the table heap writes of the transaction,
+  // e.g. the rows a statement wrote before VtabUpdate refused one
+  storage_engine_->transaction_manager_->Abort(transaction);
+  delete transaction;
+  global_transaction_ = nullptr;
+  global_savepoints_.clear();
+
+  return SQLITE_OK;
+}
+
+int VtabSavepoint(sqlite3_vtab *pVTab, int iSavepoint) {
+  // LOG_DEBUG("VtabSavepoint");
+  auto transaction = GetTransaction();
+  if (transaction == nullptr)
+    return SQLITE_OK;
+  // savepoints skipped by SQLite start at the same writes
+  std::pair<size_t, size_t> savepoint(transaction->GetWriteSet()->size(),
+                                      transaction->GetIndexWriteSet()->size());
+  global_savepoints_.resize(iSavepoint);
+  global_savepoints_.resize(iSavepoint + 1, savepoint);
+  return SQLITE_OK;
+}
 
+int VtabRelease(sqlite3_vtab *pVTab, int iSavepoint) {
+  // LOG_DEBUG("VtabRelease");
+  if ((int)global_savepoints_.size() > iSavepoint)
+    global_savepoints_.resize(iSavepoint);
+  return SQLITE_OK;
+}
+
+int VtabRollbackTo(sqlite3_vtab *pVTab, int iSavepoint) {
+  // LOG_DEBUG("VtabRollbackTo");
+  auto transaction = GetTransaction();
+  if (transaction == nullptr || (int)global_savepoints_.size() <= iSavepoint)
+    return SQLITE_OK;
+  // the savepoint stays open, the later ones are gone
+  auto savepoint = global_savepoints_[iSavepoint];
+  global_savepoints_.resize(iSavepoint + 1);
+  storage_engine_->transaction_manager_->RollbackTo(
+      transaction, savepoint.first, savepoint.second);
   return SQLITE_OK;
 }
 
 sqlite3_module VtableModule = {
-    0,              /* iVersion */
+    2,              /* iVersion */
     VtabCreate,     /* xCreate */
     VtabConnect,    /* xConnect */
     VtabBestIndex,  /* xBestIndex */
@@ -340,12 +620,12 @@ sqlite3_module VtableModule = {
     VtabBegin,      /* xBegin */
     0,              /* xSync */
     VtabCommit,     /* xCommit */
-    0,              /* xRollback */
+    VtabRollback,   /* xRollback */
     0,              /* xFindMethod */
     0,              /* xRename */
-    0,              /* xSavepoint */
-    0,              /* xRelease */
-    0,              /* xRollbackTo */
+    VtabSavepoint,  /* xSavepoint */
+    VtabRelease,    /* xRelease */
+    VtabRollbackTo, /* xRollbackTo */
 };
 
 #ifdef _WIN32
@@ -450,6 +730,73 @@ IndexMetadata *ParseIndexStatement(std::string &sql,
   assert(n != std::string::npos);
   index_name = sql.substr(0, n);
   sql = sql.substr(n + 1);
+  // optional trailing "using <type>" picks the index structure, e.g.
+  // 'foo_pk a using hash' or the in-memory 'foo_pk a using art', default to
+  // b+ tree. It may be preceded by
+  // "include" and the columns stored with every entry besides the key, e.g.
+  // 'foo_idx b include (c, d)', before that by words that switch on options
+  // in any order: "bloom" for a Bloom filter over the keys, e.g. 'foo_pk a
+  // bloom', "nonunique" for an index on columns that tuples share, e.g.
+  // 'foo_idx b nonunique', and the B+ tree options (see BPlusTreeOptions)
+  // "adaptive" for an adaptive hash index, e.g. 'foo_pk a adaptive bloom',
+  // "buffered" for a write buffer, "deferred" for deferred merges and
+  // "swizzled" for pointer swizzling
+  IndexType index_type = IndexType::BPlusTreeIndex;
+  n = sql.find(" using ");
+  if (n != std::string::npos) {
+    std::string type = sql.substr(n + 7);
+    StringUtility::Trim(type);
+    if (type == "hash")
+      index_type = IndexType::HashTableIndex;
+    else if (type == "art")
+      index_type = IndexType::ArtIndex;
+    else if (type != "btree")
+      throw Exception(EXCEPTION_TYPE_INDEX,
+                      "can't create index, unknown index type " + type);
+    sql = sql.substr(0, n);
+  }
+  std::vector<int> include_attrs;
+  n = sql.find(" include ");
+  if (n != std::string::npos) {
+    std::string columns = sql.substr(n + 9);
+    columns.erase(std::remove(columns.begin(), columns.end(), '('),
+                  columns.end());
+    columns.erase(std::remove(columns.begin(), columns.end(), ')'),
+                  columns.end());
+    for (std::string &t : StringUtility::Split(columns, ',')) {
+      StringUtility::Trim(t);
+      column_id = schema->GetColumnID(t);
+      if (column_id == -1)
+        throw Exception(EXCEPTION_TYPE_INDEX,
+                        "can't create index, unknown included column " + t);
+      include_attrs.emplace_back(column_id);
+    }
+    sql = sql.substr(0, n);
+  }
+  bool has_bloom_filter = false, is_unique = true;
+  BPlusTreeOptions tree_options;
+  while (true) {
+    StringUtility::Trim(sql);
+    n = sql.rfind(' ');
+    if (n == std::string::npos)
+      break;
+    std::string word = sql.substr(n + 1);
+    if (word == "bloom")
+      has_bloom_filter = true;
+    else if (word == "nonunique")
+      is_unique = false;
+    else if (word == "adaptive")
+      tree_options.adaptive_hash = true;
+    else if (word == "buffered")
+      tree_options.write_buffer = true;
+    else if (word == "deferred")
+      tree_options.deferred_merge = true;
+    else if (word == "swizzled")
+      tree_options.swizzling = true;
+    else
+      break;
+    sql = sql.substr(0, n);
+  }
 
   std::vector<std::string> tok = StringUtility::Split(sql, ',');
   // iterate through returned result
@@ -463,7 +810,9 @@ IndexMetadata *ParseIndexStatement(std::string &sql,
     throw Exception(EXCEPTION_TYPE_INDEX, "can't create index, format error");
 
   IndexMetadata *metadata =
-      new IndexMetadata(index_name, table_name, schema, key_attrs);
+      new IndexMetadata(index_name, table_name, schema, key_attrs, index_type,
+                        is_unique, include_attrs, has_bloom_filter,
+                        tree_options);
 
   // LOG_DEBUG("%s", metadata->ToString().c_str());
   return metadata;
@@ -504,34 +853,98 @@ Tuple ConstructTuple(Schema *schema, sqlite3_value **argv) {
   return tuple;
 }
 
-// serve the functionality of index factory
-Index *ConstructIndex(IndexMetadata *metadata,
-                      BufferPoolManager *buffer_pool_manager,
-                      page_id_t root_id) {
-  // The size of the key in bytes
-  Schema *key_schema = metadata->GetKeySchema();
-  int key_size = key_schema->GetLength();
-  // for each varchar attribute, we assume the largest size is 16 bytes
-  key_size += 16 * key_schema->GetUnlinedColumnCount();
-
+// instantiate IndexClass with the smallest generic key that holds key_size,
+// the widest one if none does
+template <template <typename, typename, typename> class IndexClass>
+Index *ConstructSizedIndex(IndexMetadata *metadata,
+                           BufferPoolManager *buffer_pool_manager,
+                           page_id_t root_id, int key_size) {
   if (key_size <= 4) {
-    return new BPlusTreeIndex<GenericKey<4>, RID, GenericComparator<4>>(
+    return new IndexClass<GenericKey<4>, RID, GenericComparator<4>>(
         metadata, buffer_pool_manager, root_id);
   } else if (key_size <= 8) {
-    return new BPlusTreeIndex<GenericKey<8>, RID, GenericComparator<8>>(
+    return new IndexClass<GenericKey<8>, RID, GenericComparator<8>>(
         metadata, buffer_pool_manager, root_id);
   } else if (key_size <= 16) {
-    return new BPlusTreeIndex<GenericKey<16>, RID, GenericComparator<16>>(
+    return new IndexClass<GenericKey<16>, RID, GenericComparator<16>>(
         metadata, buffer_pool_manager, root_id);
   } else if (key_size <= 32) {
-    return new BPlusTreeIndex<GenericKey<32>, RID, GenericComparator<32>>(
+    return new IndexClass<GenericKey<32>, RID, GenericComparator<32>>(
+        metadata, buffer_pool_manager, root_id);
+  } else if (key_size <= 64) {
+    return new IndexClass<GenericKey<64>, RID, GenericComparator<64>>(
         metadata, buffer_pool_manager, root_id);
   } else {
-    return new BPlusTreeIndex<GenericKey<64>, RID, GenericComparator<64>>(
+    return new IndexClass<GenericKey<128>, RID, GenericComparator<128>>(
         metadata, buffer_pool_manager, root_id);
   }
 }
 
+// serve the functionality of index factory
+Index *ConstructIndex(IndexMetadata *metadata,
+                      BufferPoolManager *buffer_pool_manager,
+                      page_id_t root_id) {
+  // The size of the encoded key in bytes. SQLite does not enforce the
+  // declared length of a varchar, so keys with a varchar column get the
+  // widest key type whatever length was declared. Hash and B+
+  // tree pages store keys without their zero padding (see
+  // page/packed_entry_array.h), a key only takes the bytes it uses. An index
+  // refuses rows whose key is longer than its key type (see GenericKey), so
+  // VtabUpdate fails for them
+  Schema *key_schema = metadata->GetKeySchema();
+  Schema *entry_schema = metadata->GetEntrySchema();
+  int key_size = (int)KeyEncoder::MaxLength(entry_schema);
+  // keys of a non-unique index are followed by the rid, and so are the ones
+  // of an index with included columns
+  bool has_rid = !metadata->IsUnique() || !metadata->GetIncludeAttrs().empty();
+  if (has_rid)
+    key_size += sizeof(RID);
+  for (int i = 0; i < entry_schema->GetColumnCount(); i++) {
+    if (entry_schema->GetType(i) == TypeId::VARCHAR)
+      key_size = std::numeric_limits<int>::max();
+  }
+
+  switch (metadata->GetIndexType()) {
+  case IndexType::HashTableIndex:
+    if (!metadata->IsUnique())
+      throw Exception(EXCEPTION_TYPE_INDEX,
+                      "can't create index, hash indexes are unique");
+    if (has_rid)
+      throw Exception(EXCEPTION_TYPE_INDEX,
+                      "can't create index, hash indexes include no columns");
+    if (metadata->HasBloomFilter())
+      throw Exception(EXCEPTION_TYPE_INDEX,
+                      "can't create index, hash indexes have no bloom filter");
+    if (metadata->GetTreeOptions().Any())
+      throw Exception(EXCEPTION_TYPE_INDEX,
+                      "can't create index, hash indexes have no tree options");
+    return ConstructSizedIndex<ExtendibleHashTableIndex>(
+        metadata, buffer_pool_manager, root_id, key_size);
+  case IndexType::ArtIndex:
+    if (metadata->HasBloomFilter())
+      throw Exception(EXCEPTION_TYPE_INDEX,
+                      "can't create index, art indexes have no bloom filter");
+    if (metadata->GetTreeOptions().Any())
+      throw Exception(EXCEPTION_TYPE_INDEX,
+                      "can't create index, art indexes have no tree options");
+    return new ArtIndex(metadata);
+  default:
+    // a single integer column is compared natively instead of via Value
+    if (!has_rid && key_schema->GetColumnCount() == 1 &&
+        key_schema->GetType(0) == TypeId::INTEGER)
+      return new BPlusTreeIndex<IntegerKey<int32_t>, RID,
+                                IntegerComparator<int32_t>>(
+          metadata, buffer_pool_manager, root_id);
+    if (!has_rid && key_schema->GetColumnCount() == 1 &&
+        key_schema->GetType(0) == TypeId::BIGINT)
+      return new BPlusTreeIndex<IntegerKey<int64_t>, RID,
+                                IntegerComparator<int64_t>>(
+          metadata, buffer_pool_manager, root_id);
+    return ConstructSizedIndex<BPlusTreeIndex>(metadata, buffer_pool_manager,
+                                               root_id, key_size);
+  }
+}
+
 Transaction *GetTransaction() { return global_transaction_; }
 
 } // namespace scudb
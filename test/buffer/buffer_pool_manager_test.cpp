@@ -98,5 +98,93 @@ TEST(BufferPoolManagerTest, SampleTest2) {
   remove("test.db");
 }
 
+TEST(BufferPoolManagerTest, DeletePinnedTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(2, disk_manager);
+
+  Page *page = bpm.NewPage(temp_page_id);
+  ASSERT_NE(nullptr, page);
+  page_id_t deleted_page_id = temp_page_id;
+  ASSERT_NE(nullptr, bpm.NewPage(temp_page_id));
+  EXPECT_EQ(nullptr, bpm.NewPage(temp_page_id));
+
+  // the page is still pinned twice, its frame is freed with the last pin
+  EXPECT_EQ(page, bpm.FetchPage(deleted_page_id));
+  EXPECT_EQ(false, bpm.DeletePage(deleted_page_id));
+  EXPECT_EQ(true, bpm.UnpinPage(deleted_page_id, true));
+  EXPECT_EQ(nullptr, bpm.NewPage(temp_page_id));
+  EXPECT_EQ(true, bpm.UnpinPage(deleted_page_id, true));
+  EXPECT_EQ(false, bpm.UnpinPage(deleted_page_id, false));
+  EXPECT_EQ(page, bpm.NewPage(temp_page_id));
+  EXPECT_EQ(1, page->GetPinCount());
+
+  // an unpinned page is deleted right away
+  EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, false));
+  EXPECT_EQ(true, bpm.DeletePage(temp_page_id));
+  EXPECT_EQ(page, bpm.NewPage(temp_page_id));
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, SwizzleTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(3, disk_manager);
+
+  // a parent page and two children
+  Page *parent = bpm.NewPage(temp_page_id);
+  ASSERT_NE(nullptr, parent);
+  page_id_t child_ids[2];
+  for (int i = 0; i < 2; ++i) {
+    Page *child = bpm.NewPage(child_ids[i]);
+    ASSERT_NE(nullptr, child);
+    snprintf(child->GetData(), PAGE_SIZE, "child %d", i);
+    EXPECT_EQ(true, bpm.UnpinFrame(child, true));
+  }
+
+  // the first fetch swizzles the child, the next one pins the same frame by
+  // its pin count
+  Page *child = bpm.FetchChildPage(parent, 0, child_ids[0]);
+  ASSERT_NE(nullptr, child);
+  EXPECT_EQ(child_ids[0], child->GetPageId());
+  EXPECT_EQ(true, bpm.UnpinFrame(child, false));
+  EXPECT_EQ(child, bpm.FetchChildPage(parent, 0, child_ids[0]));
+  EXPECT_EQ(1, child->GetPinCount());
+  EXPECT_EQ(true, bpm.UnpinFrame(child, false));
+  EXPECT_EQ(false, bpm.UnpinFrame(child, false));
+
+  // evict the first child, its frame now holds another page
+  Page *other = bpm.NewPage(temp_page_id);
+  ASSERT_NE(nullptr, other);
+  Page *second = bpm.FetchPage(child_ids[1]);
+  ASSERT_NE(nullptr, second);
+  EXPECT_EQ(nullptr, bpm.FetchChildPage(parent, 0, child_ids[0]));
+  EXPECT_EQ(true, bpm.UnpinFrame(other, false));
+
+  // the stale reference is not followed, the child is read back
+  child = bpm.FetchChildPage(parent, 0, child_ids[0]);
+  ASSERT_NE(nullptr, child);
+  EXPECT_EQ(child_ids[0], child->GetPageId());
+  EXPECT_EQ(0, strcmp(child->GetData(), "child 0"));
+  // a child index now holding another page is not followed either
+  EXPECT_EQ(second, bpm.FetchChildPage(parent, 0, child_ids[1]));
+  EXPECT_EQ(2, second->GetPinCount());
+  // a frame pinned through the parent while it was in the replacer is
+  // skipped as a victim, and can be evicted once unpinned again
+  EXPECT_EQ(true, bpm.UnpinFrame(child, false));
+  EXPECT_EQ(child, bpm.FetchChildPage(parent, 1, child_ids[0]));
+  EXPECT_EQ(true, bpm.UnpinFrame(child, false));
+  EXPECT_EQ(child, bpm.FetchChildPage(parent, 1, child_ids[0]));
+  EXPECT_EQ(nullptr, bpm.NewPage(temp_page_id));
+  EXPECT_EQ(true, bpm.UnpinFrame(child, false));
+  EXPECT_EQ(child, bpm.NewPage(temp_page_id));
+
+  delete disk_manager;
+  remove("test.db");
+}
 
 } // namespace scudb
\ No newline at end of file
@@ -0,0 +1,287 @@
+/**
+ * disk_extendible_hash_table_test.cpp
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "hash/disk_extendible_hash_table.h"
+#include "page/header_page.h"
+#include "vtable/virtual_table.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+TEST(DiskExtendibleHashTableTest, InsertTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+
+  DiskExtendibleHashTable<GenericKey<8>, RID, GenericComparator<8>> table(
+      "foo_pk", bpm, comparator);
+  EXPECT_TRUE(table.IsEmpty());
+  GenericKey<8> index_key;
+  RID rid;
+
+  // enough keys to split buckets and grow directories
+  const int64_t scale = 5000;
+  for (int64_t key = 0; key < scale; key++) {
+    rid.Set((int32_t)(key >> 32), key & 0xFFFFFFFF);
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(table.Insert(index_key, rid));
+  }
+  EXPECT_FALSE(table.IsEmpty());
+  EXPECT_TRUE(table.VerifyIntegrity());
+
+  // duplicate keys are rejected
+  index_key.SetFromInteger(42);
+  EXPECT_FALSE(table.Insert(index_key, rid));
+
+  std::vector<RID> rids;
+  for (int64_t key = 0; key < scale; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(table.GetValue(index_key, rids));
+    EXPECT_EQ(rids.size(), 1);
+    EXPECT_EQ(rids[0].GetSlotNum(), key & 0xFFFFFFFF);
+  }
+  rids.clear();
+  index_key.SetFromInteger(scale);
+  EXPECT_FALSE(table.GetValue(index_key, rids));
+  EXPECT_EQ(rids.size(), 0);
+
+  // the header page records where the table lives, reopen through it
+  page_id_t header_page_id;
+  EXPECT_TRUE(static_cast<HeaderPage *>(header_page)
+                  ->GetRootId("foo_pk", header_page_id));
+  EXPECT_EQ(header_page_id, table.GetHeaderPageId());
+  DiskExtendibleHashTable<GenericKey<8>, RID, GenericComparator<8>> reopened(
+      "foo_pk", bpm, comparator, header_page_id);
+  for (int64_t key = 0; key < scale; key += 7) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(reopened.GetValue(index_key, rids));
+    EXPECT_EQ(rids[0].GetSlotNum(), key & 0xFFFFFFFF);
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(DiskExtendibleHashTableTest, RemoveTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(page_id);
+
+  DiskExtendibleHashTable<GenericKey<8>, RID, GenericComparator<8>> table(
+      "foo_pk", bpm, comparator);
+  GenericKey<8> index_key;
+  RID rid;
+
+  const int64_t scale = 5000;
+  for (int64_t key = 0; key < scale; key++) {
+    rid.Set(0, key);
+    index_key.SetFromInteger(key);
+    table.Insert(index_key, rid);
+  }
+  uint32_t peak_depth = 0;
+  for (int64_t key = 0; key < scale; key++) {
+    index_key.SetFromInteger(key);
+    peak_depth = std::max(peak_depth, table.GetGlobalDepth(index_key));
+  }
+  EXPECT_GT(peak_depth, 0);
+
+  // remove odd keys, even keys stay reachable
+  for (int64_t key = 1; key < scale; key += 2) {
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(table.Remove(index_key));
+  }
+  index_key.SetFromInteger(1);
+  EXPECT_FALSE(table.Remove(index_key));
+  EXPECT_TRUE(table.VerifyIntegrity());
+
+  std::vector<RID> rids;
+  for (int64_t key = 0; key < scale; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(table.GetValue(index_key, rids), key % 2 == 0);
+  }
+
+  // once everything is gone every bucket is merged back into its directory
+  for (int64_t key = 0; key < scale; key += 2) {
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(table.Remove(index_key));
+  }
+  EXPECT_TRUE(table.VerifyIntegrity());
+  for (int64_t key = 0; key < scale; key++) {
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(table.GetGlobalDepth(index_key), 0);
+  }
+
+  // the table keeps working after shrinking
+  for (int64_t key = 0; key < scale; key++) {
+    rid.Set(0, key);
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(table.Insert(index_key, rid));
+  }
+  EXPECT_TRUE(table.VerifyIntegrity());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(DiskExtendibleHashTableTest, OverflowTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(page_id);
+
+  DiskExtendibleHashTable<GenericKey<8>, RID, GenericComparator<8>> table(
+      "foo_pk", bpm, comparator);
+  GenericKey<8> index_key;
+  RID rid;
+
+  // more keys than the buckets of directories at their max depth hold, the
+  // fullest buckets go on in overflow pages
+  const int64_t scale = 150000;
+  for (int64_t key = 0; key < scale; key++) {
+    rid.Set(0, key);
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(table.Insert(index_key, rid));
+  }
+  EXPECT_TRUE(table.VerifyIntegrity());
+  index_key.SetFromInteger(scale - 1);
+  EXPECT_FALSE(table.Insert(index_key, rid));
+
+  std::vector<RID> rids;
+  for (int64_t key = 0; key < scale; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(table.GetValue(index_key, rids));
+    EXPECT_EQ(rids.size(), 1);
+    EXPECT_EQ(rids[0].GetSlotNum(), key);
+  }
+
+  // emptied overflow pages are unlinked, the rest stays reachable
+  for (int64_t key = 1; key < scale; key += 2) {
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(table.Remove(index_key));
+  }
+  EXPECT_TRUE(table.VerifyIntegrity());
+  for (int64_t key = 0; key < scale; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(table.GetValue(index_key, rids), key % 2 == 0);
+  }
+  for (int64_t key = 0; key < scale; key += 2) {
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(table.Remove(index_key));
+  }
+  EXPECT_TRUE(table.VerifyIntegrity());
+  for (int64_t key = 0; key < scale; key += 97) {
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(table.GetGlobalDepth(index_key), 0);
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(DiskExtendibleHashTableTest, ConcurrentTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(page_id);
+
+  DiskExtendibleHashTable<GenericKey<8>, RID, GenericComparator<8>> table(
+      "foo_pk", bpm, comparator);
+
+  const int num_threads = 4;
+  const int64_t scale = 2000;
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.push_back(std::thread([&table, tid]() {
+      GenericKey<8> index_key;
+      RID rid;
+      for (int64_t key = tid; key < scale; key += num_threads) {
+        rid.Set(0, key);
+        index_key.SetFromInteger(key);
+        table.Insert(index_key, rid);
+      }
+    }));
+  }
+  for (auto &thread : threads)
+    thread.join();
+  EXPECT_TRUE(table.VerifyIntegrity());
+
+  // half of the threads remove what they inserted, the others look up
+  threads.clear();
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.push_back(std::thread([&table, tid]() {
+      GenericKey<8> index_key;
+      std::vector<RID> rids;
+      for (int64_t key = tid; key < scale; key += num_threads) {
+        index_key.SetFromInteger(key);
+        if (tid % 2 == 0) {
+          EXPECT_TRUE(table.Remove(index_key));
+        } else {
+          rids.clear();
+          EXPECT_TRUE(table.GetValue(index_key, rids));
+          EXPECT_EQ(rids.size(), 1);
+        }
+      }
+    }));
+  }
+  for (auto &thread : threads)
+    thread.join();
+  EXPECT_TRUE(table.VerifyIntegrity());
+
+  std::vector<RID> rids;
+  GenericKey<8> index_key;
+  for (int64_t key = 0; key < scale; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(table.GetValue(index_key, rids), key % num_threads % 2 == 1);
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+} // namespace scudb
@@ -2,6 +2,7 @@
  * extendible_hash_test.cpp
  */
 
+#include <map>
 #include <thread>
 #include <random>
 
@@ -10,10 +11,13 @@
 
 namespace scudb {
 
+// tests asserting an exact directory layout use IdentityHash, so that the
+// bucket of a key follows directly from its low bits
+
 TEST(ExtendibleHashTest, SampleTest) {
   // set leaf size as 2
-  ExtendibleHash<int, std::string> *test =
-          new ExtendibleHash<int, std::string>(2);
+  ExtendibleHash<int, std::string, IdentityHash<int>> *test =
+          new ExtendibleHash<int, std::string, IdentityHash<int>>(2);
 
   // insert several key/value pairs
   test->Insert(1, "a");
@@ -51,8 +55,8 @@ TEST(ExtendibleHashTest, SampleTest) {
 
 TEST(ExtendibleHashTest, SampleTest2) {
   // set leaf size as 2
-  ExtendibleHash<int, std::string> *test =
-          new ExtendibleHash<int, std::string>(2);
+  ExtendibleHash<int, std::string, IdentityHash<int>> *test =
+          new ExtendibleHash<int, std::string, IdentityHash<int>>(2);
 
   // insert several key/value pairs
   test->Insert(1, "a");
@@ -107,8 +111,8 @@ TEST(ExtendibleHashTest, SampleTest2) {
 // first split increase global depth from 0 to 3
 TEST(ExtendibleHashTest, BasicDepthTest) {
   // set leaf size as 2
-  ExtendibleHash<int, std::string> *test =
-          new ExtendibleHash<int, std::string>(2);
+  ExtendibleHash<int, std::string, IdentityHash<int>> *test =
+          new ExtendibleHash<int, std::string, IdentityHash<int>>(2);
 
   // insert several key/value pairs
   test->Insert(6, "a");   // b'0110
@@ -235,13 +239,136 @@ TEST(ExtendibleHashTest, RandomInsertAndDeleteTest) {
 }
 
 
+TEST(ExtendibleHashTest, MergeAndShrinkTest) {
+  // set leaf size as 2
+  ExtendibleHash<int, std::string, IdentityHash<int>> *test =
+          new ExtendibleHash<int, std::string, IdentityHash<int>>(2);
+
+  // same layout as BasicDepthTest
+  test->Insert(6, "a");   // b'0110
+  test->Insert(10, "b");  // b'1010
+  test->Insert(14, "c");  // b'1110
+  test->Insert(1, "d");
+  test->Insert(3, "e");
+  test->Insert(5, "f");
+  EXPECT_EQ(3, test->GetGlobalDepth());
+  EXPECT_EQ(5, test->GetNumBuckets());
+
+  // {10} merges into {6,14}, which then absorbs the empty bucket of slot 4;
+  // no bucket uses bit 2 any more so the directory is halved
+  EXPECT_EQ(1, test->Remove(10));
+  EXPECT_EQ(2, test->GetGlobalDepth());
+  EXPECT_EQ(3, test->GetNumBuckets());
+  EXPECT_EQ(1, test->GetLocalDepth(2));
+  EXPECT_EQ(2, test->GetLocalDepth(1));
+  EXPECT_EQ(2, test->GetLocalDepth(3));
+
+  // {3} merges into {1,5}; {6,14} and {1,5} are both non-empty and stay
+  EXPECT_EQ(1, test->Remove(3));
+  EXPECT_EQ(1, test->GetGlobalDepth());
+  EXPECT_EQ(2, test->GetNumBuckets());
+  EXPECT_EQ(1, test->GetLocalDepth(0));
+  EXPECT_EQ(1, test->GetLocalDepth(1));
+
+  // removing everything collapses the table back to a single bucket
+  EXPECT_EQ(1, test->Remove(6));
+  EXPECT_EQ(1, test->Remove(14));
+  EXPECT_EQ(1, test->Remove(1));
+  EXPECT_EQ(1, test->Remove(5));
+  EXPECT_EQ(0, test->GetGlobalDepth());
+  EXPECT_EQ(1, test->GetNumBuckets());
+
+  // and it keeps working afterwards
+  std::string result;
+  test->Insert(1, "d");
+  test->Insert(3, "e");
+  test->Insert(5, "f");
+  EXPECT_EQ(1, test->Find(5, result));
+  EXPECT_EQ("f", result);
+  EXPECT_EQ(0, test->Find(6, result));
+
+  delete test;
+}
+
+TEST(ExtendibleHashTest, ChurnShrinkTest) {
+  ExtendibleHash<int, int> *test = new ExtendibleHash<int, int>(10);
+
+  for (int round = 0; round < 5; round++) {
+    for (int i = 0; i < 10000; i++) {
+      test->Insert(i, i);
+    }
+    EXPECT_LE(10, test->GetGlobalDepth());
+    for (int i = 0; i < 10000; i++) {
+      EXPECT_EQ(1, test->Remove(i));
+    }
+    // directory returns to its initial size once the table is empty
+    EXPECT_EQ(0, test->GetGlobalDepth());
+    EXPECT_EQ(1, test->GetNumBuckets());
+  }
+
+  delete test;
+}
+
+// strided keys share their low bits: the identity hash has to grow the
+// directory past the stride before they separate, the default policy does not
+TEST(ExtendibleHashTest, DefaultHashStrideTest) {
+  ExtendibleHash<int, int> *mixed = new ExtendibleHash<int, int>(10);
+  ExtendibleHash<int, int, IdentityHash<int>> *identity =
+      new ExtendibleHash<int, int, IdentityHash<int>>(10);
+
+  for (int i = 0; i < 256; i++) {
+    mixed->Insert(i << 12, i);
+    identity->Insert(i << 12, i);
+  }
+  EXPECT_LE(12, identity->GetGlobalDepth());
+  EXPECT_GT(10, mixed->GetGlobalDepth());
+  for (int i = 0; i < 256; i++) {
+    int value;
+    EXPECT_EQ(1, mixed->Find(i << 12, value));
+    EXPECT_EQ(i, value);
+  }
+
+  // byte hash of strings only depends on their content
+  DefaultHash<std::string> hash;
+  EXPECT_EQ(hash(std::string("varchar key")), hash(std::string("varchar key")));
+  EXPECT_NE(hash(std::string("varchar key")), hash(std::string("varchar kez")));
+
+  delete mixed;
+  delete identity;
+}
+
+// buckets large enough to take the vectorized probe path, with removals
+// punching holes that are refilled from the end of the bucket
+TEST(ExtendibleHashTest, LargeBucketProbeTest) {
+  ExtendibleHash<int, int> *test = new ExtendibleHash<int, int>(BUCKET_SIZE);
+
+  for (int i = 0; i < 5000; i++) {
+    test->Insert(i, i * 2);
+  }
+  for (int i = 0; i < 5000; i += 3) {
+    EXPECT_EQ(1, test->Remove(i));
+  }
+  for (int i = 0; i < 5000; i++) {
+    int value = -1;
+    if (i % 3 == 0) {
+      EXPECT_EQ(0, test->Find(i, value));
+    } else {
+      EXPECT_EQ(1, test->Find(i, value));
+      EXPECT_EQ(i * 2, value);
+    }
+  }
+
+  delete test;
+}
+
 
 TEST(ExtendibleHashTest, ConcurrentInsertTest) {
   const int num_runs = 50;
   const int num_threads = 3;
   // Run concurrent test multiple times to guarantee correctness.
   for (int run = 0; run < num_runs; run++) {
-    std::shared_ptr<ExtendibleHash<int, int>> test{new ExtendibleHash<int, int>(2)};
+    std::shared_ptr<ExtendibleHash<int, int, IdentityHash<int>>> test{
+        new ExtendibleHash<int, int, IdentityHash<int>>(2)};
     std::vector<std::thread> threads;
     for (int tid = 0; tid < num_threads; tid++) {
       threads.push_back(std::thread([tid, &test]() {
@@ -264,7 +391,8 @@ TEST(ExtendibleHashTest, ConcurrentRemoveTest) {
   const int num_threads = 5;
   const int num_runs = 50;
   for (int run = 0; run < num_runs; run++) {
-    std::shared_ptr<ExtendibleHash<int, int>> test{new ExtendibleHash<int, int>(2)};
+    std::shared_ptr<ExtendibleHash<int, int, IdentityHash<int>>> test{
+        new ExtendibleHash<int, int, IdentityHash<int>>(2)};
     std::vector<std::thread> threads;
     std::vector<int> values{0, 10, 16, 32, 64};
     for (int value : values) {
@@ -281,7 +409,10 @@ TEST(ExtendibleHashTest, ConcurrentRemoveTest) {
     for (int i = 0; i < num_threads; i++) {
       threads[i].join();
     }
-    EXPECT_EQ(test->GetGlobalDepth(), 6);
+    // emptied buckets are merged back, how far the directory shrinks depends
+    // on how removes and inserts interleaved; {4,5,6,7,8} needs depth >= 2
+    EXPECT_LE(test->GetGlobalDepth(), 6);
+    EXPECT_GE(test->GetGlobalDepth(), 2);
     int val;
     EXPECT_EQ(0, test->Find(0, val));
     EXPECT_EQ(1, test->Find(8, val));
@@ -291,4 +422,4 @@ TEST(ExtendibleHashTest, ConcurrentRemoveTest) {
   }
 }
 
-} // namespace cmudb
\ No newline at end of file
+} // namespace cmudb
\ No newline at end of file
@@ -0,0 +1,134 @@
+/**
+ * adaptive_radix_tree_test.cpp
+ */
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "index/adaptive_radix_tree.h"
+#include "index/key_encoding.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+// varchar encoding of value, prefix free like every index key
+static std::string EncodeString(const std::string &value) {
+  char data[64];
+  KeyEncoder encoder(data, sizeof(data));
+  encoder.PutString(value.data(), value.size());
+  return std::string(data, encoder.Length());
+}
+
+static std::string EncodeInteger(int32_t value) {
+  char data[4];
+  KeyEncoder(data, sizeof(data)).PutSigned(value, 4);
+  return std::string(data, sizeof(data));
+}
+
+// scan of the tree against the same range of the map
+static void CheckScan(const AdaptiveRadixTree &tree,
+                      const std::map<std::string, RID> &expected,
+                      const std::string *low, const std::string *high,
+                      bool descending) {
+  std::vector<std::string> keys;
+  tree.Scan(low, high, descending, [&](const std::string &key, const RID &) {
+    keys.push_back(key);
+    return true;
+  });
+  std::vector<std::string> expected_keys;
+  for (auto &entry : expected)
+    if ((low == nullptr || entry.first >= *low) &&
+        (high == nullptr || entry.first <= *high))
+      expected_keys.push_back(entry.first);
+  if (descending)
+    std::reverse(expected_keys.begin(), expected_keys.end());
+  EXPECT_EQ(expected_keys, keys);
+}
+
+TEST(AdaptiveRadixTreeTest, InsertRemoveTest) {
+  AdaptiveRadixTree tree;
+  std::map<std::string, RID> expected;
+  std::mt19937 random(15445);
+  // short strings over few letters share long prefixes
+  for (int i = 0; i < 5000; i++) {
+    std::string value;
+    for (int j = random() % 8; j >= 0; j--)
+      value.push_back("abc\0"[random() % 4]);
+    std::string key = EncodeString(value);
+    RID rid(i, i);
+    bool inserted = expected.emplace(key, rid).second;
+    EXPECT_EQ(inserted, tree.Insert(key, rid));
+  }
+  EXPECT_EQ(expected.size(), tree.Size());
+  for (auto &entry : expected) {
+    RID rid;
+    EXPECT_TRUE(tree.GetValue(entry.first, rid));
+    EXPECT_EQ(entry.second, rid);
+  }
+  RID rid;
+  EXPECT_FALSE(tree.GetValue(EncodeString("abcabcabcabc"), rid));
+
+  // removing every other key shrinks the nodes and merges prefixes
+  int i = 0;
+  for (auto it = expected.begin(); it != expected.end(); i++) {
+    if (i % 2 == 0) {
+      EXPECT_TRUE(tree.Remove(it->first));
+      EXPECT_FALSE(tree.Remove(it->first));
+      it = expected.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  EXPECT_EQ(expected.size(), tree.Size());
+  for (auto &entry : expected) {
+    EXPECT_TRUE(tree.GetValue(entry.first, rid));
+    EXPECT_EQ(entry.second, rid);
+  }
+  CheckScan(tree, expected, nullptr, nullptr, false);
+
+  for (auto &entry : expected)
+    EXPECT_TRUE(tree.Remove(entry.first));
+  EXPECT_EQ(0u, tree.Size());
+  EXPECT_FALSE(tree.GetValue(expected.begin()->first, rid));
+}
+
+TEST(AdaptiveRadixTreeTest, ScanTest) {
+  AdaptiveRadixTree tree;
+  std::map<std::string, RID> expected;
+  std::mt19937 random(15445);
+  // dense integers fill nodes of 256 children, sparse ones smaller nodes
+  for (int32_t key = -3000; key < 3000; key++) {
+    if (key > 1000 && random() % 3 != 0)
+      continue;
+    std::string tree_key = EncodeInteger(key * 7);
+    expected.emplace(tree_key, RID(key, 0));
+    EXPECT_TRUE(tree.Insert(tree_key, RID(key, 0)));
+  }
+  CheckScan(tree, expected, nullptr, nullptr, false);
+  CheckScan(tree, expected, nullptr, nullptr, true);
+  for (int i = 0; i < 200; i++) {
+    std::string low = EncodeInteger((int32_t)(random() % 50000) - 25000);
+    std::string high = EncodeInteger((int32_t)(random() % 50000) - 25000);
+    bool descending = i % 2 == 1;
+    CheckScan(tree, expected, &low, &high, descending);
+    CheckScan(tree, expected, &low, nullptr, descending);
+    CheckScan(tree, expected, nullptr, &high, descending);
+  }
+  // bounds that end within a key
+  std::string low = EncodeInteger(700).substr(0, 3);
+  std::string high = EncodeInteger(7000).substr(0, 2);
+  CheckScan(tree, expected, &low, &high, false);
+  CheckScan(tree, expected, &low, &high, true);
+
+  // the callback stops the scan
+  int count = 0;
+  tree.Scan(nullptr, nullptr, false, [&](const std::string &, const RID &) {
+    return ++count < 10;
+  });
+  EXPECT_EQ(10, count);
+}
+
+} // namespace scudb
@@ -12,6 +12,7 @@
 #include "buffer/buffer_pool_manager.h"
 #include "common/logger.h"
 #include "index/b_plus_tree.h"
+#include "index/b_plus_tree_index.h"
 #include "vtable/virtual_table.h"
 #include "gtest/gtest.h"
 
@@ -348,4 +349,410 @@ TEST(BPlusTreeConcurrentTest, MixTest) {
   remove("test.log");
 }
 
+// helper function to scan the whole tree and check the keys are ascending
+void ScanHelper(BPlusTree<GenericKey<8>, RID, GenericComparator<8>> &tree,
+                int rounds, __attribute__((unused)) uint64_t thread_itr = 0) {
+  for (int i = 0; i < rounds; i++) {
+    int64_t last_key = 0;
+    for (auto iterator = tree.Begin(); iterator.isEnd() == false;
+         ++iterator) {
+      int64_t current_key = (*iterator).second.GetSlotNum();
+      EXPECT_LT(last_key, current_key);
+      last_key = current_key;
+    }
+  }
+}
+
+// same for a reverse scan, the keys have to be descending
+void ReverseScanHelper(
+    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> &tree, int rounds,
+    __attribute__((unused)) uint64_t thread_itr = 0) {
+  for (int i = 0; i < rounds; i++) {
+    int64_t last_key = INT64_MAX;
+    for (auto iterator = tree.RBegin(); iterator.isEnd() == false;
+         ++iterator) {
+      int64_t current_key = (*iterator).second.GetSlotNum();
+      EXPECT_GT(last_key, current_key);
+      last_key = current_key;
+    }
+  }
+}
+
+// point lookups of keys that stay in the tree the whole time
+void LookupHelper(BPlusTree<GenericKey<8>, RID, GenericComparator<8>> &tree,
+                  const std::vector<int64_t> &keys, int rounds,
+                  __attribute__((unused)) uint64_t thread_itr = 0) {
+  GenericKey<8> index_key;
+  std::vector<RID> rids;
+  for (int i = 0; i < rounds; i++) {
+    for (auto key : keys) {
+      rids.clear();
+      index_key.SetFromInteger(key);
+      EXPECT_EQ(true, tree.GetValue(index_key, rids));
+      EXPECT_EQ(key, rids.empty() ? -1 : rids[0].GetSlotNum());
+    }
+  }
+}
+
+TEST(BPlusTreeConcurrentTest, LookupDuringSplitTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // create b+ tree
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
+                                                           comparator);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+
+  // readers look up the even keys while the odd keys around them are
+  // inserted and removed again, every lookup races with splits and merges of
+  // its leaf and has to find its key by moving right or starting over
+  int64_t scale = 3000;
+  std::vector<int64_t> stable_keys, keys;
+  for (int64_t key = 1; key <= scale; key++) {
+    if (key % 2 == 0)
+      stable_keys.push_back(key);
+    else
+      keys.push_back(key);
+  }
+  InsertHelper(tree, stable_keys);
+  std::thread reader(LookupHelper, std::ref(tree), stable_keys, 10, 0);
+  std::thread reverse_scanner(ReverseScanHelper, std::ref(tree), 10, 0);
+  LaunchParallelTest(4, InsertHelperSplit, std::ref(tree), keys, 4);
+  LaunchParallelTest(4, DeleteHelperSplit, std::ref(tree), keys, 4);
+  reader.join();
+  reverse_scanner.join();
+
+  int64_t size = 0;
+  for (auto iterator = tree.Begin(); iterator.isEnd() == false; ++iterator) {
+    size = size + 1;
+    EXPECT_EQ((*iterator).second.GetSlotNum(), 2 * size);
+  }
+  EXPECT_EQ(size, scale / 2);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeConcurrentTest, BloomFilterTest) {
+  Schema *schema = ParseCreateStatement("a bigint");
+  std::string sql = "foo_pk a bloom";
+  IndexMetadata *metadata = ParseIndexStatement(sql, "foo", schema);
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(page_id);
+  BPlusTreeIndex<GenericKey<8>, RID, GenericComparator<8>> index(metadata,
+                                                                 bpm);
+  Schema *key_schema = metadata->GetKeySchema();
+  auto key = [&](int64_t value) {
+    return Tuple(std::vector<Value>{Value(TypeId::BIGINT, value)},
+                 key_schema);
+  };
+
+  // every thread looks up a key it inserted before after each insert, so
+  // the growing filter is rebuilt while other threads insert. No key in the
+  // tree may be filtered out
+  int64_t scale = 4000;
+  auto insert_and_lookup = [&](uint64_t thread_itr) {
+    std::vector<RID> rids;
+    for (int64_t k = thread_itr; k < scale; k += 4) {
+      index.InsertEntry(key(k), RID(0, (uint32_t)k));
+      int64_t probe = k - 4 * (k / 8);
+      rids.clear();
+      index.ScanKey(key(probe), rids);
+      EXPECT_EQ(1, rids.size()) << "key " << probe;
+    }
+  };
+  LaunchParallelTest(4, insert_and_lookup);
+  std::vector<RID> rids;
+  for (int64_t k = 0; k < scale; k++)
+    index.ScanKey(key(k), rids);
+  EXPECT_EQ(scale, rids.size());
+  EXPECT_EQ(0, index.GetLookupStats().filtered);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeConcurrentTest, AdaptiveHashTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // create b+ tree
+  BPlusTreeOptions options;
+  options.adaptive_hash = true;
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree(
+      "foo_pk", bpm, comparator, INVALID_PAGE_ID, options);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+
+  // readers keep looking up a few hundred hot keys from the adaptive hash
+  // while their leaves split, merge and are deleted under them
+  int64_t scale = 3000;
+  std::vector<int64_t> stable_keys, hot_keys, keys;
+  for (int64_t key = 1; key <= scale; key++) {
+    if (key % 2 == 0)
+      stable_keys.push_back(key);
+    else
+      keys.push_back(key);
+  }
+  for (int64_t key = 2; key <= scale; key += 10)
+    hot_keys.push_back(key);
+  InsertHelper(tree, stable_keys);
+  std::thread reader(LookupHelper, std::ref(tree), hot_keys, 50, 0);
+  std::thread other_reader(LookupHelper, std::ref(tree), hot_keys, 50, 1);
+  for (int round = 0; round < 2; round++) {
+    LaunchParallelTest(4, InsertHelperSplit, std::ref(tree), keys, 4);
+    LaunchParallelTest(4, DeleteHelperSplit, std::ref(tree), keys, 4);
+  }
+  reader.join();
+  other_reader.join();
+  LookupHelper(tree, stable_keys, 1);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeConcurrentTest, WriteBufferTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // create b+ tree
+  BPlusTreeOptions options;
+  options.write_buffer = true;
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree(
+      "foo_pk", bpm, comparator, INVALID_PAGE_ID, options);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+
+  // readers look up keys while writers buffer inserts and removes and flush
+  // them down
+  int64_t scale = 2 * WRITE_BUFFER_SIZE;
+  std::vector<int64_t> stable_keys, keys;
+  for (int64_t key = 1; key <= scale; key++) {
+    if (key % 2 == 0)
+      stable_keys.push_back(key);
+    else
+      keys.push_back(key);
+  }
+  InsertHelper(tree, stable_keys);
+  std::thread reader(LookupHelper, std::ref(tree), stable_keys, 3, 0);
+  std::thread scanner(ScanHelper, std::ref(tree), 3, 0);
+  for (int round = 0; round < 2; round++) {
+    LaunchParallelTest(4, InsertHelperSplit, std::ref(tree), keys, 4);
+    LaunchParallelTest(4, DeleteHelperSplit, std::ref(tree), keys, 4);
+  }
+  reader.join();
+  scanner.join();
+  LookupHelper(tree, stable_keys, 1);
+  int64_t size = 0;
+  for (auto iterator = tree.Begin(); !iterator.isEnd(); ++iterator)
+    size++;
+  EXPECT_EQ((int64_t)stable_keys.size(), size);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeConcurrentTest, SwizzlingTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  // a pool smaller than the tree, swizzled children get evicted
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // create b+ tree
+  BPlusTreeOptions options;
+  options.swizzling = true;
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree(
+      "foo_pk", bpm, comparator, INVALID_PAGE_ID, options);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+
+  // readers descend through swizzled children while writers split and merge
+  // the pages they point to
+  int64_t scale = 4000;
+  std::vector<int64_t> stable_keys, keys;
+  for (int64_t key = 1; key <= scale; key++) {
+    if (key % 2 == 0)
+      stable_keys.push_back(key);
+    else
+      keys.push_back(key);
+  }
+  InsertHelper(tree, stable_keys);
+  std::thread reader(LookupHelper, std::ref(tree), stable_keys, 3, 0);
+  std::thread scanner(ScanHelper, std::ref(tree), 3, 0);
+  for (int round = 0; round < 2; round++) {
+    LaunchParallelTest(4, InsertHelperSplit, std::ref(tree), keys, 4);
+    LaunchParallelTest(4, DeleteHelperSplit, std::ref(tree), keys, 4);
+  }
+  reader.join();
+  scanner.join();
+  LookupHelper(tree, stable_keys, 1);
+  int64_t size = 0;
+  for (auto iterator = tree.Begin(); !iterator.isEnd(); ++iterator)
+    size++;
+  EXPECT_EQ((int64_t)stable_keys.size(), size);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeConcurrentTest, DeferredMergeTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+  {
+    // the compaction thread stops with the tree, before the pool goes
+    BPlusTreeOptions options;
+    options.deferred_merge = true;
+    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree(
+        "foo_pk", bpm, comparator, INVALID_PAGE_ID, options);
+    // writers drain and refill leaves while the compaction thread merges the
+    // underfull ones and readers look up keys that stay
+    int64_t scale = 8000;
+    std::vector<int64_t> stable_keys, keys;
+    for (int64_t key = 1; key <= scale; key++) {
+      if (key % 4 == 0)
+        stable_keys.push_back(key);
+      else
+        keys.push_back(key);
+    }
+    InsertHelper(tree, stable_keys);
+    std::thread reader(LookupHelper, std::ref(tree), stable_keys, 3, 0);
+    std::thread scanner(ScanHelper, std::ref(tree), 3, 0);
+    for (int round = 0; round < 3; round++) {
+      LaunchParallelTest(4, InsertHelperSplit, std::ref(tree), keys, 4);
+      LaunchParallelTest(4, DeleteHelperSplit, std::ref(tree), keys, 4);
+    }
+    reader.join();
+    scanner.join();
+    tree.Compact();
+    LookupHelper(tree, stable_keys, 1);
+    int64_t size = 0;
+    for (auto iterator = tree.Begin(); !iterator.isEnd(); ++iterator)
+      size++;
+    EXPECT_EQ((int64_t)stable_keys.size(), size);
+    // no leaf is left below a quarter of the page
+    BPlusTreeShape shape = tree.GetShape();
+    EXPECT_GT(shape.entries, 4 * shape.leaf_pages);
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeConcurrentTest, ScaleMixTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // create b+ tree
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
+                                                           comparator);
+  GenericKey<8> index_key;
+  std::vector<RID> rids;
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+
+  // insert and remove split across threads while two threads scan forward
+  // and backward, so splits, merges and redistributions race with each other
+  // and with scans
+  int64_t scale = 2000;
+  std::vector<int64_t> keys, remove_keys;
+  for (int64_t key = 1; key <= scale; key++) {
+    keys.push_back(key);
+    if (key % 2 == 1)
+      remove_keys.push_back(key);
+  }
+  std::thread scanner(ScanHelper, std::ref(tree), 20, 0);
+  std::thread reverse_scanner(ReverseScanHelper, std::ref(tree), 20, 0);
+  LaunchParallelTest(4, InsertHelperSplit, std::ref(tree), keys, 4);
+  LaunchParallelTest(4, DeleteHelperSplit, std::ref(tree), remove_keys, 4);
+  scanner.join();
+  reverse_scanner.join();
+
+  for (int64_t key = 1; key <= scale; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(tree.GetValue(index_key, rids), key % 2 == 0);
+  }
+  int64_t size = 0;
+  for (auto iterator = tree.Begin(); iterator.isEnd() == false; ++iterator) {
+    size = size + 1;
+    EXPECT_EQ((*iterator).second.GetSlotNum(), 2 * size);
+  }
+  EXPECT_EQ(size, scale / 2);
+  for (auto iterator = tree.RBegin(); iterator.isEnd() == false; ++iterator) {
+    EXPECT_EQ((*iterator).second.GetSlotNum(), 2 * size);
+    size = size - 1;
+  }
+  EXPECT_EQ(size, 0);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
 } // namespace scudb
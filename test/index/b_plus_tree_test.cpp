@@ -5,11 +5,14 @@
 #include <algorithm>
 #include <cstdio>
 #include <iostream>
+#include <random>
+#include <set>
 #include <sstream>
 
 #include "buffer/buffer_pool_manager.h"
 #include "common/logger.h"
 #include "index/b_plus_tree.h"
+#include "index/b_plus_tree_index.h"
 #include "vtable/virtual_table.h"
 #include "gtest/gtest.h"
 
@@ -390,4 +393,1027 @@ TEST(BPlusTreeTests, ScaleTest) {
   remove("test.db");
   remove("test.log");
 }
+
+TEST(BPlusTreeTests, BulkLoadTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(30, disk_manager);
+  // create b+ tree
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
+                                                           comparator);
+  GenericKey<8> index_key;
+  RID rid;
+  // create transaction
+  Transaction *transaction = new Transaction(0);
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+
+  // bulk load the even keys, leaving room in every node
+  int64_t scale = 5000;
+  std::vector<std::pair<GenericKey<8>, RID>> items;
+  for (int64_t key = 2; key <= scale; key += 2) {
+    index_key.SetFromInteger(key);
+    rid.Set(0, key);
+    items.emplace_back(index_key, rid);
+  }
+  std::swap(items[0], items[1]);
+  EXPECT_EQ(false, tree.BulkLoad(items, 0.7));
+  EXPECT_EQ(true, tree.IsEmpty());
+  std::swap(items[0], items[1]);
+  EXPECT_EQ(true, tree.BulkLoad(items, 0.7));
+  EXPECT_EQ(false, tree.BulkLoad(items, 0.7));
+
+  std::vector<RID> rids;
+  for (int64_t key = 1; key <= scale; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(key % 2 == 0, tree.GetValue(index_key, rids));
+  }
+  int64_t current_key = 0;
+  for (auto iterator = tree.Begin(); iterator.isEnd() == false; ++iterator) {
+    current_key = current_key + 2;
+    EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+  }
+  EXPECT_EQ(current_key, scale);
+
+  // inserts and removes split and merge the bulk loaded nodes
+  for (int64_t key = 1; key <= scale; key += 2) {
+    index_key.SetFromInteger(key);
+    rid.Set(0, key);
+    EXPECT_EQ(true, tree.Insert(index_key, rid, transaction));
+  }
+  for (int64_t key = 1; key <= scale - 100; key++) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key, transaction);
+  }
+  current_key = scale - 100;
+  for (auto iterator = tree.Begin(); iterator.isEnd() == false; ++iterator) {
+    current_key = current_key + 1;
+    EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+  }
+  EXPECT_EQ(current_key, scale);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, IntegerKeyTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  IntegerComparator<int64_t> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // create b+ tree
+  BPlusTree<IntegerKey<int64_t>, RID, IntegerComparator<int64_t>> tree(
+      "foo_pk", bpm, comparator);
+  IntegerKey<int64_t> index_key;
+  RID rid;
+  // create transaction
+  Transaction *transaction = new Transaction(0);
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+
+  // negative keys have to sort before positive ones
+  std::vector<int64_t> keys;
+  for (int64_t key = -1000; key < 1000; key++)
+    keys.push_back(key);
+  std::random_shuffle(keys.begin(), keys.end());
+  for (auto key : keys) {
+    rid.Set(0, (uint32_t)(key + 1000));
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(true, tree.Insert(index_key, rid, transaction));
+  }
+  EXPECT_EQ(false, tree.Insert(index_key, rid, transaction));
+
+  std::vector<RID> rids;
+  index_key.SetFromInteger(-7);
+  EXPECT_EQ(true, tree.GetValue(index_key, rids));
+  EXPECT_EQ(rids[0].GetSlotNum(), 993);
+
+  int64_t current_key = -10;
+  index_key.SetFromInteger(current_key);
+  for (auto iterator = tree.Begin(index_key); iterator.isEnd() == false;
+       ++iterator) {
+    EXPECT_EQ((*iterator).first.ToString(), current_key);
+    current_key = current_key + 1;
+  }
+  EXPECT_EQ(current_key, 1000);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete key_schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, VarcharKeyTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a varchar(64)");
+  GenericComparator<64> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // create b+ tree
+  BPlusTree<GenericKey<64>, RID, GenericComparator<64>> tree("foo_pk", bpm,
+                                                             comparator);
+  GenericKey<64> index_key;
+  RID rid;
+  // create transaction
+  Transaction *transaction = new Transaction(0);
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+
+  // long keys sharing most of their bytes, zero padded numbers keep the
+  // string order equal to the numeric order
+  int64_t scale = 3000;
+  auto set_key = [&](int64_t key) {
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "customer/region-eu/account-%06lld/main",
+             (long long)key);
+    std::vector<Value> values{Value(TypeId::VARCHAR, std::string(buffer))};
+    index_key.SetFromKey(Tuple(values, key_schema), key_schema);
+  };
+  std::vector<int64_t> keys;
+  for (int64_t key = 0; key < scale; key++)
+    keys.push_back(key);
+  std::random_shuffle(keys.begin(), keys.end());
+  for (auto key : keys) {
+    rid.Set(0, (uint32_t)key);
+    set_key(key);
+    EXPECT_EQ(true, tree.Insert(index_key, rid, transaction));
+  }
+
+  // only the suffixes are stored, a leaf holds many more than the
+  // PAGE_SIZE / sizeof(GenericKey<64>) pairs of full width keys
+  BPlusTreeShape shape = tree.GetShape();
+  EXPECT_EQ(shape.entries, scale);
+  EXPECT_GT(shape.entries, 8 * shape.leaf_pages);
+  EXPECT_LE(shape.height, 3);
+
+  int64_t current_key = 0;
+  for (auto iterator = tree.Begin(); iterator.isEnd() == false; ++iterator) {
+    EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+    current_key = current_key + 1;
+  }
+  EXPECT_EQ(current_key, scale);
+
+  for (int64_t key = 0; key < scale; key += 2) {
+    set_key(key);
+    tree.Remove(index_key, transaction);
+  }
+  std::vector<RID> rids;
+  for (int64_t key = 0; key < scale; key++) {
+    rids.clear();
+    set_key(key);
+    EXPECT_EQ(key % 2 == 1, tree.GetValue(index_key, rids));
+  }
+  EXPECT_EQ(tree.GetShape().entries, scale / 2);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete key_schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, RangeScanTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  IntegerComparator<int64_t> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // create b+ tree
+  BPlusTree<IntegerKey<int64_t>, RID, IntegerComparator<int64_t>> tree(
+      "foo_pk", bpm, comparator);
+  IntegerKey<int64_t> index_key, end_key;
+  RID rid;
+  // create transaction
+  Transaction *transaction = new Transaction(0);
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+
+  // even keys only, so range bounds fall both on and between keys
+  std::vector<int64_t> keys;
+  for (int64_t key = 0; key < 4000; key += 2)
+    keys.push_back(key);
+  std::random_shuffle(keys.begin(), keys.end());
+  for (auto key : keys) {
+    rid.Set(0, (uint32_t)key);
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(true, tree.Insert(index_key, rid, transaction));
+  }
+
+  // ranges ending inside a leaf, on a leaf boundary and past the last key
+  for (int64_t low = -3; low < 4000; low += 97) {
+    for (int64_t length : {0, 1, 2, 7, 100, 1000, 5000}) {
+      int64_t high = low + length;
+      index_key.SetFromInteger(low);
+      end_key.SetFromInteger(high);
+      int64_t first_key = std::max<int64_t>(0, low + (low & 1));
+      int64_t last_key = first_key;
+      while (last_key <= high && last_key < 4000)
+        last_key += 2;
+      int64_t current_key = first_key;
+      for (auto iterator = tree.Begin(index_key, end_key);
+           iterator.isEnd() == false; ++iterator) {
+        EXPECT_EQ((*iterator).first.ToString(), current_key);
+        EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+        current_key = current_key + 2;
+      }
+      EXPECT_EQ(current_key, last_key);
+    }
+  }
+
+  // an end key below the start key is an empty range
+  index_key.SetFromInteger(100);
+  end_key.SetFromInteger(50);
+  EXPECT_EQ(true, tree.Begin(index_key, end_key).isEnd());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete key_schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, ReverseScanTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  IntegerComparator<int64_t> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // create b+ tree
+  BPlusTree<IntegerKey<int64_t>, RID, IntegerComparator<int64_t>> tree(
+      "foo_pk", bpm, comparator);
+  IntegerKey<int64_t> index_key, end_key;
+  RID rid;
+  // create transaction
+  Transaction *transaction = new Transaction(0);
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+
+  std::vector<int64_t> keys;
+  for (int64_t key = 0; key < 4000; key++)
+    keys.push_back(key);
+  std::random_shuffle(keys.begin(), keys.end());
+  for (auto key : keys) {
+    rid.Set(0, (uint32_t)key);
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(true, tree.Insert(index_key, rid, transaction));
+  }
+  // splits and merges both have to keep the prev links
+  std::set<int64_t> live(keys.begin(), keys.end());
+  for (auto key : keys) {
+    if (key % 2 == 1 || (key > 1000 && key < 3000)) {
+      index_key.SetFromInteger(key);
+      tree.Remove(index_key, transaction);
+      live.erase(key);
+    }
+  }
+
+  auto expected = live.rbegin();
+  for (auto iterator = tree.RBegin(); iterator.isEnd() == false;
+       ++iterator, ++expected) {
+    ASSERT_TRUE(expected != live.rend());
+    EXPECT_EQ((*iterator).first.ToString(), *expected);
+    EXPECT_EQ((*iterator).second.GetSlotNum(), *expected);
+  }
+  EXPECT_TRUE(expected == live.rend());
+
+  // start on, between and past keys, end inside and past the tree
+  for (int64_t high = -1; high < 4100; high += 211) {
+    for (int64_t length : {0, 1, 3, 50, 500, 5000}) {
+      int64_t low = high - length;
+      index_key.SetFromInteger(high);
+      end_key.SetFromInteger(low);
+      std::vector<int64_t> range, all;
+      for (auto it = live.rbegin(); it != live.rend(); ++it) {
+        if (*it <= high)
+          all.push_back(*it);
+        if (*it <= high && *it >= low)
+          range.push_back(*it);
+      }
+      std::vector<int64_t> scanned;
+      for (auto iterator = tree.RBegin(index_key, end_key);
+           iterator.isEnd() == false; ++iterator)
+        scanned.push_back((*iterator).first.ToString());
+      EXPECT_EQ(range, scanned);
+      scanned.clear();
+      for (auto iterator = tree.RBegin(index_key); iterator.isEnd() == false;
+           ++iterator)
+        scanned.push_back((*iterator).first.ToString());
+      EXPECT_EQ(all, scanned);
+    }
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete key_schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, BatchLookupTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  IntegerComparator<int64_t> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(10, disk_manager);
+  // create b+ tree
+  BPlusTree<IntegerKey<int64_t>, RID, IntegerComparator<int64_t>> tree(
+      "foo_pk", bpm, comparator);
+  IntegerKey<int64_t> index_key;
+  RID rid;
+  std::vector<RID> result;
+  // create transaction
+  Transaction *transaction = new Transaction(0);
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+
+  std::vector<IntegerKey<int64_t>> probes(3);
+  EXPECT_EQ(0u, tree.GetValues(probes, result));
+
+  // even keys only, odd probes miss
+  std::vector<int64_t> keys;
+  for (int64_t key = 0; key < 4000; key += 2)
+    keys.push_back(key);
+  std::random_shuffle(keys.begin(), keys.end());
+  for (auto key : keys) {
+    rid.Set(0, (uint32_t)key);
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(true, tree.Insert(index_key, rid, transaction));
+  }
+
+  // unsorted probes with misses, duplicates and keys outside the tree
+  std::vector<int64_t> probe_keys;
+  for (int64_t key = -10; key < 4010; key += 3)
+    probe_keys.push_back(key);
+  probe_keys.push_back(1000);
+  std::random_shuffle(probe_keys.begin(), probe_keys.end());
+  probes.clear();
+  std::vector<int64_t> expected;
+  for (auto key : probe_keys) {
+    index_key.SetFromInteger(key);
+    probes.push_back(index_key);
+    if (key >= 0 && key < 4000 && key % 2 == 0)
+      expected.push_back(key);
+  }
+  std::sort(expected.begin(), expected.end());
+  EXPECT_EQ(expected.size(), tree.GetValues(probes, result));
+  std::vector<int64_t> found;
+  for (auto &value : result)
+    found.push_back(value.GetSlotNum());
+  EXPECT_EQ(expected, found);
+
+  // ranges inside a leaf, across many leaves and overlapping each other
+  std::vector<std::pair<IntegerKey<int64_t>, IntegerKey<int64_t>>> ranges;
+  std::vector<std::pair<int64_t, int64_t>> bounds = {
+      {3001, 3001}, {-5, 3}, {2500, 2200}, {101, 1300}, {990, 1010},
+      {3990, 5000}, {400, 410}};
+  for (auto &bound : bounds) {
+    IntegerKey<int64_t> low, high;
+    low.SetFromInteger(bound.first);
+    high.SetFromInteger(bound.second);
+    ranges.emplace_back(low, high);
+  }
+  std::sort(bounds.begin(), bounds.end());
+  expected.clear();
+  for (auto &bound : bounds) {
+    for (int64_t key = bound.first; key <= bound.second; key++) {
+      if (key >= 0 && key < 4000 && key % 2 == 0)
+        expected.push_back(key);
+    }
+  }
+  result.clear();
+  EXPECT_EQ(expected.size(), tree.GetRanges(ranges, result));
+  found.clear();
+  for (auto &value : result)
+    found.push_back(value.GetSlotNum());
+  EXPECT_EQ(expected, found);
+
+  // every page is unlatched and unpinned again
+  for (auto key : keys) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key, transaction);
+  }
+  EXPECT_EQ(true, tree.IsEmpty());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete key_schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, AppendInsertTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  IntegerComparator<int64_t> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // create b+ trees
+  BPlusTree<IntegerKey<int64_t>, RID, IntegerComparator<int64_t>> ascending(
+      "foo_pk", bpm, comparator);
+  BPlusTree<IntegerKey<int64_t>, RID, IntegerComparator<int64_t>> descending(
+      "bar_pk", bpm, comparator);
+  IntegerKey<int64_t> index_key;
+  RID rid;
+  // create transaction
+  Transaction *transaction = new Transaction(0);
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+
+  int64_t scale = 4000;
+  for (int64_t key = 0; key < scale; key++) {
+    rid.Set(0, (uint32_t)key);
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(true, ascending.Insert(index_key, rid, transaction));
+    index_key.SetFromInteger(scale - 1 - key);
+    EXPECT_EQ(true, descending.Insert(index_key, rid, transaction));
+  }
+  // appending again at the end is still a duplicate
+  index_key.SetFromInteger(scale - 1);
+  EXPECT_EQ(false, ascending.Insert(index_key, rid, transaction));
+
+  // splits at the right edge leave the left leaf mostly full, the ones at
+  // the left edge split in halves
+  BPlusTreeShape shape = ascending.GetShape();
+  EXPECT_EQ(shape.entries, scale);
+  EXPECT_LT(10 * shape.leaf_pages, 7 * descending.GetShape().leaf_pages);
+
+  // inserts in between and removes that merge the last leaf away, appends
+  // after them descend again
+  for (int64_t key = scale - 200; key < scale; key++) {
+    index_key.SetFromInteger(key);
+    ascending.Remove(index_key, transaction);
+  }
+  index_key.SetFromInteger(scale / 2);
+  EXPECT_EQ(false, ascending.Insert(index_key, rid, transaction));
+  for (int64_t key = scale - 200; key < 2 * scale; key++) {
+    rid.Set(0, (uint32_t)key);
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(true, ascending.Insert(index_key, rid, transaction));
+  }
+  int64_t current_key = 0;
+  for (auto iterator = ascending.Begin(); iterator.isEnd() == false;
+       ++iterator) {
+    EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+    current_key = current_key + 1;
+  }
+  EXPECT_EQ(current_key, 2 * scale);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete key_schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, AdaptiveHashTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  // a key is hot after two searches, a search that reached another leaf
+  // moves it there
+  AdaptiveHashIndex<GenericKey<8>, GenericComparator<8>> hash(64, comparator);
+  GenericKey<8> index_key;
+  page_id_t page_id;
+  lsn_t version;
+  index_key.SetFromInteger(7);
+  hash.Record(index_key, 3, 1);
+  EXPECT_EQ(false, hash.Lookup(index_key, page_id, version));
+  hash.Record(index_key, 3, 1);
+  EXPECT_EQ(true, hash.Lookup(index_key, page_id, version));
+  EXPECT_EQ(3, page_id);
+  EXPECT_EQ(1, version);
+  EXPECT_EQ(false, hash.Validate(index_key, 3, 2));
+  hash.Record(index_key, 5, 4);
+  EXPECT_EQ(true, hash.Lookup(index_key, page_id, version));
+  EXPECT_EQ(5, page_id);
+  EXPECT_EQ(4, version);
+  EXPECT_EQ(false, hash.Validate(index_key, 3, 1));
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // create b+ tree
+  BPlusTreeOptions options;
+  options.adaptive_hash = true;
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree(
+      "foo_pk", bpm, comparator, INVALID_PAGE_ID, options);
+  RID rid;
+  // create transaction
+  Transaction *transaction = new Transaction(0);
+  // create and fetch header_page
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+
+  int64_t scale = 2000;
+  for (int64_t key = 0; key < scale; key++) {
+    rid.Set(0, (uint32_t)key);
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid, transaction);
+  }
+  // make the first keys hot, then split, merge and redistribute their leaves
+  std::vector<RID> rids;
+  for (int round = 0; round < 3; round++) {
+    for (int64_t key = 0; key < 200; key++) {
+      rids.clear();
+      index_key.SetFromInteger(key);
+      EXPECT_EQ(true, tree.GetValue(index_key, rids));
+      EXPECT_EQ(key, rids[0].GetSlotNum());
+    }
+  }
+  for (int64_t key = 0; key < scale; key++) {
+    if (key % 3 != 0) {
+      index_key.SetFromInteger(key);
+      tree.Remove(index_key, transaction);
+    }
+  }
+  for (int64_t key = scale; key < scale + 100; key++) {
+    rid.Set(0, (uint32_t)key);
+    index_key.SetFromInteger(key % 200);
+    tree.Insert(index_key, rid, transaction);
+  }
+  for (int round = 0; round < 3; round++) {
+    for (int64_t key = 0; key < 200; key++) {
+      rids.clear();
+      index_key.SetFromInteger(key);
+      bool present = key % 3 == 0 || key < 100;
+      EXPECT_EQ(present, tree.GetValue(index_key, rids));
+      if (present) {
+        EXPECT_EQ(key % 3 == 0 ? key : key + scale, rids[0].GetSlotNum());
+      }
+    }
+  }
+  // the tree emptied and started again
+  for (int64_t key = 0; key < scale + 200; key++) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key, transaction);
+  }
+  index_key.SetFromInteger(0);
+  EXPECT_EQ(false, tree.GetValue(index_key, rids));
+  rid.Set(0, 1);
+  tree.Insert(index_key, rid, transaction);
+  rids.clear();
+  EXPECT_EQ(true, tree.GetValue(index_key, rids));
+  EXPECT_EQ(1, rids[0].GetSlotNum());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete key_schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, BloomFilterTest) {
+  Schema *schema = ParseCreateStatement("a bigint, b varchar(8)");
+  std::string sql = "foo_idx b nonunique bloom";
+  IndexMetadata *metadata = ParseIndexStatement(sql, "foo", schema);
+  EXPECT_EQ(false, metadata->IsUnique());
+  EXPECT_EQ(true, metadata->HasBloomFilter());
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+  BPlusTreeIndex<GenericKey<32>, RID, GenericComparator<32>> index(metadata,
+                                                                   bpm);
+  Schema *key_schema = metadata->GetKeySchema();
+  auto key = [&](const std::string &value) {
+    return Tuple(std::vector<Value>{Value(TypeId::VARCHAR, value)},
+                 key_schema);
+  };
+
+  // two entries for every key, the filter grows past its first size
+  int scale = 1000;
+  for (int i = 0; i < 2 * scale; i++)
+    index.InsertEntry(key("k" + std::to_string(i % scale)), RID(0, i));
+  std::vector<RID> rids;
+  for (int i = 0; i < scale; i++) {
+    rids.clear();
+    index.ScanKey(key("k" + std::to_string(i)), rids);
+    EXPECT_EQ(2, rids.size());
+  }
+  for (int i = 0; i < scale; i++) {
+    rids.clear();
+    index.ScanKey(key("x" + std::to_string(i)), rids);
+    EXPECT_EQ(0, rids.size());
+  }
+  IndexLookupStats stats = index.GetLookupStats();
+  EXPECT_EQ(2 * scale, stats.lookups);
+  EXPECT_EQ(scale, stats.misses);
+  EXPECT_LT(stats.FalsePositiveRate(), 0.05);
+  EXPECT_GT(stats.MeanLatencyMicros(), 0);
+
+  // deleted keys stay in the filter until deletes make it stale, the next
+  // lookup rebuilds it without them
+  for (int i = 0; i < 2 * scale; i++) {
+    if (i % scale < scale / 2)
+      index.DeleteEntry(key("k" + std::to_string(i % scale)), RID(0, i));
+  }
+  for (int i = 0; i < scale; i++) {
+    rids.clear();
+    index.ScanKey(key("k" + std::to_string(i)), rids);
+    EXPECT_EQ(i < scale / 2 ? 0 : 2, rids.size());
+  }
+  IndexLookupStats rebuilt = index.GetLookupStats();
+  EXPECT_EQ(scale + scale / 2, rebuilt.misses);
+  EXPECT_GT(rebuilt.filtered - stats.filtered, scale / 2 * 9 / 10);
+
+  // keys come back into the filter with their entries, batches are filtered
+  // too
+  index.InsertEntry(key("k0"), RID(1, 0));
+  std::vector<Tuple> keys{key("k0"), key("k1"), key("k999"), key("x1")};
+  rids.clear();
+  index.ScanKeys(keys, rids);
+  EXPECT_EQ(3, rids.size());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, LongKeyTest) {
+  Schema *schema = ParseCreateStatement("a bigint, b varchar");
+  std::string sql = "foo_idx b nonunique";
+  IndexMetadata *metadata = ParseIndexStatement(sql, "foo", schema);
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(page_id);
+  // room for a varchar of 5 characters and the rid
+  BPlusTreeIndex<GenericKey<16>, RID, GenericComparator<16>> index(metadata,
+                                                                   bpm);
+  Schema *key_schema = metadata->GetKeySchema();
+  auto key = [&](const std::string &value) {
+    return Tuple(std::vector<Value>{Value(TypeId::VARCHAR, value)},
+                 key_schema);
+  };
+
+  // longer keys would lose their rid and the entries of two tuples clash
+  EXPECT_TRUE(index.InsertEntry(key("short"), RID(0, 1)));
+  EXPECT_FALSE(index.InsertEntry(key("longer key"), RID(0, 2)));
+  EXPECT_FALSE(index.InsertEntry(key("longer key"), RID(0, 3)));
+  EXPECT_FALSE(index.InsertEntries({{key("longer key"), RID(0, 4)},
+                                    {key("short"), RID(0, 5)}}));
+  index.DeleteEntry(key("longer key"), RID(0, 2));
+  std::vector<RID> rids;
+  index.ScanKey(key("short"), rids);
+  EXPECT_EQ(2, rids.size());
+  rids.clear();
+  index.ScanKey(key("longer key"), rids);
+  EXPECT_EQ(0, rids.size());
+  rids.clear();
+  index.ScanRange(nullptr, nullptr, false, rids);
+  EXPECT_EQ(2, rids.size());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, WriteBufferTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  // a pool far smaller than the tree
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(20, disk_manager);
+  // create b+ tree
+  BPlusTreeOptions options;
+  options.write_buffer = true;
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree(
+      "foo_pk", bpm, comparator, INVALID_PAGE_ID, options);
+  GenericKey<8> index_key;
+  RID rid;
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+
+  int64_t scale = 3 * WRITE_BUFFER_SIZE;
+  std::vector<int64_t> keys;
+  for (int64_t key = 0; key < scale; key++)
+    keys.push_back(key);
+  std::shuffle(keys.begin(), keys.end(), std::default_random_engine(0));
+  for (auto key : keys) {
+    rid.Set(0, (uint32_t)key);
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(true, tree.Insert(index_key, rid));
+  }
+  // the last key is still buffered, a duplicate. Once the shape walk has
+  // applied the buffer, the insert of a key the tree holds is taken without
+  // reading the tree and dropped when applied
+  index_key.SetFromInteger(keys.back());
+  EXPECT_EQ(false, tree.Insert(index_key, RID(1, 1)));
+  tree.GetShape();
+  std::vector<RID> rids;
+  index_key.SetFromInteger(keys.front());
+  EXPECT_EQ(true, tree.Insert(index_key, RID(1, 1)));
+  EXPECT_EQ(true, tree.GetValue(index_key, rids));
+  EXPECT_EQ(0, rids[0].GetPageId());
+  // remove a third of the keys and insert half of them again, buffered or
+  // applied lookups see the latest write
+  for (auto key : keys) {
+    if (key % 3 == 0) {
+      index_key.SetFromInteger(key);
+      tree.Remove(index_key);
+    }
+  }
+  for (auto key : keys) {
+    if (key % 6 == 0) {
+      index_key.SetFromInteger(key);
+      EXPECT_EQ(true, tree.Insert(index_key, RID(1, (uint32_t)key)));
+    }
+  }
+  for (int64_t key = 0; key < scale; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    bool present = key % 3 != 0 || key % 6 == 0;
+    EXPECT_EQ(present, tree.GetValue(index_key, rids));
+    if (present) {
+      EXPECT_EQ(key % 6 == 0 ? 1 : 0, rids[0].GetPageId());
+      EXPECT_EQ(key, rids[0].GetSlotNum());
+    }
+  }
+  // a scan applies the buffer first
+  int64_t count = 0, last_key = -1;
+  for (auto iterator = tree.Begin(); !iterator.isEnd(); ++iterator) {
+    int64_t key = (*iterator).second.GetSlotNum();
+    EXPECT_LT(last_key, key);
+    EXPECT_TRUE(key % 3 != 0 || key % 6 == 0);
+    last_key = key;
+    count++;
+  }
+  EXPECT_EQ(scale - scale / 6, count);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, SwizzlingTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  // a pool far smaller than the tree, swizzled children get evicted
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(20, disk_manager);
+  // create b+ tree
+  BPlusTreeOptions options;
+  options.swizzling = true;
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree(
+      "foo_pk", bpm, comparator, INVALID_PAGE_ID, options);
+  GenericKey<8> index_key;
+  RID rid;
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+
+  int64_t scale = 5000;
+  std::vector<int64_t> keys;
+  for (int64_t key = 0; key < scale; key++)
+    keys.push_back(key);
+  std::shuffle(keys.begin(), keys.end(), std::default_random_engine(0));
+  for (auto key : keys) {
+    rid.Set(0, (uint32_t)key);
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(true, tree.Insert(index_key, rid));
+  }
+  // removes merge pages and shift the children of their parents
+  for (auto key : keys) {
+    if (key % 3 == 0) {
+      index_key.SetFromInteger(key);
+      tree.Remove(index_key);
+    }
+  }
+  std::vector<RID> rids;
+  for (int64_t key = 0; key < scale; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(key % 3 != 0, tree.GetValue(index_key, rids));
+    if (key % 3 != 0) {
+      EXPECT_EQ(key, rids[0].GetSlotNum());
+    }
+  }
+  int64_t count = 0, last_key = -1;
+  for (auto iterator = tree.Begin(); !iterator.isEnd(); ++iterator) {
+    int64_t key = (*iterator).second.GetSlotNum();
+    EXPECT_LT(last_key, key);
+    last_key = key;
+    count++;
+  }
+  EXPECT_EQ(scale - (scale + 2) / 3, count);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, DeferredMergeTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // create b+ tree
+  BPlusTreeOptions options;
+  options.deferred_merge = true;
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree(
+      "foo_pk", bpm, comparator, INVALID_PAGE_ID, options);
+  GenericKey<8> index_key;
+  RID rid;
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+
+  int64_t scale = 500;
+  for (int64_t key = 0; key < scale; key++) {
+    rid.Set(0, (uint32_t)key);
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid);
+  }
+  BPlusTreeShape full = tree.GetShape();
+  // too few leaves to wake the compaction thread
+  ASSERT_LT(full.leaf_pages, COMPACTION_UNDERFULL_LEAVES);
+
+  // removing seven keys of eight leaves every leaf underfull but none merged
+  for (int64_t key = 0; key < scale; key++) {
+    if (key % 8 != 0) {
+      index_key.SetFromInteger(key);
+      tree.Remove(index_key);
+    }
+  }
+  BPlusTreeShape drained = tree.GetShape();
+  EXPECT_EQ((scale + 7) / 8, drained.entries);
+  EXPECT_EQ(full.leaf_pages, drained.leaf_pages);
+  EXPECT_GE(drained.underfull_leaves, full.leaf_pages - 2);
+
+  EXPECT_GT(tree.Compact(), 0u);
+  BPlusTreeShape compacted = tree.GetShape();
+  EXPECT_EQ((scale + 7) / 8, compacted.entries);
+  EXPECT_LT(2 * compacted.leaf_pages, full.leaf_pages);
+  std::vector<RID> rids;
+  for (int64_t key = 0; key < scale; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(key % 8 == 0, tree.GetValue(index_key, rids));
+  }
+  int64_t count = 0, last_key = -1;
+  for (auto iterator = tree.Begin(); !iterator.isEnd(); ++iterator) {
+    int64_t key = (*iterator).second.GetSlotNum();
+    EXPECT_LT(last_key, key);
+    last_key = key;
+    count++;
+  }
+  EXPECT_EQ((scale + 7) / 8, count);
+
+  // a leaf emptied is merged right away
+  for (int64_t key = 0; key < scale; key += 8) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key);
+  }
+  EXPECT_EQ(true, tree.IsEmpty());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, StatisticsTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // create b+ tree
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
+                                                           comparator);
+  GenericKey<8> index_key;
+  RID rid;
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+
+  IndexStatistics stats = tree.GetStatistics();
+  EXPECT_EQ(0, stats.entries);
+  int64_t scale = 10000;
+  std::vector<int64_t> keys;
+  for (int64_t key = 0; key < scale; key++)
+    keys.push_back(key);
+  std::shuffle(keys.begin(), keys.end(), std::default_random_engine(0));
+  for (auto key : keys) {
+    rid.Set(0, (uint32_t)key);
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid);
+  }
+  // the empty tree's statistics are stale by now
+  stats = tree.GetStatistics();
+  BPlusTreeShape shape = tree.GetShape();
+  EXPECT_EQ(shape.height, stats.height);
+  EXPECT_NEAR(shape.leaf_pages, stats.leaf_pages, shape.leaf_pages / 4);
+  EXPECT_NEAR(scale, stats.entries, scale / 4);
+  EXPECT_EQ(stats.entries, stats.distinct_keys);
+  EXPECT_GT(stats.average_fill, 0.5);
+  EXPECT_LE(stats.average_fill, 1.0);
+
+  // the statistics are kept next to the root id
+  IndexStatistics stored;
+  EXPECT_TRUE(reinterpret_cast<HeaderPage *>(header_page)
+                  ->GetStatistics("foo_pk", stored));
+  EXPECT_EQ(stats.entries, stored.entries);
+  EXPECT_EQ(stats.leaf_pages, stored.leaf_pages);
+
+  // a few writes keep them, half of the keys removed make them stale
+  for (int64_t key = 0; key < scale; key += 2) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key);
+    if (key == 10) {
+      EXPECT_EQ(stats.entries, tree.GetStatistics().entries);
+    }
+  }
+  stats = tree.GetStatistics();
+  EXPECT_NEAR(scale / 2, stats.entries, scale / 8);
+
+  // twenty entries per key
+  auto same_key = [](const GenericKey<8> &left, const GenericKey<8> &right) {
+    return left.ToString() / 20 == right.ToString() / 20;
+  };
+  for (int64_t key = 0; key < scale; key += 2) {
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid);
+  }
+  stats = tree.GetStatistics(same_key);
+  EXPECT_NEAR(scale / 20, stats.distinct_keys, scale / 50);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
 } // namespace scudb
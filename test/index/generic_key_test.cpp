@@ -0,0 +1,146 @@
+/**
+ * generic_key_test.cpp
+ */
+
+#include <climits>
+#include <vector>
+
+#include "index/generic_key.h"
+#include "vtable/virtual_table.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+// column by column Value comparison, the order the encoding has to preserve
+static int CompareValues(const std::vector<Value> &lhs,
+                         const std::vector<Value> &rhs) {
+  for (size_t i = 0; i < lhs.size(); i++) {
+    if (lhs[i].CompareLessThan(rhs[i]) == CMP_TRUE)
+      return -1;
+    if (lhs[i].CompareGreaterThan(rhs[i]) == CMP_TRUE)
+      return 1;
+  }
+  return 0;
+}
+
+// check every pair of keys compares like their values
+static void CheckOrder(const std::vector<std::vector<Value>> &keys,
+                       Schema *key_schema) {
+  GenericComparator<64> comparator(key_schema);
+  std::vector<GenericKey<64>> index_keys(keys.size());
+  for (size_t i = 0; i < keys.size(); i++)
+    index_keys[i].SetFromKey(Tuple(keys[i], key_schema), key_schema);
+  for (size_t i = 0; i < keys.size(); i++) {
+    for (size_t j = 0; j < keys.size(); j++) {
+      EXPECT_EQ(CompareValues(keys[i], keys[j]),
+                comparator(index_keys[i], index_keys[j]))
+          << "keys " << i << " and " << j;
+    }
+  }
+}
+
+TEST(GenericKeyTest, IntegerOrderTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  std::vector<std::vector<Value>> keys;
+  for (int64_t key : {LLONG_MIN + 1, -(1LL << 40), -256LL, -1LL, 0LL, 1LL,
+                      255LL, 256LL, 1LL << 40, LLONG_MAX})
+    keys.push_back({Value(TypeId::BIGINT, key)});
+  CheckOrder(keys, key_schema);
+
+  // SetFromInteger encodes like a BIGINT column and decodes back
+  GenericKey<8> index_key;
+  index_key.SetFromInteger(-42);
+  EXPECT_EQ(-42, index_key.ToString());
+  delete key_schema;
+}
+
+TEST(GenericKeyTest, CompositeOrderTest) {
+  Schema *key_schema =
+      ParseCreateStatement("a smallint, b varchar(16), c double");
+  std::vector<std::vector<Value>> keys;
+  for (int16_t a : {-3, 0, 7}) {
+    for (const char *b : {"", "a", "ab", "b"}) {
+      for (double c : {-1e300, -2.5, 0.0, 0.5, 1e300})
+        keys.push_back({Value(TypeId::SMALLINT, a),
+                        Value(TypeId::VARCHAR, std::string(b)),
+                        Value(TypeId::DECIMAL, c)});
+    }
+  }
+  CheckOrder(keys, key_schema);
+  delete key_schema;
+}
+
+TEST(GenericKeyTest, MaxLengthTest) {
+  // varchars count with their declared length, 32 if undeclared
+  Schema *key_schema =
+      ParseCreateStatement("a smallint, b varchar(10), c double, d varchar");
+  EXPECT_EQ(2u + 13u + 8u + 35u, KeyEncoder::MaxLength(key_schema));
+
+  // a key with strings of the declared length takes exactly that much
+  char buffer[128];
+  KeyEncoder encoder(buffer, sizeof(buffer));
+  Tuple tuple({Value(TypeId::SMALLINT, (int16_t)1),
+               Value(TypeId::VARCHAR, std::string(10, 'x')),
+               Value(TypeId::DECIMAL, 0.5),
+               Value(TypeId::VARCHAR, std::string(32, 'y'))},
+              key_schema);
+  for (int i = 0; i < key_schema->GetColumnCount(); i++)
+    encoder.PutValue(tuple.GetValue(key_schema, i));
+  EXPECT_EQ(KeyEncoder::MaxLength(key_schema), encoder.Length());
+  delete key_schema;
+}
+
+TEST(GenericKeyTest, EntryDecodeTest) {
+  // key columns a and b, rid, included columns c, d and e
+  Schema *entry_schema = ParseCreateStatement(
+      "a int, b varchar(8), c double, d varchar(8), e tinyint");
+  std::vector<std::vector<Value>> entries = {
+      {Value(TypeId::INTEGER, -7), Value(TypeId::VARCHAR, std::string("x")),
+       Value(TypeId::DECIMAL, -2.5), Value(TypeId::VARCHAR, std::string("")),
+       Value(TypeId::TINYINT, (int8_t)-1)},
+      {Value(TypeId::INTEGER, 1 << 30),
+       Value(TypeId::VARCHAR, std::string("a\0b", 3)),
+       Value(TypeId::DECIMAL, 1e300), Value(TypeId::VARCHAR, nullptr, 0, false),
+       Value(TypeId::TINYINT, (int8_t)100)}};
+  for (auto &values : entries) {
+    GenericKey<64> index_key;
+    index_key.SetFromEntry(Tuple(values, entry_schema), entry_schema, 2,
+                           RID(3, 4));
+    Tuple entry = index_key.GetEntry(entry_schema, 2, true);
+    for (int i = 0; i < entry_schema->GetColumnCount(); i++) {
+      Value value = entry.GetValue(entry_schema, i);
+      EXPECT_EQ(values[i].IsNull(), value.IsNull()) << "column " << i;
+      if (!values[i].IsNull()) {
+        EXPECT_EQ(CMP_TRUE, values[i].CompareEquals(value)) << "column " << i;
+      }
+    }
+  }
+  delete entry_schema;
+}
+
+TEST(GenericKeyTest, TruncationTest) {
+  Schema *key_schema = ParseCreateStatement("a varchar");
+  auto key = [&](size_t length) {
+    return Tuple({Value(TypeId::VARCHAR, std::string(length, 'x'))},
+                 key_schema);
+  };
+
+  // 13 characters between the marker and the terminator fill the key
+  GenericKey<16> index_key;
+  EXPECT_TRUE(index_key.SetFromKey(key(13), key_schema));
+  EXPECT_FALSE(index_key.SetFromKey(key(14), key_schema));
+
+  // the rid needs its 8 bytes too. One byte short, the rids of two tuples
+  // differ past the end and their keys compare equal
+  GenericComparator<16> comparator(key_schema);
+  GenericKey<16> other_key;
+  EXPECT_TRUE(index_key.SetFromKey(key(5), key_schema, RID(1, 2)));
+  EXPECT_TRUE(other_key.SetFromKey(key(5), key_schema, RID(1, 3)));
+  EXPECT_NE(0, comparator(index_key, other_key));
+  EXPECT_FALSE(index_key.SetFromKey(key(6), key_schema, RID(1, 2)));
+  EXPECT_FALSE(other_key.SetFromKey(key(6), key_schema, RID(1, 3)));
+  EXPECT_EQ(0, comparator(index_key, other_key));
+  delete key_schema;
+}
+
+} // namespace scudb
@@ -5,8 +5,6 @@
 #include "page/header_page.h"
 #include "gtest/gtest.h"
 
-// NOTE: when you running this test, make sure page size(config.h) is at least
-// 4096
 namespace scudb {
 
 TEST(HeaderPageTest, UnitTest) {
@@ -19,31 +17,37 @@ TEST(HeaderPageTest, UnitTest) {
   ASSERT_NE(nullptr, page);
   page->Init();
 
-  for (int i = 1; i < 28; i++) {
+  // every record takes 36 bytes after the record count, the statistics count
+  // takes the last 4 bytes of the page
+  const int capacity = (PAGE_SIZE - 8) / 36;
+  for (int i = 1; i <= capacity; i++) {
     std::string name = std::to_string(i);
     EXPECT_EQ(page->InsertRecord(name, i), true);
   }
+  EXPECT_EQ(page->InsertRecord(std::to_string(capacity + 1), capacity + 1),
+            false);
+  EXPECT_EQ(page->GetRecordCount(), capacity);
 
-  for (int i = 27; i >= 1; i--) {
+  for (int i = capacity; i >= 1; i--) {
     std::string name = std::to_string(i);
     page_id_t root_id;
     EXPECT_EQ(page->GetRootId(name, root_id), true);
     // std::cout << "root page id is " << root_id << '\n';
   }
 
-  for (int i = 1; i < 28; i++) {
+  for (int i = 1; i <= capacity; i++) {
     std::string name = std::to_string(i);
     EXPECT_EQ(page->UpdateRecord(name, i + 10), true);
   }
 
-  for (int i = 27; i >= 1; i--) {
+  for (int i = capacity; i >= 1; i--) {
     std::string name = std::to_string(i);
     page_id_t root_id;
     EXPECT_EQ(page->GetRootId(name, root_id), true);
     // std::cout << "root page id is " << root_id << '\n';
   }
 
-  for (int i = 1; i < 28; i++) {
+  for (int i = 1; i <= capacity; i++) {
     std::string name = std::to_string(i);
     EXPECT_EQ(page->DeleteRecord(name), true);
   }
@@ -55,4 +59,52 @@ TEST(HeaderPageTest, UnitTest) {
   remove("test.db");
   remove("test.log");
 }
+
+TEST(HeaderPageTest, StatisticsTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *buffer_pool_manager =
+      new BufferPoolManager(20, disk_manager);
+  page_id_t header_page_id;
+  HeaderPage *page =
+      static_cast<HeaderPage *>(buffer_pool_manager->NewPage(header_page_id));
+  ASSERT_NE(nullptr, page);
+  page->Init();
+
+  IndexStatistics stats, stored;
+  EXPECT_EQ(page->GetStatistics("foo_pk", stored), false);
+  EXPECT_EQ(page->InsertRecord("foo", 1), true);
+  EXPECT_EQ(page->InsertRecord("foo_pk", 2), true);
+  stats.entries = 100;
+  EXPECT_EQ(page->SetStatistics("foo", stats), true);
+  stats.entries = 200;
+  EXPECT_EQ(page->SetStatistics("foo_pk", stats), true);
+  EXPECT_EQ(page->GetStatistics("foo_pk", stored), true);
+  EXPECT_EQ(stored.entries, 200);
+  stats.entries = 300;
+  EXPECT_EQ(page->SetStatistics("foo_pk", stats), true);
+  EXPECT_EQ(page->GetStatistics("foo_pk", stored), true);
+  EXPECT_EQ(stored.entries, 300);
+
+  // deleting the record of a name deletes its statistics
+  EXPECT_EQ(page->DeleteRecord("foo"), true);
+  EXPECT_EQ(page->GetStatistics("foo", stored), false);
+  EXPECT_EQ(page->GetStatistics("foo_pk", stored), true);
+  EXPECT_EQ(stored.entries, 300);
+
+  // root records take the room of statistics
+  int records = 1;
+  while (page->InsertRecord(std::to_string(records), records))
+    records++;
+  EXPECT_EQ(page->GetRecordCount(), records);
+  EXPECT_EQ(page->GetStatistics("foo_pk", stored), false);
+  EXPECT_EQ(page->SetStatistics("foo_pk", stats), false);
+  page_id_t root_id;
+  EXPECT_EQ(page->GetRootId("foo_pk", root_id), true);
+  EXPECT_EQ(root_id, 2);
+
+  delete buffer_pool_manager;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
 } // namespace scudb
@@ -44,4 +44,390 @@ TEST(VtableTest, CreateTest) {
   remove("vtable.db");
   return;
 }
+
+// first column of the single result row, -1 if the query failed
+static int64_t QueryInteger(sqlite3 *db, const std::string &sql) {
+  int64_t result = -1;
+  auto callback = [](void *out, int argc, char **argv, char **) {
+    *reinterpret_cast<int64_t *>(out) = std::stoll(argv[0]);
+    return 0;
+  };
+  if (sqlite3_exec(db, sql.c_str(), callback, &result, nullptr) != SQLITE_OK)
+    return -1;
+  return result;
+}
+
+TEST(VtableTest, HashIndexTest) {
+  std::string db_file = "sqlite.db";
+  remove(db_file.c_str());
+  remove("vtable.db");
+  sqlite3 *db;
+  int rc;
+  rc = sqlite3_open(db_file.c_str(), &db);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  rc = sqlite3_enable_load_extension(db, 1);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  const char *zFile = "libvtable"; // shared library name
+  const char *zProc = 0;           // entry point within library
+  char *zErrMsg = 0;
+  rc = sqlite3_load_extension(db, zFile, zProc, &zErrMsg);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  // trailing "using hash" backs the index with an extendible hash table
+  EXPECT_TRUE(ExecSQL(db, "CREATE VIRTUAL TABLE foo2 USING vtable ('a INT, b "
+                          "varchar(8)', 'foo2_pk a using hash')"));
+  EXPECT_TRUE(ExecSQL(db, "INSERT INTO foo2 VALUES(1, 'hello')"));
+  EXPECT_TRUE(ExecSQL(db, "INSERT INTO foo2 VALUES(2, 'world')"));
+  EXPECT_TRUE(ExecSQL(db, "SELECT * FROM foo2 WHERE a = 2"));
+  // the hash table refuses a second entry of a key, so does the statement
+  EXPECT_FALSE(ExecSQL(db, "INSERT INTO foo2 VALUES(2, 'again')"));
+  EXPECT_FALSE(ExecSQL(db, "UPDATE foo2 SET a = 2 WHERE a = 1"));
+  EXPECT_FALSE(ExecSQL(db, "UPDATE foo2 SET a = 2, b = 'longer' WHERE a = 1"));
+  EXPECT_EQ(2, QueryInteger(db, "SELECT count(*) FROM foo2"));
+  EXPECT_EQ(1, QueryInteger(db, "SELECT count(*) FROM foo2 WHERE a = 1"));
+  EXPECT_EQ(1, QueryInteger(db, "SELECT count(*) FROM foo2 WHERE a = 2"));
+  EXPECT_TRUE(ExecSQL(db, "INSERT INTO foo2 VALUES(3, 'again')"));
+  EXPECT_EQ(3, QueryInteger(db, "SELECT count(*) FROM foo2"));
+  EXPECT_TRUE(ExecSQL(db, "DELETE FROM foo2 WHERE a = 1"));
+  EXPECT_TRUE(ExecSQL(db, "SELECT * FROM foo2"));
+  EXPECT_TRUE(ExecSQL(db, "DROP TABLE foo2"));
+
+  rc = sqlite3_close(db);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  remove(db_file.c_str());
+  remove("vtable.db");
+}
+
+TEST(VtableTest, NonUniqueIndexTest) {
+  std::string db_file = "sqlite.db";
+  remove(db_file.c_str());
+  remove("vtable.db");
+  sqlite3 *db;
+  int rc;
+  rc = sqlite3_open(db_file.c_str(), &db);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  rc = sqlite3_enable_load_extension(db, 1);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  const char *zFile = "libvtable"; // shared library name
+  const char *zProc = 0;           // entry point within library
+  char *zErrMsg = 0;
+  rc = sqlite3_load_extension(db, zFile, zProc, &zErrMsg);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  // "nonunique" keeps one index entry per tuple of a shared key, the B+ tree
+  // options may come in any order with it
+  EXPECT_TRUE(ExecSQL(db, "CREATE VIRTUAL TABLE foo3 USING vtable ('a INT, b "
+                          "varchar(8)', 'foo3_idx b adaptive nonunique')"));
+  for (int i = 0; i < 300; i++) {
+    EXPECT_TRUE(ExecSQL(db, "INSERT INTO foo3 VALUES(" + std::to_string(i) +
+                                ", 'k" + std::to_string(i % 3) + "')"));
+  }
+  EXPECT_EQ(100, QueryInteger(db, "SELECT count(*) FROM foo3 WHERE b = 'k1'"));
+  EXPECT_EQ(0, QueryInteger(db, "SELECT count(*) FROM foo3 WHERE b = 'k3'"));
+  EXPECT_TRUE(ExecSQL(db, "DELETE FROM foo3 WHERE a < 30"));
+  EXPECT_EQ(90, QueryInteger(db, "SELECT count(*) FROM foo3 WHERE b = 'k1'"));
+  // an update moves the entries of the updated tuples to the new key
+  EXPECT_TRUE(ExecSQL(db, "UPDATE foo3 SET b = 'k1' WHERE b = 'k0'"));
+  EXPECT_EQ(180, QueryInteger(db, "SELECT count(*) FROM foo3 WHERE b = 'k1'"));
+  EXPECT_EQ(0, QueryInteger(db, "SELECT count(*) FROM foo3 WHERE b = 'k0'"));
+  // range and ordered scans take in every entry of a key
+  EXPECT_EQ(90, QueryInteger(db, "SELECT count(*) FROM foo3 WHERE b > 'k1'"));
+  EXPECT_EQ(270, QueryInteger(db, "SELECT count(*) FROM foo3 WHERE b >= 'k1' "
+                                  "AND b < 'k3'"));
+  EXPECT_EQ(1, QueryInteger(db, "SELECT count(*) FROM (SELECT b FROM foo3 "
+                                "ORDER BY b DESC LIMIT 91) WHERE b = 'k1'"));
+  EXPECT_TRUE(ExecSQL(db, "DROP TABLE foo3"));
+
+  rc = sqlite3_close(db);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  remove(db_file.c_str());
+  remove("vtable.db");
+}
+
+// last column of every result row joined by ",", "error" if the query failed
+static std::string QueryColumn(sqlite3 *db, const std::string &sql) {
+  std::string result;
+  auto callback = [](void *out, int argc, char **argv, char **) {
+    auto column = reinterpret_cast<std::string *>(out);
+    if (!column->empty())
+      column->append(",");
+    column->append(argv[argc - 1] ? argv[argc - 1] : "NULL");
+    return 0;
+  };
+  if (sqlite3_exec(db, sql.c_str(), callback, &result, nullptr) != SQLITE_OK)
+    return "error";
+  return result;
+}
+
+TEST(VtableTest, OrderedIndexScanTest) {
+  std::string db_file = "sqlite.db";
+  remove(db_file.c_str());
+  remove("vtable.db");
+  sqlite3 *db;
+  int rc;
+  rc = sqlite3_open(db_file.c_str(), &db);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  rc = sqlite3_enable_load_extension(db, 1);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  const char *zFile = "libvtable"; // shared library name
+  const char *zProc = 0;           // entry point within library
+  char *zErrMsg = 0;
+  rc = sqlite3_load_extension(db, zFile, zProc, &zErrMsg);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  EXPECT_TRUE(ExecSQL(db, "CREATE VIRTUAL TABLE foo4 USING vtable ('a INT, b "
+                          "INT', 'foo4_idx b buffered deferred swizzled')"));
+  for (int i = 0; i < 200; i++) {
+    EXPECT_TRUE(ExecSQL(db, "INSERT INTO foo4 VALUES(" + std::to_string(i) +
+                                ", " + std::to_string(i * 37 % 200) + ")"));
+  }
+  // the index returns the rows in order, SQLite does not sort them
+  EXPECT_EQ(std::string::npos,
+            QueryColumn(db, "EXPLAIN QUERY PLAN SELECT b FROM foo4 ORDER BY b "
+                            "DESC")
+                .find("TEMP B-TREE"));
+  EXPECT_EQ("199,198,197,196,195",
+            QueryColumn(db, "SELECT b FROM foo4 ORDER BY b DESC LIMIT 5"));
+  EXPECT_EQ("0,1,2", QueryColumn(db, "SELECT b FROM foo4 ORDER BY b LIMIT 3"));
+  EXPECT_EQ("15,14,13,12,11",
+            QueryColumn(db, "SELECT b FROM foo4 WHERE b > 10 AND b <= 15 ORDER "
+                            "BY b DESC"));
+  EXPECT_EQ("2,1,0",
+            QueryColumn(db, "SELECT b FROM foo4 WHERE b < 3 ORDER BY b DESC"));
+  EXPECT_EQ(50, QueryInteger(db, "SELECT count(*) FROM foo4 WHERE b >= 150"));
+  // bounds an INTEGER key can not hold leave the scan open at that end
+  EXPECT_EQ("4,3", QueryColumn(db, "SELECT b FROM foo4 WHERE b > 2.5 AND b < "
+                                   "5 ORDER BY b DESC"));
+  EXPECT_EQ(200, QueryInteger(db, "SELECT count(*) FROM foo4 WHERE b < "
+                                  "10000000000"));
+  EXPECT_EQ("37", QueryColumn(db, "SELECT b FROM foo4 WHERE a = 1"));
+  // the unique index refuses the second row of b = 5, which fails the
+  // statement and rolls back its first row. Ordered and range scans of the
+  // index see the rows of a full scan
+  EXPECT_TRUE(ExecSQL(db, "DELETE FROM foo4"));
+  EXPECT_FALSE(ExecSQL(db, "INSERT INTO foo4 VALUES(1, 5), (2, 5), (3, 7)"));
+  EXPECT_EQ(0, QueryInteger(db, "SELECT count(*) FROM foo4"));
+  EXPECT_EQ(0, QueryInteger(db, "SELECT count(*) FROM foo4 WHERE b = 5"));
+  EXPECT_TRUE(ExecSQL(db, "INSERT INTO foo4 VALUES(1, 5), (3, 7)"));
+  // a failed update rolls back the rows it changed before
+  EXPECT_FALSE(ExecSQL(db, "UPDATE foo4 SET b = 6"));
+  // in a transaction only the failed statement is rolled back
+  EXPECT_TRUE(ExecSQL(db, "BEGIN"));
+  EXPECT_TRUE(ExecSQL(db, "INSERT INTO foo4 VALUES(4, 8)"));
+  EXPECT_FALSE(ExecSQL(db, "INSERT INTO foo4 VALUES(5, 9), (6, 8)"));
+  EXPECT_TRUE(ExecSQL(db, "DELETE FROM foo4 WHERE b = 8"));
+  EXPECT_TRUE(ExecSQL(db, "COMMIT"));
+  EXPECT_EQ(0, QueryInteger(db, "SELECT count(*) FROM foo4 WHERE b > 7"));
+  EXPECT_EQ(2, QueryInteger(db, "SELECT count(*) FROM foo4"));
+  EXPECT_EQ(2, QueryInteger(db, "SELECT count(*) FROM foo4 WHERE b > 0"));
+  EXPECT_EQ("5,7", QueryColumn(db, "SELECT a, b FROM foo4 ORDER BY b"));
+  EXPECT_EQ("1,3", QueryColumn(db, "SELECT b, a FROM foo4 ORDER BY b"));
+  EXPECT_TRUE(ExecSQL(db, "DROP TABLE foo4"));
+
+  rc = sqlite3_close(db);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  remove(db_file.c_str());
+  remove("vtable.db");
+}
+
+TEST(VtableTest, CoveringIndexTest) {
+  std::string db_file = "sqlite.db";
+  remove(db_file.c_str());
+  remove("vtable.db");
+  sqlite3 *db;
+  int rc;
+  rc = sqlite3_open(db_file.c_str(), &db);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  rc = sqlite3_enable_load_extension(db, 1);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  const char *zFile = "libvtable"; // shared library name
+  const char *zProc = 0;           // entry point within library
+  char *zErrMsg = 0;
+  rc = sqlite3_load_extension(db, zFile, zProc, &zErrMsg);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  // "include" stores c with every entry of b
+  EXPECT_TRUE(ExecSQL(db, "CREATE VIRTUAL TABLE foo5 USING vtable ('a INT, b "
+                          "INT, c varchar(8)', 'foo5_idx b include (c)')"));
+  for (int i = 0; i < 200; i++) {
+    EXPECT_TRUE(ExecSQL(db, "INSERT INTO foo5 VALUES(" + std::to_string(i) +
+                                ", " + std::to_string(i * 37 % 200) + ", 'v" +
+                                std::to_string(i) + "')"));
+  }
+  // queries reading b and c only are served from the index
+  EXPECT_NE(std::string::npos,
+            QueryColumn(db, "EXPLAIN QUERY PLAN SELECT c FROM foo5 WHERE b = "
+                            "37")
+                .find("index-only"));
+  EXPECT_EQ("v1", QueryColumn(db, "SELECT c FROM foo5 WHERE b = 37"));
+  EXPECT_EQ("v30,v3,v176",
+            QueryColumn(db, "SELECT c FROM foo5 WHERE b >= 110 AND b < 113 "
+                            "ORDER BY b"));
+  EXPECT_EQ("v176,v3,v30",
+            QueryColumn(db, "SELECT c FROM foo5 WHERE b >= 110 AND b < 113 "
+                            "ORDER BY b DESC"));
+  // a reads the table heap
+  EXPECT_EQ(std::string::npos,
+            QueryColumn(db, "EXPLAIN QUERY PLAN SELECT a FROM foo5 WHERE b = "
+                            "37")
+                .find("index-only"));
+  EXPECT_EQ("1", QueryColumn(db, "SELECT a FROM foo5 WHERE b = 37"));
+  // updates and deletes keep the included columns in step
+  EXPECT_TRUE(ExecSQL(db, "UPDATE foo5 SET c = 'new' WHERE a = 1"));
+  EXPECT_EQ("new", QueryColumn(db, "SELECT c FROM foo5 WHERE b = 37"));
+  // the first entry of a unique key stays, a second one is refused
+  EXPECT_FALSE(ExecSQL(db, "INSERT INTO foo5 VALUES(500, 37, 'dup')"));
+  EXPECT_EQ("new", QueryColumn(db, "SELECT c FROM foo5 WHERE b = 37"));
+  EXPECT_EQ(0, QueryInteger(db, "SELECT count(*) FROM foo5 WHERE a = 500"));
+  EXPECT_TRUE(ExecSQL(db, "DELETE FROM foo5 WHERE a = 1"));
+  EXPECT_EQ(0, QueryInteger(db, "SELECT count(*) FROM foo5 WHERE b = 37"));
+  EXPECT_TRUE(ExecSQL(db, "DROP TABLE foo5"));
+
+  rc = sqlite3_close(db);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  remove(db_file.c_str());
+  remove("vtable.db");
+}
+
+TEST(VtableTest, ArtIndexTest) {
+  std::string db_file = "sqlite.db";
+  remove(db_file.c_str());
+  remove("vtable.db");
+  sqlite3 *db;
+  int rc;
+  rc = sqlite3_open(db_file.c_str(), &db);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  rc = sqlite3_enable_load_extension(db, 1);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  const char *zFile = "libvtable"; // shared library name
+  const char *zProc = 0;           // entry point within library
+  char *zErrMsg = 0;
+  rc = sqlite3_load_extension(db, zFile, zProc, &zErrMsg);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  // "using art" keeps the index in memory in an adaptive radix tree
+  EXPECT_TRUE(ExecSQL(db, "CREATE VIRTUAL TABLE foo6 USING vtable ('a INT, b "
+                          "INT, c varchar(8)', 'foo6_idx b nonunique include "
+                          "(c) using art')"));
+  for (int i = 0; i < 300; i++) {
+    EXPECT_TRUE(ExecSQL(db, "INSERT INTO foo6 VALUES(" + std::to_string(i) +
+                                ", " + std::to_string(i % 100 - 50) + ", 'v" +
+                                std::to_string(i) + "')"));
+  }
+  EXPECT_EQ("v7,v107,v207",
+            QueryColumn(db, "SELECT c FROM foo6 WHERE b = -43"));
+  EXPECT_EQ("-48,-48,-48,-49,-49,-49,-50,-50,-50",
+            QueryColumn(db, "SELECT b FROM foo6 WHERE b < -47 ORDER BY b "
+                            "DESC"));
+  EXPECT_EQ(30, QueryInteger(db, "SELECT count(*) FROM foo6 WHERE b >= 10 "
+                                 "AND b < 20"));
+
+  rc = sqlite3_close(db);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  // nothing of the index is stored, connecting builds it from the table
+  rc = sqlite3_open(db_file.c_str(), &db);
+  EXPECT_EQ(rc, SQLITE_OK);
+  rc = sqlite3_enable_load_extension(db, 1);
+  EXPECT_EQ(rc, SQLITE_OK);
+  rc = sqlite3_load_extension(db, zFile, zProc, &zErrMsg);
+  EXPECT_EQ(rc, SQLITE_OK);
+  EXPECT_EQ("v7,v107,v207",
+            QueryColumn(db, "SELECT c FROM foo6 WHERE b = -43"));
+  EXPECT_EQ(30, QueryInteger(db, "SELECT count(*) FROM foo6 WHERE b >= 10 "
+                                 "AND b < 20"));
+  EXPECT_TRUE(ExecSQL(db, "DELETE FROM foo6 WHERE a < 10"));
+  EXPECT_EQ("v107,v207", QueryColumn(db, "SELECT c FROM foo6 WHERE b = -43"));
+  EXPECT_TRUE(ExecSQL(db, "UPDATE foo6 SET b = 1000 WHERE a = 107"));
+  EXPECT_EQ("v107", QueryColumn(db, "SELECT c FROM foo6 WHERE b = 1000"));
+  EXPECT_EQ("v207", QueryColumn(db, "SELECT c FROM foo6 WHERE b = -43"));
+  EXPECT_TRUE(ExecSQL(db, "DROP TABLE foo6"));
+
+  rc = sqlite3_close(db);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  remove(db_file.c_str());
+  remove("vtable.db");
+}
+
+TEST(VtableTest, LongKeyTest) {
+  std::string db_file = "sqlite.db";
+  // an undeclared varchar is sized as 32 bytes, SQLite stores longer values
+  // and the index takes their keys at full length. Keys that share a long
+  // prefix must not be taken for one
+  std::string prefix(80, 'p');
+  // too long for any index page
+  std::string huge(300, 'h');
+  // foo7 is indexed by a B+ tree, foo8 by a hash table
+  for (std::string table : {"foo7", "foo8"}) {
+    remove(db_file.c_str());
+    remove("vtable.db");
+    sqlite3 *db;
+    int rc;
+    rc = sqlite3_open(db_file.c_str(), &db);
+    EXPECT_EQ(rc, SQLITE_OK);
+
+    rc = sqlite3_enable_load_extension(db, 1);
+    EXPECT_EQ(rc, SQLITE_OK);
+
+    const char *zFile = "libvtable"; // shared library name
+    const char *zProc = 0;           // entry point within library
+    char *zErrMsg = 0;
+    rc = sqlite3_load_extension(db, zFile, zProc, &zErrMsg);
+    EXPECT_EQ(rc, SQLITE_OK);
+
+    std::string index = table + "_idx d";
+    if (table == "foo8")
+      index += " using hash";
+    EXPECT_TRUE(ExecSQL(db, "CREATE VIRTUAL TABLE " + table + " USING vtable "
+                            "('a INT, d varchar', '" + index + "')"));
+    // enough keys to split pages
+    for (int i = 0; i < 50; i++)
+      EXPECT_TRUE(ExecSQL(db, "INSERT INTO " + table + " VALUES(" +
+                                  std::to_string(i) + ", '" + prefix +
+                                  std::to_string(i) + "')"));
+    EXPECT_FALSE(ExecSQL(db, "INSERT INTO " + table + " VALUES(50, '" +
+                                 prefix + "7')"));
+    EXPECT_TRUE(ExecSQL(db, "INSERT INTO " + table + " VALUES(51, 'short')"));
+    EXPECT_TRUE(ExecSQL(db, "UPDATE " + table + " SET d = '" + prefix +
+                                "x' WHERE a = 51"));
+    EXPECT_FALSE(ExecSQL(db, "INSERT INTO " + table + " VALUES(52, '" +
+                                 huge + "')"));
+    EXPECT_EQ(51, QueryInteger(db, "SELECT count(*) FROM " + table));
+    for (int i = 0; i < 50; i++)
+      EXPECT_EQ(std::to_string(i),
+                QueryColumn(db, "SELECT a FROM " + table + " WHERE d = '" +
+                                    prefix + std::to_string(i) + "'"));
+    EXPECT_EQ("51", QueryColumn(db, "SELECT a FROM " + table +
+                                        " WHERE d = '" + prefix + "x'"));
+    EXPECT_EQ(0, QueryInteger(db, "SELECT count(*) FROM " + table +
+                                      " WHERE d = 'short'"));
+    EXPECT_TRUE(ExecSQL(db, "DELETE FROM " + table + " WHERE d = '" +
+                                prefix + "7'"));
+    EXPECT_EQ(0, QueryInteger(db, "SELECT count(*) FROM " + table +
+                                      " WHERE d = '" + prefix + "7'"));
+    EXPECT_EQ(50, QueryInteger(db, "SELECT count(*) FROM " + table));
+    EXPECT_TRUE(ExecSQL(db, "DROP TABLE " + table));
+
+    rc = sqlite3_close(db);
+    EXPECT_EQ(rc, SQLITE_OK);
+  }
+
+  remove(db_file.c_str());
+  remove("vtable.db");
+}
 } // namespace scudb